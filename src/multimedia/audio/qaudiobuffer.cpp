@@ -16,9 +16,28 @@ public:
     {
     }
 
+    QAudioBufferPrivate(const QAudioBufferPrivate &other)
+        : QSharedData(other), format(other.format), startTime(other.startTime)
+    {
+        // external memory stays with the buffers that were created from it
+        if (other.external)
+            data = QByteArray(other.data.constData(), other.data.size());
+        else
+            data = other.data;
+    }
+
+    ~QAudioBufferPrivate()
+    {
+        if (cleanupFunction)
+            cleanupFunction(cleanupInfo);
+    }
+
     QAudioFormat format;
     QByteArray data;
     qint64 startTime;
+    bool external = false;
+    QAudioBufferCleanupFunction cleanupFunction = nullptr;
+    void *cleanupInfo = nullptr;
 };
 
 QT_DEFINE_QESDP_SPECIALIZATION_DTOR(QAudioBufferPrivate);
@@ -96,6 +115,56 @@ QAudioBuffer::QAudioBuffer(int numFrames, const QAudioFormat &format, qint64 sta
     d = new QAudioBufferPrivate(format, data, startTime);
 }
 
+/*!
+    \typedef QAudioBufferCleanupFunction
+    \relates QAudioBuffer
+    \since 6.6
+
+    A function with the following signature that can be used to
+    release external memory adopted by a QAudioBuffer:
+
+    \code
+    void myAudioBufferCleanupHandler(void *info);
+    \endcode
+*/
+
+/*!
+    \since 6.6
+
+    Creates a new audio buffer that references \a size bytes of samples at
+    \a data, in the given \a format, without copying them. This is useful for
+    samples in memory mapped files, ring buffers or the frames of a decoder.
+
+    The buffer calls \a cleanupFunction with \a cleanupInfo once it and all of
+    its copies are destroyed. If the buffer can't be created, because the format
+    is invalid or there is no data, it is called right away. Without a cleanup
+    function, \a data has to stay valid for as long as the buffer and its copies
+    are in use. Note that the cleanup function may be called from any thread
+    that destroys the last copy of the buffer.
+
+    The data is read only; calling data() to modify it, or detach(), copies it
+    into memory owned by the buffer.
+
+    \a startTime (in microseconds) indicates when this buffer
+    starts in the stream.
+    If this buffer is not part of a stream, set it to -1.
+*/
+QAudioBuffer::QAudioBuffer(const void *data, qsizetype size, const QAudioFormat &format,
+                           qint64 startTime, QAudioBufferCleanupFunction cleanupFunction,
+                           void *cleanupInfo)
+{
+    if (!format.isValid() || !data || size <= 0) {
+        if (cleanupFunction)
+            cleanupFunction(cleanupInfo);
+        return;
+    }
+    d = new QAudioBufferPrivate(
+            format, QByteArray::fromRawData(static_cast<const char *>(data), size), startTime);
+    d->external = true;
+    d->cleanupFunction = cleanupFunction;
+    d->cleanupInfo = cleanupInfo;
+}
+
 /*!
     \fn QAudioBuffer::QAudioBuffer(QAudioBuffer &&other)
 
@@ -111,6 +111,8 @@ using QAudioFrameSurround7Dot1 = QAudioFrame<QAudioFormat::ChannelConfigSurround
 class QAudioBufferPrivate;
 QT_DECLARE_QESDP_SPECIALIZATION_DTOR_WITH_EXPORT(QAudioBufferPrivate, Q_MULTIMEDIA_EXPORT)
 
+typedef void (*QAudioBufferCleanupFunction)(void *);
+
 class Q_MULTIMEDIA_EXPORT QAudioBuffer
 {
 public:
@@ -118,6 +120,8 @@ public:
     QAudioBuffer(const QAudioBuffer &other) noexcept;
     QAudioBuffer(const QByteArray &data, const QAudioFormat &format, qint64 startTime = -1);
     QAudioBuffer(int numFrames, const QAudioFormat &format, qint64 startTime = -1); // Initialized to empty
+    QAudioBuffer(const void *data, qsizetype size, const QAudioFormat &format, qint64 startTime = -1,
+                 QAudioBufferCleanupFunction cleanupFunction = nullptr, void *cleanupInfo = nullptr);
     ~QAudioBuffer();
 
     QAudioBuffer& operator=(const QAudioBuffer &other);
@@ -0,0 +1,92 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qaudiocallbackbridge_p.h"
+#include "qaudiohelpers_p.h"
+
+QT_BEGIN_NAMESPACE
+
+QAudioCallbackBridge::QAudioCallbackBridge(const QAudioFormat &format, qsizetype frames,
+                                           qsizetype bufferFrames,
+                                           QPlatformAudioSink::AudioCallback &&callback)
+    : m_format(format),
+      m_frames(frames),
+      m_callback(std::move(callback)),
+      // room for at least two calls, so that one can be rendered while the other is read
+      m_ring(qMax(bufferFrames, 2 * frames) * format.channelCount())
+{
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    m_thread.reset(QThread::create([this] { render(); }));
+    m_thread->setObjectName(QStringLiteral("QAudioCallbackBridge"));
+    m_thread->start(QThread::TimeCriticalPriority);
+}
+
+QAudioCallbackBridge::~QAudioCallbackBridge()
+{
+    m_running.storeRelease(false);
+    m_roomForMore.release();
+    m_thread->wait();
+}
+
+// Called on the rendering thread
+void QAudioCallbackBridge::render()
+{
+    const qsizetype samples = m_frames * m_format.channelCount();
+    std::vector<float> buffer(samples);
+
+    while (m_running.loadAcquire()) {
+        if (m_ring.free() < samples) {
+            m_roomForMore.acquire();
+            continue;
+        }
+
+        m_callback(buffer.data(), m_frames);
+
+        const bool wasEmpty = m_ring.used() == 0;
+        m_ring.write(buffer.data(), samples);
+        // the sink stops reading when it runs out, tell it to continue
+        if (wasEmpty)
+            emit readyRead();
+    }
+}
+
+qint64 QAudioCallbackBridge::bytesAvailable() const
+{
+    return m_ring.used() * m_format.bytesPerSample();
+}
+
+qint64 QAudioCallbackBridge::readData(char *data, qint64 maxlen)
+{
+    const int channels = m_format.channelCount();
+    const qsizetype frames = qMin(maxlen / m_format.bytesPerFrame(), m_ring.used() / channels);
+    if (frames <= 0)
+        return 0;
+
+    const qsizetype samples = frames * channels;
+    if (m_format.sampleFormat() == QAudioFormat::Float) {
+        m_ring.read(reinterpret_cast<float *>(data), samples);
+    } else {
+        m_readBuffer.resize(samples);
+        m_ring.read(m_readBuffer.data(), samples);
+        QAudioHelperInternal::qConvertSamplesFromFloat(m_readBuffer.data(), m_format, data, samples);
+    }
+
+    // only ever one wake up pending, the thread checks for room itself
+    if (m_roomForMore.available() == 0)
+        m_roomForMore.release();
+
+    return frames * m_format.bytesPerFrame();
+}
+
+qint64 QAudioCallbackBridge::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+
+    return -1;
+}
+
+QT_END_NAMESPACE
+
+#include "moc_qaudiocallbackbridge_p.cpp"
@@ -0,0 +1,73 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QAUDIOCALLBACKBRIDGE_P_H
+#define QAUDIOCALLBACKBRIDGE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qaudioformat.h>
+#include <private/qaudioringbuffer_p.h>
+#include <private/qaudiosystem_p.h>
+
+#include <QtCore/qiodevice.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthread.h>
+
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+// Feeds an audio sink that reads from a QIODevice in its event loop with what
+// a callback renders on a thread of its own. The two sides only share a ring
+// buffer, so the callback never waits for the event loop, and the event loop
+// only wakes the thread up when there is room for more.
+class Q_MULTIMEDIA_EXPORT QAudioCallbackBridge : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    QAudioCallbackBridge(const QAudioFormat &format, qsizetype frames, qsizetype bufferFrames,
+                         QPlatformAudioSink::AudioCallback &&callback);
+    ~QAudioCallbackBridge();
+
+    // The number of frames passed to every call of the callback
+    qsizetype frames() const { return m_frames; }
+
+    bool isSequential() const override { return true; }
+    // the stream doesn't end, running out of data is an underrun
+    bool atEnd() const override { return false; }
+    qint64 bytesAvailable() const override;
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    void render();
+
+    QAudioFormat m_format;
+    qsizetype m_frames = 0;
+    QPlatformAudioSink::AudioCallback m_callback;
+
+    QAudioRingBuffer<float> m_ring;
+    QSemaphore m_roomForMore;
+    QAtomicInteger<bool> m_running = true;
+    std::unique_ptr<QThread> m_thread;
+
+    std::vector<float> m_readBuffer; // for converting to the sample format of the sink
+};
+
+QT_END_NAMESPACE
+
+#endif
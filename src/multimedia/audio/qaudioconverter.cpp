@@ -0,0 +1,523 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qaudioconverter_p.h"
+#include "qaudiohelpers_p.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qmath.h>
+#include <QtCore/private/qsimd_p.h>
+
+#include <numeric>
+
+QT_BEGIN_NAMESPACE
+
+static Q_LOGGING_CATEGORY(qLcAudioConverter, "qt.multimedia.audioconverter")
+
+namespace {
+
+// Filter length at the lower of the two rates; downsampling needs proportionally more
+constexpr int BaseTaps = 32;
+constexpr int MaxTaps = 256;
+// Rate pairs that would need more phases interpolate between the phases of this table
+constexpr int MaxTablePhases = 1024;
+// The passband ends a bit before the Nyquist frequency, to leave room for the transition
+constexpr double Cutoff = 0.95;
+
+constexpr float MinusThreeDb = float(M_SQRT1_2);
+
+QAudioFormat::ChannelConfig channelConfig(const QAudioFormat &format)
+{
+    QAudioFormat::ChannelConfig config = format.channelConfig();
+    if (config == QAudioFormat::ChannelConfigUnknown)
+        config = QAudioFormat::defaultChannelConfigForChannelCount(format.channelCount());
+    // positions that don't match the channels are no use
+    if (qPopulationCount(quint32(config)) != uint(format.channelCount()))
+        return QAudioFormat::ChannelConfigUnknown;
+    return config;
+}
+
+int channelOffset(QAudioFormat::ChannelConfig config, int position)
+{
+    if (!(config & (1u << position)))
+        return -1;
+    return qPopulationCount(config & ((1u << position) - 1));
+}
+
+enum class Side { Left, Right, Center, LowFrequency };
+
+Side side(int position)
+{
+    switch (position) {
+    case QAudioFormat::FrontLeft:
+    case QAudioFormat::BackLeft:
+    case QAudioFormat::FrontLeftOfCenter:
+    case QAudioFormat::SideLeft:
+    case QAudioFormat::TopFrontLeft:
+    case QAudioFormat::TopBackLeft:
+    case QAudioFormat::TopSideLeft:
+    case QAudioFormat::BottomFrontLeft:
+        return Side::Left;
+    case QAudioFormat::FrontRight:
+    case QAudioFormat::BackRight:
+    case QAudioFormat::FrontRightOfCenter:
+    case QAudioFormat::SideRight:
+    case QAudioFormat::TopFrontRight:
+    case QAudioFormat::TopBackRight:
+    case QAudioFormat::TopSideRight:
+    case QAudioFormat::BottomFrontRight:
+        return Side::Right;
+    case QAudioFormat::LFE:
+    case QAudioFormat::LFE2:
+        return Side::LowFrequency;
+    default:
+        return Side::Center;
+    }
+}
+
+bool isFront(int position)
+{
+    switch (position) {
+    case QAudioFormat::FrontLeft:
+    case QAudioFormat::FrontRight:
+    case QAudioFormat::FrontCenter:
+    case QAudioFormat::FrontLeftOfCenter:
+    case QAudioFormat::FrontRightOfCenter:
+    case QAudioFormat::TopFrontLeft:
+    case QAudioFormat::TopFrontCenter:
+    case QAudioFormat::TopFrontRight:
+    case QAudioFormat::BottomFrontCenter:
+    case QAudioFormat::BottomFrontLeft:
+    case QAudioFormat::BottomFrontRight:
+        return true;
+    default:
+        return false;
+    }
+}
+
+float dotProduct(const float *a, const float *b, int count)
+{
+    int i = 0;
+    float sum = 0.f;
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    const __m128 acc = _mm_add_ps(acc0, acc1);
+    const __m128 pairs = _mm_add_ps(acc, _mm_shuffle_ps(acc, acc, _MM_SHUFFLE(2, 3, 0, 1)));
+    sum = _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.f);
+    float32x4_t acc1 = vdupq_n_f32(0.f);
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    const float32x4_t acc = vaddq_f32(acc0, acc1);
+    const float32x2_t pairs = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    sum = vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+#endif
+    for (; i < count; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+void deinterleaveStereo(const float *in, float *left, float *right, qsizetype frames)
+{
+    qsizetype i = 0;
+#if defined(__SSE2__)
+    for (; i + 4 <= frames; i += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * i);
+        const __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+        _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 4 <= frames; i += 4) {
+        const float32x4x2_t v = vld2q_f32(in + 2 * i);
+        vst1q_f32(left + i, v.val[0]);
+        vst1q_f32(right + i, v.val[1]);
+    }
+#endif
+    for (; i < frames; ++i) {
+        left[i] = in[2 * i];
+        right[i] = in[2 * i + 1];
+    }
+}
+
+bool isIdentity(const QList<float> &matrix, int inputs, int outputs)
+{
+    if (inputs != outputs)
+        return false;
+    for (int o = 0; o < outputs; ++o) {
+        for (int i = 0; i < inputs; ++i) {
+            if (matrix[o * inputs + i] != (o == i ? 1.f : 0.f))
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+QAudioConverter::QAudioConverter(const QAudioFormat &inputFormat, const QAudioFormat &outputFormat)
+    : m_inputFormat(inputFormat), m_outputFormat(outputFormat)
+{
+    if (!isValid()) {
+        qCWarning(qLcAudioConverter) << "Can't convert from" << inputFormat << "to" << outputFormat;
+        return;
+    }
+
+    m_inputChannels = inputFormat.channelCount();
+    m_outputChannels = outputFormat.channelCount();
+    m_matrix = channelMatrix(inputFormat, outputFormat);
+    m_mixChannels = !isIdentity(m_matrix, m_inputChannels, m_outputChannels);
+    m_resample = inputFormat.sampleRate() != outputFormat.sampleRate();
+    if (m_resample)
+        initResampler();
+}
+
+QAudioConverter::~QAudioConverter() = default;
+
+bool QAudioConverter::isValid() const
+{
+    return m_inputFormat.isValid() && m_outputFormat.isValid();
+}
+
+QList<float> QAudioConverter::channelMatrix(const QAudioFormat &from, const QAudioFormat &to)
+{
+    const int inputs = from.channelCount();
+    const int outputs = to.channelCount();
+    if (inputs <= 0 || outputs <= 0)
+        return {};
+
+    QList<float> matrix(inputs * outputs, 0.f);
+    auto weight = [&](int output, int input) -> float & { return matrix[output * inputs + input]; };
+
+    const QAudioFormat::ChannelConfig fromConfig = channelConfig(from);
+    const QAudioFormat::ChannelConfig toConfig = channelConfig(to);
+
+    if (inputs == 1) {
+        // mono plays at full level on the front speakers, or on all of them if there are none
+        bool front = false;
+        for (int position : { QAudioFormat::FrontLeft, QAudioFormat::FrontRight, QAudioFormat::FrontCenter }) {
+            const int output = channelOffset(toConfig, position);
+            if (output >= 0) {
+                weight(output, 0) = 1.f;
+                front = true;
+            }
+        }
+        for (int output = 0; !front && output < outputs; ++output)
+            weight(output, 0) = 1.f;
+        return matrix;
+    }
+
+    if (fromConfig == QAudioFormat::ChannelConfigUnknown || toConfig == QAudioFormat::ChannelConfigUnknown) {
+        // without positions, channels map by their index, and a mono output gets all of them
+        for (int output = 0; output < outputs; ++output) {
+            for (int input = 0; input < inputs; ++input) {
+                if (outputs == 1 || input == output)
+                    weight(output, input) = 1.f;
+            }
+        }
+    } else {
+        for (int position = 0; position < QAudioFormat::NChannelPositions; ++position) {
+            const int input = channelOffset(fromConfig, position);
+            if (input < 0)
+                continue;
+
+            auto add = [&](int target, float gain) {
+                const int output = channelOffset(toConfig, target);
+                if (output < 0)
+                    return false;
+                weight(output, input) += gain;
+                return true;
+            };
+            auto addPair = [&](int left, int right, float gain) {
+                if (channelOffset(toConfig, left) < 0 || channelOffset(toConfig, right) < 0)
+                    return false;
+                return add(left, gain) && add(right, gain);
+            };
+
+            if (add(position, 1.f))
+                continue;
+
+            // surround channels move to their neighbours first
+            bool mapped = false;
+            switch (position) {
+            case QAudioFormat::BackLeft:
+                mapped = add(QAudioFormat::SideLeft, 1.f);
+                break;
+            case QAudioFormat::BackRight:
+                mapped = add(QAudioFormat::SideRight, 1.f);
+                break;
+            case QAudioFormat::SideLeft:
+                mapped = add(QAudioFormat::BackLeft, 1.f);
+                break;
+            case QAudioFormat::SideRight:
+                mapped = add(QAudioFormat::BackRight, 1.f);
+                break;
+            case QAudioFormat::BackCenter:
+                mapped = addPair(QAudioFormat::BackLeft, QAudioFormat::BackRight, MinusThreeDb)
+                        || addPair(QAudioFormat::SideLeft, QAudioFormat::SideRight, MinusThreeDb);
+                break;
+            case QAudioFormat::LFE:
+                mapped = add(QAudioFormat::LFE2, 1.f);
+                break;
+            case QAudioFormat::LFE2:
+                mapped = add(QAudioFormat::LFE, 1.f);
+                break;
+            default:
+                break;
+            }
+            if (mapped)
+                continue;
+
+            // otherwise into the front, attenuated if it comes from elsewhere
+            const float gain = isFront(position) ? 1.f : MinusThreeDb;
+            switch (side(position)) {
+            case Side::Left:
+                add(QAudioFormat::FrontLeft, gain) || add(QAudioFormat::FrontCenter, gain * MinusThreeDb);
+                break;
+            case Side::Right:
+                add(QAudioFormat::FrontRight, gain) || add(QAudioFormat::FrontCenter, gain * MinusThreeDb);
+                break;
+            case Side::Center:
+                addPair(QAudioFormat::FrontLeft, QAudioFormat::FrontRight, gain * MinusThreeDb)
+                        || add(QAudioFormat::FrontCenter, gain);
+                break;
+            case Side::LowFrequency:
+                // dropped, like most downmixes do
+                break;
+            }
+        }
+    }
+
+    // scale down the outputs that would otherwise clip at full scale inputs
+    for (int output = 0; output < outputs; ++output) {
+        float sum = 0.f;
+        for (int input = 0; input < inputs; ++input)
+            sum += qAbs(weight(output, input));
+        if (sum > 1.f) {
+            for (int input = 0; input < inputs; ++input)
+                weight(output, input) /= sum;
+        }
+    }
+    return matrix;
+}
+
+void QAudioConverter::initResampler()
+{
+    const int inputRate = m_inputFormat.sampleRate();
+    const int outputRate = m_outputFormat.sampleRate();
+    const int divisor = std::gcd(inputRate, outputRate);
+    m_interpolation = outputRate / divisor;
+    m_decimation = inputRate / divisor;
+    m_tablePhases = qMin(m_interpolation, MaxTablePhases);
+
+    // relative to the input rate; below the Nyquist frequency of the lower rate
+    const double ratio = qMin(1., double(m_interpolation) / m_decimation);
+    const double cutoff = 0.5 * Cutoff * ratio;
+    m_taps = qMin(int(std::ceil(BaseTaps / ratio)), MaxTaps);
+    m_taps = (m_taps + 7) & ~7; // whole SIMD blocks
+
+    // Windowed sinc, one phase for every fraction of an input sample that an
+    // output sample can fall on. The extra phase is the first one shifted by a
+    // sample, for interpolating past the last one.
+    const int center = m_taps / 2 - 1;
+    m_filter.resize(size_t(m_tablePhases + 1) * m_taps);
+    for (int phase = 0; phase <= m_tablePhases; ++phase) {
+        float *coefficients = m_filter.data() + size_t(phase) * m_taps;
+        const double fraction = double(phase) / m_tablePhases;
+        double sum = 0.;
+        for (int tap = 0; tap < m_taps; ++tap) {
+            const double x = tap - center - fraction;
+            const double u = (x + m_taps / 2.) / m_taps; // position in the Blackman window
+            const double window = 0.42 - 0.5 * std::cos(2 * M_PI * u) + 0.08 * std::cos(4 * M_PI * u);
+            const double sinc = x == 0. ? 1. : std::sin(2 * M_PI * cutoff * x) / (2 * M_PI * cutoff * x);
+            coefficients[tap] = float(sinc * window);
+            sum += coefficients[tap];
+        }
+        // unity gain at DC
+        for (int tap = 0; tap < m_taps; ++tap)
+            coefficients[tap] = float(coefficients[tap] / sum);
+    }
+
+    m_planes.resize(m_outputChannels);
+    reset();
+}
+
+void QAudioConverter::reset()
+{
+    m_phase = 0;
+    m_position = 0;
+    // the filter looks ahead by half of its length, so it starts on silence
+    for (auto &plane : m_planes)
+        plane.assign(m_taps / 2 - 1, 0.f);
+}
+
+void QAudioConverter::mixChannels(const float *in, float *out, qsizetype frames) const
+{
+    for (qsizetype frame = 0; frame < frames; ++frame, in += m_inputChannels) {
+        const float *weights = m_matrix.constData();
+        for (int output = 0; output < m_outputChannels; ++output, weights += m_inputChannels) {
+            float sum = 0.f;
+            for (int input = 0; input < m_inputChannels; ++input)
+                sum += weights[input] * in[input];
+            *out++ = sum;
+        }
+    }
+}
+
+// Appends the frames to the planes of the resampler, mixing the channels on the way
+void QAudioConverter::mixToPlanes(const float *in, qsizetype frames)
+{
+    const size_t start = m_planes.front().size();
+    for (auto &plane : m_planes)
+        plane.resize(start + frames);
+
+    if (m_mixChannels) {
+        for (int output = 0; output < m_outputChannels; ++output) {
+            const float *weights = m_matrix.constData() + output * m_inputChannels;
+            float *out = m_planes[output].data() + start;
+            for (qsizetype frame = 0; frame < frames; ++frame) {
+                const float *samples = in + frame * m_inputChannels;
+                float sum = 0.f;
+                for (int input = 0; input < m_inputChannels; ++input)
+                    sum += weights[input] * samples[input];
+                out[frame] = sum;
+            }
+        }
+    } else if (m_inputChannels == 2) {
+        deinterleaveStereo(in, m_planes[0].data() + start, m_planes[1].data() + start, frames);
+    } else {
+        for (int channel = 0; channel < m_inputChannels; ++channel) {
+            float *out = m_planes[channel].data() + start;
+            for (qsizetype frame = 0; frame < frames; ++frame)
+                out[frame] = in[frame * m_inputChannels + channel];
+        }
+    }
+}
+
+// Filters the planes into interleaved frames in m_outputBuffer, and returns how many
+qsizetype QAudioConverter::resample()
+{
+    const qsizetype available = qsizetype(m_planes.front().size());
+    if (available < m_position + m_taps)
+        return 0;
+
+    const qsizetype maxFrames =
+            (qint64(available - m_position) * m_interpolation) / m_decimation + 2;
+    m_outputBuffer.resize(maxFrames * m_outputChannels);
+    float *out = m_outputBuffer.data();
+
+    qsizetype index = m_position;
+    qsizetype frames = 0;
+    while (index + m_taps <= available) {
+        // the phase in the table, and how far the output is towards the next one
+        const qint64 tablePosition = qint64(m_phase) * m_tablePhases;
+        const int tablePhase = int(tablePosition / m_interpolation);
+        const float t = float(tablePosition % m_interpolation) / m_interpolation;
+        const float *coefficients = m_filter.data() + size_t(tablePhase) * m_taps;
+
+        for (int channel = 0; channel < m_outputChannels; ++channel) {
+            const float *samples = m_planes[channel].data() + index;
+            float value = dotProduct(coefficients, samples, m_taps);
+            if (t != 0.f)
+                value += t * (dotProduct(coefficients + m_taps, samples, m_taps) - value);
+            *out++ = value;
+        }
+        ++frames;
+
+        m_phase += m_decimation;
+        index += m_phase / m_interpolation;
+        m_phase %= m_interpolation;
+    }
+
+    // keep what the next frames are computed from
+    const qsizetype consumed = qMin(index, available);
+    for (auto &plane : m_planes)
+        plane.erase(plane.begin(), plane.begin() + consumed);
+    m_position = index - consumed;
+    return frames;
+}
+
+QByteArray QAudioConverter::process(const float *in, qsizetype frames)
+{
+    const float *out = in;
+    qsizetype outputFrames = frames;
+    if (m_resample) {
+        mixToPlanes(in, frames);
+        outputFrames = resample();
+        out = m_outputBuffer.data();
+    } else if (m_mixChannels) {
+        m_mixBuffer.resize(frames * m_outputChannels);
+        mixChannels(in, m_mixBuffer.data(), frames);
+        out = m_mixBuffer.data();
+    }
+
+    QByteArray result(outputFrames * m_outputFormat.bytesPerFrame(), Qt::Uninitialized);
+    QAudioHelperInternal::qConvertSamplesFromFloat(out, m_outputFormat, result.data(),
+                                                   outputFrames * m_outputChannels);
+    return result;
+}
+
+QByteArray QAudioConverter::convert(const char *data, qsizetype size)
+{
+    if (!isValid())
+        return {};
+
+    const qsizetype frames = size / m_inputFormat.bytesPerFrame();
+    const qsizetype samples = frames * m_inputChannels;
+    if (!m_resample && !m_mixChannels) {
+        if (m_inputFormat.sampleFormat() == m_outputFormat.sampleFormat())
+            return QByteArray(data, frames * m_inputFormat.bytesPerFrame());
+        // only the sample format changes, which doesn't need the float buffer on either end
+        if (m_outputFormat.sampleFormat() == QAudioFormat::Float) {
+            QByteArray result(samples * sizeof(float), Qt::Uninitialized);
+            QAudioHelperInternal::qConvertSamplesToFloat(m_inputFormat, data,
+                                                         reinterpret_cast<float *>(result.data()), samples);
+            return result;
+        }
+    }
+
+    const float *in = reinterpret_cast<const float *>(data);
+    const bool aligned = (quintptr(data) % alignof(float)) == 0;
+    if (m_inputFormat.sampleFormat() != QAudioFormat::Float || !aligned) {
+        m_inputBuffer.resize(samples);
+        QAudioHelperInternal::qConvertSamplesToFloat(m_inputFormat, data, m_inputBuffer.data(), samples);
+        in = m_inputBuffer.data();
+    }
+    return process(in, frames);
+}
+
+QAudioBuffer QAudioConverter::convert(const QAudioBuffer &buffer)
+{
+    const QAudioFormat format = buffer.format();
+    if (format.sampleFormat() != m_inputFormat.sampleFormat()
+        || format.channelCount() != m_inputFormat.channelCount()
+        || format.sampleRate() != m_inputFormat.sampleRate()) {
+        qCWarning(qLcAudioConverter) << "Buffer in" << format << "doesn't match" << m_inputFormat;
+        return {};
+    }
+    return QAudioBuffer(convert(buffer.constData<char>(), buffer.byteCount()), m_outputFormat,
+                        buffer.startTime());
+}
+
+QByteArray QAudioConverter::flush()
+{
+    if (!isValid() || !m_resample)
+        return {};
+
+    // pushes the input that the filter still has to look past out of it
+    const std::vector<float> silence(size_t(m_taps / 2) * m_inputChannels, 0.f);
+    const QByteArray result = process(silence.data(), m_taps / 2);
+    reset();
+    return result;
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,98 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QAUDIOCONVERTER_P_H
+#define QAUDIOCONVERTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qaudiobuffer.h>
+#include <qaudioformat.h>
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qlist.h>
+
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+// Converts a stream of audio between sample formats, channel layouts and sample
+// rates. All conversions go through float samples; channels are mixed with a
+// matrix derived from the channel positions of the formats, and the rate is
+// changed with a polyphase windowed sinc filter. The resampler keeps the end of
+// every chunk to filter the next one with, so a converter handles one stream
+// and isn't thread-safe.
+//
+// It's exported for the sample cache, the plugins and the tests, but it stays
+// private API: the filter and the mixing rules are still
+// expected to change, and a public class would freeze them, and its layout, for
+// the lifetime of the ABI. Applications get converted audio from QAudioDecoder,
+// whose output format can be set, and from QSoundEffect.
+class Q_MULTIMEDIA_EXPORT QAudioConverter
+{
+public:
+    QAudioConverter(const QAudioFormat &inputFormat, const QAudioFormat &outputFormat);
+    ~QAudioConverter();
+
+    QAudioFormat inputFormat() const { return m_inputFormat; }
+    QAudioFormat outputFormat() const { return m_outputFormat; }
+    bool isValid() const;
+
+    QByteArray convert(const char *data, qsizetype size);
+    QAudioBuffer convert(const QAudioBuffer &buffer);
+
+    // Returns what is left in the resampler at the end of the stream, and resets it
+    QByteArray flush();
+    void reset();
+
+    // The weights of the input channels in each output channel; row major,
+    // with a row for every output channel.
+    static QList<float> channelMatrix(const QAudioFormat &from, const QAudioFormat &to);
+
+private:
+    Q_DISABLE_COPY(QAudioConverter)
+
+    void initResampler();
+    qsizetype resample();
+    void mixChannels(const float *in, float *out, qsizetype frames) const;
+    void mixToPlanes(const float *in, qsizetype frames);
+    QByteArray process(const float *in, qsizetype frames);
+
+    QAudioFormat m_inputFormat;
+    QAudioFormat m_outputFormat;
+    int m_inputChannels = 0;
+    int m_outputChannels = 0;
+
+    QList<float> m_matrix;
+    bool m_mixChannels = false;
+
+    // polyphase resampler, steps through the input by m_decimation / m_interpolation
+    bool m_resample = false;
+    int m_interpolation = 1;
+    int m_decimation = 1;
+    int m_taps = 0;
+    int m_tablePhases = 0; // m_interpolation, or fewer which are interpolated
+    std::vector<float> m_filter; // m_tablePhases + 1 phases of m_taps coefficients
+    int m_phase = 0;
+    // the input waiting to be filtered, one plane for every output channel,
+    // and where in them the next output frame starts
+    std::vector<std::vector<float>> m_planes;
+    qsizetype m_position = 0;
+
+    std::vector<float> m_inputBuffer;
+    std::vector<float> m_mixBuffer;
+    std::vector<float> m_outputBuffer;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -4,36 +4,316 @@
 #include "qaudiohelpers_p.h"
 
 #include <QDebug>
+#include <QtCore/private/qsimd_p.h>
+
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <type_traits>
 
 QT_BEGIN_NAMESPACE
 
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+// Defined in qaudiohelpers_avx2.cpp. They process whole blocks of samples and
+// return how many they processed, the rest is left to the kernels below.
+qsizetype qt_multiplySamples_int16_avx2(float factor, const qint16 *src, qint16 *dst, qsizetype count);
+qsizetype qt_multiplySamples_float_avx2(float factor, const float *src, float *dst, qsizetype count);
+qsizetype qt_mixSamples_int16_avx2(float factor, const qint16 *src, qint16 *dst, qsizetype count);
+qsizetype qt_mixSamples_float_avx2(float factor, const float *src, float *dst, qsizetype count);
+qsizetype qt_mixSamples_int16_to_float_avx2(float factor, const qint16 *src, float *dst, qsizetype count);
+qsizetype qt_convertSamples_int16_to_float_avx2(const qint16 *src, float *dst, qsizetype count);
+qsizetype qt_convertSamples_float_to_int16_avx2(const float *src, qint16 *dst, qsizetype count);
+#endif
+
 namespace QAudioHelperInternal
 {
 
-template<class T> void adjustSamples(qreal factor, const void *src, void *dst, int samples)
+// Integer samples are handled as signed values, unsigned ones are biased around 0x80.
+// 32 bit samples are computed in double precision, as float can't represent all of them.
+template<class T> struct Sample
 {
-    const T *pSrc = (const T *)src;
-    T *pDst = (T*)dst;
-    for ( int i = 0; i < samples; i++ )
-        pDst[i] = pSrc[i] * factor;
-}
+    using Compute = std::conditional_t<(sizeof(T) >= 4), double, float>;
+    static constexpr Compute offset = std::is_signed_v<T> ? 0 : Compute(1 << (8 * sizeof(T) - 1));
+    static constexpr Compute min = Compute(std::numeric_limits<T>::min()) - offset;
+    static constexpr Compute max = Compute(std::numeric_limits<T>::max()) - offset;
+
+    static Compute value(T sample) { return Compute(sample) - offset; }
+    static T fromValue(Compute value)
+    {
+        // clip before rounding, so that overdriven samples don't wrap around
+        return T(qRound64(qBound(min, value, max)) + qint64(offset));
+    }
+};
 
-// Unsigned samples are biased around 0x80/0x8000 :/
-// This makes a pure template solution a bit unwieldy but possible
-template<class T> struct signedVersion {};
-template<> struct signedVersion<quint8>
+template<> struct Sample<float>
 {
-    using TS = qint8;
-    static constexpr int offset = 0x80;
+    using Compute = float;
+    static constexpr float max = 1.f;
+
+    static float value(float sample) { return sample; }
+    static float fromValue(float value) { return value; }
 };
 
-template<class T> void adjustUnsignedSamples(qreal factor, const void *src, void *dst, int samples)
+template<class T> void multiplySamples(float factor, const T *src, T *dst, qsizetype from, qsizetype count)
+{
+    for (qsizetype i = from; i < count; ++i)
+        dst[i] = Sample<T>::fromValue(Sample<T>::value(src[i]) * factor);
+}
+
+template<class T> void multiplySamplesRamped(float from, float to, int channels, const T *src, T *dst,
+                                             qsizetype frames)
+{
+    const float step = (to - from) / frames;
+    for (qsizetype frame = 0; frame < frames; ++frame) {
+        const float factor = from + step * frame;
+        for (int c = 0; c < channels; ++c, ++src, ++dst)
+            *dst = Sample<T>::fromValue(Sample<T>::value(*src) * factor);
+    }
+}
+
+template<class T> void mixSamples(float factor, const T *src, T *dst, qsizetype from, qsizetype count)
+{
+    for (qsizetype i = from; i < count; ++i)
+        dst[i] = Sample<T>::fromValue(Sample<T>::value(dst[i]) + Sample<T>::value(src[i]) * factor);
+}
+
+template<class T> void mixSamplesToFloat(float factor, const T *src, float *dst, qsizetype from, qsizetype count)
+{
+    // the factor includes the normalization
+    for (qsizetype i = from; i < count; ++i)
+        dst[i] += float(Sample<T>::value(src[i]) * factor);
+}
+
+template<class T> void convertSamplesToFloat(const T *src, float *dst, qsizetype from, qsizetype count)
+{
+    for (qsizetype i = from; i < count; ++i)
+        dst[i] = float(Sample<T>::value(src[i]) / Sample<T>::max);
+}
+
+template<class T> void convertSamplesFromFloat(const float *src, T *dst, qsizetype from, qsizetype count)
+{
+    using Compute = typename Sample<T>::Compute;
+    for (qsizetype i = from; i < count; ++i)
+        dst[i] = Sample<T>::fromValue(Compute(qBound(-1.f, src[i], 1.f)) * Sample<T>::max);
+}
+
+#if defined(__SSE2__)
+// Rounds half away from zero like qRound(), where _mm_cvtps_epi32 would round half to even.
+// The values are clipped beforehand, so the truncation can't overflow.
+static inline __m128i roundToInt(__m128 v)
+{
+    const __m128 half = _mm_or_ps(_mm_and_ps(v, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f));
+    return _mm_cvttps_epi32(_mm_add_ps(v, half));
+}
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+// Rounds half away from zero like qRound(). vcvtq_s32_f32 truncates, but saturates.
+static inline int32x4_t roundToInt(float32x4_t v)
+{
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(v), vdupq_n_u32(0x80000000));
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    return vcvtq_s32_f32(vaddq_f32(v, half));
+}
+#endif
+
+static void multiplyInt16(float factor, const qint16 *src, qint16 *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_multiplySamples_int16_avx2(factor, src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(factor);
+    const __m128 min = _mm_set1_ps(Sample<qint16>::min);
+    const __m128 max = _mm_set1_ps(Sample<qint16>::max);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        // sign extend to 32 bits
+        const __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        const __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        // clip before converting, out of range values would turn into INT_MIN
+        const __m128i rlo = roundToInt(_mm_min_ps(_mm_max_ps(_mm_mul_ps(lo, g), min), max));
+        const __m128i rhi = roundToInt(_mm_min_ps(_mm_max_ps(_mm_mul_ps(hi, g), min), max));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(rlo, rhi));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(factor);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        // the conversion and the narrowing both saturate
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(roundToInt(vmulq_f32(lo, g))),
+                                        vqmovn_s32(roundToInt(vmulq_f32(hi, g)))));
+    }
+#endif
+    multiplySamples<qint16>(factor, src, dst, i, count);
+}
+
+static void multiplyFloat(float factor, const float *src, float *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_multiplySamples_float_avx2(factor, src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(factor);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(factor);
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(dst + i, vmulq_f32(vld1q_f32(src + i), g));
+#endif
+    multiplySamples<float>(factor, src, dst, i, count);
+}
+
+static void mixInt16(float factor, const qint16 *src, qint16 *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_mixSamples_int16_avx2(factor, src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(factor);
+    const __m128 min = _mm_set1_ps(Sample<qint16>::min);
+    const __m128 max = _mm_set1_ps(Sample<qint16>::max);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        const __m128 slo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        const __m128 shi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        const __m128 dlo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(d, d), 16));
+        const __m128 dhi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(d, d), 16));
+        const __m128 lo = _mm_add_ps(dlo, _mm_mul_ps(slo, g));
+        const __m128 hi = _mm_add_ps(dhi, _mm_mul_ps(shi, g));
+        const __m128i rlo = roundToInt(_mm_min_ps(_mm_max_ps(lo, min), max));
+        const __m128i rhi = roundToInt(_mm_min_ps(_mm_max_ps(hi, min), max));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packs_epi32(rlo, rhi));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(factor);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        const int16x8_t d = vld1q_s16(dst + i);
+        const float32x4_t lo = vmlaq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(d))),
+                                         vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), g);
+        const float32x4_t hi = vmlaq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(d))),
+                                         vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), g);
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(roundToInt(lo)), vqmovn_s32(roundToInt(hi))));
+    }
+#endif
+    mixSamples<qint16>(factor, src, dst, i, count);
+}
+
+static void mixFloat(float factor, const float *src, float *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_mixSamples_float_avx2(factor, src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(factor);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), g)));
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(factor);
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), vld1q_f32(src + i), g));
+#endif
+    mixSamples<float>(factor, src, dst, i, count);
+}
+
+static void mixInt16ToFloat(float factor, const qint16 *src, float *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_mixSamples_int16_to_float_avx2(factor, src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 g = _mm_set1_ps(factor);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_cvtepi32_ps(lo), g)));
+        _mm_storeu_ps(dst + i + 4,
+                      _mm_add_ps(_mm_loadu_ps(dst + i + 4), _mm_mul_ps(_mm_cvtepi32_ps(hi), g)));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t g = vdupq_n_f32(factor);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(s)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(s)));
+        vst1q_f32(dst + i, vmlaq_f32(vld1q_f32(dst + i), lo, g));
+        vst1q_f32(dst + i + 4, vmlaq_f32(vld1q_f32(dst + i + 4), hi, g));
+    }
+#endif
+    mixSamplesToFloat<qint16>(factor, src, dst, i, count);
+}
+
+static void convertInt16ToFloat(const qint16 *src, float *dst, qsizetype count)
+{
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_convertSamples_int16_to_float_avx2(src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(1.f / Sample<qint16>::max);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t scale = vdupq_n_f32(1.f / Sample<qint16>::max);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t s = vld1q_s16(src + i);
+        vst1q_f32(dst + i, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(s))), scale));
+        vst1q_f32(dst + i + 4, vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(s))), scale));
+    }
+#endif
+    convertSamplesToFloat<qint16>(src, dst, i, count);
+}
+
+static void convertFloatToInt16(const float *src, qint16 *dst, qsizetype count)
 {
-    const T *pSrc = (const T *)src;
-    T *pDst = (T*)dst;
-    for ( int i = 0; i < samples; i++ ) {
-        pDst[i] = signedVersion<T>::offset + ((typename signedVersion<T>::TS)(pSrc[i] - signedVersion<T>::offset) * factor);
+    qsizetype i = 0;
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+    if (qCpuHasFeature(AVX2))
+        i = qt_convertSamples_float_to_int16_avx2(src, dst, count);
+#endif
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(Sample<qint16>::max);
+    const __m128 min = _mm_set1_ps(-1.f);
+    const __m128 max = _mm_set1_ps(1.f);
+    for (; i + 8 <= count; i += 8) {
+        const __m128 lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), min), max);
+        const __m128 hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4), min), max);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                         _mm_packs_epi32(roundToInt(_mm_mul_ps(lo, scale)),
+                                         roundToInt(_mm_mul_ps(hi, scale))));
     }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    const float32x4_t scale = vdupq_n_f32(Sample<qint16>::max);
+    const float32x4_t min = vdupq_n_f32(-1.f);
+    const float32x4_t max = vdupq_n_f32(1.f);
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t lo = vminq_f32(vmaxq_f32(vld1q_f32(src + i), min), max);
+        const float32x4_t hi = vminq_f32(vmaxq_f32(vld1q_f32(src + i + 4), min), max);
+        vst1q_s16(dst + i, vcombine_s16(vqmovn_s32(roundToInt(vmulq_f32(lo, scale))),
+                                        vqmovn_s32(roundToInt(vmulq_f32(hi, scale)))));
+    }
+#endif
+    convertSamplesFromFloat<qint16>(src, dst, i, count);
 }
 
 void qMultiplySamples(qreal factor, const QAudioFormat &format, const void* src, void* dest, int len)
@@ -45,19 +325,216 @@ void qMultiplySamples(qreal factor, const QAudioFormat &format, const void* src,
     case QAudioFormat::NSampleFormats:
         return;
     case QAudioFormat::UInt8:
-        QAudioHelperInternal::adjustUnsignedSamples<quint8>(factor,src,dest,samplesCount);
+        multiplySamples<quint8>(factor, static_cast<const quint8 *>(src), static_cast<quint8 *>(dest),
+                                0, samplesCount);
+        break;
+    case QAudioFormat::Int16:
+        multiplyInt16(factor, static_cast<const qint16 *>(src), static_cast<qint16 *>(dest), samplesCount);
+        break;
+    case QAudioFormat::Int32:
+        multiplySamples<qint32>(factor, static_cast<const qint32 *>(src), static_cast<qint32 *>(dest),
+                                0, samplesCount);
+        break;
+    case QAudioFormat::Float:
+        multiplyFloat(factor, static_cast<const float *>(src), static_cast<float *>(dest), samplesCount);
+        break;
+    }
+}
+
+void qMultiplySamples(qreal fromFactor, qreal toFactor, const QAudioFormat &format, const void *src,
+                      void *dest, int len)
+{
+    const int framesCount = len / qMax(1, format.bytesPerFrame());
+    if (qFuzzyCompare(fromFactor, toFactor) || framesCount <= 1) {
+        qMultiplySamples(toFactor, format, src, dest, len);
+        return;
+    }
+
+    const int channels = format.channelCount();
+    switch (format.sampleFormat()) {
+    case QAudioFormat::Unknown:
+    case QAudioFormat::NSampleFormats:
+        return;
+    case QAudioFormat::UInt8:
+        multiplySamplesRamped<quint8>(fromFactor, toFactor, channels, static_cast<const quint8 *>(src),
+                                      static_cast<quint8 *>(dest), framesCount);
+        break;
+    case QAudioFormat::Int16:
+        multiplySamplesRamped<qint16>(fromFactor, toFactor, channels, static_cast<const qint16 *>(src),
+                                      static_cast<qint16 *>(dest), framesCount);
+        break;
+    case QAudioFormat::Int32:
+        multiplySamplesRamped<qint32>(fromFactor, toFactor, channels, static_cast<const qint32 *>(src),
+                                      static_cast<qint32 *>(dest), framesCount);
+        break;
+    case QAudioFormat::Float:
+        multiplySamplesRamped<float>(fromFactor, toFactor, channels, static_cast<const float *>(src),
+                                     static_cast<float *>(dest), framesCount);
+        break;
+    }
+}
+
+void qMixSamples(qreal factor, const QAudioFormat &format, const void *src, void *dest, int len)
+{
+    const int samplesCount = len / qMax(1, format.bytesPerSample());
+
+    switch (format.sampleFormat()) {
+    case QAudioFormat::Unknown:
+    case QAudioFormat::NSampleFormats:
+        return;
+    case QAudioFormat::UInt8:
+        mixSamples<quint8>(factor, static_cast<const quint8 *>(src), static_cast<quint8 *>(dest),
+                           0, samplesCount);
+        break;
+    case QAudioFormat::Int16:
+        mixInt16(factor, static_cast<const qint16 *>(src), static_cast<qint16 *>(dest), samplesCount);
+        break;
+    case QAudioFormat::Int32:
+        mixSamples<qint32>(factor, static_cast<const qint32 *>(src), static_cast<qint32 *>(dest),
+                           0, samplesCount);
+        break;
+    case QAudioFormat::Float:
+        mixFloat(factor, static_cast<const float *>(src), static_cast<float *>(dest), samplesCount);
+        break;
+    }
+}
+
+void qMixSamplesToFloat(float factor, const QAudioFormat &format, const void *src, float *dest, int len)
+{
+    const int samplesCount = len / qMax(1, format.bytesPerSample());
+
+    switch (format.sampleFormat()) {
+    case QAudioFormat::Unknown:
+    case QAudioFormat::NSampleFormats:
+        return;
+    case QAudioFormat::UInt8:
+        mixSamplesToFloat<quint8>(factor / Sample<quint8>::max, static_cast<const quint8 *>(src), dest,
+                                  0, samplesCount);
+        break;
+    case QAudioFormat::Int16:
+        mixInt16ToFloat(factor / Sample<qint16>::max, static_cast<const qint16 *>(src), dest, samplesCount);
+        break;
+    case QAudioFormat::Int32:
+        mixSamplesToFloat<qint32>(factor / Sample<qint32>::max, static_cast<const qint32 *>(src), dest,
+                                  0, samplesCount);
+        break;
+    case QAudioFormat::Float:
+        mixFloat(factor, static_cast<const float *>(src), dest, samplesCount);
+        break;
+    }
+}
+
+void qConvertSamplesToFloat(const QAudioFormat &format, const void *src, float *dest, int samples)
+{
+    switch (format.sampleFormat()) {
+    case QAudioFormat::Unknown:
+    case QAudioFormat::NSampleFormats:
+        return;
+    case QAudioFormat::UInt8:
+        convertSamplesToFloat<quint8>(static_cast<const quint8 *>(src), dest, 0, samples);
+        break;
+    case QAudioFormat::Int16:
+        convertInt16ToFloat(static_cast<const qint16 *>(src), dest, samples);
+        break;
+    case QAudioFormat::Int32:
+        convertSamplesToFloat<qint32>(static_cast<const qint32 *>(src), dest, 0, samples);
+        break;
+    case QAudioFormat::Float:
+        if (src != dest)
+            memcpy(dest, src, samples * sizeof(float));
+        break;
+    }
+}
+
+void qConvertSamplesFromFloat(const float *src, const QAudioFormat &format, void *dest, int samples)
+{
+    switch (format.sampleFormat()) {
+    case QAudioFormat::Unknown:
+    case QAudioFormat::NSampleFormats:
+        return;
+    case QAudioFormat::UInt8:
+        convertSamplesFromFloat<quint8>(src, static_cast<quint8 *>(dest), 0, samples);
         break;
     case QAudioFormat::Int16:
-        QAudioHelperInternal::adjustSamples<qint16>(factor,src,dest,samplesCount);
+        convertFloatToInt16(src, static_cast<qint16 *>(dest), samples);
         break;
     case QAudioFormat::Int32:
-        QAudioHelperInternal::adjustSamples<qint32>(factor,src,dest,samplesCount);
+        convertSamplesFromFloat<qint32>(src, static_cast<qint32 *>(dest), 0, samples);
         break;
     case QAudioFormat::Float:
-        QAudioHelperInternal::adjustSamples<float>(factor,src,dest,samplesCount);
+        if (src != dest)
+            memcpy(dest, src, samples * sizeof(float));
         break;
     }
 }
+
+void qMeasureSamples(const float *src, int channels, int frames, float *peak, float *sumOfSquares)
+{
+    if (channels <= 0 || frames <= 0)
+        return;
+
+    const qsizetype count = qsizetype(frames) * channels;
+    qsizetype i = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+    // Lane j of the k-th vector in a run of period vectors always holds channel
+    // (4 * k + j) % channels, so every vector of the run gets accumulators of its own.
+    // Channel counts with longer runs than fit in registers are left to the loop below.
+    constexpr int MaxPeriod = 8;
+    const int period = channels / std::gcd(channels, 4);
+    if (period <= MaxPeriod) {
+        const qsizetype step = 4 * period;
+        float peaks[4 * MaxPeriod];
+        float sums[4 * MaxPeriod];
+#if defined(__SSE2__)
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 p[MaxPeriod];
+        __m128 s[MaxPeriod];
+        for (int k = 0; k < period; ++k)
+            p[k] = s[k] = _mm_setzero_ps();
+        for (; i + step <= count; i += step) {
+            for (int k = 0; k < period; ++k) {
+                const __m128 v = _mm_loadu_ps(src + i + 4 * k);
+                p[k] = _mm_max_ps(p[k], _mm_and_ps(v, absMask));
+                s[k] = _mm_add_ps(s[k], _mm_mul_ps(v, v));
+            }
+        }
+        for (int k = 0; k < period; ++k) {
+            _mm_storeu_ps(peaks + 4 * k, p[k]);
+            _mm_storeu_ps(sums + 4 * k, s[k]);
+        }
+#else
+        float32x4_t p[MaxPeriod];
+        float32x4_t s[MaxPeriod];
+        for (int k = 0; k < period; ++k)
+            p[k] = s[k] = vdupq_n_f32(0.f);
+        for (; i + step <= count; i += step) {
+            for (int k = 0; k < period; ++k) {
+                const float32x4_t v = vld1q_f32(src + i + 4 * k);
+                p[k] = vmaxq_f32(p[k], vabsq_f32(v));
+                s[k] = vmlaq_f32(s[k], v, v);
+            }
+        }
+        for (int k = 0; k < period; ++k) {
+            vst1q_f32(peaks + 4 * k, p[k]);
+            vst1q_f32(sums + 4 * k, s[k]);
+        }
+#endif
+        for (int lane = 0; lane < step; ++lane) {
+            const int channel = lane % channels;
+            peak[channel] = qMax(peak[channel], peaks[lane]);
+            sumOfSquares[channel] += sums[lane];
+        }
+    }
+#endif
+    // step is a multiple of channels, so i starts at a frame boundary
+    for (; i < count; i += channels) {
+        for (int c = 0; c < channels; ++c) {
+            const float v = src[i + c];
+            peak[c] = qMax(peak[c], qAbs(v));
+            sumOfSquares[c] += v * v;
+        }
+    }
+}
 }
 
 QT_END_NAMESPACE
@@ -0,0 +1,115 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qaudiohelpers_p.h"
+
+#include <QtCore/private/qsimd_p.h>
+
+#include <limits>
+
+#ifdef QT_COMPILER_SUPPORTS_AVX2
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+inline __m256 loadInt16(const qint16 *src)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src))));
+}
+
+// Rounds half away from zero like qRound() and the SSE2 code
+inline __m256i roundToInt(__m256 v)
+{
+    const __m256 half = _mm256_or_ps(_mm256_and_ps(v, _mm256_set1_ps(-0.f)), _mm256_set1_ps(0.5f));
+    return _mm256_cvttps_epi32(_mm256_add_ps(v, half));
+}
+
+// Clips lo and hi to the range of qint16 and stores them as 16 samples
+inline void storeInt16(qint16 *dst, __m256 lo, __m256 hi)
+{
+    const __m256 min = _mm256_set1_ps(std::numeric_limits<qint16>::min());
+    const __m256 max = _mm256_set1_ps(std::numeric_limits<qint16>::max());
+    const __m256i rlo = roundToInt(_mm256_min_ps(_mm256_max_ps(lo, min), max));
+    const __m256i rhi = roundToInt(_mm256_min_ps(_mm256_max_ps(hi, min), max));
+    // packs works within 128 bit lanes, restore the order of the samples afterwards
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(rlo, rhi), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), packed);
+}
+
+} // namespace
+
+qsizetype qt_multiplySamples_int16_avx2(float factor, const qint16 *src, qint16 *dst, qsizetype count)
+{
+    const __m256 g = _mm256_set1_ps(factor);
+    qsizetype i = 0;
+    for (; i + 16 <= count; i += 16)
+        storeInt16(dst + i, _mm256_mul_ps(loadInt16(src + i), g), _mm256_mul_ps(loadInt16(src + i + 8), g));
+    return i;
+}
+
+qsizetype qt_multiplySamples_float_avx2(float factor, const float *src, float *dst, qsizetype count)
+{
+    const __m256 g = _mm256_set1_ps(factor);
+    qsizetype i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_loadu_ps(src + i), g));
+    return i;
+}
+
+qsizetype qt_mixSamples_int16_avx2(float factor, const qint16 *src, qint16 *dst, qsizetype count)
+{
+    const __m256 g = _mm256_set1_ps(factor);
+    qsizetype i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256 lo = _mm256_fmadd_ps(loadInt16(src + i), g, loadInt16(dst + i));
+        const __m256 hi = _mm256_fmadd_ps(loadInt16(src + i + 8), g, loadInt16(dst + i + 8));
+        storeInt16(dst + i, lo, hi);
+    }
+    return i;
+}
+
+qsizetype qt_mixSamples_float_avx2(float factor, const float *src, float *dst, qsizetype count)
+{
+    const __m256 g = _mm256_set1_ps(factor);
+    qsizetype i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), g, _mm256_loadu_ps(dst + i)));
+    return i;
+}
+
+qsizetype qt_mixSamples_int16_to_float_avx2(float factor, const qint16 *src, float *dst, qsizetype count)
+{
+    const __m256 g = _mm256_set1_ps(factor);
+    qsizetype i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_fmadd_ps(loadInt16(src + i), g, _mm256_loadu_ps(dst + i)));
+    return i;
+}
+
+qsizetype qt_convertSamples_int16_to_float_avx2(const qint16 *src, float *dst, qsizetype count)
+{
+    const __m256 scale = _mm256_set1_ps(1.f / std::numeric_limits<qint16>::max());
+    qsizetype i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_mul_ps(loadInt16(src + i), scale));
+    return i;
+}
+
+qsizetype qt_convertSamples_float_to_int16_avx2(const float *src, qint16 *dst, qsizetype count)
+{
+    const __m256 scale = _mm256_set1_ps(std::numeric_limits<qint16>::max());
+    const __m256 min = _mm256_set1_ps(-1.f);
+    const __m256 max = _mm256_set1_ps(1.f);
+    qsizetype i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256 lo = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i), min), max);
+        const __m256 hi = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src + i + 8), min), max);
+        storeInt16(dst + i, _mm256_mul_ps(lo, scale), _mm256_mul_ps(hi, scale));
+    }
+    return i;
+}
+
+QT_END_NAMESPACE
+
+#endif
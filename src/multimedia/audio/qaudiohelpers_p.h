@@ -22,7 +22,30 @@ QT_BEGIN_NAMESPACE
 
 namespace QAudioHelperInternal
 {
+// The functions below take the length of src in bytes. Integer samples are clipped
+// to their range instead of wrapping around.
+
+// dest = src * factor
 Q_MULTIMEDIA_EXPORT void qMultiplySamples(qreal factor, const QAudioFormat& format, const void *src, void* dest, int len);
+// Ramps the factor linearly from fromFactor to toFactor over the frames of src,
+// which avoids audible clicks when the volume changes
+Q_MULTIMEDIA_EXPORT void qMultiplySamples(qreal fromFactor, qreal toFactor, const QAudioFormat &format,
+                                          const void *src, void *dest, int len);
+// dest += src * factor, for mixing streams of the same format
+Q_MULTIMEDIA_EXPORT void qMixSamples(qreal factor, const QAudioFormat &format, const void *src, void *dest, int len);
+// dest += src * factor, with src normalized to [-1, 1]; for mixing into a float buffer
+Q_MULTIMEDIA_EXPORT void qMixSamplesToFloat(float factor, const QAudioFormat &format, const void *src, float *dest,
+                                            int len);
+// Converts samples in format to normalized float samples
+Q_MULTIMEDIA_EXPORT void qConvertSamplesToFloat(const QAudioFormat &format, const void *src, float *dest,
+                                                int samples);
+// Converts normalized float samples to format, clipping them to [-1, 1]
+Q_MULTIMEDIA_EXPORT void qConvertSamplesFromFloat(const float *src, const QAudioFormat &format, void *dest,
+                                                  int samples);
+// Accumulates the largest magnitude and the sum of the squares of each channel of
+// normalized float frames into peak and sumOfSquares, which have an entry per channel
+Q_MULTIMEDIA_EXPORT void qMeasureSamples(const float *src, int channels, int frames, float *peak,
+                                         float *sumOfSquares);
 }
 
 QT_END_NAMESPACE
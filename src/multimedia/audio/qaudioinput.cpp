@@ -8,6 +8,8 @@
 #include <private/qplatformaudioinput_p.h>
 #include <private/qplatformmediaintegration_p.h>
 
+#include <QtCore/qtimer.h>
+
 #include <utility>
 
 /*!
@@ -177,6 +179,214 @@ void QAudioInput::setDevice(const QAudioDevice &device)
     emit deviceChanged();
 }
 
+/*!
+    \qmlproperty bool QtMultimedia::AudioInput::levelMeteringEnabled
+    \since 6.6
+
+    This property holds whether the audio input measures the levels and the
+    spectrum of the audio it records, and updates \l peakLevels, \l rmsLevels
+    and \l spectrum.
+
+    Defaults to \c{false}.
+
+    \note Level metering is currently only supported by the FFmpeg media backend.
+*/
+
+/*!
+    \property QAudioInput::levelMeteringEnabled
+    \since 6.6
+    \brief Whether the levels of the audio are measured.
+
+    When enabled, the backend measures the audio that this input records on its
+    audio thread, and levelsChanged() is emitted every levelUpdateInterval
+    milliseconds with new values of peakLevels(), rmsLevels() and spectrum().
+    Disabling it clears them.
+
+    By default level metering is disabled, and costs nothing.
+
+    \note Level metering is currently only supported by the FFmpeg media backend.
+*/
+bool QAudioInput::isLevelMeteringEnabled() const
+{
+    return d->levelMeteringEnabled;
+}
+
+void QAudioInput::setLevelMeteringEnabled(bool enabled)
+{
+    if (d->levelMeteringEnabled == enabled)
+        return;
+    d->levelMeteringEnabled = enabled;
+
+    if (enabled) {
+        QAudioLevelMeter *meter = d->createLevelMeter();
+        meter->setInterval(d->levelUpdateInterval);
+        meter->setBandCount(d->spectrumBandCount);
+        meter->setEnabled(true);
+        if (!d->levelTimer) {
+            d->levelTimer = new QTimer(this);
+            connect(d->levelTimer, &QTimer::timeout, this, [this, meter] {
+                if (meter->takeLevels(&d->levels))
+                    emit levelsChanged();
+            });
+        }
+        d->levelTimer->start(d->levelUpdateInterval);
+    } else {
+        d->levelMeter()->setEnabled(false);
+        d->levelTimer->stop();
+        d->levels = {};
+        emit levelsChanged();
+    }
+    emit levelMeteringEnabledChanged(enabled);
+}
+
+/*!
+    \qmlproperty int QtMultimedia::AudioInput::levelUpdateInterval
+    \since 6.6
+
+    This property holds how often, in milliseconds, the levels are measured and
+    updated while \l levelMeteringEnabled is \c true.
+
+    Defaults to \c{50}; intervals shorter than 10 milliseconds are raised to 10.
+*/
+
+/*!
+    \property QAudioInput::levelUpdateInterval
+    \since 6.6
+    \brief How often the levels are updated, in milliseconds.
+
+    Each update measures the audio of one interval, so the peak levels are
+    those of the last interval. Intervals shorter than 10 milliseconds are
+    raised to 10.
+
+    By default the interval is 50 milliseconds.
+*/
+int QAudioInput::levelUpdateInterval() const
+{
+    return d->levelUpdateInterval;
+}
+
+void QAudioInput::setLevelUpdateInterval(int msecs)
+{
+    const int interval = qMax(msecs, QAudioLevelMeter::MinimumInterval);
+    if (d->levelUpdateInterval == interval)
+        return;
+    d->levelUpdateInterval = interval;
+
+    if (auto meter = d->levelMeter())
+        meter->setInterval(interval);
+    if (d->levelTimer && d->levelTimer->isActive())
+        d->levelTimer->start(interval);
+    emit levelUpdateIntervalChanged(interval);
+}
+
+/*!
+    \qmlproperty int QtMultimedia::AudioInput::spectrumBandCount
+    \since 6.6
+
+    This property holds the number of frequency bands in \l spectrum, up to 256.
+
+    Defaults to \c{0}, which leaves the spectrum empty.
+*/
+
+/*!
+    \property QAudioInput::spectrumBandCount
+    \since 6.6
+    \brief The number of frequency bands in spectrum().
+
+    The bands are spaced logarithmically, from 20 Hz to half the sample rate
+    of the audio. At most 256 bands are supported.
+
+    By default it is \c 0, and the spectrum isn't computed.
+*/
+int QAudioInput::spectrumBandCount() const
+{
+    return d->spectrumBandCount;
+}
+
+void QAudioInput::setSpectrumBandCount(int bands)
+{
+    const int bandCount = qBound(0, bands, QAudioLevelMeter::MaxBandCount);
+    if (d->spectrumBandCount == bandCount)
+        return;
+    d->spectrumBandCount = bandCount;
+
+    if (auto meter = d->levelMeter())
+        meter->setBandCount(bandCount);
+    emit spectrumBandCountChanged(bandCount);
+}
+
+/*!
+    \qmlproperty list<real> QtMultimedia::AudioInput::peakLevels
+    \since 6.6
+
+    This property holds the largest magnitude of the samples of every channel
+    during the last update interval, scaled linearly from \c 0.0 to \c 1.0.
+*/
+
+/*!
+    \property QAudioInput::peakLevels
+    \since 6.6
+    \brief The peak level of every channel.
+
+    The largest magnitude of the samples of every channel during the last
+    update interval, scaled linearly from \c 0 to \c 1 (full scale).
+    The list is empty until the first interval was measured.
+
+    \sa levelMeteringEnabled, QAudio::convertVolume()
+*/
+QList<float> QAudioInput::peakLevels() const
+{
+    return d->levels.peak;
+}
+
+/*!
+    \qmlproperty list<real> QtMultimedia::AudioInput::rmsLevels
+    \since 6.6
+
+    This property holds the root mean square level of every channel during
+    the last update interval, scaled linearly from \c 0.0 to \c 1.0.
+*/
+
+/*!
+    \property QAudioInput::rmsLevels
+    \since 6.6
+    \brief The RMS level of every channel.
+
+    The root mean square of the samples of every channel during the last
+    update interval, scaled linearly from \c 0 to \c 1 (full scale).
+    The list is empty until the first interval was measured.
+
+    \sa levelMeteringEnabled, QAudio::convertVolume()
+*/
+QList<float> QAudioInput::rmsLevels() const
+{
+    return d->levels.rms;
+}
+
+/*!
+    \qmlproperty list<real> QtMultimedia::AudioInput::spectrum
+    \since 6.6
+
+    This property holds the magnitude of each of the \l spectrumBandCount
+    frequency bands of the audio, from low to high frequencies.
+*/
+
+/*!
+    \property QAudioInput::spectrum
+    \since 6.6
+    \brief The magnitude of every frequency band.
+
+    The spectrum of the mix of all channels, over the last 2048 frames at the
+    end of the update interval. Every band holds the magnitude of its strongest
+    frequency, scaled linearly so that a full scale sine wave reads \c 1.
+
+    \sa spectrumBandCount
+*/
+QList<float> QAudioInput::spectrum() const
+{
+    return d->levels.spectrum;
+}
+
 /*!
     \internal
 */
@@ -0,0 +1,231 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qaudiolevelmeter_p.h"
+#include "qaudiohelpers_p.h"
+
+#include <QtCore/qmath.h>
+
+#include <pffft.h>
+
+#include <algorithm>
+
+QT_BEGIN_NAMESPACE
+
+// process() converts and measures this many frames at a time
+constexpr qsizetype ScratchFrames = 1024;
+
+void QAudioLevelMeter::FftDeleter::operator()(PFFFT_Setup *setup) const
+{
+    pffft_destroy_setup(setup);
+}
+
+void QAudioLevelMeter::FftDeleter::operator()(float *data) const
+{
+    pffft_aligned_free(data);
+}
+
+QAudioLevelMeter::QAudioLevelMeter() = default;
+
+QAudioLevelMeter::~QAudioLevelMeter() = default;
+
+void QAudioLevelMeter::setEnabled(bool enabled)
+{
+    m_enabled.storeRelaxed(enabled);
+    m_settingsSerial.fetchAndAddRelease(1);
+}
+
+void QAudioLevelMeter::setInterval(int msecs)
+{
+    m_interval.storeRelaxed(qMax(msecs, MinimumInterval));
+    m_settingsSerial.fetchAndAddRelease(1);
+}
+
+void QAudioLevelMeter::setBandCount(int bands)
+{
+    m_bandCount.storeRelaxed(qBound(0, bands, MaxBandCount));
+    m_settingsSerial.fetchAndAddRelease(1);
+}
+
+// Called on the audio thread, allocates only when the format or the settings change
+void QAudioLevelMeter::configure(const QAudioFormat &format)
+{
+    m_configuredSerial = m_settingsSerial.loadAcquire();
+    m_format = format;
+
+    const int channels = format.channelCount();
+    const int bands = bandCount();
+    m_blockFrames = qMax(qsizetype(1), qsizetype(format.sampleRate()) * interval() / 1000);
+    m_scratch.resize(ScratchFrames * channels);
+    m_peak.resize(channels);
+    m_sumOfSquares.resize(channels);
+    m_spectrum.resize(bands);
+
+    m_bandEdges.clear();
+    if (bands > 0) {
+        if (!m_fft) {
+            m_fft.reset(pffft_new_setup(FftSize, PFFFT_REAL));
+            m_fftData.reset(static_cast<float *>(pffft_aligned_malloc(3 * FftSize * sizeof(float))));
+            m_history.resize(FftSize);
+            m_window.resize(FftSize);
+            for (int i = 0; i < FftSize; ++i)
+                m_window[i] = 0.5f - 0.5f * std::cos(2 * float(M_PI) * i / FftSize);
+        }
+
+        // at least one bin per band, so the lowest ones are wider than their share
+        const int bins = FftSize / 2;
+        const float binsPerHz = float(FftSize) / format.sampleRate();
+        const float octaves = std::log2(format.sampleRate() / 2.f / LowestFrequency);
+        m_bandEdges.resize(bands + 1);
+        m_bandEdges[0] = qBound(1, qRound(LowestFrequency * binsPerHz), bins - bands);
+        for (int band = 1; band < bands; ++band) {
+            const float frequency = LowestFrequency * std::exp2(octaves * band / bands);
+            m_bandEdges[band] = qBound(m_bandEdges[band - 1] + 1, qRound(frequency * binsPerHz),
+                                       bins - bands + band);
+        }
+        m_bandEdges[bands] = bins;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_levels.peak.resize(channels);
+        m_levels.rms.resize(channels);
+        m_levels.spectrum.resize(bands);
+        m_hasLevels = false;
+    }
+
+    clear();
+}
+
+void QAudioLevelMeter::clear()
+{
+    std::fill(m_peak.begin(), m_peak.end(), 0.f);
+    std::fill(m_sumOfSquares.begin(), m_sumOfSquares.end(), 0.f);
+    std::fill(m_history.begin(), m_history.end(), 0.f);
+    m_historyPos = 0;
+    m_framesMeasured = 0;
+}
+
+void QAudioLevelMeter::process(const QAudioFormat &format, const void *data, qsizetype len)
+{
+    if (!isEnabled() || !format.isValid())
+        return;
+    if (format != m_format || m_configuredSerial != m_settingsSerial.loadAcquire())
+        configure(format);
+
+    const int channels = m_format.channelCount();
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const char *src = static_cast<const char *>(data);
+    qsizetype frames = len / bytesPerFrame;
+    while (frames > 0) {
+        const qsizetype chunk = std::min({ frames, m_blockFrames - m_framesMeasured, ScratchFrames });
+        const float *samples = reinterpret_cast<const float *>(src);
+        if (m_format.sampleFormat() != QAudioFormat::Float) {
+            QAudioHelperInternal::qConvertSamplesToFloat(m_format, src, m_scratch.data(),
+                                                         int(chunk * channels));
+            samples = m_scratch.data();
+        }
+
+        QAudioHelperInternal::qMeasureSamples(samples, channels, int(chunk), m_peak.data(),
+                                              m_sumOfSquares.data());
+
+        if (!m_bandEdges.empty()) {
+            const float gain = 1.f / channels;
+            for (qsizetype frame = 0; frame < chunk; ++frame, samples += channels) {
+                float sum = 0.f;
+                for (int c = 0; c < channels; ++c)
+                    sum += samples[c];
+                m_history[m_historyPos] = sum * gain;
+                m_historyPos = (m_historyPos + 1) % FftSize;
+            }
+        }
+
+        m_framesMeasured += chunk;
+        src += chunk * bytesPerFrame;
+        frames -= chunk;
+        if (m_framesMeasured == m_blockFrames)
+            finishBlock();
+    }
+}
+
+void QAudioLevelMeter::finishBlock()
+{
+    if (!m_bandEdges.empty())
+        computeSpectrum(m_spectrum.data());
+
+    // the owner only holds the lock while it copies the levels; rather than waiting
+    // for it, drop this block, the next one is only an interval away
+    if (m_mutex.tryLock()) {
+        for (qsizetype c = 0; c < m_levels.peak.size(); ++c) {
+            m_levels.peak.data()[c] = m_peak[c];
+            m_levels.rms.data()[c] = std::sqrt(m_sumOfSquares[c] / m_framesMeasured);
+        }
+        std::copy(m_spectrum.cbegin(), m_spectrum.cend(), m_levels.spectrum.data());
+        m_hasLevels = true;
+        m_mutex.unlock();
+    }
+
+    std::fill(m_peak.begin(), m_peak.end(), 0.f);
+    std::fill(m_sumOfSquares.begin(), m_sumOfSquares.end(), 0.f);
+    m_framesMeasured = 0;
+}
+
+void QAudioLevelMeter::computeSpectrum(float *bands)
+{
+    float *input = m_fftData.get();
+    float *output = input + FftSize;
+    float *work = output + FftSize;
+
+    // the history is a ring, starting with its oldest frame at m_historyPos
+    const qsizetype tail = FftSize - m_historyPos;
+    for (qsizetype i = 0; i < tail; ++i)
+        input[i] = m_history[m_historyPos + i] * m_window[i];
+    for (qsizetype i = tail; i < FftSize; ++i)
+        input[i] = m_history[i - tail] * m_window[i];
+
+    pffft_transform_ordered(m_fft.get(), input, output, work, PFFFT_FORWARD);
+
+    // bin k is at output[2 * k] and output[2 * k + 1]. The magnitude of a sine wave
+    // is half the sum of the window times its amplitude, so full scale reads 1.
+    const float scale = 4.f / FftSize;
+    for (qsizetype band = 0; band + 1 < qsizetype(m_bandEdges.size()); ++band) {
+        float magnitude = 0.f;
+        for (int bin = m_bandEdges[band]; bin < m_bandEdges[band + 1]; ++bin) {
+            const float re = output[2 * bin];
+            const float im = output[2 * bin + 1];
+            magnitude = qMax(magnitude, re * re + im * im);
+        }
+        bands[band] = std::sqrt(magnitude) * scale;
+    }
+}
+
+void QAudioLevelMeter::reset()
+{
+    if (!m_format.isValid())
+        return;
+
+    clear();
+    std::fill(m_spectrum.begin(), m_spectrum.end(), 0.f);
+
+    QMutexLocker locker(&m_mutex);
+    std::fill(m_levels.peak.begin(), m_levels.peak.end(), 0.f);
+    std::fill(m_levels.rms.begin(), m_levels.rms.end(), 0.f);
+    std::fill(m_levels.spectrum.begin(), m_levels.spectrum.end(), 0.f);
+    m_hasLevels = true;
+}
+
+bool QAudioLevelMeter::takeLevels(Levels *levels)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_hasLevels)
+        return false;
+    m_hasLevels = false;
+
+    // copy the data, sharing it would make the audio thread allocate when it writes
+    levels->peak = QList<float>(m_levels.peak.cbegin(), m_levels.peak.cend());
+    levels->rms = QList<float>(m_levels.rms.cbegin(), m_levels.rms.cend());
+    levels->spectrum = QList<float>(m_levels.spectrum.cbegin(), m_levels.spectrum.cend());
+    return true;
+}
+
+QT_END_NAMESPACE
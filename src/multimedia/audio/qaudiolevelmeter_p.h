@@ -0,0 +1,119 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QAUDIOLEVELMETER_P_H
+#define QAUDIOLEVELMETER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qaudioformat.h>
+#include <private/qtmultimediaglobal_p.h>
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmutex.h>
+
+#include <memory>
+#include <vector>
+
+struct PFFFT_Setup;
+
+QT_BEGIN_NAMESPACE
+
+// Measures the peak and RMS level of every channel, and the spectrum of their
+// mix, of the samples that an audio output plays or an audio input records.
+//
+// The backend calls process() on its audio thread, which measures blocks of
+// interval() milliseconds. The owner polls for the levels of the last block
+// with takeLevels(), so the audio thread never waits for the event loop, and
+// only gives up a block when it collides with the owner taking one.
+class Q_MULTIMEDIA_EXPORT QAudioLevelMeter
+{
+public:
+    struct Levels
+    {
+        QList<float> peak; // per channel
+        QList<float> rms; // per channel
+        QList<float> spectrum; // per band, from low to high frequencies
+    };
+
+    static constexpr int DefaultInterval = 50;
+    static constexpr int MinimumInterval = 10;
+    static constexpr int FftSize = 2048;
+    static constexpr int MaxBandCount = FftSize / 8;
+    // the bands are spaced logarithmically from here up to half the sample rate
+    static constexpr float LowestFrequency = 20.f;
+
+    QAudioLevelMeter();
+    ~QAudioLevelMeter();
+
+    // The settings can be changed from any thread
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.loadRelaxed(); }
+    void setInterval(int msecs);
+    int interval() const { return m_interval.loadRelaxed(); }
+    void setBandCount(int bands);
+    int bandCount() const { return m_bandCount.loadRelaxed(); }
+
+    // Called on the audio thread with the samples that were played or recorded
+    void process(const QAudioFormat &format, const void *data, qsizetype len);
+    // Called on the audio thread when the stream stops, so the levels fall to silence
+    void reset();
+
+    // Returns whether a block was measured since the last call, and its levels
+    bool takeLevels(Levels *levels);
+
+private:
+    Q_DISABLE_COPY(QAudioLevelMeter)
+
+    void configure(const QAudioFormat &format);
+    void clear();
+    void finishBlock();
+    void computeSpectrum(float *bands);
+
+    QAtomicInteger<bool> m_enabled = false;
+    QAtomicInteger<int> m_interval = DefaultInterval;
+    QAtomicInteger<int> m_bandCount = 0;
+    // bumped whenever a setting changes, so that the audio thread picks it up
+    QAtomicInteger<int> m_settingsSerial = 0;
+
+    // only used by the audio thread
+    QAudioFormat m_format;
+    int m_configuredSerial = -1;
+    qsizetype m_blockFrames = 0;
+    qsizetype m_framesMeasured = 0;
+    std::vector<float> m_scratch;
+    std::vector<float> m_peak;
+    std::vector<float> m_sumOfSquares;
+    std::vector<float> m_spectrum;
+
+    std::vector<float> m_history; // the mono mix of the last FftSize frames
+    qsizetype m_historyPos = 0;
+    std::vector<float> m_window;
+    std::vector<int> m_bandEdges; // the first bin of every band, and the end of the last one
+    struct FftDeleter
+    {
+        void operator()(PFFFT_Setup *setup) const;
+        void operator()(float *data) const;
+    };
+    std::unique_ptr<PFFFT_Setup, FftDeleter> m_fft;
+    std::unique_ptr<float, FftDeleter> m_fftData; // input, output and work area, aligned for pffft
+
+    // shared with the owner
+    QMutex m_mutex;
+    Levels m_levels;
+    bool m_hasLevels = false;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -4,6 +4,7 @@
 #ifndef QAUDIOOUTPUTDEVICE_H
 #define QAUDIOOUTPUTDEVICE_H
 
+#include <QtCore/qlist.h>
 #include <QtCore/qobject.h>
 #include <QtMultimedia/qtmultimediaglobal.h>
 #include <QtMultimedia/qaudio.h>
@@ -21,6 +22,15 @@ class Q_MULTIMEDIA_EXPORT QAudioOutput : public QObject
     Q_PROPERTY(QAudioDevice device READ device WRITE setDevice NOTIFY deviceChanged)
     Q_PROPERTY(float volume READ volume WRITE setVolume NOTIFY volumeChanged)
     Q_PROPERTY(bool muted READ isMuted WRITE setMuted NOTIFY mutedChanged)
+    Q_PROPERTY(bool levelMeteringEnabled READ isLevelMeteringEnabled WRITE setLevelMeteringEnabled
+               NOTIFY levelMeteringEnabledChanged)
+    Q_PROPERTY(int levelUpdateInterval READ levelUpdateInterval WRITE setLevelUpdateInterval
+               NOTIFY levelUpdateIntervalChanged)
+    Q_PROPERTY(int spectrumBandCount READ spectrumBandCount WRITE setSpectrumBandCount
+               NOTIFY spectrumBandCountChanged)
+    Q_PROPERTY(QList<float> peakLevels READ peakLevels NOTIFY levelsChanged)
+    Q_PROPERTY(QList<float> rmsLevels READ rmsLevels NOTIFY levelsChanged)
+    Q_PROPERTY(QList<float> spectrum READ spectrum NOTIFY levelsChanged)
 
 public:
     explicit QAudioOutput(QObject *parent = nullptr);
@@ -31,21 +41,36 @@ public:
     float volume() const;
     bool isMuted() const;
 
+    bool isLevelMeteringEnabled() const;
+    int levelUpdateInterval() const;
+    int spectrumBandCount() const;
+    QList<float> peakLevels() const;
+    QList<float> rmsLevels() const;
+    QList<float> spectrum() const;
+
 public Q_SLOTS:
     void setDevice(const QAudioDevice &device);
     void setVolume(float volume);
     void setMuted(bool muted);
+    void setLevelMeteringEnabled(bool enabled);
+    void setLevelUpdateInterval(int msecs);
+    void setSpectrumBandCount(int bands);
 
 Q_SIGNALS:
     void deviceChanged();
     void volumeChanged(float volume);
     void mutedChanged(bool muted);
+    void levelMeteringEnabledChanged(bool enabled);
+    void levelUpdateIntervalChanged(int msecs);
+    void spectrumBandCountChanged(int bands);
+    void levelsChanged();
 
 private:
     QPlatformAudioOutput *handle() const { return d; }
     void setDisconnectFunction(std::function<void()> disconnectFunction);
     friend class QMediaCaptureSession;
     friend class QMediaPlayer;
+    friend class QPlatformAudioOutput;
     Q_DISABLE_COPY(QAudioOutput)
     QPlatformAudioOutput *d = nullptr;
 };
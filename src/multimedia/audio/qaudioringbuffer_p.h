@@ -0,0 +1,124 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QAUDIORINGBUFFER_P_H
+#define QAUDIORINGBUFFER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qglobal.h>
+
+#include <algorithm>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+// A lock-free ring buffer for one producer and one consumer thread, e.g. an
+// audio thread and the thread with the event loop. Only the producer may write
+// and only the consumer may read; reset() needs both of them to be idle.
+template <typename T>
+class QAudioRingBuffer
+{
+public:
+    struct Region
+    {
+        T *data = nullptr;
+        qsizetype size = 0;
+    };
+
+    explicit QAudioRingBuffer(qsizetype size)
+        : m_size(size),
+          m_buffer(std::make_unique<T[]>(size))
+    {
+    }
+
+    // A contiguous part of the data that was written, up to size elements
+    Region acquireReadRegion(qsizetype size) const
+    {
+        const qsizetype used = m_used.loadAcquire();
+        return { m_buffer.get() + m_readPos, std::min({ size, m_size - m_readPos, used }) };
+    }
+
+    void releaseReadRegion(const Region &region)
+    {
+        m_readPos = (m_readPos + region.size) % m_size;
+        m_used.fetchAndSubRelease(region.size);
+    }
+
+    // A contiguous part of the free space, up to size elements
+    Region acquireWriteRegion(qsizetype size) const
+    {
+        const qsizetype free = m_size - m_used.loadAcquire();
+        return { m_buffer.get() + m_writePos, std::min({ size, m_size - m_writePos, free }) };
+    }
+
+    void releaseWriteRegion(const Region &region)
+    {
+        m_writePos = (m_writePos + region.size) % m_size;
+        m_used.fetchAndAddRelease(region.size);
+    }
+
+    // Copies as much of data as fits, and returns how much that was
+    qsizetype write(const T *data, qsizetype size)
+    {
+        qsizetype written = 0;
+        while (written < size) {
+            const Region region = acquireWriteRegion(size - written);
+            if (region.size == 0)
+                break;
+            std::copy_n(data + written, region.size, region.data);
+            releaseWriteRegion(region);
+            written += region.size;
+        }
+        return written;
+    }
+
+    // Copies up to size elements into data, and returns how many there were
+    qsizetype read(T *data, qsizetype size)
+    {
+        qsizetype read = 0;
+        while (read < size) {
+            const Region region = acquireReadRegion(size - read);
+            if (region.size == 0)
+                break;
+            std::copy_n(region.data, region.size, data + read);
+            releaseReadRegion(region);
+            read += region.size;
+        }
+        return read;
+    }
+
+    qsizetype used() const { return m_used.loadRelaxed(); }
+    qsizetype free() const { return m_size - m_used.loadRelaxed(); }
+    qsizetype size() const { return m_size; }
+
+    void reset()
+    {
+        m_readPos = 0;
+        m_writePos = 0;
+        m_used.storeRelaxed(0);
+    }
+
+private:
+    Q_DISABLE_COPY(QAudioRingBuffer)
+
+    const qsizetype m_size;
+    std::unique_ptr<T[]> m_buffer;
+    qsizetype m_readPos = 0; // only used by the consumer
+    qsizetype m_writePos = 0; // only used by the producer
+    QAtomicInteger<qsizetype> m_used = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif
@@ -5,6 +5,7 @@
 #include "qaudio.h"
 #include "qaudiodevice.h"
 #include "qaudiosystem_p.h"
+#include "qaudiocallbackbridge_p.h"
 #include "qaudiosink.h"
 
 #include <private/qplatformmediadevices_p.h>
@@ -139,6 +140,7 @@ void QAudioSink::start(QIODevice* device)
         return;
     d->elapsedTime.restart();
     d->start(device);
+    d->callbackBridge.reset();
 }
 
 /*!
@@ -163,7 +165,45 @@ QIODevice* QAudioSink::start()
     if (!d)
         return nullptr;
     d->elapsedTime.restart();
-    return d->start();
+    QIODevice *device = d->start();
+    d->callbackBridge.reset();
+    return device;
+}
+
+/*!
+    \typedef QAudioSink::AudioCallback
+    \since 6.6
+
+    A function that renders audio into a buffer of float samples: \c data has
+    room for \c frames frames, with the channels of format() interleaved.
+*/
+
+/*!
+    \since 6.6
+
+    Starts playing the audio that \a callback renders.
+
+    The callback is called from an audio thread, never from the thread of the
+    QAudioSink, with the same number of frames every time. It has to fill the
+    whole buffer, with silence if there is nothing to play, and should neither
+    block nor allocate memory. The samples are converted to the sample format of
+    the sink.
+
+    Where the audio system calls into the application from a thread of its own,
+    the callback is called from there. Otherwise it renders into a lock-free ring
+    buffer on a dedicated thread, which the sink reads from as it needs more
+    data, so the audio never goes through the event loop.
+
+    The callback is released by stop(), reset(), or starting the sink again.
+
+    \sa start()
+*/
+void QAudioSink::start(AudioCallback callback)
+{
+    if (!d || !callback)
+        return;
+    d->elapsedTime.restart();
+    d->startWithCallback(std::move(callback));
 }
 
 /*!
@@ -174,8 +214,10 @@ QIODevice* QAudioSink::start()
 */
 void QAudioSink::stop()
 {
-    if (d)
-        d->stop();
+    if (!d)
+        return;
+    d->stop();
+    d->callbackBridge.reset();
 }
 
 /*!
@@ -184,8 +226,10 @@ void QAudioSink::stop()
 */
 void QAudioSink::reset()
 {
-    if (d)
-        d->reset();
+    if (!d)
+        return;
+    d->reset();
+    d->callbackBridge.reset();
 }
 
 /*!
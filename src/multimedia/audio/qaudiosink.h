@@ -13,6 +13,7 @@
 #include <QtMultimedia/qaudioformat.h>
 #include <QtMultimedia/qaudiodevice.h>
 
+#include <functional>
 
 QT_BEGIN_NAMESPACE
 
@@ -33,8 +34,11 @@ public:
 
     QAudioFormat format() const;
 
+    using AudioCallback = std::function<void(float *data, qsizetype frames)>;
+
     void start(QIODevice *device);
     QIODevice* start();
+    void start(AudioCallback callback);
 
     void stop();
     void reset();
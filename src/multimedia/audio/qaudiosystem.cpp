@@ -2,11 +2,31 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qaudiosystem_p.h"
+#include "qaudiocallbackbridge_p.h"
 
 QT_BEGIN_NAMESPACE
 
 QPlatformAudioSink::QPlatformAudioSink(QObject *parent) : QObject(parent) { }
 
+QPlatformAudioSink::~QPlatformAudioSink() = default;
+
+void QPlatformAudioSink::startWithCallback(AudioCallback &&callback)
+{
+#if QT_CONFIG(thread)
+    const QAudioFormat format = this->format();
+    // 10ms at a time, with the buffer size of the sink, if there is one, in the ring
+    const qsizetype frames = qMax(format.sampleRate() / 100, 1);
+    const qsizetype bufferFrames = format.bytesPerFrame() ? bufferSize() / format.bytesPerFrame() : 0;
+    auto bridge = std::make_unique<QAudioCallbackBridge>(format, frames, bufferFrames, std::move(callback));
+    start(bridge.get());
+    // the sink has stopped reading from any previous bridge
+    callbackBridge = std::move(bridge);
+#else
+    Q_UNUSED(callback);
+    qWarning("QAudioSink: audio callbacks need thread support");
+#endif
+}
+
 qreal QPlatformAudioSink::volume() const
 {
     return 1.0;
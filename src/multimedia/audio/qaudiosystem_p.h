@@ -24,18 +24,29 @@
 #include <QtCore/qelapsedtimer.h>
 #include <QtCore/private/qglobal_p.h>
 
+#include <functional>
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 class QIODevice;
+class QAudioCallbackBridge;
 
 class Q_MULTIMEDIA_EXPORT QPlatformAudioSink : public QObject
 {
     Q_OBJECT
 
 public:
+    using AudioCallback = std::function<void(float *data, qsizetype frames)>;
+
     QPlatformAudioSink(QObject *parent);
+    ~QPlatformAudioSink() override;
     virtual void start(QIODevice *device) = 0;
     virtual QIODevice* start() = 0;
+    // Calls the callback from an audio thread. By default it renders into a ring
+    // buffer on a thread of its own, which the sink then reads in pull mode;
+    // backends with an audio thread of their own call it from there instead.
+    virtual void startWithCallback(AudioCallback &&callback);
     virtual void stop() = 0;
     virtual void reset() = 0;
     virtual void suspend() = 0;
@@ -52,6 +63,7 @@ public:
     virtual qreal volume() const;
 
     QElapsedTimer elapsedTime;
+    std::unique_ptr<QAudioCallbackBridge> callbackBridge;
 
 Q_SIGNALS:
     void errorChanged(QAudio::Error error);
@@ -2,21 +2,200 @@
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
 #include "qsamplecache_p.h"
-#include "qwavedecoder.h"
+#include "qaudiobuffer.h"
+#include "qaudioconverter_p.h"
+#include "qaudiodecoder.h"
+#include "qwavedecoder_p.h"
 
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkRequest>
 
 #include <QtCore/QDebug>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qeventloop.h>
+#include <QtCore/qfile.h>
 #include <QtCore/qloggingcategory.h>
+#include <QtCore/qtimer.h>
 
 static Q_LOGGING_CATEGORY(qLcSampleCache, "qt.multimedia.samplecache")
 
+#include <future>
 #include <mutex>
+#include <optional>
 
 QT_BEGIN_NAMESPACE
 
+namespace {
+
+// A decoder that doesn't produce anything for this long is given up on
+constexpr int DecodeStallTimeoutMs = 10000;
+// How often a decoding thread checks whether the cache is being destroyed
+constexpr int DecodeCancelPollMs = 50;
+
+struct DecodedSample
+{
+    QByteArray data;
+    QAudioFormat format;
+    std::shared_ptr<const void> owner;
+};
+
+QString localFileName(const QUrl &url)
+{
+    if (url.isLocalFile())
+        return url.toLocalFile();
+    if (url.scheme() == QLatin1String("qrc"))
+        return QLatin1Char(':') + url.path();
+    return {};
+}
+
+bool isRiffFile(QFile *file)
+{
+    const QByteArray id = file->peek(4);
+    return id == "RIFF" || id == "RIFX";
+}
+
+// Reads the WAV file \a file, referencing the samples in place when the decoder
+// would return them unchanged. Returns nothing if the file can't be parsed.
+std::optional<DecodedSample> readWave(std::unique_ptr<QFile> &file)
+{
+    QWaveDecoder decoder(file.get());
+    bool formatKnown = false;
+    QObject::connect(&decoder, &QWaveDecoder::formatKnown, [&formatKnown] { formatKnown = true; });
+
+    // all of the file is available, so this parses the headers right away
+    if (!decoder.open(QIODevice::ReadOnly) || !formatKnown)
+        return {};
+
+    DecodedSample sample;
+    sample.format = decoder.audioFormat();
+    const int bytesPerFrame = sample.format.bytesPerFrame();
+    const qint64 offset = file->pos();
+
+    if (QWaveDecoderPrivate::get(&decoder)->isRawData() && bytesPerFrame > 0) {
+        qint64 size = qMin(decoder.size(), file->size() - offset);
+        size -= size % bytesPerFrame;
+        if (uchar *data = size > 0 ? file->map(offset, size) : nullptr) {
+            qCDebug(qLcSampleCache) << "QSample: mapped" << size << "bytes of" << file->fileName();
+            sample.data = QByteArray::fromRawData(reinterpret_cast<const char *>(data), size);
+            // the mapping lives as long as the file
+            sample.owner = std::shared_ptr<const QFile>(file.release());
+            return sample;
+        }
+    }
+
+    sample.data.resize(decoder.size());
+    const qint64 read = decoder.read(sample.data.data(), sample.data.size());
+    if (read <= 0)
+        return {};
+    // a truncated data chunk plays as far as it goes
+    if (bytesPerFrame > 0)
+        sample.data.resize(read - read % bytesPerFrame);
+    return sample;
+}
+
+// Decodes with the platform's decoder. Gives up when \a canceled is set, or when
+// the decoder stalls.
+std::optional<DecodedSample> decodeAudio(const QUrl &url, QIODevice *device,
+                                         const QAtomicInteger<bool> &canceled)
+{
+    if (canceled.loadRelaxed())
+        return {};
+
+    QAudioDecoder decoder;
+    if (!decoder.isSupported())
+        return {};
+    if (device)
+        decoder.setSourceDevice(device);
+    else
+        decoder.setSource(url);
+
+    // there's no event loop running on the decoding threads
+    QEventLoop loop;
+    DecodedSample sample;
+    bool done = false;
+    bool failed = false;
+    QDeadlineTimer stallDeadline(DecodeStallTimeoutMs);
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, &loop, [&] {
+        stallDeadline.setRemainingTime(DecodeStallTimeoutMs);
+        const QAudioBuffer buffer = decoder.read();
+        if (!buffer.isValid())
+            return;
+        if (sample.format != buffer.format()) {
+            if (sample.format.isValid()) {
+                failed = true;
+                decoder.stop();
+                loop.quit();
+                return;
+            }
+            sample.format = buffer.format();
+        }
+        sample.data.append(buffer.constData<char>(), buffer.byteCount());
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, &loop, [&] {
+        done = true;
+        loop.quit();
+    });
+    QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), &loop,
+                     [&](QAudioDecoder::Error error) {
+                         qCDebug(qLcSampleCache) << "QSample: decoding error" << error
+                                                 << decoder.errorString();
+                         done = true;
+                         failed = true;
+                         loop.quit();
+                     });
+
+    QTimer watchdog;
+    watchdog.setInterval(DecodeCancelPollMs);
+    QObject::connect(&watchdog, &QTimer::timeout, &loop, [&] {
+        if (canceled.loadRelaxed())
+            qCDebug(qLcSampleCache) << "QSample: decoding canceled" << url;
+        else if (stallDeadline.hasExpired())
+            qCDebug(qLcSampleCache) << "QSample: decoding timed out" << url;
+        else
+            return;
+        failed = true;
+        decoder.stop();
+        loop.quit();
+    });
+
+    decoder.start();
+    if (!done) {
+        watchdog.start();
+        loop.exec();
+    }
+
+    if (failed || sample.data.isEmpty())
+        return {};
+    return sample;
+}
+
+// Called in the decoding pool
+std::optional<DecodedSample> decodeSample(const QUrl &url, const QAtomicInteger<bool> &canceled)
+{
+    const QString fileName = localFileName(url);
+    if (fileName.isEmpty())
+        return decodeAudio(url, nullptr, canceled);
+
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly)) {
+        qCDebug(qLcSampleCache) << "QSample: can't open" << fileName << file->errorString();
+        return {};
+    }
+
+    if (auto sample = readWave(file))
+        return sample;
+
+    if (!file->seek(0))
+        return {};
+    // a broken WAV file isn't going to get any better with another decoder
+    if (isRiffFile(file.get()))
+        return {};
+    return decodeAudio(url, file.get(), canceled);
+}
+
+}
+
 
 /*!
     \class QSampleCache
@@ -71,6 +250,7 @@ QSampleCache::QSampleCache(QObject *parent)
     , m_loadingRefCount(0)
 {
     m_loadingThread.setObjectName(QLatin1String("QSampleCache::LoadingThread"));
+    m_decodingPool.setObjectName(QLatin1String("QSampleCache::DecodingPool"));
 }
 
 QNetworkAccessManager& QSampleCache::networkAccessManager()
@@ -82,6 +262,11 @@ QNetworkAccessManager& QSampleCache::networkAccessManager()
 
 QSampleCache::~QSampleCache()
 {
+    // the decoding samples need the lock to finish; stop the decoders rather than
+    // waiting for them, which might not finish at all
+    m_decodingCanceled.storeRelaxed(true);
+    m_decodingPool.waitForDone();
+
     const std::lock_guard<QRecursiveMutex> locker(m_mutex);
 
     m_loadingThread.quit();
@@ -160,6 +345,17 @@ QSample* QSampleCache::requestSample(const QUrl& url)
     return sample;
 }
 
+// Requests all of \a urls at once, so that the ones that need decoding are decoded
+// concurrently. Each of the returned samples has to be released.
+QList<QSample *> QSampleCache::requestSamples(const QList<QUrl> &urls)
+{
+    QList<QSample *> samples;
+    samples.reserve(urls.size());
+    for (const QUrl &url : urls)
+        samples.append(requestSample(url));
+    return samples;
+}
+
 void QSampleCache::setCapacity(qint64 capacity)
 {
     const std::lock_guard<QRecursiveMutex> locker(m_mutex);
@@ -185,7 +381,7 @@ void QSampleCache::setCapacity(qint64 capacity)
 // Called locked
 void QSampleCache::unloadSample(QSample *sample)
 {
-    m_usage -= sample->m_soundData.size();
+    m_usage -= sample->m_soundData.size() + sample->m_convertedSize;
     m_staleSamples.insert(sample);
     sample->deleteLater();
 }
@@ -207,7 +403,7 @@ void QSampleCache::refresh(qint64 usageChange)
             ++it;
             continue;
         }
-        recoveredSize += sample->m_soundData.size();
+        recoveredSize += sample->m_soundData.size() + sample->m_convertedSize;
         unloadSample(sample);
         it = m_samples.erase(it);
         if (m_usage <= m_capacity)
@@ -222,6 +418,17 @@ void QSampleCache::refresh(qint64 usageChange)
         qWarning() << "QSampleCache: usage[" << m_usage << " out of limit[" << m_capacity << "]";
 }
 
+// Called in the decoding pool when a conversion of \a sample is done
+void QSampleCache::addConvertedData(QSample *sample, qint64 size)
+{
+    const std::lock_guard<QRecursiveMutex> locker(m_mutex);
+    // an unloaded sample doesn't count anymore
+    if (m_staleSamples.contains(sample))
+        return;
+    sample->m_convertedSize += size;
+    refresh(size);
+}
+
 // Called in both threads
 void QSampleCache::removeUnreferencedSample(QSample *sample)
 {
@@ -236,6 +443,12 @@ QSample::~QSample()
     // Remove ourselves from our parent
     m_parent->removeUnreferencedSample(this);
 
+    // only a sample that has been released meanwhile can be deleted while decoding
+    // or converting
+    m_decodingDone.acquire();
+    for (const auto &[format, conversion] : std::as_const(m_convertedData))
+        conversion.wait();
+
     QMutexLocker locker(&m_mutex);
     qCDebug(qLcSampleCache) << "~QSample" << this << ": deleted [" << m_url << "]" << QThread::currentThread();
     cleanup();
@@ -268,6 +481,52 @@ bool QSampleCache::notifyUnreferencedSample(QSample* sample)
     return true;
 }
 
+// Called in application thread
+void QSample::prepareConvertedData(const QAudioFormat &format)
+{
+    if (format.isValid() && format != m_audioFormat)
+        startConversion(format);
+}
+
+// Called in application thread
+QByteArray QSample::convertedData(const QAudioFormat &format)
+{
+    if (!format.isValid() || format == m_audioFormat)
+        return m_soundData;
+    return startConversion(format).get();
+}
+
+// Called in application thread.
+// Converts on the decoding pool of the cache, so neither the application thread nor
+// the lock are held up by the resampling.
+std::shared_future<QByteArray> QSample::startConversion(const QAudioFormat &format)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT(m_state == Ready);
+    for (const auto &[convertedFormat, conversion] : std::as_const(m_convertedData)) {
+        if (convertedFormat == format)
+            return conversion;
+    }
+
+    auto task = std::make_shared<std::packaged_task<QByteArray()>>(
+            [this, data = m_soundData, from = m_audioFormat, format] {
+                QAudioConverter converter(from, format);
+                if (!converter.isValid())
+                    return QByteArray();
+                QByteArray converted =
+                        converter.convert(data.constData(), data.size()) + converter.flush();
+                qCDebug(qLcSampleCache) << "QSample: converted [" << m_url << "] to" << format;
+                m_parent->addConvertedData(this, converted.size());
+                return converted;
+            });
+    std::shared_future<QByteArray> conversion = task->get_future().share();
+    m_convertedData.append({ format, conversion });
+    locker.unlock();
+
+    m_parent->m_decodingPool.start([task] { (*task)(); });
+    return conversion;
+}
+
 // Called in application thread
 void QSample::release()
 {
@@ -342,6 +601,42 @@ void QSample::decoderReady()
         onReady();
 }
 
+// Called in loading thread.
+// Decodes the sample on the decoding pool of the cache, which lets several samples
+// be decoded at the same time.
+void QSample::decodeInBackground()
+{
+    // wait for a previous, failed attempt to be completely done
+    m_decodingDone.acquire();
+    m_parent->m_decodingPool.start([this, url = m_url] {
+        std::optional<DecodedSample> sample = decodeSample(url, m_parent->m_decodingCanceled);
+        {
+            QMutexLocker m(&m_mutex);
+            if (sample) {
+                qCDebug(qLcSampleCache) << "QSample: decoded [" << m_url << "]" << sample->format;
+                m_soundData = std::move(sample->data);
+                m_audioFormat = sample->format;
+                m_dataOwner = std::move(sample->owner);
+                m_state = QSample::Ready;
+            } else {
+                qCDebug(qLcSampleCache) << "QSample: decoding failed [" << m_url << "]";
+                m_state = QSample::Error;
+            }
+        }
+        if (sample)
+            m_parent->refresh(m_soundData.size());
+        m_parent->loadingRelease();
+
+        if (sample)
+            emit ready();
+        else
+            emit error();
+
+        // must be last, the sample may be deleted as soon as this is released
+        m_decodingDone.release();
+    });
+}
+
 // Called in all threads
 QSample::State QSample::state() const
 {
@@ -357,6 +652,15 @@ void QSample::load()
     Q_ASSERT(QThread::currentThread()->objectName() == QLatin1String("QSampleCache::LoadingThread"));
 #endif
     qCDebug(qLcSampleCache) << "QSample: load [" << m_url << "]";
+
+    // Local files and resources are read directly, and anything that needs to go
+    // through QAudioDecoder is decoded in the background. Only remote WAV files
+    // are streamed through the network stack.
+    if (!localFileName(m_url).isEmpty()) {
+        decodeInBackground();
+        return;
+    }
+
     m_stream = m_parent->networkAccessManager().get(QNetworkRequest(m_url));
     connect(m_stream, SIGNAL(errorOccurred(QNetworkReply::NetworkError)), SLOT(loadingError(QNetworkReply::NetworkError)));
     m_waveDecoder = new QWaveDecoder(m_stream);
@@ -389,9 +693,9 @@ void QSample::decoderError()
     QMutexLocker m(&m_mutex);
     qCDebug(qLcSampleCache) << "QSample: decoder error";
     cleanup();
-    m_state = QSample::Error;
-    qobject_cast<QSampleCache*>(m_parent)->loadingRelease();
-    emit error();
+
+    // not a WAV file, but QAudioDecoder might know the format
+    decodeInBackground();
 }
 
 // Called in loading thread from decoder when sample is done. Locked already.
@@ -15,16 +15,22 @@
 // We mean it.
 //
 
+#include <QtCore/qatomic.h>
 #include <QtCore/qobject.h>
 #include <QtCore/qthread.h>
 #include <QtCore/qurl.h>
 #include <QtCore/qmutex.h>
 #include <QtCore/qmap.h>
+#include <QtCore/qsemaphore.h>
 #include <QtCore/qset.h>
+#include <QtCore/qthreadpool.h>
 #include <qaudioformat.h>
 #include <qnetworkreply.h>
 #include <private/qglobal_p.h>
 
+#include <future>
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
 class QIODevice;
@@ -51,6 +57,16 @@ public:
     // variables are updated to their final states
     const QByteArray& data() const { Q_ASSERT(state() == Ready); return m_soundData; }
     const QAudioFormat& format() const { Q_ASSERT(state() == Ready); return m_audioFormat; }
+    // data() may point into a memory mapped file, which this keeps alive for as long
+    // as it's referenced. Null if data() owns its memory.
+    std::shared_ptr<const void> dataOwner() const { Q_ASSERT(state() == Ready); return m_dataOwner; }
+    // Starts converting data() to format in the background, unless that's been
+    // done already or it is in format
+    void prepareConvertedData(const QAudioFormat &format);
+    // data() converted to format, which is kept for as long as the sample. Waits
+    // for a conversion that is still running. Returns data() if it is in format
+    // already, and nothing if it can't be converted.
+    QByteArray convertedData(const QAudioFormat &format);
     void release();
 
 Q_SIGNALS:
@@ -72,19 +88,25 @@ private:
     void cleanup();
     void addRef();
     void loadIfNecessary();
+    void decodeInBackground();
+    std::shared_future<QByteArray> startConversion(const QAudioFormat &format);
     QSample();
     ~QSample();
 
     mutable QMutex m_mutex;
     QSampleCache *m_parent;
     QByteArray   m_soundData;
+    std::shared_ptr<const void> m_dataOwner;
     QAudioFormat m_audioFormat;
+    QList<std::pair<QAudioFormat, std::shared_future<QByteArray>>> m_convertedData;
+    qint64       m_convertedSize = 0; // guarded by the lock of the cache
     QIODevice    *m_stream;
     QWaveDecoder *m_waveDecoder;
     QUrl         m_url;
     qint64       m_sampleReadLength;
     State        m_state;
     int          m_ref;
+    QSemaphore   m_decodingDone{ 1 }; // taken while the sample is decoding
 };
 
 class Q_MULTIMEDIA_EXPORT QSampleCache : public QObject
@@ -97,6 +119,7 @@ public:
     ~QSampleCache();
 
     QSample* requestSample(const QUrl& url);
+    QList<QSample *> requestSamples(const QList<QUrl> &urls);
     void setCapacity(qint64 capacity);
 
     bool isLoading() const;
@@ -110,9 +133,13 @@ private:
     qint64 m_capacity;
     qint64 m_usage;
     QThread m_loadingThread;
+    QThreadPool m_decodingPool;
+    // set when the cache is destroyed, to stop the samples that are still decoding
+    QAtomicInteger<bool> m_decodingCanceled = false;
 
     QNetworkAccessManager& networkAccessManager();
     void refresh(qint64 usageChange);
+    void addConvertedData(QSample *sample, qint64 size);
     bool notifyUnreferencedSample(QSample* sample);
     void removeUnreferencedSample(QSample* sample);
     void unloadSample(QSample* sample);
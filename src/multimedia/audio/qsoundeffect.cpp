@@ -4,8 +4,8 @@
 #include <QtMultimedia/private/qtmultimediaglobal_p.h>
 #include "qsoundeffect.h"
 #include "qsamplecache_p.h"
+#include "qsoundeffectmixer_p.h"
 #include "qaudiodevice.h"
-#include "qaudiosink.h"
 #include "qmediadevices.h"
 #include <QtCore/qloggingcategory.h>
 
@@ -15,40 +15,24 @@ QT_BEGIN_NAMESPACE
 
 Q_GLOBAL_STATIC(QSampleCache, sampleCache)
 
-class QSoundEffectPrivate : public QIODevice
+class QSoundEffectPrivate : public QObject
 {
 public:
     QSoundEffectPrivate(QSoundEffect *q, const QAudioDevice &audioDevice = QAudioDevice());
     ~QSoundEffectPrivate() override = default;
 
-    qint64 readData(char *data, qint64 len) override;
-    qint64 writeData(const char *data, qint64 len) override;
-    qint64 size() const override {
-        if (m_sample->state() != QSample::Ready)
-            return 0;
-        return m_loopCount == QSoundEffect::Infinite ? 0 : m_loopCount * m_sample->data().size();
-    }
-    qint64 bytesAvailable() const override {
-        if (m_sample->state() != QSample::Ready)
-            return 0;
-        return m_loopCount == QSoundEffect::Infinite
-                   ? std::numeric_limits<qint64>::max() : m_runningCount * m_sample->data().size() - m_offset;
-    }
-    bool isSequential() const override {
-        return m_loopCount == QSoundEffect::Infinite;
-    }
-    bool atEnd() const override {
-        return m_runningCount == 0;
-    }
-
     void setLoopsRemaining(int loopsRemaining);
     void setStatus(QSoundEffect::Status status);
     void setPlaying(bool playing);
 
+    float gain() const { return m_muted ? 0.f : m_volume; }
+    void startVoice();
+    void stopVoices();
+    void voiceLoopsChanged(QSoundEffectMixer::VoiceId voice, int loopsRemaining);
+
 public Q_SLOTS:
     void sampleReady();
     void decoderError();
-    void stateChanged(QAudio::State);
 
 public:
     QSoundEffect *q_ptr;
@@ -57,21 +41,21 @@ public:
     int m_runningCount = 0;
     bool m_playing = false;
     QSoundEffect::Status  m_status = QSoundEffect::Null;
-    QAudioSink *m_audioOutput = nullptr;
+    std::shared_ptr<QSoundEffectMixer> m_mixer;
+    QList<QSoundEffectMixer::VoiceId> m_voices; // the oldest first
+    int m_maxVoices = 1;
     QSample *m_sample = nullptr;
     bool m_muted = false;
     float m_volume = 1.0;
     bool m_sampleReady = false;
-    qint64 m_offset = 0;
     QAudioDevice m_audioDevice;
 };
 
 QSoundEffectPrivate::QSoundEffectPrivate(QSoundEffect *q, const QAudioDevice &audioDevice)
-    : QIODevice(q)
+    : QObject(q)
     , q_ptr(q)
     , m_audioDevice(audioDevice)
 {
-    open(QIODevice::ReadOnly);
 }
 
 void QSoundEffectPrivate::sampleReady()
@@ -82,20 +66,16 @@ void QSoundEffectPrivate::sampleReady()
     qCDebug(qLcSoundEffect) << this << "sampleReady: sample size:" << m_sample->data().size();
     disconnect(m_sample, &QSample::error, this, &QSoundEffectPrivate::decoderError);
     disconnect(m_sample, &QSample::ready, this, &QSoundEffectPrivate::sampleReady);
-    if (!m_audioOutput) {
-        m_audioOutput = new QAudioSink(m_audioDevice, m_sample->format());
-        connect(m_audioOutput, &QAudioSink::stateChanged, this, &QSoundEffectPrivate::stateChanged);
-        if (!m_muted)
-            m_audioOutput->setVolume(m_volume);
-        else
-            m_audioOutput->setVolume(0);
-    }
+    if (!m_mixer)
+        m_mixer = QSoundEffectMixer::instance(m_audioDevice);
+    // resample on load rather than when the effect is played first
+    m_sample->prepareConvertedData(m_mixer->voiceFormat(m_sample->format()));
     m_sampleReady = true;
     setStatus(QSoundEffect::Ready);
 
-    if (m_playing && m_audioOutput->state() == QAudio::StoppedState) {
-        qCDebug(qLcSoundEffect) << this << "starting playback on audiooutput";
-        m_audioOutput->start(this);
+    if (m_playing && m_voices.isEmpty()) {
+        qCDebug(qLcSoundEffect) << this << "starting playback on the mixer";
+        startVoice();
     }
 }
 
@@ -108,50 +88,55 @@ void QSoundEffectPrivate::decoderError()
     setStatus(QSoundEffect::Error);
 }
 
-void QSoundEffectPrivate::stateChanged(QAudio::State state)
+void QSoundEffectPrivate::startVoice()
 {
-    qCDebug(qLcSoundEffect) << this << "stateChanged " << state;
-    if ((state == QAudio::IdleState && m_runningCount == 0) || state == QAudio::StoppedState)
-        q_ptr->stop();
-}
-
-qint64 QSoundEffectPrivate::readData(char *data, qint64 len)
-{
-    qCDebug(qLcSoundEffect) << this << "readData" << len << m_runningCount;
-    if (!len)
-        return 0;
-    if (m_sample->state() != QSample::Ready)
-        return 0;
-    if (m_runningCount == 0 || !m_playing)
-        return 0;
-
-    qint64 bytesWritten = 0;
-
-    const int   sampleSize = m_sample->data().size();
-    const char* sampleData = m_sample->data().constData();
-
-    while (len && m_runningCount) {
-        int toWrite = qMin(sampleSize - m_offset, len);
-        memcpy(data, sampleData + m_offset, toWrite);
-        bytesWritten += toWrite;
-        data += toWrite;
-        len -= toWrite;
-        m_offset += toWrite;
-        if (m_offset >= sampleSize) {
-            if (m_runningCount > 0 && m_runningCount != QSoundEffect::Infinite)
-                setLoopsRemaining(m_runningCount - 1);
-            m_offset = 0;
-        }
+    Q_ASSERT(m_mixer && m_sampleReady);
+
+    // steal the oldest voices to make room
+    while (m_voices.size() >= m_maxVoices)
+        m_mixer->fadeOutVoice(m_voices.takeFirst());
+
+    // the sample resamples with a band-limited filter, and keeps the result
+    QAudioFormat format = m_mixer->voiceFormat(m_sample->format());
+    QByteArray data = m_sample->convertedData(format);
+    std::shared_ptr<const void> dataOwner;
+    if (format == m_sample->format() || data.isEmpty()) {
+        data = m_sample->data();
+        dataOwner = m_sample->dataOwner();
+        format = m_sample->format();
     }
 
-    return bytesWritten;
+    m_voices.append(m_mixer->startVoice(
+            this,
+            [this](QSoundEffectMixer::VoiceId voice, int loopsRemaining) {
+                voiceLoopsChanged(voice, loopsRemaining);
+            },
+            data, std::move(dataOwner), format, m_runningCount, gain()));
 }
 
-qint64 QSoundEffectPrivate::writeData(const char *data, qint64 len)
+void QSoundEffectPrivate::stopVoices()
 {
-    Q_UNUSED(data);
-    Q_UNUSED(len);
-    return 0;
+    for (QSoundEffectMixer::VoiceId voice : std::as_const(m_voices))
+        m_mixer->stopVoice(voice);
+    m_voices.clear();
+}
+
+void QSoundEffectPrivate::voiceLoopsChanged(QSoundEffectMixer::VoiceId voice, int loopsRemaining)
+{
+    // ignore what's left over from voices that have been stopped or stolen since
+    const qsizetype index = m_voices.indexOf(voice);
+    if (index < 0)
+        return;
+
+    qCDebug(qLcSoundEffect) << this << "voiceLoopsChanged" << voice << loopsRemaining;
+    // the remaining loops are the ones of the most recently started voice
+    if (index == m_voices.size() - 1)
+        setLoopsRemaining(loopsRemaining);
+    if (loopsRemaining == 0) {
+        m_voices.removeAt(index);
+        if (m_voices.isEmpty())
+            q_ptr->stop();
+    }
 }
 
 void QSoundEffectPrivate::setLoopsRemaining(int loopsRemaining)
@@ -178,19 +163,17 @@ void QSoundEffectPrivate::setStatus(QSoundEffect::Status status)
 void QSoundEffectPrivate::setPlaying(bool playing)
 {
     qCDebug(qLcSoundEffect) << this << "setPlaying(" << playing << ")" << m_playing;
-    if (m_audioOutput) {
-        m_audioOutput->stop();
-        if (playing && !m_sampleReady)
-            return;
-    }
+    // playing again adds a voice, which replaces the oldest one once there are
+    // maxVoices of them
+    if (!playing)
+        stopVoices();
+    else if (m_sampleReady)
+        startVoice();
 
     if (m_playing == playing)
         return;
     m_playing = playing;
 
-    if (m_audioOutput && playing)
-        m_audioOutput->start(this);
-
     emit q_ptr->playingChanged();
 }
 
@@ -220,9 +203,9 @@ void QSoundEffectPrivate::setPlaying(bool playing)
 
     \snippet multimedia-snippets/qsound.cpp 3
 
-    Since QSoundEffect requires slightly more resources to achieve lower
-    latency playback, the platform may limit the number of simultaneously playing
-    sound effects.
+    All sound effects playing on the same audio device are mixed in software
+    into a single audio output, which stays open while effects are being
+    played. Starting an effect therefore doesn't need to open a new stream.
 */
 
 
@@ -280,11 +263,8 @@ QSoundEffect::QSoundEffect(const QAudioDevice &audioDevice, QObject *parent)
 QSoundEffect::~QSoundEffect()
 {
     stop();
-    if (d->m_audioOutput) {
-        d->m_audioOutput->stop();
-        d->m_audioOutput->deleteLater();
+    if (d->m_sampleReady)
         d->m_sample->release();
-    }
     delete d;
 }
 
@@ -362,12 +342,6 @@ void QSoundEffect::setSource(const QUrl &url)
         d->m_sample = nullptr;
     }
 
-    if (d->m_audioOutput) {
-        QObject::disconnect(d->m_audioOutput, &QAudioSink::stateChanged, d, &QSoundEffectPrivate::stateChanged);
-        d->m_audioOutput->stop();
-        d->m_audioOutput->deleteLater();
-        d->m_audioOutput = nullptr;
-    }
 
     d->setStatus(QSoundEffect::Loading);
     d->m_sample = sampleCache()->requestSample(url);
@@ -445,8 +419,11 @@ void QSoundEffect::setLoopCount(int loopCount)
         return;
 
     d->m_loopCount = loopCount;
-    if (d->m_playing)
+    if (d->m_playing) {
         d->setLoopsRemaining(loopCount);
+        for (QSoundEffectMixer::VoiceId voice : std::as_const(d->m_voices))
+            d->m_mixer->setVoiceLoops(voice, loopCount);
+    }
     emit loopCountChanged();
 }
 
@@ -464,8 +441,15 @@ void QSoundEffect::setAudioDevice(const QAudioDevice &device)
 {
     if (d->m_audioDevice == device)
         return;
-    // ### recreate the QAudioSink if needed
     d->m_audioDevice = device;
+    if (d->m_mixer) {
+        // move a playing effect over to the mixer of the new device
+        const bool restart = !d->m_voices.isEmpty();
+        d->stopVoices();
+        d->m_mixer = QSoundEffectMixer::instance(device);
+        if (restart)
+            d->startVoice();
+    }
     emit audioDeviceChanged();
 }
 
@@ -513,9 +497,6 @@ int QSoundEffect::loopsRemaining() const
  */
 float QSoundEffect::volume() const
 {
-    if (d->m_audioOutput && !d->m_muted)
-        return d->m_audioOutput->volume();
-
     return d->m_volume;
 }
 
@@ -539,8 +520,8 @@ void QSoundEffect::setVolume(float volume)
 
     d->m_volume = volume;
 
-    if (d->m_audioOutput && !d->m_muted)
-        d->m_audioOutput->setVolume(volume);
+    for (QSoundEffectMixer::VoiceId voice : std::as_const(d->m_voices))
+        d->m_mixer->setVoiceGain(voice, d->gain());
 
     emit volumeChanged();
 }
@@ -575,15 +556,60 @@ void QSoundEffect::setMuted(bool muted)
     if (d->m_muted == muted)
         return;
 
-    if (muted && d->m_audioOutput)
-        d->m_audioOutput->setVolume(0);
-    else if (!muted && d->m_audioOutput && d->m_muted)
-        d->m_audioOutput->setVolume(d->m_volume);
-
     d->m_muted = muted;
+    for (QSoundEffectMixer::VoiceId voice : std::as_const(d->m_voices))
+        d->m_mixer->setVoiceGain(voice, d->gain());
+
     emit mutedChanged();
 }
 
+/*!
+    \qmlproperty int QtMultimedia::SoundEffect::maxVoices
+    \since 6.6
+
+    This property holds how many times the sound effect can be playing at the same
+    time. Calling \l play() while the effect is already playing starts another voice
+    of it, until there are \c maxVoices voices. After that the oldest voice is faded
+    out to make room for the new one.
+
+    The default is \c 1, which makes \l play() restart the effect.
+*/
+/*!
+    \property QSoundEffect::maxVoices
+    \since 6.6
+
+    This property holds how many times the sound effect can be playing at the same
+    time. Calling play() while the effect is already playing starts another voice
+    of it, until there are \c maxVoices voices. After that the oldest voice is faded
+    out to make room for the new one.
+
+    All the voices share the loaded sample and are mixed into the same audio output,
+    so playing an effect many times over is cheap. The loopsRemaining property
+    follows the voice that was started last.
+
+    The default is \c 1, which makes play() restart the effect.
+*/
+int QSoundEffect::maxVoices() const
+{
+    return d->m_maxVoices;
+}
+
+void QSoundEffect::setMaxVoices(int maxVoices)
+{
+    if (maxVoices < 1) {
+        qWarning("SoundEffect: maxVoices should be a positive integer");
+        return;
+    }
+    if (d->m_maxVoices == maxVoices)
+        return;
+
+    d->m_maxVoices = maxVoices;
+    while (d->m_voices.size() > maxVoices)
+        d->m_mixer->fadeOutVoice(d->m_voices.takeFirst());
+
+    emit maxVoicesChanged();
+}
+
 /*!
     \fn QSoundEffect::isLoaded() const
 
@@ -603,7 +629,9 @@ bool QSoundEffect::isLoaded() const
     \qmlmethod QtMultimedia::SoundEffect::play()
 
     Start playback of the sound effect, looping the effect for the number of
-    times as specified in the loops property.
+    times as specified in the loops property. If the effect is already playing,
+    another voice of it is started, or the oldest one is replaced once there are
+    \l maxVoices of them.
 
     This is the default method for SoundEffect.
 
@@ -613,11 +641,12 @@ bool QSoundEffect::isLoaded() const
     \fn QSoundEffect::play()
 
     Start playback of the sound effect, looping the effect for the number of
-    times as specified in the loops property.
+    times as specified in the loops property. If the effect is already playing,
+    another voice of it is started, or the oldest one is replaced once there are
+    \l maxVoices of them.
 */
 void QSoundEffect::play()
 {
-    d->m_offset = 0;
     d->setLoopsRemaining(d->m_loopCount);
     qCDebug(qLcSoundEffect) << this << "play" << d->m_loopCount << d->m_runningCount;
     if (d->m_status == QSoundEffect::Null || d->m_status == QSoundEffect::Error) {
@@ -701,7 +730,6 @@ void QSoundEffect::stop()
     if (!d->m_playing)
         return;
     qCDebug(qLcSoundEffect) << "stop()";
-    d->m_offset = 0;
 
     d->setPlaying(false);
 }
@@ -773,6 +801,19 @@ void QSoundEffect::stop()
     The \c mutedChanged signal is emitted when the mute state has changed.
 */
 
+/*!
+    \fn void QSoundEffect::maxVoicesChanged()
+    \since 6.6
+
+    The \c maxVoicesChanged signal is emitted when the maximum number of voices has changed.
+*/
+/*!
+    \qmlsignal QtMultimedia::SoundEffect::maxVoicesChanged()
+    \since 6.6
+
+    The \c maxVoicesChanged signal is emitted when the maximum number of voices has changed.
+*/
+
 /*!
     \fn void QSoundEffect::playingChanged()
 
@@ -26,6 +26,7 @@ class Q_MULTIMEDIA_EXPORT QSoundEffect : public QObject
     Q_PROPERTY(int loopsRemaining READ loopsRemaining NOTIFY loopsRemainingChanged)
     Q_PROPERTY(float volume READ volume WRITE setVolume NOTIFY volumeChanged)
     Q_PROPERTY(bool muted READ isMuted WRITE setMuted NOTIFY mutedChanged)
+    Q_PROPERTY(int maxVoices READ maxVoices WRITE setMaxVoices NOTIFY maxVoicesChanged)
     Q_PROPERTY(bool playing READ isPlaying NOTIFY playingChanged)
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(QAudioDevice audioDevice READ audioDevice WRITE setAudioDevice NOTIFY audioDeviceChanged)
@@ -68,6 +69,9 @@ public:
     bool isMuted() const;
     void setMuted(bool muted);
 
+    int maxVoices() const;
+    void setMaxVoices(int maxVoices);
+
     bool isLoaded() const;
 
     bool isPlaying() const;
@@ -79,6 +83,7 @@ Q_SIGNALS:
     void loopsRemainingChanged();
     void volumeChanged();
     void mutedChanged();
+    void maxVoicesChanged();
     void loadedChanged();
     void playingChanged();
     void statusChanged();
@@ -0,0 +1,386 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qsoundeffectmixer_p.h"
+#include "qaudiosink.h"
+#include "qmediadevices.h"
+#include "qaudiohelpers_p.h"
+
+#include <QtCore/qcoreapplication.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qthread.h>
+
+#include <algorithm>
+#include <limits>
+
+QT_BEGIN_NAMESPACE
+
+static Q_LOGGING_CATEGORY(qLcSoundEffectMixer, "qt.multimedia.soundeffect.mixer")
+
+namespace {
+
+struct MixerRegistry
+{
+    QMutex mutex;
+    QHash<QByteArray, std::weak_ptr<QSoundEffectMixer>> mixers;
+};
+
+Q_GLOBAL_STATIC(MixerRegistry, mixerRegistry)
+
+// The value of the output channel \a channel in \a frame, which is in \a format
+float channelValue(const QAudioFormat &format, const char *frame, int channel, int channels)
+{
+    const int sourceChannels = format.channelCount();
+    const int bytesPerSample = format.bytesPerSample();
+    if (sourceChannels == 1)
+        return format.normalizedSampleValue(frame);
+    if (channels == 1) {
+        float sum = 0.f;
+        for (int c = 0; c < sourceChannels; ++c)
+            sum += format.normalizedSampleValue(frame + c * bytesPerSample);
+        return sum / sourceChannels;
+    }
+    if (channel < sourceChannels)
+        return format.normalizedSampleValue(frame + channel * bytesPerSample);
+    return 0.f;
+}
+
+}
+
+std::shared_ptr<QSoundEffectMixer> QSoundEffectMixer::instance(const QAudioDevice &device)
+{
+    MixerRegistry *registry = mixerRegistry();
+    QMutexLocker locker(&registry->mutex);
+
+    std::weak_ptr<QSoundEffectMixer> &entry = registry->mixers[device.id()];
+    if (auto mixer = entry.lock())
+        return mixer;
+
+    // the last effect using the mixer can be in any thread
+    std::shared_ptr<QSoundEffectMixer> mixer(new QSoundEffectMixer(device),
+                                             [](QSoundEffectMixer *mixer) {
+                                                 if (mixer->thread() == QThread::currentThread())
+                                                     delete mixer;
+                                                 else
+                                                     mixer->deleteLater();
+                                             });
+    entry = mixer;
+    return mixer;
+}
+
+QSoundEffectMixer::QSoundEffectMixer(const QAudioDevice &device) : m_device(device)
+{
+    const QAudioDevice output = device.isNull() ? QMediaDevices::defaultAudioOutput() : device;
+    m_format = output.preferredFormat();
+    if (!m_format.isValid()) {
+        m_format.setSampleRate(48000);
+        m_format.setChannelCount(2);
+        m_format.setSampleFormat(QAudioFormat::Int16);
+    }
+
+    // we mix in float, so use it for the output as well if the device takes it
+    QAudioFormat floatFormat = m_format;
+    floatFormat.setSampleFormat(QAudioFormat::Float);
+    if (output.isFormatSupported(floatFormat))
+        m_format = floatFormat;
+
+    qCDebug(qLcSoundEffectMixer) << "mixing into" << m_format << "for" << output.description();
+
+    // unbuffered, as read ahead would only add latency
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    // the sink needs an event loop, and the one of the thread creating the
+    // first effect might not outlive the others
+    if (auto *app = QCoreApplication::instance())
+        moveToThread(app->thread());
+}
+
+QSoundEffectMixer::~QSoundEffectMixer()
+{
+    if (m_sink) {
+        disconnect(m_sink, nullptr, this, nullptr);
+        m_sink->stop();
+        delete m_sink;
+    }
+}
+
+QSoundEffectMixer::VoiceId QSoundEffectMixer::startVoice(QObject *receiver, LoopsCallback callback,
+                                                         const QByteArray &data,
+                                                         std::shared_ptr<const void> dataOwner,
+                                                         const QAudioFormat &format, int loops,
+                                                         float gain)
+{
+    Voice voice;
+    voice.receiver = receiver;
+    voice.callback = std::move(callback);
+    voice.data = data; // shares the sample, doesn't copy it
+    voice.dataOwner = std::move(dataOwner);
+    voice.format = format;
+    voice.frames = format.bytesPerFrame() > 0 ? data.size() / format.bytesPerFrame() : 0;
+    if (format.sampleRate() > 0)
+        voice.step = (qint64(format.sampleRate()) << PositionShift) / m_format.sampleRate();
+    voice.loopsRemaining = loops == 0 ? 1 : (loops < 0 ? InfiniteLoops : loops);
+    voice.gain = gain;
+
+    VoiceId id;
+    {
+        QMutexLocker locker(&m_mutex);
+        id = voice.id = m_nextVoiceId++;
+
+        // Start the voice as far into the next buffer as the call is from the last pull, so
+        // that effects triggered in quick succession keep their spacing instead of all
+        // being aligned to the start of a buffer.
+        voice.startFrame = m_framesMixed;
+        if (m_lastPull.isValid()) {
+            const qint64 elapsed = m_format.framesForDuration(m_lastPull.nsecsElapsed() / 1000);
+            voice.startFrame += qMin(elapsed, m_lastPullFrames);
+        }
+
+        if (voice.frames == 0) {
+            voice.loopsRemaining = 0;
+            notify(voice);
+            return id;
+        }
+
+        qCDebug(qLcSoundEffectMixer) << "starting voice" << id << "at frame"
+                                     << voice.startFrame;
+        m_voices.push_back(std::move(voice));
+    }
+
+    if (thread() == QThread::currentThread())
+        startSink();
+    else
+        QMetaObject::invokeMethod(this, [this] { startSink(); }, Qt::QueuedConnection);
+
+    return id;
+}
+
+QAudioFormat QSoundEffectMixer::voiceFormat(const QAudioFormat &format) const
+{
+    if (format.sampleRate() == m_format.sampleRate())
+        return format;
+    // mixed right away, and without losing precision to the output format
+    QAudioFormat mixFormat = m_format;
+    mixFormat.setSampleFormat(QAudioFormat::Float);
+    return mixFormat;
+}
+
+void QSoundEffectMixer::stopVoice(VoiceId voice)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = std::find_if(m_voices.begin(), m_voices.end(),
+                           [voice](const Voice &v) { return v.id == voice; });
+    if (it != m_voices.end())
+        m_voices.erase(it);
+}
+
+void QSoundEffectMixer::fadeOutVoice(VoiceId voice)
+{
+    QMutexLocker locker(&m_mutex);
+    Voice *v = findVoice(voice);
+    if (v && v->fadeRemaining < 0) {
+        v->fadeRemaining = m_format.framesForDuration(FadeOutUs);
+        // the owner forgets the voice, and may be destroyed before the fade ends
+        v->receiver = nullptr;
+        v->callback = {};
+    }
+}
+
+void QSoundEffectMixer::setVoiceGain(VoiceId voice, float gain)
+{
+    QMutexLocker locker(&m_mutex);
+    if (Voice *v = findVoice(voice))
+        v->gain = gain;
+}
+
+void QSoundEffectMixer::setVoiceLoops(VoiceId voice, int loops)
+{
+    QMutexLocker locker(&m_mutex);
+    if (Voice *v = findVoice(voice))
+        v->loopsRemaining = loops == 0 ? 1 : (loops < 0 ? InfiniteLoops : loops);
+}
+
+int QSoundEffectMixer::voiceCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return int(m_voices.size());
+}
+
+QSoundEffectMixer::Voice *QSoundEffectMixer::findVoice(VoiceId voice)
+{
+    for (Voice &v : m_voices) {
+        if (v.id == voice)
+            return &v;
+    }
+    return nullptr;
+}
+
+void QSoundEffectMixer::startSink()
+{
+    if (!m_sink) {
+        m_sink = new QAudioSink(m_device, m_format, this);
+        connect(m_sink, &QAudioSink::stateChanged, this, &QSoundEffectMixer::sinkStateChanged);
+    }
+
+    if (m_sink->state() == QAudio::ActiveState)
+        return;
+
+    qCDebug(qLcSoundEffectMixer) << "(re)starting the sink, state was" << m_sink->state();
+    m_sink->stop();
+    m_sink->start(this);
+}
+
+void QSoundEffectMixer::sinkStateChanged(QAudio::State state)
+{
+    if (state != QAudio::StoppedState || m_sink->error() == QAudio::NoError)
+        return;
+
+    qCWarning(qLcSoundEffectMixer) << "audio output failed:" << m_sink->error();
+
+    // the effects would otherwise wait forever for their voices to finish
+    QMutexLocker locker(&m_mutex);
+    for (Voice &voice : m_voices) {
+        voice.loopsRemaining = 0;
+        notify(voice);
+    }
+    m_voices.clear();
+}
+
+void QSoundEffectMixer::notify(const Voice &voice) const
+{
+    if (!voice.receiver || !voice.callback)
+        return;
+
+    // Posting while m_mutex is held keeps the receiver alive, as it stops the voices it
+    // knows about before being destroyed, and the ones it faded out no longer refer to
+    // it. Pending calls are dropped with the receiver.
+    QMetaObject::invokeMethod(
+            voice.receiver,
+            [callback = voice.callback, id = voice.id, loops = voice.loopsRemaining] {
+                callback(id, loops);
+            },
+            Qt::QueuedConnection);
+}
+
+qint64 QSoundEffectMixer::bytesAvailable() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_voices.empty() && m_idleFrames >= m_format.framesForDuration(IdleTimeoutMs * 1000))
+        return 0;
+    return std::numeric_limits<qint64>::max();
+}
+
+qint64 QSoundEffectMixer::readData(char *data, qint64 len)
+{
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const qint64 frames = bytesPerFrame > 0 ? len / bytesPerFrame : 0;
+    if (frames == 0)
+        return 0;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_voices.empty()) {
+        // let the sink go idle; startVoice() restarts it
+        if (m_idleFrames >= m_format.framesForDuration(IdleTimeoutMs * 1000)) {
+            m_lastPull.invalidate();
+            return 0;
+        }
+        m_idleFrames += frames;
+    } else {
+        m_idleFrames = 0;
+    }
+
+    m_mixBuffer.assign(frames * m_format.channelCount(), 0.f);
+    for (auto it = m_voices.begin(); it != m_voices.end();) {
+        if (mixVoice(*it, m_mixBuffer.data(), frames))
+            ++it;
+        else
+            it = m_voices.erase(it);
+    }
+    writeOutput(m_mixBuffer.data(), data, frames);
+
+    m_framesMixed += frames;
+    m_lastPullFrames = frames;
+    m_lastPull.start();
+    return frames * bytesPerFrame;
+}
+
+qint64 QSoundEffectMixer::writeData(const char *data, qint64 len)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(len);
+    return 0;
+}
+
+// Adds the next \a frames of \a voice to \a out. Returns false once the voice is done.
+bool QSoundEffectMixer::mixVoice(Voice &voice, float *out, qint64 frames)
+{
+    const int channels = m_format.channelCount();
+    const int bytesPerFrame = voice.format.bytesPerFrame();
+    const char *data = voice.data.constData();
+    const qint64 end = voice.frames << PositionShift;
+
+    // sample-accurate start inside of the buffer
+    qint64 frame = 0;
+    if (voice.startFrame > m_framesMixed)
+        frame = qMin(frames, voice.startFrame - m_framesMixed);
+
+    const bool direct = voice.step == PositionOne && voice.format.channelCount() == channels
+            && voice.fadeRemaining < 0;
+    const qint64 fadeLength = qMax(m_format.framesForDuration(FadeOutUs), 1);
+
+    while (frame < frames) {
+        if (direct) {
+            const qint64 first = voice.position >> PositionShift;
+            const qint64 count = qMin(frames - frame, voice.frames - first);
+            const char *source = data + first * bytesPerFrame;
+            float *target = out + frame * channels;
+            if (voice.gain != 0.f) {
+                QAudioHelperInternal::qMixSamplesToFloat(voice.gain, voice.format, source, target,
+                                                         count * bytesPerFrame);
+            }
+            frame += count;
+            voice.position += count << PositionShift;
+        } else {
+            // different channel layout, or fading out. Voices at a different rate are
+            // interpolated linearly, which voiceFormat() is there to avoid.
+            for (; frame < frames && voice.position < end; ++frame, voice.position += voice.step) {
+                float gain = voice.gain;
+                if (voice.fadeRemaining >= 0) {
+                    if (voice.fadeRemaining == 0)
+                        return false;
+                    gain *= float(voice.fadeRemaining--) / fadeLength;
+                }
+                const qint64 index = voice.position >> PositionShift;
+                const float t = float(voice.position & (PositionOne - 1)) / PositionOne;
+                const char *current = data + index * bytesPerFrame;
+                const char *next = index + 1 < voice.frames ? current + bytesPerFrame : current;
+                float *target = out + frame * channels;
+                for (int c = 0; c < channels; ++c) {
+                    const float a = channelValue(voice.format, current, c, channels);
+                    const float b = t != 0.f ? channelValue(voice.format, next, c, channels) : a;
+                    target[c] += (a + (b - a) * t) * gain;
+                }
+            }
+        }
+
+        if (voice.position >= end) {
+            // keeps the phase of resampled voices across loops
+            voice.position -= end;
+            if (voice.loopsRemaining > 0) {
+                --voice.loopsRemaining;
+                notify(voice);
+                if (voice.loopsRemaining == 0)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+void QSoundEffectMixer::writeOutput(const float *mix, char *data, qint64 frames) const
+{
+    QAudioHelperInternal::qConvertSamplesFromFloat(mix, m_format, data, frames * m_format.channelCount());
+}
+
+QT_END_NAMESPACE
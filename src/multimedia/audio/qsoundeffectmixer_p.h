@@ -0,0 +1,133 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QSOUNDEFFECTMIXER_P_H
+#define QSOUNDEFFECTMIXER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <QtCore/qbytearray.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qiodevice.h>
+#include <QtCore/qmutex.h>
+#include <qaudio.h>
+#include <qaudiodevice.h>
+#include <qaudioformat.h>
+#include <private/qglobal_p.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+class QAudioSink;
+
+// Mixes all the sound effects playing on one audio device into a single
+// QAudioSink, which is kept open while there is something to play.
+// Lives in the application thread; voices can be controlled from any thread.
+class Q_MULTIMEDIA_EXPORT QSoundEffectMixer : public QIODevice
+{
+public:
+    using VoiceId = quint64;
+
+    // Called in the thread of the receiver whenever a loop of the voice has
+    // completed, with the number of loops left. 0 means the voice is done.
+    using LoopsCallback = std::function<void(VoiceId voice, int loopsRemaining)>;
+
+    // A negative loop count plays the voice until it is stopped
+    static constexpr int InfiniteLoops = -1;
+
+    static std::shared_ptr<QSoundEffectMixer> instance(const QAudioDevice &device);
+    ~QSoundEffectMixer() override;
+
+    QAudioDevice audioDevice() const { return m_device; }
+    QAudioFormat format() const { return m_format; }
+    // The format to convert samples in format to before starting voices of them.
+    // The mixer only resamples linearly, which aliases.
+    QAudioFormat voiceFormat(const QAudioFormat &format) const;
+
+    // dataOwner keeps data alive if it doesn't own its memory
+    VoiceId startVoice(QObject *receiver, LoopsCallback callback, const QByteArray &data,
+                       std::shared_ptr<const void> dataOwner, const QAudioFormat &format,
+                       int loops, float gain);
+    void stopVoice(VoiceId voice);
+    // Stops the voice after a short fade, which avoids clicking when cutting it off.
+    // The callback of the voice isn't called anymore.
+    void fadeOutVoice(VoiceId voice);
+    void setVoiceGain(VoiceId voice, float gain);
+    void setVoiceLoops(VoiceId voice, int loops);
+    int voiceCount() const;
+
+    qint64 bytesAvailable() const override;
+    qint64 size() const override { return 0; }
+    bool isSequential() const override { return true; }
+    bool atEnd() const override { return false; }
+
+protected:
+    qint64 readData(char *data, qint64 len) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    // 16.16 fixed point positions in the frames of a voice
+    static constexpr int PositionShift = 16;
+    static constexpr qint64 PositionOne = qint64(1) << PositionShift;
+
+    // How long silence is played after the last voice finished, before the sink is
+    // allowed to go idle. Effects starting in this window don't have to reopen it.
+    static constexpr int IdleTimeoutMs = 2000;
+
+    static constexpr int FadeOutUs = 5000;
+
+    struct Voice
+    {
+        VoiceId id = 0;
+        QObject *receiver = nullptr;
+        LoopsCallback callback;
+        QByteArray data;
+        std::shared_ptr<const void> dataOwner;
+        QAudioFormat format;
+        qint64 frames = 0;
+        qint64 position = 0;
+        qint64 step = PositionOne;
+        qint64 startFrame = 0; // mixer frame at which the voice becomes audible
+        qint64 fadeRemaining = -1; // frames left until a fading voice is silent
+        int loopsRemaining = 1;
+        float gain = 1.f;
+    };
+
+    explicit QSoundEffectMixer(const QAudioDevice &device);
+
+    Voice *findVoice(VoiceId voice);
+    void startSink();
+    void sinkStateChanged(QAudio::State state);
+    void notify(const Voice &voice) const;
+    bool mixVoice(Voice &voice, float *out, qint64 frames);
+    void writeOutput(const float *mix, char *data, qint64 frames) const;
+
+    const QAudioDevice m_device;
+    QAudioFormat m_format;
+    QAudioSink *m_sink = nullptr;
+
+    mutable QMutex m_mutex;
+    std::vector<Voice> m_voices;
+    std::vector<float> m_mixBuffer;
+    VoiceId m_nextVoiceId = 1;
+    qint64 m_framesMixed = 0;
+    qint64 m_lastPullFrames = 0;
+    qint64 m_idleFrames = 0;
+    QElapsedTimer m_lastPull;
+};
+
+QT_END_NAMESPACE
+
+#endif // QSOUNDEFFECTMIXER_P_H
@@ -1,11 +1,13 @@
 // Copyright (C) 2021 The Qt Company Ltd.
 // SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
 
-#include "qwavedecoder.h"
+#include "qwavedecoder_p.h"
 
 #include <QtCore/qtimer.h>
 #include <QtCore/qendian.h>
+#include <QtCore/qfiledevice.h>
 #include <limits.h>
+#include <limits>
 #include <qdebug.h>
 
 QT_BEGIN_NAMESPACE
@@ -16,7 +18,6 @@ void bswap2(char *data, qsizetype count) noexcept
 {
     for (qsizetype i = 0; i < count; ++i) {
         qSwap(data[0], data[1]);
-        ++count;
         data += 2;
     }
 }
@@ -26,46 +27,116 @@ void bswap4(char *data, qsizetype count) noexcept
     for (qsizetype i = 0; i < count; ++i) {
         qSwap(data[0], data[3]);
         qSwap(data[1], data[2]);
-        ++count;
         data += 4;
     }
 }
 
+// Keeps the upper 16 bits of packed 24 bit samples, in host byte order
+void convert24To16(const char *src, char *dst, qsizetype count, bool bigEndian) noexcept
+{
+    const uchar *in = reinterpret_cast<const uchar *>(src);
+    for (qsizetype i = 0; i < count; ++i) {
+        const quint16 value = bigEndian ? (in[0] << 8) | in[1] : (in[2] << 8) | in[1];
+        qToUnaligned(value, dst);
+        in += 3;
+        dst += 2;
+    }
+}
+
+// Wave64 identifies the file and its chunks by GUIDs. The ones for the chunks
+// start with the RIFF chunk ids and end in the same 12 bytes.
+constexpr uchar wave64RiffGuid[16] = { 'r', 'i', 'f', 'f', 0x2e, 0x91, 0xcf, 0x11,
+                                       0xa5, 0xd6, 0x28, 0xdb, 0x04, 0xc1, 0x00, 0x00 };
+constexpr uchar wave64GuidTail[12] = { 0xf3, 0xac, 0xd3, 0x11, 0x8c, 0xd1,
+                                       0x00, 0xc0, 0x4f, 0x8e, 0xdb, 0x8a };
+constexpr int wave64HeaderLength = 40; // riff GUID, 64 bit size, wave GUID
+constexpr int wave64ChunkHeaderLength = 24; // GUID, 64 bit size
+
+// The contents of a ds64 chunk that we need: the 64 bit RIFF and data sizes
+constexpr int ds64Length = 16;
+
+// RIFF and RF64 files store sizes that don't fit in 32 bits as this
+constexpr quint32 unknownSize = 0xffffffff;
+
+struct chunk
+{
+    char        id[4];
+    quint32     size;
+};
+
+struct RIFFHeader
+{
+    chunk       descriptor;
+    char        type[4];
+};
+struct WAVEHeader
+{
+    chunk       descriptor;
+    quint16     audioFormat;
+    quint16     numChannels;
+    quint32     sampleRate;
+    quint32     byteRate;
+    quint16     blockAlign;
+    quint16     bitsPerSample;
+};
+
+struct DATAHeader
+{
+    chunk       descriptor;
+};
+
+struct CombinedHeader
+{
+    RIFFHeader  riff;
+    WAVEHeader  wave;
+    DATAHeader  data;
+};
+constexpr int HeaderLength = sizeof(CombinedHeader);
+
 }
 
 QWaveDecoder::QWaveDecoder(QIODevice *device, QObject *parent)
-    : QIODevice(parent),
-      device(device)
+    : QIODevice(*new QWaveDecoderPrivate, parent)
 {
+    Q_D(QWaveDecoder);
+    d->device = device;
 }
 
 QWaveDecoder::QWaveDecoder(QIODevice *device, const QAudioFormat &format, QObject *parent)
-    : QIODevice(parent),
-        device(device),
-        format(format)
+    : QIODevice(*new QWaveDecoderPrivate, parent)
 {
+    Q_D(QWaveDecoder);
+    d->device = device;
+    d->format = format;
 }
 
-QWaveDecoder::~QWaveDecoder() = default;
+QWaveDecoder::~QWaveDecoder()
+{
+    Q_D(QWaveDecoder);
+    d->unmapData();
+}
 
 bool QWaveDecoder::open(QIODevice::OpenMode mode)
 {
+    Q_D(QWaveDecoder);
     bool canOpen = false;
     if (mode & QIODevice::ReadOnly && mode & ~QIODevice::WriteOnly) {
         canOpen = QIODevice::open(mode | QIODevice::Unbuffered);
-        if (canOpen && enoughDataAvailable())
+        if (!canOpen)
+            return false;
+        // handleData() disconnects once it has found the samples
+        connect(d->device, SIGNAL(readyRead()), SLOT(handleData()));
+        if (enoughDataAvailable())
             handleData();
-        else
-            connect(device, SIGNAL(readyRead()), SLOT(handleData()));
-        return canOpen;
+        return true;
     }
 
     if (mode & QIODevice::WriteOnly) {
-        if (format.sampleFormat() != QAudioFormat::Int16)
+        if (d->format.sampleFormat() != QAudioFormat::Int16)
             return false; // data format is not supported
         canOpen = QIODevice::open(mode);
         if (canOpen && writeHeader())
-            haveHeader = true;
+            d->haveHeader = true;
         return canOpen;
     }
     return QIODevice::open(mode);
@@ -73,63 +144,94 @@ bool QWaveDecoder::open(QIODevice::OpenMode mode)
 
 void QWaveDecoder::close()
 {
+    Q_D(QWaveDecoder);
     if (isOpen() && (openMode() & QIODevice::WriteOnly)) {
-        Q_ASSERT(dataSize < INT_MAX);
-        if (!device->isOpen() || !writeDataLength())
+        Q_ASSERT(d->dataSize < INT_MAX);
+        if (!d->device->isOpen() || !writeDataLength())
             qWarning() << "Failed to finalize wav file";
     }
+    d->unmapData();
     QIODevice::close();
 }
 
+// When reading, positions are offsets in the samples as read() returns them,
+// which seek() maps to where those samples are in the device.
 bool QWaveDecoder::seek(qint64 pos)
 {
-    return device->seek(pos);
+    Q_D(QWaveDecoder);
+    if (!(openMode() & QIODevice::ReadOnly))
+        return d->device->seek(pos);
+
+    if (!d->haveFormat || pos < 0 || pos > size() || isSequential())
+        return false;
+
+    // only ever continue reading at the start of a frame
+    pos -= pos % d->format.bytesPerFrame();
+    const qint64 offset = d->bps == 24 ? pos / 2 * 3 : pos;
+    if (!d->mappedData && !d->device->seek(d->dataStart + offset))
+        return false;
+    d->dataPos = offset;
+    return QIODevice::seek(pos);
 }
 
 qint64 QWaveDecoder::pos() const
 {
-    return device->pos();
+    Q_D(const QWaveDecoder);
+    if (openMode() & QIODevice::ReadOnly)
+        return QIODevice::pos();
+    return d->device->pos();
 }
 
 QAudioFormat QWaveDecoder::audioFormat() const
 {
-    return format;
+    Q_D(const QWaveDecoder);
+    return d->format;
 }
 
 QIODevice* QWaveDecoder::getDevice()
 {
-    return device;
+    Q_D(QWaveDecoder);
+    return d->device;
 }
 
 int QWaveDecoder::duration() const
 {
+    Q_D(const QWaveDecoder);
     if (openMode() & QIODevice::WriteOnly)
         return 0;
-    int bytesPerSec = format.bytesPerFrame() * format.sampleRate();
+    int bytesPerSec = d->format.bytesPerFrame() * d->format.sampleRate();
     return bytesPerSec ? size() * 1000 / bytesPerSec : 0;
 }
 
 qint64 QWaveDecoder::size() const
 {
+    Q_D(const QWaveDecoder);
     if (openMode() & QIODevice::ReadOnly) {
-        if (!haveFormat)
+        if (!d->haveFormat)
             return 0;
-        if (bps == 24)
-            return dataSize*2/3;
-        return dataSize;
+        if (d->bps == 24)
+            return d->dataSize / 3 * 2;
+        return d->dataSize;
     } else {
-        return device->size();
+        return d->device->size();
     }
 }
 
 bool QWaveDecoder::isSequential() const
 {
-    return device->isSequential();
+    Q_D(const QWaveDecoder);
+    return d->device->isSequential();
 }
 
 qint64 QWaveDecoder::bytesAvailable() const
 {
-    return haveFormat ? device->bytesAvailable() : 0;
+    Q_D(const QWaveDecoder);
+    if (!d->haveFormat)
+        return 0;
+    qint64 available = d->dataLimit - d->dataPos;
+    if (!d->mappedData)
+        available = qMin(available, d->device->bytesAvailable());
+    return d->bps == 24 ? available / 3 * 2 : available;
 }
 
 qint64 QWaveDecoder::headerLength()
@@ -139,39 +241,62 @@ qint64 QWaveDecoder::headerLength()
 
 qint64 QWaveDecoder::readData(char *data, qint64 maxlen)
 {
-    if (!haveFormat || format.bytesPerSample() == 0)
+    Q_D(QWaveDecoder);
+    if (!d->haveFormat || d->format.bytesPerSample() == 0)
+        return 0;
+
+    if (!d->mapAttempted)
+        d->mapData();
+
+    // read whole samples, and nothing after the data chunk
+    const int sampleSize = d->bps / 8;
+    qint64 length = qMin(d->bps == 24 ? maxlen / 2 * 3 : maxlen, d->dataLimit - d->dataPos);
+    if (!d->mappedData && d->device->isSequential())
+        length = qMin(length, d->device->bytesAvailable());
+    length -= length % sampleSize;
+    if (length <= 0)
         return 0;
 
-    if (bps == 24) {
+    if (d->bps == 24) {
         // 24 bit WAV, read in as 16 bit
+        char buffer[3 * 1024];
         qint64 l = 0;
-        while (l < maxlen - 1) {
-            char tmp[3];
-            device->read(tmp, 3);
-            if (byteSwap)
-                qSwap(tmp[0], tmp[2]);
-#if Q_BYTE_ORDER == Q_BIG_ENDIAN
-            data[0] = tmp[0];
-            data[1] = tmp[1];
-#else
-            data[0] = tmp[1];
-            data[1] = tmp[2];
-#endif
-            data += 2;
-            l += 2;
+        qint64 remaining = length;
+        while (remaining > 0) {
+            const char *samples = buffer;
+            qint64 read = remaining;
+            if (d->mappedData) {
+                samples = d->mappedData + d->dataPos;
+            } else {
+                read = d->device->read(buffer, qMin(remaining, qint64(sizeof(buffer))));
+                if (read <= 0)
+                    break;
+            }
+            convert24To16(samples, data + l, read / 3, d->bigEndian);
+            l += read / 3 * 2;
+            d->dataPos += read;
+            remaining -= read;
+            if (read % 3)
+                break; // the file is cut off
         }
         return l;
     }
 
-    qint64 nSamples = maxlen / format.bytesPerSample();
-    maxlen = nSamples * format.bytesPerSample();
-    int read = device->read(data, maxlen);
+    qint64 read = length;
+    if (d->mappedData) {
+        memcpy(data, d->mappedData + d->dataPos, length);
+    } else {
+        read = d->device->read(data, length);
+        if (read <= 0)
+            return read;
+    }
+    d->dataPos += read;
 
-    if (!byteSwap || format.bytesPerFrame() == 1)
+    if (!d->byteSwap || d->format.bytesPerFrame() == 1)
         return read;
 
-    nSamples = read / format.bytesPerSample();
-    switch (format.bytesPerSample()) {
+    const qint64 nSamples = read / d->format.bytesPerSample();
+    switch (d->format.bytesPerSample()) {
     case 2:
         bswap2(data, nSamples);
         break;
@@ -182,21 +307,22 @@ qint64 QWaveDecoder::readData(char *data, qint64 maxlen)
         Q_UNREACHABLE();
     }
     return read;
-
 }
 
 qint64 QWaveDecoder::writeData(const char *data, qint64 len)
 {
-    if (!haveHeader)
+    Q_D(QWaveDecoder);
+    if (!d->haveHeader)
         return 0;
-    qint64 written = device->write(data, len);
-    dataSize += written;
+    qint64 written = d->device->write(data, len);
+    d->dataSize += written;
     return written;
 }
 
 bool QWaveDecoder::writeHeader()
 {
-    if (device->size() != 0)
+    Q_D(QWaveDecoder);
+    if (d->device->size() != 0)
         return false;
 
 #ifndef Q_LITTLE_ENDIAN
@@ -210,7 +336,7 @@ bool QWaveDecoder::writeHeader()
 
     // RIFF header
     memcpy(header.riff.descriptor.id,"RIFF",4);
-    qToLittleEndian<quint32>(quint32(dataSize + HeaderLength - 8),
+    qToLittleEndian<quint32>(quint32(d->dataSize + HeaderLength - 8),
                              reinterpret_cast<unsigned char*>(&header.riff.descriptor.size));
     memcpy(header.riff.type, "WAVE",4);
 
@@ -220,27 +346,28 @@ bool QWaveDecoder::writeHeader()
                              reinterpret_cast<unsigned char*>(&header.wave.descriptor.size));
     qToLittleEndian<quint16>(quint16(1),
                              reinterpret_cast<unsigned char*>(&header.wave.audioFormat));
-    qToLittleEndian<quint16>(quint16(format.channelCount()),
+    qToLittleEndian<quint16>(quint16(d->format.channelCount()),
                              reinterpret_cast<unsigned char*>(&header.wave.numChannels));
-    qToLittleEndian<quint32>(quint32(format.sampleRate()),
+    qToLittleEndian<quint32>(quint32(d->format.sampleRate()),
                              reinterpret_cast<unsigned char*>(&header.wave.sampleRate));
-    qToLittleEndian<quint32>(quint32(format.sampleRate() * format.bytesPerFrame()),
+    qToLittleEndian<quint32>(quint32(d->format.sampleRate() * d->format.bytesPerFrame()),
                              reinterpret_cast<unsigned char*>(&header.wave.byteRate));
-    qToLittleEndian<quint16>(quint16(format.channelCount() * format.bytesPerSample()),
+    qToLittleEndian<quint16>(quint16(d->format.channelCount() * d->format.bytesPerSample()),
                              reinterpret_cast<unsigned char*>(&header.wave.blockAlign));
-    qToLittleEndian<quint16>(quint16(format.bytesPerSample() * 8),
+    qToLittleEndian<quint16>(quint16(d->format.bytesPerSample() * 8),
                              reinterpret_cast<unsigned char*>(&header.wave.bitsPerSample));
 
     // DATA header
     memcpy(header.data.descriptor.id,"data",4);
-    qToLittleEndian<quint32>(quint32(dataSize),
+    qToLittleEndian<quint32>(quint32(d->dataSize),
                              reinterpret_cast<unsigned char*>(&header.data.descriptor.size));
 
-    return device->write(reinterpret_cast<const char *>(&header), HeaderLength);
+    return d->device->write(reinterpret_cast<const char *>(&header), HeaderLength);
 }
 
 bool QWaveDecoder::writeDataLength()
 {
+    Q_D(QWaveDecoder);
 #ifndef Q_LITTLE_ENDIAN
     // only implemented for LITTLE ENDIAN
     return false;
@@ -250,109 +377,130 @@ bool QWaveDecoder::writeDataLength()
         return false;
 
     // seek to RIFF header size, see header.riff.descriptor.size above
-    if (!device->seek(4)) {
+    if (!d->device->seek(4)) {
         qDebug() << "can't seek";
         return false;
     }
 
-    quint32 length = dataSize + HeaderLength - 8;
-    if (device->write(reinterpret_cast<const char *>(&length), 4) != 4)
+    quint32 length = d->dataSize + HeaderLength - 8;
+    if (d->device->write(reinterpret_cast<const char *>(&length), 4) != 4)
         return false;
 
     // seek to DATA header size, see header.data.descriptor.size above
-    if (!device->seek(40))
+    if (!d->device->seek(40))
         return false;
 
-    return device->write(reinterpret_cast<const char *>(&dataSize), 4);
+    return d->device->write(reinterpret_cast<const char *>(&d->dataSize), 4);
 }
 
 void QWaveDecoder::parsingFailed()
 {
-    Q_ASSERT(device);
-    device->disconnect(SIGNAL(readyRead()), this, SLOT(handleData()));
+    Q_D(QWaveDecoder);
+    Q_ASSERT(d->device);
+    d->device->disconnect(SIGNAL(readyRead()), this, SLOT(handleData()));
     emit parsingError();
 }
 
 void QWaveDecoder::handleData()
 {
+    Q_D(QWaveDecoder);
     if (openMode() == QIODevice::WriteOnly)
         return;
 
     // As a special "state", if we have junk to skip, we do
-    if (junkToSkip > 0) {
-        discardBytes(junkToSkip); // this also updates junkToSkip
+    if (d->junkToSkip > 0) {
+        d->discardBytes(d->junkToSkip); // this also updates junkToSkip
 
         // If we couldn't skip all the junk, return
-        if (junkToSkip > 0) {
+        if (d->junkToSkip > 0) {
             // We might have run out
-            if (device->atEnd())
+            if (d->device->atEnd())
                 parsingFailed();
             return;
         }
     }
 
-    if (state == QWaveDecoder::InitialState) {
-        if (device->bytesAvailable() < qint64(sizeof(RIFFHeader)))
+    if (d->state == QWaveDecoderPrivate::InitialState) {
+        if (d->device->bytesAvailable() < qint64(sizeof(RIFFHeader)))
             return;
 
-        RIFFHeader riff;
-        device->read(reinterpret_cast<char *>(&riff), sizeof(RIFFHeader));
+        char id[4];
+        d->device->peek(id, sizeof(id));
+        if (qstrncmp(id, "riff", 4) == 0) {
+            if (d->device->bytesAvailable() < wave64HeaderLength)
+                return;
 
-        // RIFF = little endian RIFF, RIFX = big endian RIFF
-        if (((qstrncmp(riff.descriptor.id, "RIFF", 4) != 0) && (qstrncmp(riff.descriptor.id, "RIFX", 4) != 0))
-                || qstrncmp(riff.type, "WAVE", 4) != 0) {
-            parsingFailed();
-            return;
+            uchar header[wave64HeaderLength];
+            d->device->read(reinterpret_cast<char *>(header), wave64HeaderLength);
+            if (memcmp(header, wave64RiffGuid, sizeof(wave64RiffGuid)) != 0
+                    || qstrncmp(reinterpret_cast<const char *>(header) + 24, "wave", 4) != 0
+                    || memcmp(header + 28, wave64GuidTail, sizeof(wave64GuidTail)) != 0) {
+                parsingFailed();
+                return;
+            }
+            d->container = QWaveDecoderPrivate::Wave64;
+        } else {
+            RIFFHeader riff;
+            d->device->read(reinterpret_cast<char *>(&riff), sizeof(RIFFHeader));
+
+            // RIFF = little endian RIFF, RIFX = big endian RIFF, RF64 and BW64 are
+            // little endian RIFF with 64 bit sizes
+            if (((qstrncmp(riff.descriptor.id, "RIFF", 4) != 0) && (qstrncmp(riff.descriptor.id, "RIFX", 4) != 0)
+                        && (qstrncmp(riff.descriptor.id, "RF64", 4) != 0) && (qstrncmp(riff.descriptor.id, "BW64", 4) != 0))
+                    || qstrncmp(riff.type, "WAVE", 4) != 0) {
+                parsingFailed();
+                return;
+            }
+
+            d->bigEndian = (qstrncmp(riff.descriptor.id, "RIFX", 4) == 0);
+            if (qstrncmp(riff.descriptor.id, "RF64", 4) == 0 || qstrncmp(riff.descriptor.id, "BW64", 4) == 0)
+                d->container = QWaveDecoderPrivate::RF64;
         }
 
-        state = QWaveDecoder::WaitingForFormatState;
-        bigEndian = (qstrncmp(riff.descriptor.id, "RIFX", 4) == 0);
-        byteSwap = (bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian));
+        d->state = QWaveDecoderPrivate::WaitingForFormatState;
+        d->byteSwap = (d->bigEndian != (QSysInfo::ByteOrder == QSysInfo::BigEndian));
     }
 
-    if (state == QWaveDecoder::WaitingForFormatState) {
-        if (findChunk("fmt ")) {
-            chunk descriptor;
-            peekChunk(&descriptor);
+    if (d->state == QWaveDecoderPrivate::WaitingForFormatState) {
+        if (d->findChunk("fmt ")) {
+            QWaveDecoderPrivate::ChunkInfo descriptor;
+            d->peekChunk(&descriptor);
 
-            quint32 rawChunkSize = descriptor.size + sizeof(chunk);
-            if (device->bytesAvailable() < qint64(rawChunkSize))
+            const qint64 rawChunkSize = d->chunkLength(descriptor);
+            if (d->device->bytesAvailable() < rawChunkSize)
                 return;
 
-            WAVEHeader wave;
-            device->read(reinterpret_cast<char *>(&wave), sizeof(WAVEHeader));
-
-            if (rawChunkSize > sizeof(WAVEHeader))
-                discardBytes(rawChunkSize - sizeof(WAVEHeader));
-
-            // Swizzle this
-            if (bigEndian) {
-                wave.audioFormat = qFromBigEndian<quint16>(wave.audioFormat);
-            } else {
-                wave.audioFormat = qFromLittleEndian<quint16>(wave.audioFormat);
+            // the PCM format, without any extension
+            char wave[wave64ChunkHeaderLength + 16];
+            if (descriptor.size < 16
+                    || d->device->read(wave, descriptor.headerSize + 16) != descriptor.headerSize + 16) {
+                parsingFailed();
+                return;
             }
-
-            if (wave.audioFormat != 0 && wave.audioFormat != 1) {
+            d->discardBytes(rawChunkSize - descriptor.headerSize - 16);
+
+            const char *fields = wave + descriptor.headerSize;
+            const auto read16 = [d](const char *p) -> quint16 {
+                return d->bigEndian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+            };
+            const auto read32 = [d](const char *p) -> quint32 {
+                return d->bigEndian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            };
+
+            const quint16 audioFormat = read16(fields);
+            if (audioFormat != 0 && audioFormat != 1) {
                 // 32bit wave files have format == 0xFFFE (WAVE_FORMAT_EXTENSIBLE).
                 // but don't support them at the moment.
                 parsingFailed();
                 return;
             }
 
-            int rate;
-            int channels;
-            if (bigEndian) {
-                 bps = qFromBigEndian<quint16>(wave.bitsPerSample);
-                 rate = qFromBigEndian<quint32>(wave.sampleRate);
-                 channels = qFromBigEndian<quint16>(wave.numChannels);
-            } else {
-                bps = qFromLittleEndian<quint16>(wave.bitsPerSample);
-                rate = qFromLittleEndian<quint32>(wave.sampleRate);
-                channels = qFromLittleEndian<quint16>(wave.numChannels);
-            }
+            const int channels = read16(fields + 2);
+            const int rate = read32(fields + 4);
+            d->bps = read16(fields + 14);
 
             QAudioFormat::SampleFormat fmt = QAudioFormat::Unknown;
-            switch(bps) {
+            switch(d->bps) {
             case 8:
                 fmt = QAudioFormat::UInt8;
                 break;
@@ -371,31 +519,44 @@ void QWaveDecoder::handleData()
                 return;
             }
 
-            format.setSampleFormat(fmt);
-            format.setSampleRate(/*qFromBigEndian<quint32>*/(wave.sampleRate));
-            format.setChannelCount(/*qFromBigEndian<quint16>*/(wave.numChannels));
+            d->format.setSampleFormat(fmt);
+            d->format.setSampleRate(rate);
+            d->format.setChannelCount(channels);
 
-            state = QWaveDecoder::WaitingForDataState;
+            d->state = QWaveDecoderPrivate::WaitingForDataState;
         }
     }
 
-    if (state == QWaveDecoder::WaitingForDataState) {
-        if (findChunk("data")) {
-            device->disconnect(SIGNAL(readyRead()), this, SLOT(handleData()));
-
-            chunk descriptor;
-            device->read(reinterpret_cast<char *>(&descriptor), sizeof(chunk));
-            if (bigEndian)
-                descriptor.size = qFromBigEndian<quint32>(descriptor.size);
-            else
-                descriptor.size = qFromLittleEndian<quint32>(descriptor.size);
-
-            dataSize = descriptor.size; //means the data size from the data header, not the actual file size
-            if (!dataSize)
-                dataSize = device->size() - headerLength();
+    if (d->state == QWaveDecoderPrivate::WaitingForDataState) {
+        if (d->findChunk("data")) {
+            d->device->disconnect(SIGNAL(readyRead()), this, SLOT(handleData()));
+
+            QWaveDecoderPrivate::ChunkInfo descriptor;
+            d->peekChunk(&descriptor);
+            d->device->skip(descriptor.headerSize);
+            d->dataStart = d->device->pos();
+
+            // means the data size from the data header, not the actual file size
+            qint64 size = descriptor.size;
+            bool sizeKnown = true;
+            if (d->container == QWaveDecoderPrivate::RF64 && size == unknownSize && d->ds64DataSize >= 0)
+                size = d->ds64DataSize;
+            else if (d->container != QWaveDecoderPrivate::Wave64 && size == unknownSize)
+                sizeKnown = false; // not finalized, the samples go up to the end
+
+            if (!d->device->isSequential()) {
+                // recordings that were cut off don't have all the samples the header claims
+                const qint64 available = qMax(d->device->size() - d->dataStart, qint64(0));
+                d->dataSize = sizeKnown ? qMin(size, available) : available;
+                d->dataLimit = d->dataSize;
+            } else {
+                d->dataSize = sizeKnown ? size : qMax(d->device->size() - d->dataStart, qint64(0));
+                d->dataLimit = sizeKnown ? size : std::numeric_limits<qint64>::max();
+            }
+            d->dataPos = 0;
 
-            haveFormat = true;
-            connect(device, SIGNAL(readyRead()), SIGNAL(readyRead()));
+            d->haveFormat = true;
+            connect(d->device, SIGNAL(readyRead()), SIGNAL(readyRead()));
             emit formatKnown();
 
             return;
@@ -403,33 +564,41 @@ void QWaveDecoder::handleData()
     }
 
     // If we hit the end without finding data, it's a parsing error
-    if (device->atEnd()) {
+    if (d->device->atEnd()) {
         parsingFailed();
     }
 }
 
 bool QWaveDecoder::enoughDataAvailable()
 {
+    Q_D(QWaveDecoder);
+    // Random access devices have all of the file available
+    if (!d->device->isSequential())
+        return true;
+
     chunk descriptor;
-    if (!peekChunk(&descriptor, false))
+    if (d->device->peek(reinterpret_cast<char *>(&descriptor), sizeof(chunk)) != qint64(sizeof(chunk)))
         return false;
 
     // This is only called for the RIFF/RIFX header, before bigEndian is set,
-    // so we have to manually swizzle
+    // so we have to manually swizzle. The size of RF64 and Wave64 files isn't
+    // in there, those are parsed as their data arrives.
     if (qstrncmp(descriptor.id, "RIFX", 4) == 0)
         descriptor.size = qFromBigEndian<quint32>(descriptor.size);
-    if (qstrncmp(descriptor.id, "RIFF", 4) == 0)
+    else if (qstrncmp(descriptor.id, "RIFF", 4) == 0)
         descriptor.size = qFromLittleEndian<quint32>(descriptor.size);
+    else
+        return false;
 
-    if (device->bytesAvailable() < qint64(sizeof(chunk) + descriptor.size))
+    if (d->device->bytesAvailable() < qint64(sizeof(chunk) + descriptor.size))
         return false;
 
     return true;
 }
 
-bool QWaveDecoder::findChunk(const char *chunkId)
+bool QWaveDecoderPrivate::findChunk(const char *chunkId)
 {
-    chunk descriptor;
+    ChunkInfo descriptor;
 
     do {
         if (!peekChunk(&descriptor))
@@ -438,9 +607,17 @@ bool QWaveDecoder::findChunk(const char *chunkId)
         if (qstrncmp(descriptor.id, chunkId, 4) == 0)
             return true;
 
+        // RF64 keeps the sizes that don't fit into the chunk headers in ds64
+        if (container == RF64 && qstrncmp(descriptor.id, "ds64", 4) == 0 && descriptor.size >= ds64Length) {
+            char ds64[sizeof(chunk) + ds64Length];
+            if (device->peek(ds64, sizeof(ds64)) != qint64(sizeof(ds64)))
+                return false;
+            ds64DataSize = qFromLittleEndian<quint64>(ds64 + sizeof(chunk) + 8);
+        }
+
         // It's possible that bytes->available() is less than the chunk size
         // if it's corrupt.
-        junkToSkip = qint64(sizeof(chunk) + descriptor.size);
+        junkToSkip = chunkLength(descriptor);
 
         // Skip the current amount
         if (junkToSkip > 0)
@@ -456,41 +633,91 @@ bool QWaveDecoder::findChunk(const char *chunkId)
     return false;
 }
 
-bool QWaveDecoder::peekChunk(chunk *pChunk, bool handleEndianness)
+bool QWaveDecoderPrivate::peekChunk(ChunkInfo *info)
 {
+    if (container == Wave64) {
+        char header[wave64ChunkHeaderLength];
+        if (device->bytesAvailable() < qint64(sizeof(header)))
+            return false;
+        if (device->peek(header, sizeof(header)) != qint64(sizeof(header)))
+            return false;
+
+        memcpy(info->id, header, 4);
+        // a chunk we don't know about, which only matches by chance
+        if (memcmp(header + 4, wave64GuidTail, sizeof(wave64GuidTail)) != 0)
+            memset(info->id, 0, 4);
+        // the size includes the header
+        const quint64 size = qFromLittleEndian<quint64>(header + 16);
+        if (size < quint64(wave64ChunkHeaderLength) || size > quint64(std::numeric_limits<qint64>::max()))
+            return false;
+        info->size = qint64(size) - wave64ChunkHeaderLength;
+        info->headerSize = wave64ChunkHeaderLength;
+        return true;
+    }
+
+    chunk descriptor;
     if (device->bytesAvailable() < qint64(sizeof(chunk)))
         return false;
 
-    if (!device->peek(reinterpret_cast<char *>(pChunk), sizeof(chunk)))
+    if (device->peek(reinterpret_cast<char *>(&descriptor), sizeof(chunk)) != qint64(sizeof(chunk)))
         return false;
 
-    if (handleEndianness) {
-        if (bigEndian)
-            pChunk->size = qFromBigEndian<quint32>(pChunk->size);
-        else
-            pChunk->size = qFromLittleEndian<quint32>(pChunk->size);
-    }
+    memcpy(info->id, descriptor.id, 4);
+    if (bigEndian)
+        info->size = qFromBigEndian<quint32>(descriptor.size);
+    else
+        info->size = qFromLittleEndian<quint32>(descriptor.size);
+    info->headerSize = sizeof(chunk);
     return true;
 }
 
-void QWaveDecoder::discardBytes(qint64 numBytes)
+// The length of the chunk in the device, with the padding that aligns the next
+// one to 2 bytes, or 8 bytes in Wave64
+qint64 QWaveDecoderPrivate::chunkLength(const ChunkInfo &info) const
+{
+    const qint64 length = info.headerSize + info.size;
+    const qint64 alignment = container == Wave64 ? 8 : 2;
+    return (length + alignment - 1) / alignment * alignment;
+}
+
+void QWaveDecoderPrivate::discardBytes(qint64 numBytes)
 {
-    // Discards a number of bytes
+    // Discards a number of bytes, seeking over them on random access devices
+    // and reading what's there already from sequential ones.
     // If the iodevice doesn't have this many bytes in it,
     // remember how much more junk we have to skip.
-    if (device->isSequential()) {
-        QByteArray r = device->read(qMin(numBytes, qint64(16384))); // uggh, wasted memory, limit to a max of 16k
-        if (r.size() < numBytes)
-            junkToSkip = numBytes - r.size();
-        else
-            junkToSkip = 0;
-    } else {
-        quint64 origPos = device->pos();
-        device->seek(device->pos() + numBytes);
-        junkToSkip = origPos + numBytes - device->pos();
+    const qint64 skipped = device->skip(numBytes);
+    junkToSkip = numBytes - qMax(skipped, qint64(0));
+}
+
+void QWaveDecoderPrivate::mapData()
+{
+    mapAttempted = true;
+
+    auto *file = qobject_cast<QFileDevice *>(device);
+    if (!file || file->isSequential() || dataLimit <= 0 || bps == 0)
+        return;
+
+    // falls back to reading, e.g. when the samples don't fit into the address space
+    if (uchar *data = file->map(dataStart, dataLimit)) {
+        mappedFile = file;
+        mappedData = reinterpret_cast<const char *>(data);
+        // closing the file unmaps it, so stop reading from the mapping before that
+        closeConnection = QObject::connect(file, &QIODevice::aboutToClose, q_func(),
+                                           [this] { unmapData(); });
     }
 }
 
+void QWaveDecoderPrivate::unmapData()
+{
+    QObject::disconnect(closeConnection);
+    if (mappedData && mappedFile)
+        mappedFile->unmap(reinterpret_cast<uchar *>(const_cast<char *>(mappedData)));
+    mappedFile = nullptr;
+    mappedData = nullptr;
+    mapAttempted = false;
+}
+
 QT_END_NAMESPACE
 
 #include "moc_qwavedecoder.cpp"
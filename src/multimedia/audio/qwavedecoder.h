@@ -10,6 +10,7 @@
 
 QT_BEGIN_NAMESPACE
 
+class QWaveDecoderPrivate;
 
 
 class Q_MULTIMEDIA_EXPORT QWaveDecoder : public QIODevice
@@ -50,62 +51,9 @@ private:
     bool writeHeader();
     bool writeDataLength();
     bool enoughDataAvailable();
-    bool findChunk(const char *chunkId);
-    void discardBytes(qint64 numBytes);
     void parsingFailed();
 
-    enum State {
-        InitialState,
-        WaitingForFormatState,
-        WaitingForDataState
-    };
-
-    struct chunk
-    {
-        char        id[4];
-        quint32     size;
-    };
-    bool peekChunk(chunk* pChunk, bool handleEndianness = true);
-
-    struct RIFFHeader
-    {
-        chunk       descriptor;
-        char        type[4];
-    };
-    struct WAVEHeader
-    {
-        chunk       descriptor;
-        quint16     audioFormat;
-        quint16     numChannels;
-        quint32     sampleRate;
-        quint32     byteRate;
-        quint16     blockAlign;
-        quint16     bitsPerSample;
-    };
-
-    struct DATAHeader
-    {
-        chunk       descriptor;
-    };
-
-    struct CombinedHeader
-    {
-        RIFFHeader  riff;
-        WAVEHeader  wave;
-        DATAHeader  data;
-    };
-    static const int HeaderLength = sizeof(CombinedHeader);
-
-    bool haveFormat = false;
-    bool haveHeader = false;
-    qint64 dataSize = 0;
-    QIODevice *device = nullptr;
-    QAudioFormat format;
-    State state = InitialState;
-    quint32 junkToSkip = 0;
-    bool bigEndian = false;
-    bool byteSwap = false;
-    int bps = 0;
+    Q_DECLARE_PRIVATE(QWaveDecoder)
 };
 
 QT_END_NAMESPACE
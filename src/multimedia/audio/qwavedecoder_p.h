@@ -0,0 +1,96 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QWAVEDECODER_P_H
+#define QWAVEDECODER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qwavedecoder.h>
+#include <private/qtmultimediaglobal_p.h>
+
+#include <QtCore/private/qiodevice_p.h>
+#include <QtCore/qpointer.h>
+
+QT_BEGIN_NAMESPACE
+
+class QFileDevice;
+
+class Q_MULTIMEDIA_EXPORT QWaveDecoderPrivate : public QIODevicePrivate
+{
+    Q_DECLARE_PUBLIC(QWaveDecoder)
+
+public:
+    static QWaveDecoderPrivate *get(QWaveDecoder *decoder) { return decoder->d_func(); }
+
+    // Whether the samples are stored in the device exactly as read() returns them,
+    // i.e. without byte swapping or conversion from 24 bits
+    bool isRawData() const { return haveFormat && !byteSwap && bps != 24; }
+
+    enum State {
+        InitialState,
+        WaitingForFormatState,
+        WaitingForDataState
+    };
+
+    enum Container {
+        Riff,
+        RF64, // also BW64, with 64 bit sizes in a ds64 chunk
+        Wave64
+    };
+
+    // A chunk header as found in the device. Wave64 identifies chunks by GUIDs,
+    // the ones we know start with the RIFF chunk id.
+    struct ChunkInfo
+    {
+        char        id[4];
+        qint64      size;       // of the contents
+        int         headerSize;
+    };
+
+    bool peekChunk(ChunkInfo *info);
+    qint64 chunkLength(const ChunkInfo &info) const;
+    bool findChunk(const char *chunkId);
+    void discardBytes(qint64 numBytes);
+    void mapData();
+    void unmapData();
+
+    bool haveFormat = false;
+    bool haveHeader = false;
+    qint64 dataSize = 0;
+    QIODevice *device = nullptr;
+    QAudioFormat format;
+    State state = InitialState;
+    Container container = Riff;
+    qint64 junkToSkip = 0;
+    qint64 ds64DataSize = -1;
+    bool bigEndian = false;
+    bool byteSwap = false;
+    int bps = 0;
+
+    // Where the samples are in the device, how many of their bytes can be read
+    // (unlimited while streaming a file of unknown length), and how many were.
+    qint64 dataStart = 0;
+    qint64 dataLimit = 0;
+    qint64 dataPos = 0;
+
+    // The samples of a local file are read straight from a mapping of it, which
+    // is dropped when the file is closed
+    bool mapAttempted = false;
+    QPointer<QFileDevice> mappedFile;
+    const char *mappedData = nullptr;
+    QMetaObject::Connection closeConnection;
+};
+
+QT_END_NAMESPACE
+
+#endif // QWAVEDECODER_P_H
@@ -16,10 +16,17 @@
 
 #include <private/qtmultimediaglobal_p.h>
 #include <qaudiodevice.h>
+#include <private/qaudiolevelmeter_p.h>
+
+#include <QtCore/qmutex.h>
+
+#include <functional>
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 
 class QAudioOutput;
+class QTimer;
 
 class Q_MULTIMEDIA_EXPORT QPlatformAudioOutput
 {
@@ -31,11 +38,40 @@ public:
     virtual void setMuted(bool /*muted*/) {}
     virtual void setVolume(float /*volume*/) {}
 
+    // For backends that are only handed the QAudioOutput
+    static QPlatformAudioOutput *get(const QAudioOutput &output);
+
     QAudioOutput *q = nullptr;
     QAudioDevice device;
     float volume = 1.;
     bool muted = false;
     std::function<void()>  disconnectFunction;
+
+    // The meter is only created the first time level metering is enabled. The backend
+    // takes it on its audio thread, where it's null until then.
+    std::shared_ptr<QAudioLevelMeter> levelMeter() const
+    {
+        QMutexLocker locker(&m_levelMeterMutex);
+        return m_levelMeter;
+    }
+    QAudioLevelMeter *createLevelMeter()
+    {
+        QMutexLocker locker(&m_levelMeterMutex);
+        if (!m_levelMeter)
+            m_levelMeter = std::make_shared<QAudioLevelMeter>();
+        return m_levelMeter.get();
+    }
+
+    bool levelMeteringEnabled = false;
+    int levelUpdateInterval = QAudioLevelMeter::DefaultInterval;
+    int spectrumBandCount = 0;
+    // polled from the meter by levelTimer while metering is enabled
+    QAudioLevelMeter::Levels levels;
+    QTimer *levelTimer = nullptr;
+
+private:
+    mutable QMutex m_levelMeterMutex;
+    std::shared_ptr<QAudioLevelMeter> m_levelMeter;
 };
 
 QT_END_NAMESPACE
@@ -44,6 +44,7 @@ class Q_MULTIMEDIA_EXPORT QMediaEncoderSettings
     QSize m_videoResolution = QSize(-1, -1);
     int m_videoFrameRate = -1;
     int m_videoBitRate = -1;
+    int m_videoKeyFrameInterval = -1;
 public:
 
     QMediaFormat mediaFormat() const { return m_format; }
@@ -71,6 +72,9 @@ public:
     int videoBitRate() const { return m_videoBitRate; }
     void setVideoBitRate(int bitrate) { m_videoBitRate = bitrate; }
 
+    int videoKeyFrameInterval() const { return m_videoKeyFrameInterval; }
+    void setVideoKeyFrameInterval(int interval) { m_videoKeyFrameInterval = interval; }
+
     int audioBitRate() const { return m_audioBitrate; }
     void setAudioBitRate(int bitrate) { m_audioBitrate = bitrate; }
 
@@ -90,7 +94,8 @@ public:
                m_audioChannels == other.m_audioChannels &&
                m_videoResolution == other.m_videoResolution &&
                m_videoFrameRate == other.m_videoFrameRate &&
-               m_videoBitRate == other.m_videoBitRate;
+               m_videoBitRate == other.m_videoBitRate &&
+               m_videoKeyFrameInterval == other.m_videoKeyFrameInterval;
     }
 
     bool operator!=(const QMediaEncoderSettings &other) const
@@ -110,6 +115,10 @@ public:
     virtual void resume();
     virtual void stop() = 0;
 
+    // Called when quality, video bit rate, frame rate or key frame interval change
+    // while recording. Backends apply what they can to the ongoing recording.
+    virtual void updateEncoderSettings(const QMediaEncoderSettings &) {}
+
     virtual qint64 duration() const { return m_duration; }
 
     virtual void setMetaData(const QMediaMetaData &) {}
@@ -23,8 +23,9 @@ const int SinkPeriodTimeMs = 20;
 static void  outputStreamWriteCallback(pa_stream *stream, size_t length, void *userdata)
 {
     Q_UNUSED(stream);
-    Q_UNUSED(userdata);
     qCDebug(qLcPulseAudioOut) << "Write callback:" << length;
+    if (userdata)
+        static_cast<QPulseAudioSink *>(userdata)->renderCallback(length);
     QPulseAudioEngine *pulseEngine = QPulseAudioEngine::instance();
     pa_threaded_mainloop_signal(pulseEngine->mainloop(), 0);
 }
@@ -212,6 +213,86 @@ void QPulseAudioSink::startReading()
         m_tickTimer.start(m_periodTime, this);
 }
 
+void QPulseAudioSink::startWithCallback(AudioCallback &&callback)
+{
+    setState(QAudio::StoppedState);
+    setError(QAudio::NoError);
+
+    // Handle change of mode
+    if (m_audioSource && !m_pullMode)
+        delete m_audioSource;
+    m_audioSource = nullptr;
+
+    close();
+
+    m_pullMode = false;
+    m_callbackFrames = qMax(m_format.sampleRate() * SinkPeriodTimeMs / 1000, 1);
+    m_callbackBuffer.resize(m_callbackFrames * m_format.channelCount());
+    m_callbackOutput.resize(m_callbackFrames * m_format.bytesPerFrame());
+    m_callbackPending = 0;
+    m_callback = std::move(callback);
+
+    if (!open()) {
+        m_callback = {};
+        return;
+    }
+
+    // ensure we only process timing infos that are up to date
+    gettimeofday(&lastTimingInfo, nullptr);
+    lastProcessedUSecs = 0;
+
+    setState(QAudio::ActiveState);
+}
+
+// Called on the PulseAudio thread, with the main loop locked, whenever the
+// stream wants more data. Writes exactly what is requested; the rest of the
+// last rendered period is written with the next request.
+void QPulseAudioSink::renderCallback(size_t length)
+{
+    if (!m_callback)
+        return;
+
+    const qsizetype chunkSize = m_callbackOutput.size();
+    length -= length % m_format.bytesPerFrame();
+    while (length > 0) {
+        if (m_callbackPending == 0) {
+            renderCallbackChunk();
+            m_callbackPending = chunkSize;
+        }
+
+        const char *data = m_callbackOutput.constData() + chunkSize - m_callbackPending;
+        const size_t bytes = qMin(length, size_t(m_callbackPending));
+        if (pa_stream_write(m_stream, data, bytes, nullptr, 0, PA_SEEK_RELATIVE) < 0) {
+            qCWarning(qLcPulseAudioOut) << "pa_stream_write error:"
+                                        << pa_strerror(pa_context_errno(pa_stream_get_context(m_stream)));
+            return;
+        }
+        m_callbackPending -= bytes;
+        m_totalTimeValue += bytes;
+        length -= bytes;
+    }
+}
+
+// Renders the next period into m_callbackOutput, in the format of the stream
+void QPulseAudioSink::renderCallbackChunk()
+{
+    m_callback(m_callbackBuffer.data(), m_callbackFrames);
+
+    char *output = m_callbackOutput.data();
+    if (m_format.sampleFormat() == QAudioFormat::Float) {
+        memcpy(output, m_callbackBuffer.data(), m_callbackOutput.size());
+    } else {
+        QAudioHelperInternal::qConvertSamplesFromFloat(m_callbackBuffer.data(), m_format, output,
+                                                       m_callbackBuffer.size());
+    }
+    const float volume = m_volume.load(std::memory_order_relaxed);
+    if (volume < 1.0f || m_appliedVolume < 1.0f) {
+        QAudioHelperInternal::qMultiplySamples(m_appliedVolume, volume, m_format, output, output,
+                                               m_callbackOutput.size());
+        m_appliedVolume = volume;
+    }
+}
+
 QIODevice *QPulseAudioSink::start()
 {
     setState(QAudio::StoppedState);
@@ -328,10 +409,20 @@ bool QPulseAudioSink::open()
     requestedBuffer.maxlength = (uint32_t)-1;
     requestedBuffer.minreq = (uint32_t)-1;
     requestedBuffer.prebuf = (uint32_t)-1;
-    requestedBuffer.tlength = m_bufferSize;
+    requestedBuffer.tlength = m_bufferSize > 0 ? m_bufferSize : (uint32_t)-1;
+
+    // The callback renders whole periods, so ask for those, and buffer at least two
+    // of them so that one can be rendered while the other plays
+    if (m_callback) {
+        const uint32_t chunkSize = m_callbackFrames * m_format.bytesPerFrame();
+        requestedBuffer.minreq = chunkSize;
+        if (m_bufferSize > 0)
+            requestedBuffer.tlength = qMax(uint32_t(m_bufferSize), 2 * chunkSize);
+    }
 
     pa_stream_flags flags = pa_stream_flags(PA_STREAM_AUTO_TIMING_UPDATE|PA_STREAM_ADJUST_LATENCY);
-    if (pa_stream_connect_playback(m_stream, m_device.data(), (m_bufferSize > 0) ? &requestedBuffer : nullptr, flags, nullptr, nullptr) < 0) {
+    const bool requestBuffer = m_bufferSize > 0 || m_callback;
+    if (pa_stream_connect_playback(m_stream, m_device.data(), requestBuffer ? &requestedBuffer : nullptr, flags, nullptr, nullptr) < 0) {
         qCWarning(qLcPulseAudioOut) << "pa_stream_connect_playback() failed!";
         pa_stream_unref(m_stream);
         m_stream = nullptr;
@@ -377,7 +468,8 @@ bool QPulseAudioSink::open()
 
     m_opened = true;
 
-    startReading();
+    if (!m_callback)
+        startReading();
 
     m_elapsedTimeOffset = 0;
 
@@ -412,6 +504,8 @@ void QPulseAudioSink::close()
 
         pulseEngine->unlock();
     }
+    // the PulseAudio thread doesn't call it anymore
+    m_callback = {};
 
     disconnect(pulseEngine, &QPulseAudioEngine::contextFailed, this, &QPulseAudioSink::onPulseContextFailed);
 
@@ -507,10 +601,13 @@ qint64 QPulseAudioSink::write(const char *data, qint64 len)
 
     len = qMin(len, qint64(nbytes));
 
-    if (m_volume < 1.0f) {
+    const float volume = m_volume.load(std::memory_order_relaxed);
+    if (volume < 1.0f || m_appliedVolume < 1.0f) {
         // Don't use PulseAudio volume, as it might affect all other streams of the same category
-        // or even affect the system volume if flat volumes are enabled
-        QAudioHelperInternal::qMultiplySamples(m_volume, m_format, data, dest, len);
+        // or even affect the system volume if flat volumes are enabled.
+        // Volume changes are ramped over the chunk, so that they don't click.
+        QAudioHelperInternal::qMultiplySamples(m_appliedVolume, volume, m_format, data, dest, len);
+        m_appliedVolume = volume;
     } else {
         memcpy(dest, data, len);
     }
@@ -651,7 +748,8 @@ void QPulseAudioSink::resume()
 
         pulseEngine->unlock();
 
-        m_tickTimer.start(m_periodTime, this);
+        if (!m_callback)
+            m_tickTimer.start(m_periodTime, this);
 
         setState(m_suspendedInState);
         setError(QAudio::NoError);
@@ -727,15 +825,13 @@ qint64 PulseOutputPrivate::writeData(const char *data, qint64 len)
 
 void QPulseAudioSink::setVolume(qreal vol)
 {
-    if (qFuzzyCompare(m_volume, vol))
-        return;
-
-    m_volume = qBound(qreal(0), vol, qreal(1));
+    // the callback reads it on the PulseAudio thread, at the start of every period
+    m_volume.store(qBound(0.f, float(vol), 1.f), std::memory_order_relaxed);
 }
 
 qreal QPulseAudioSink::volume() const
 {
-    return m_volume;
+    return m_volume.load(std::memory_order_relaxed);
 }
 
 void QPulseAudioSink::onPulseContextFailed()
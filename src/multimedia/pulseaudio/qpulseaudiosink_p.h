@@ -28,6 +28,9 @@
 
 #include <pulse/pulseaudio.h>
 
+#include <atomic>
+#include <vector>
+
 QT_BEGIN_NAMESPACE
 
 class QPulseAudioSink : public QPlatformAudioSink
@@ -41,6 +44,7 @@ public:
 
     void start(QIODevice *device) override;
     QIODevice *start() override;
+    void startWithCallback(AudioCallback &&callback) override;
     void stop() override;
     void reset() override;
     void suspend() override;
@@ -59,6 +63,8 @@ public:
 
     void streamUnderflowCallback();
     void streamDrainedCallback();
+    void renderCallback(size_t length);
+    void renderCallbackChunk();
 
 protected:
     void timerEvent(QTimerEvent *event) override;
@@ -92,11 +98,19 @@ private:
     pa_stream *m_stream = nullptr;
     char *m_audioBuffer = nullptr;
 
+    // rendered on the PulseAudio thread, m_callbackFrames at a time
+    AudioCallback m_callback;
+    qsizetype m_callbackFrames = 0;
+    std::vector<float> m_callbackBuffer;
+    QByteArray m_callbackOutput;
+    qsizetype m_callbackPending = 0; // bytes at the end of m_callbackOutput not written yet
+
     qint64 m_totalTimeValue = 0;
     qint64 m_elapsedTimeOffset = 0;
     mutable qint64 averageLatency = 0; // average latency
     mutable qint64 lastProcessedUSecs = 0;
-    qreal m_volume = 1.0;
+    std::atomic<float> m_volume{ 1.0f };
+    float m_appliedVolume = 1.0f; // the volume the last chunk ended with
 
     QAudio::Error m_errorState = QAudio::NoError;
     QAudio::State m_deviceState = QAudio::StoppedState;
@@ -98,6 +98,12 @@ QString QMediaRecorderPrivate::msgFailedStartRecording()
     return QMediaRecorder::tr("Failed to start recording");
 }
 
+void QMediaRecorderPrivate::updateEncoderSettings()
+{
+    if (control && control->state() != QMediaRecorder::StoppedState)
+        control->updateEncoderSettings(encoderSettings);
+}
+
 /*!
     Constructs a media recorder which records the media produced by a microphone and camera.
     The media recorder is a child of \a{parent}.
@@ -670,6 +676,9 @@ void QMediaRecorder::setEncodingMode(EncodingMode mode)
     \property QMediaRecorder::quality
 
     Returns the recording quality.
+
+    Since Qt 6.6, changing the quality while recording is applied to the
+    ongoing recording, if the backend supports it.
 */
 QMediaRecorder::Quality QMediaRecorder::quality() const
 {
@@ -688,6 +697,7 @@ void QMediaRecorder::setQuality(Quality quality)
     if (d->encoderSettings.quality() == quality)
         return;
     d->encoderSettings.setQuality(quality);
+    d->updateEncoderSettings();
     emit qualityChanged();
 }
 
@@ -747,6 +757,9 @@ qreal QMediaRecorder::videoFrameRate() const
 
     A value of 0 indicates the recorder should make an optimal choice based on what is available
     from the video source and the limitations of the codec.
+
+    Since Qt 6.6, lowering the frame rate while recording makes the recorder
+    drop frames of the ongoing recording, if the backend supports it.
 */
 void QMediaRecorder::setVideoFrameRate(qreal frameRate)
 {
@@ -754,6 +767,7 @@ void QMediaRecorder::setVideoFrameRate(qreal frameRate)
     if (d->encoderSettings.videoFrameRate() == frameRate)
         return;
     d->encoderSettings.setVideoFrameRate(frameRate);
+    d->updateEncoderSettings();
     emit videoFrameRateChanged();
 }
 
@@ -773,6 +787,9 @@ int QMediaRecorder::videoBitRate() const
 */
 /*!
     Sets the video \a bitRate in bits per second.
+
+    Since Qt 6.6, changing the bit rate while recording is applied to the
+    ongoing recording, if the backend supports it.
 */
 void QMediaRecorder::setVideoBitRate(int bitRate)
 {
@@ -780,9 +797,48 @@ void QMediaRecorder::setVideoBitRate(int bitRate)
     if (d->encoderSettings.videoBitRate() == bitRate)
         return;
     d->encoderSettings.setVideoBitRate(bitRate);
+    d->updateEncoderSettings();
     emit videoBitRateChanged();
 }
 
+/*!
+    \since 6.6
+
+    Returns the maximum number of frames between two key frames of the
+    encoded video, or -1 if the encoder chooses it.
+*/
+int QMediaRecorder::videoKeyFrameInterval() const
+{
+    Q_D(const QMediaRecorder);
+    return d->encoderSettings.videoKeyFrameInterval();
+}
+
+/*!
+    \fn void QMediaRecorder::videoKeyFrameIntervalChanged()
+    \since 6.6
+
+    Signals when the key frame interval of the recorded video changes.
+*/
+/*!
+    \since 6.6
+
+    Sets the maximum number of frames between two key frames of the encoded
+    video to \a interval. A value of -1 lets the encoder choose it.
+
+    Changing the interval while recording is applied to the ongoing recording,
+    if the backend supports it. Backends that have to restart the encoder for
+    that do it at a key frame boundary.
+*/
+void QMediaRecorder::setVideoKeyFrameInterval(int interval)
+{
+    Q_D(QMediaRecorder);
+    if (d->encoderSettings.videoKeyFrameInterval() == interval)
+        return;
+    d->encoderSettings.setVideoKeyFrameInterval(interval);
+    d->updateEncoderSettings();
+    emit videoKeyFrameIntervalChanged();
+}
+
 /*!
     Returns the bit rate of the compressed audio stream in bits per second.
 */
@@ -111,6 +111,9 @@ public:
     int videoBitRate() const;
     void setVideoBitRate(int bitRate);
 
+    int videoKeyFrameInterval() const;
+    void setVideoKeyFrameInterval(int interval);
+
     int audioBitRate() const;
     void setAudioBitRate(int bitRate);
 
@@ -149,6 +152,7 @@ Q_SIGNALS:
     void videoResolutionChanged();
     void videoFrameRateChanged();
     void videoBitRateChanged();
+    void videoKeyFrameIntervalChanged();
     void audioBitRateChanged();
     void audioChannelCountChanged();
     void audioSampleRateChanged();
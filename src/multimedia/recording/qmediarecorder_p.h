@@ -35,6 +35,8 @@ public:
 
     static QString msgFailedStartRecording();
 
+    void updateEncoderSettings();
+
     QMediaCaptureSession *captureSession = nullptr;
     QPlatformMediaRecorder *control = nullptr;
     QString initErrorMessage;
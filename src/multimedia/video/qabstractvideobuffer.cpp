@@ -136,6 +136,25 @@ QRhi *QAbstractVideoBuffer::rhi() const
     \since 5.4
 */
 
+/*!
+    Maps the planes of the buffer selected by \a planeMask, where bit \c i selects
+    plane \c i, in the given \a mode. Only the data within \a region, in pixels of
+    the frame, has to be valid.
+
+    The returned data describes the whole planes, like map(); QVideoFrame adjusts it
+    to the region. Buffers that can transfer parts of their data reimplement this.
+    The default implementation maps the whole buffer.
+
+    \sa map()
+*/
+QAbstractVideoBuffer::MapData QAbstractVideoBuffer::mapRegion(QVideoFrame::MapMode mode,
+                                                             const QRect &region, int planeMask)
+{
+    Q_UNUSED(region);
+    Q_UNUSED(planeMask);
+    return map(mode);
+}
+
 /*!
     \fn QAbstractVideoBuffer::unmap()
 
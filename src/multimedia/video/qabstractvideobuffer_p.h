@@ -57,6 +57,7 @@ public:
 
     virtual QVideoFrame::MapMode mapMode() const = 0;
     virtual MapData map(QVideoFrame::MapMode mode) = 0;
+    virtual MapData mapRegion(QVideoFrame::MapMode mode, const QRect &region, int planeMask);
     virtual void unmap() = 0;
 
     virtual std::unique_ptr<QVideoFrameTextures> mapTextures(QRhi *) { return {}; }
@@ -10,6 +10,7 @@
 #include "qpainter.h"
 #include <qtextlayout.h>
 
+#include <qcache.h>
 #include <qimage.h>
 #include <qmutex.h>
 #include <qpair.h>
@@ -21,6 +22,24 @@
 
 QT_BEGIN_NAMESPACE
 
+class QVideoFramePrivate;
+
+namespace {
+
+// The images of the frames converted last, limited by their size in bytes
+struct ImageCache
+{
+    static constexpr qsizetype DefaultLimit = 32 * 1024 * 1024;
+
+    QMutex mutex;
+    QVideoFrame::ImageCachePolicy policy = QVideoFrame::PerFrameImageCache;
+    QCache<const QVideoFramePrivate *, QImage> images{ DefaultLimit };
+};
+
+Q_GLOBAL_STATIC(ImageCache, g_imageCache)
+
+}
+
 class QVideoFramePrivate : public QSharedData
 {
 public:
@@ -32,26 +51,82 @@ public:
 
     ~QVideoFramePrivate()
     {
+        if (imageShared && !g_imageCache.isDestroyed()) {
+            QMutexLocker locker(&g_imageCache->mutex);
+            g_imageCache->images.remove(this);
+        }
+
         delete buffer;
     }
 
+    QImage cachedImage() const
+    {
+        if (!image.isNull())
+            return image;
+        if (!imageShared)
+            return {};
+
+        QMutexLocker locker(&g_imageCache->mutex);
+        const QImage *cached = g_imageCache->images.object(this);
+        return cached ? *cached : QImage();
+    }
+
+    void cacheImage(const QImage &converted)
+    {
+        QMutexLocker locker(&g_imageCache->mutex);
+        switch (g_imageCache->policy) {
+        case QVideoFrame::NoImageCache:
+            break;
+        case QVideoFrame::PerFrameImageCache:
+            image = converted;
+            break;
+        case QVideoFrame::SharedImageCache:
+            // an image exceeding the limit is not cached
+            imageShared = g_imageCache->images.insert(this, new QImage(converted),
+                                                      converted.sizeInBytes());
+            break;
+        }
+    }
+
     qint64 startTime = -1;
     qint64 endTime = -1;
     QAbstractVideoBuffer::MapData mapData;
     QVideoFrameFormat format;
     QAbstractVideoBuffer *buffer = nullptr;
     int mappedCount = 0;
+    bool mappedPartially = false;
     QMutex mapMutex;
     QString subtitleText;
     QVideoFrame::RotationAngle rotationAngle = QVideoFrame::Rotation0;
     bool mirrored = false;
     QImage image;
+    bool imageShared = false;
 private:
     Q_DISABLE_COPY(QVideoFramePrivate)
 };
 
 QT_DEFINE_QESDP_SPECIALIZATION_DTOR(QVideoFramePrivate);
 
+using TextureDescription = QVideoTextureHelper::TextureDescription;
+
+// The size of a sample of a plane, which covers sizeScale pixels
+static int bytesPerTexel(QRhiTexture::Format format)
+{
+    switch (format) {
+    case QRhiTexture::R8:
+        return 1;
+    case QRhiTexture::RG8:
+    case QRhiTexture::R16:
+        return 2;
+    case QRhiTexture::RGBA8:
+    case QRhiTexture::BGRA8:
+    case QRhiTexture::RG16:
+        return 4;
+    default:
+        return 0; // opaque formats
+    }
+}
+
 /*!
     \class QVideoFrame
     \brief The QVideoFrame class represents a frame of video data.
@@ -345,18 +420,67 @@ QVideoFrame::MapMode QVideoFrame::mapMode() const
     \sa unmap(), mapMode(), bits()
 */
 bool QVideoFrame::map(QVideoFrame::MapMode mode)
+{
+    return map(mode, QRect(QPoint(), size()), AllPlanes);
+}
+
+/*!
+    Maps the contents of the planes selected by \a planeMask within \a region of
+    the frame to system memory, in the given \a mode. Bit \c i of \a planeMask
+    selects plane \c i.
+
+    While mapped, bits() returns the address of the top left pixel of the region
+    in each selected plane, and a null pointer for the other planes. For planes
+    with subsampled or packed pixels, this is the sample covering the top left
+    pixel. bytesPerLine() is the stride of the whole plane, and mappedBytes() the
+    size of the data from bits() up to the end of the region.
+
+    This is faster than mapping the whole frame when only a part of it is needed,
+    like the luma plane or a region of interest, if the frame can be transferred
+    partially to system memory.
+
+    A frame mapped to a part of its contents cannot be mapped again until it is
+    unmapped. The \a region is clipped to the frame; mapping an empty region or no
+    planes fails.
+
+    Returns true if the frame was mapped to memory and false otherwise.
+
+    \sa unmap(), bits()
+    \since 6.6
+*/
+bool QVideoFrame::map(QVideoFrame::MapMode mode, const QRect &region, int planeMask)
 {
 
     if (!d || !d->buffer)
         return false;
 
+    const auto pixelFormat = d->format.pixelFormat();
+    auto *textureDescription = QVideoTextureHelper::textureDescription(pixelFormat);
+    const int formatPlanes = textureDescription->nplanes ? (1 << textureDescription->nplanes) - 1
+                                                         : AllPlanes;
+    planeMask &= formatPlanes;
+
+    const QRect frameRect(QPoint(), size());
+    const QRect mapRegion = region.intersected(frameRect);
+    const bool partial = (region != frameRect && mapRegion != frameRect) || planeMask != formatPlanes;
+    if (partial) {
+        if (mapRegion.isEmpty() || !planeMask)
+            return false;
+
+        // the layout of the data is unknown
+        if (pixelFormat == QVideoFrameFormat::Format_Jpeg || textureDescription->strideFactor == 0
+            || !bytesPerTexel(textureDescription->textureFormat[0]))
+            return false;
+    }
+
     QMutexLocker lock(&d->mapMutex);
     if (mode == QVideoFrame::NotMapped)
         return false;
 
     if (d->mappedCount > 0) {
         //it's allowed to map the video frame multiple times in read only mode
-        if (d->buffer->mapMode() == QVideoFrame::ReadOnly
+        if (!partial && !d->mappedPartially
+                && d->buffer->mapMode() == QVideoFrame::ReadOnly
                 && mode == QVideoFrame::ReadOnly) {
             d->mappedCount++;
             return true;
@@ -370,7 +494,8 @@ bool QVideoFrame::map(QVideoFrame::MapMode mode)
     Q_ASSERT(d->mapData.nPlanes == 0);
     Q_ASSERT(d->mapData.size[0] == 0);
 
-    d->mapData = d->buffer->map(mode);
+    d->mapData = partial ? d->buffer->mapRegion(mode, mapRegion, planeMask)
+                         : d->buffer->map(mode);
     if (d->mapData.nPlanes == 0)
         return false;
 
@@ -455,6 +580,30 @@ bool QVideoFrame::map(QVideoFrame::MapMode mode)
         }
     }
 
+    if (partial) {
+        const int nPlanes = qMin(d->mapData.nPlanes, int(TextureDescription::maxPlanes));
+        for (int plane = 0; plane < 4; ++plane) {
+            if (plane >= nPlanes || !(planeMask & (1 << plane))) {
+                d->mapData.data[plane] = nullptr;
+                d->mapData.size[plane] = 0;
+                continue;
+            }
+
+            // the samples of the plane covering the region
+            const auto scale = textureDescription->sizeScale[plane];
+            const int texelBytes = bytesPerTexel(textureDescription->textureFormat[plane]);
+            const int left = mapRegion.left() / scale.x * texelBytes;
+            const int right = (mapRegion.right() / scale.x + 1) * texelBytes;
+            const int top = mapRegion.top() / scale.y;
+            const int bottom = mapRegion.bottom() / scale.y;
+            const int stride = d->mapData.bytesPerLine[plane];
+
+            d->mapData.data[plane] += top * stride + left;
+            d->mapData.size[plane] = (bottom - top) * stride + right - left;
+        }
+        d->mappedPartially = true;
+    }
+
     d->mappedCount++;
     return true;
 }
@@ -485,6 +634,7 @@ void QVideoFrame::unmap()
 
     if (d->mappedCount == 0) {
         d->mapData = {};
+        d->mappedPartially = false;
         d->buffer->unmap();
     }
 }
@@ -670,18 +820,152 @@ bool QVideoFrame::mirrored() const
 
 /*!
     Based on the pixel format converts current video frame to image.
+
+    Whether the image is kept for further calls depends on imageCachePolicy().
+
     \since 5.15
 */
 QImage QVideoFrame::toImage() const
 {
     if (!isValid())
         return {};
-    if (!d->image.isNull())
-        return d->image;
 
-    d->image = qImageFromVideoFrame(*this, rotationAngle(), mirrored(),
-                                    surfaceFormat().scanLineDirection() != QVideoFrameFormat::TopToBottom);
-    return d->image;
+    QImage image = d->cachedImage();
+    if (!image.isNull())
+        return image;
+
+    image = qImageFromVideoFrame(*this, rotationAngle(), mirrored(),
+                                 surfaceFormat().scanLineDirection() != QVideoFrameFormat::TopToBottom);
+    d->cacheImage(image);
+    return image;
+}
+
+/*!
+    Converts the video frame to an image of \a targetSize in the given \a format,
+    applying the rotation and mirroring of the frame.
+
+    This is faster than scaling the result of toImage(), since the frame is scaled
+    while it's converted. If \a targetSize is empty, the image has the size of the
+    (rotated) frame. If \a format is QImage::Format_Invalid, the image has the
+    format toImage() would return.
+
+    \since 6.6
+*/
+QImage QVideoFrame::toImage(const QSize &targetSize, QImage::Format format) const
+{
+    if (!isValid())
+        return {};
+
+    QImage image = d->cachedImage();
+    if (!image.isNull()) {
+        // already converted at full size
+        if (!targetSize.isEmpty() && image.size() != targetSize)
+            image = image.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        if (format != QImage::Format_Invalid && image.format() != format)
+            image.convertTo(format);
+        return image;
+    }
+
+    return qImageFromVideoFrame(*this, rotationAngle(), mirrored(),
+                                surfaceFormat().scanLineDirection() != QVideoFrameFormat::TopToBottom,
+                                targetSize, format);
+}
+
+/*!
+    Converts the video frame to an image of \a targetSize in the given \a format,
+    like toImage(), but without blocking the calling thread.
+
+    The conversion runs on a dedicated thread, with its own graphics resources, so
+    the thread rendering the video isn't stalled by the readback of the image.
+    Conversions finish in the order they were requested. When the conversions cannot
+    keep up with the requests, a few of them are queued and the returned future of
+    further requests is canceled right away.
+
+    \since 6.6
+*/
+QFuture<QImage> QVideoFrame::toImageAsync(const QSize &targetSize, QImage::Format format) const
+{
+    if (!isValid())
+        return QtFuture::makeReadyValueFuture(QImage());
+
+    if (!d->cachedImage().isNull())
+        return QtFuture::makeReadyValueFuture(toImage(targetSize, format));
+
+    return qImageFromVideoFrameAsync(*this, rotationAngle(), mirrored(),
+                                     surfaceFormat().scanLineDirection() != QVideoFrameFormat::TopToBottom,
+                                     targetSize, format);
+}
+
+/*!
+    \enum QVideoFrame::ImageCachePolicy
+
+    Describes how the images returned by toImage() are kept, so the frame isn't
+    converted again.
+
+    \value NoImageCache The images are not kept. Every call converts the frame.
+    \value PerFrameImageCache Each frame keeps its image for its lifetime. Queues
+        of converted frames hold an image in addition to the video data of each frame.
+    \value SharedImageCache The images of the frames converted last are kept in a
+        cache shared by all frames, up to imageCacheLimit() bytes. The least recently
+        used images are dropped first.
+
+    \since 6.6
+*/
+
+/*!
+    Sets the \a policy for keeping the images returned by toImage(). Changing the
+    policy doesn't affect the images frames already keep, except that the shared
+    cache is cleared when it isn't used anymore.
+
+    The default is PerFrameImageCache, which is how frames kept their images
+    before Qt 6.6. SharedImageCache bounds the memory of converted frames that
+    an application keeps, and has to be enabled explicitly.
+
+    \since 6.6
+*/
+void QVideoFrame::setImageCachePolicy(ImageCachePolicy policy)
+{
+    QMutexLocker locker(&g_imageCache->mutex);
+    g_imageCache->policy = policy;
+    if (policy != SharedImageCache)
+        g_imageCache->images.clear();
+}
+
+/*!
+    Returns the policy for keeping the images returned by toImage().
+
+    \since 6.6
+*/
+QVideoFrame::ImageCachePolicy QVideoFrame::imageCachePolicy()
+{
+    QMutexLocker locker(&g_imageCache->mutex);
+    return g_imageCache->policy;
+}
+
+/*!
+    Sets the maximum size in \a bytes of the images kept by the SharedImageCache
+    policy. Images larger than the limit are not cached.
+
+    The default is 32 MB.
+
+    \since 6.6
+*/
+void QVideoFrame::setImageCacheLimit(qsizetype bytes)
+{
+    QMutexLocker locker(&g_imageCache->mutex);
+    g_imageCache->images.setMaxCost(qMax(bytes, qsizetype(0)));
+}
+
+/*!
+    Returns the maximum size in bytes of the images kept by the SharedImageCache
+    policy.
+
+    \since 6.6
+*/
+qsizetype QVideoFrame::imageCacheLimit()
+{
+    QMutexLocker locker(&g_imageCache->mutex);
+    return g_imageCache->images.maxCost();
 }
 
 /*!
@@ -7,6 +7,7 @@
 #include <QtMultimedia/qtmultimediaglobal.h>
 #include <QtMultimedia/qvideoframeformat.h>
 
+#include <QtCore/qfuture.h>
 #include <QtCore/qmetatype.h>
 #include <QtCore/qshareddata.h>
 #include <QtGui/qimage.h>
@@ -48,6 +49,13 @@ public:
         Rotation270 = 270
     };
 
+    enum ImageCachePolicy
+    {
+        NoImageCache,
+        PerFrameImageCache,
+        SharedImageCache
+    };
+
     QVideoFrame();
     QVideoFrame(const QVideoFrameFormat &format);
     QVideoFrame(const QVideoFrame &other);
@@ -80,7 +88,10 @@ public:
 
     QVideoFrame::MapMode mapMode() const;
 
+    static constexpr int AllPlanes = 0xf;
+
     bool map(QVideoFrame::MapMode mode);
+    bool map(QVideoFrame::MapMode mode, const QRect &region, int planeMask = AllPlanes);
     void unmap();
 
     int bytesPerLine(int plane) const;
@@ -103,6 +114,15 @@ public:
     bool mirrored() const;
 
     QImage toImage() const;
+    QImage toImage(const QSize &targetSize,
+                   QImage::Format format = QImage::Format_Invalid) const;
+    QFuture<QImage> toImageAsync(const QSize &targetSize = {},
+                                 QImage::Format format = QImage::Format_Invalid) const;
+
+    static void setImageCachePolicy(ImageCachePolicy policy);
+    static ImageCachePolicy imageCachePolicy();
+    static void setImageCacheLimit(qsizetype bytes);
+    static qsizetype imageCacheLimit();
 
     struct PaintOptions {
         QColor backgroundColor = Qt::transparent;
@@ -8,25 +8,38 @@
 
 QT_BEGIN_NAMESPACE
 
-#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
-
-#define EXPAND_UV(u, v) \
-    int uu = u - 128; \
-    int vv = v - 128; \
-    int rv = 409 * vv + 128; \
-    int guv = 100 * uu + 208 * vv + 128; \
-    int bu = 516 * uu + 128; \
-
-static inline quint32 qYUVToARGB32(int y, int rv, int guv, int bu, int a = 0xff)
+// Derived from Kr and Kb of each standard, for 8 bit video and full range
+static constexpr YUVToRGBMatrix BT601_Video = { 16, 298, 409, 100, 208, 516 };
+static constexpr YUVToRGBMatrix BT601_Full = { 0, 256, 359, 88, 183, 454 };
+static constexpr YUVToRGBMatrix BT709_Video = { 16, 298, 459, 55, 136, 541 };
+static constexpr YUVToRGBMatrix BT709_Full = { 0, 256, 403, 48, 120, 475 };
+static constexpr YUVToRGBMatrix BT2020_Video = { 16, 298, 430, 48, 167, 548 };
+static constexpr YUVToRGBMatrix BT2020_Full = { 0, 256, 377, 42, 146, 482 };
+
+const YUVToRGBMatrix &qYUVToRGBMatrix(const QVideoFrameFormat &format)
 {
-    int yy = (y - 16) * 298;
-    return (a << 24)
-            | CLAMP((yy + rv) >> 8) << 16
-            | CLAMP((yy - guv) >> 8) << 8
-            | CLAMP((yy + bu) >> 8);
+    const bool fullRange = format.colorRange() == QVideoFrameFormat::ColorRange_Full;
+
+    switch (format.colorSpace()) {
+    case QVideoFrameFormat::ColorSpace_Undefined:
+        // same guess as the GPU path: HD video is BT709, SD video BT601
+        if (format.frameHeight() > 576)
+            return fullRange ? BT709_Full : BT709_Video;
+        return fullRange ? BT601_Full : BT601_Video;
+    case QVideoFrameFormat::ColorSpace_AdobeRgb:
+        return BT601_Full;
+    case QVideoFrameFormat::ColorSpace_BT601:
+        return fullRange ? BT601_Full : BT601_Video;
+    case QVideoFrameFormat::ColorSpace_BT2020:
+        return fullRange ? BT2020_Full : BT2020_Video;
+    case QVideoFrameFormat::ColorSpace_BT709:
+    default:
+        return fullRange ? BT709_Full : BT709_Video;
+    }
 }
 
-static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
+static inline void planarYUV420_to_ARGB32(const YUVToRGBMatrix &matrix,
+                                          const uchar *y, int yStride,
                                           const uchar *u, int uStride,
                                           const uchar *v, int vStride,
                                           int uvPixelStride,
@@ -44,14 +57,14 @@ static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
         const uchar *lineV = v;
 
         for (int i = 0; i < width; i += 2) {
-            EXPAND_UV(*lineU, *lineV);
+            EXPAND_UV(matrix, *lineU, *lineV);
             lineU += uvPixelStride;
             lineV += uvPixelStride;
 
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
-            *rgb1++ = qYUVToARGB32(*lineY1++, rv, guv, bu);
-            *rgb1++ = qYUVToARGB32(*lineY1++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(matrix, *lineY1++, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(matrix, *lineY1++, rv, guv, bu);
         }
 
         y += yStride << 1; // stride * 2
@@ -62,7 +75,8 @@ static inline void planarYUV420_to_ARGB32(const uchar *y, int yStride,
     }
 }
 
-static inline void planarYUV422_to_ARGB32(const uchar *y, int yStride,
+static inline void planarYUV422_to_ARGB32(const YUVToRGBMatrix &matrix,
+                                          const uchar *y, int yStride,
                                           const uchar *u, int uStride,
                                           const uchar *v, int vStride,
                                           int uvPixelStride,
@@ -77,27 +91,27 @@ static inline void planarYUV422_to_ARGB32(const uchar *y, int yStride,
         const uchar *lineV = v;
 
         for (int i = 0; i < width; i += 2) {
-            EXPAND_UV(*lineU, *lineV);
+            EXPAND_UV(matrix, *lineU, *lineV);
             lineU += uvPixelStride;
             lineV += uvPixelStride;
 
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
-            *rgb0++ = qYUVToARGB32(*lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0++, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0++, rv, guv, bu);
         }
 
-        y += yStride; // stride * 2
+        y += yStride;
         u += uStride;
         v += vStride;
-        rgb0 += width;
     }
 }
 
 
 
-static void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    FETCH_INFO_TRIPLANAR(frame)
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    FETCH_INFO_TRIPLANAR(frame, 1)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane3, plane3Stride,
                            1,
@@ -105,10 +119,11 @@ static void QT_FASTCALL qt_convert_YUV420P_to_ARGB32(const QVideoFrame &frame, u
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_YUV422P_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_YUV422P_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    FETCH_INFO_TRIPLANAR(frame)
-    planarYUV422_to_ARGB32(plane1, plane1Stride,
+    FETCH_INFO_TRIPLANAR(frame, 0)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV422_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane3, plane3Stride,
                            1,
@@ -117,10 +132,11 @@ static void QT_FASTCALL qt_convert_YUV422P_to_ARGB32(const QVideoFrame &frame, u
 }
 
 
-static void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    FETCH_INFO_TRIPLANAR(frame)
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    FETCH_INFO_TRIPLANAR(frame, 1)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane3, plane3Stride,
                            plane2, plane2Stride,
                            1,
@@ -128,9 +144,10 @@ static void QT_FASTCALL qt_convert_YV12_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_AYUV_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_AYUV_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     MERGE_LOOPS(width, height, stride, 4)
 
     quint32 *rgb = reinterpret_cast<quint32*>(output);
@@ -144,18 +161,19 @@ static void QT_FASTCALL qt_convert_AYUV_to_ARGB32(const QVideoFrame &frame, ucha
             int u = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(matrix, u, v);
 
-            *rgb++ = qPremultiply(qYUVToARGB32(y, rv, guv, bu, a));
+            *rgb++ = qPremultiply(qYUVToARGB32(matrix, y, rv, guv, bu, a));
         }
 
         src += stride;
     }
 }
 
-static void QT_FASTCALL qt_convert_AYUV_Premultiplied_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_AYUV_Premultiplied_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     MERGE_LOOPS(width, height, stride, 4)
 
     quint32 *rgb = reinterpret_cast<quint32*>(output);
@@ -169,18 +187,19 @@ static void QT_FASTCALL qt_convert_AYUV_Premultiplied_to_ARGB32(const QVideoFram
             int u = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(matrix, u, v);
 
-            *rgb++ = qYUVToARGB32(y, rv, guv, bu, a);
+            *rgb++ = qYUVToARGB32(matrix, y, rv, guv, bu, a);
         }
 
         src += stride;
     }
 }
 
-static void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     MERGE_LOOPS(width, height, stride, 2)
 
     quint32 *rgb = reinterpret_cast<quint32*>(output);
@@ -194,19 +213,20 @@ static void QT_FASTCALL qt_convert_UYVY_to_ARGB32(const QVideoFrame &frame, ucha
             int v = *lineSrc++;
             int y1 = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(matrix, u, v);
 
-            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
-            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(matrix, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(matrix, y1, rv, guv, bu);
         }
 
         src += stride;
     }
 }
 
-static void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     MERGE_LOOPS(width, height, stride, 2)
 
     quint32 *rgb = reinterpret_cast<quint32*>(output);
@@ -220,20 +240,21 @@ static void QT_FASTCALL qt_convert_YUYV_to_ARGB32(const QVideoFrame &frame, ucha
             int y1 = *lineSrc++;
             int v = *lineSrc++;
 
-            EXPAND_UV(u, v);
+            EXPAND_UV(matrix, u, v);
 
-            *rgb++ = qYUVToARGB32(y0, rv, guv, bu);
-            *rgb++ = qYUVToARGB32(y1, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(matrix, y0, rv, guv, bu);
+            *rgb++ = qYUVToARGB32(matrix, y1, rv, guv, bu);
         }
 
         src += stride;
     }
 }
 
-static void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_BIPLANAR(frame)
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane2 + 1, plane2Stride,
                            2,
@@ -241,10 +262,11 @@ static void QT_FASTCALL qt_convert_NV12_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_BIPLANAR(frame)
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2 + 1, plane2Stride,
                            plane2, plane2Stride,
                            2,
@@ -252,13 +274,14 @@ static void QT_FASTCALL qt_convert_NV21_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_IMC1_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_IMC1_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    FETCH_INFO_TRIPLANAR(frame)
+    FETCH_INFO_TRIPLANAR(frame, 1)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     Q_ASSERT(plane1Stride == plane2Stride);
     Q_ASSERT(plane1Stride == plane3Stride);
 
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane3, plane3Stride,
                            plane2, plane2Stride,
                            1,
@@ -266,12 +289,13 @@ static void QT_FASTCALL qt_convert_IMC1_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_IMC2_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_IMC2_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_BIPLANAR(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     Q_ASSERT(plane1Stride == plane2Stride);
 
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2 + (plane1Stride >> 1), plane1Stride,
                            plane2, plane1Stride,
                            1,
@@ -279,13 +303,14 @@ static void QT_FASTCALL qt_convert_IMC2_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_IMC3_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_IMC3_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    FETCH_INFO_TRIPLANAR(frame)
+    FETCH_INFO_TRIPLANAR(frame, 1)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     Q_ASSERT(plane1Stride == plane2Stride);
     Q_ASSERT(plane1Stride == plane3Stride);
 
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2, plane2Stride,
                            plane3, plane3Stride,
                            1,
@@ -293,12 +318,13 @@ static void QT_FASTCALL qt_convert_IMC3_to_ARGB32(const QVideoFrame &frame, ucha
                            width, height);
 }
 
-static void QT_FASTCALL qt_convert_IMC4_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_IMC4_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_BIPLANAR(frame)
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
     Q_ASSERT(plane1Stride == plane2Stride);
 
-    planarYUV420_to_ARGB32(plane1, plane1Stride,
+    planarYUV420_to_ARGB32(matrix, plane1, plane1Stride,
                            plane2, plane1Stride,
                            plane2 + (plane1Stride >> 1), plane1Stride,
                            1,
@@ -308,7 +334,7 @@ static void QT_FASTCALL qt_convert_IMC4_to_ARGB32(const QVideoFrame &frame, ucha
 
 
 template<typename Pixel>
-static void QT_FASTCALL qt_convert_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -342,7 +368,7 @@ static void QT_FASTCALL qt_convert_to_ARGB32(const QVideoFrame &frame, uchar *ou
 }
 
 template<typename Pixel>
-static void QT_FASTCALL qt_convert_premultiplied_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_premultiplied_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -375,7 +401,8 @@ static void QT_FASTCALL qt_convert_premultiplied_to_ARGB32(const QVideoFrame &fr
     }
 }
 
-static inline void planarYUV420_16bit_to_ARGB32(const uchar *y, int yStride,
+static inline void planarYUV420_16bit_to_ARGB32(const YUVToRGBMatrix &matrix,
+                                                  const uchar *y, int yStride,
                                                   const uchar *u, int uStride,
                                                   const uchar *v, int vStride,
                                                   int uvPixelStride,
@@ -393,17 +420,17 @@ static inline void planarYUV420_16bit_to_ARGB32(const uchar *y, int yStride,
         const uchar *lineV = v;
 
         for (int i = 0; i < width; i += 2) {
-            EXPAND_UV(*lineU, *lineV);
+            EXPAND_UV(matrix, *lineU, *lineV);
             lineU += uvPixelStride;
             lineV += uvPixelStride;
 
-            *rgb0++ = qYUVToARGB32(*lineY0, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0, rv, guv, bu);
             lineY0 += 2;
-            *rgb0++ = qYUVToARGB32(*lineY0, rv, guv, bu);
+            *rgb0++ = qYUVToARGB32(matrix, *lineY0, rv, guv, bu);
             lineY0 += 2;
-            *rgb1++ = qYUVToARGB32(*lineY1, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(matrix, *lineY1, rv, guv, bu);
             lineY1 += 2;
-            *rgb1++ = qYUVToARGB32(*lineY1, rv, guv, bu);
+            *rgb1++ = qYUVToARGB32(matrix, *lineY1, rv, guv, bu);
             lineY1 += 2;
         }
 
@@ -415,10 +442,11 @@ static inline void planarYUV420_16bit_to_ARGB32(const uchar *y, int yStride,
     }
 }
 
-static void QT_FASTCALL qt_convert_P016_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_P016_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_BIPLANAR(frame)
-    planarYUV420_16bit_to_ARGB32(plane1 + 1, plane1Stride,
+    const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+    planarYUV420_16bit_to_ARGB32(matrix, plane1 + 1, plane1Stride,
                            plane2 + 1, plane2Stride,
                            plane2 + 3, plane2Stride,
                            4,
@@ -428,7 +456,7 @@ static void QT_FASTCALL qt_convert_P016_to_ARGB32(const QVideoFrame &frame, ucha
 }
 
 template <typename Y>
-static void QT_FASTCALL qt_convert_Y_to_ARGB32(const QVideoFrame &frame, uchar *output)
+static void QT_FASTCALL qt_convert_Y_to_ARGB32(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, (int)sizeof(Y))
@@ -497,10 +525,10 @@ static VideoFrameConvertFunc qConvertFuncs[QVideoFrameFormat::NPixelFormats] = {
 static void qInitConvertFuncsAsm()
 {
 #ifdef QT_COMPILER_SUPPORTS_SSE2
-    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output);
+    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_sse2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
     if (qCpuHasFeature(SSE2)){
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888] = qt_convert_ARGB8888_to_ARGB32_sse2;
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888_Premultiplied] = qt_convert_ARGB8888_to_ARGB32_sse2;
@@ -515,10 +543,10 @@ static void qInitConvertFuncsAsm()
     }
 #endif
 #ifdef QT_COMPILER_SUPPORTS_SSSE3
-    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output);
+    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
     if (qCpuHasFeature(SSSE3)){
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888] = qt_convert_ARGB8888_to_ARGB32_ssse3;
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888_Premultiplied] = qt_convert_ARGB8888_to_ARGB32_ssse3;
@@ -532,11 +560,16 @@ static void qInitConvertFuncsAsm()
         qConvertFuncs[QVideoFrameFormat::Format_RGBX8888] = qt_convert_RGBA8888_to_ARGB32_ssse3;
     }
 #endif
+#ifdef QT_COMPILER_SUPPORTS_SSE4_1
+    extern void qt_install_YUV_converters_sse4_1(VideoFrameConvertFunc *converters);
+    if (qCpuHasFeature(SSE4_1))
+        qt_install_YUV_converters_sse4_1(qConvertFuncs);
+#endif
 #ifdef QT_COMPILER_SUPPORTS_AVX2
-    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output);
-    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output);
+    extern void QT_FASTCALL  qt_convert_ARGB8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_ABGR8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_RGBA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
+    extern void QT_FASTCALL  qt_convert_BGRA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine);
     if (qCpuHasFeature(AVX2)){
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888] = qt_convert_ARGB8888_to_ARGB32_avx2;
         qConvertFuncs[QVideoFrameFormat::Format_ARGB8888_Premultiplied] = qt_convert_ARGB8888_to_ARGB32_avx2;
@@ -549,6 +582,19 @@ static void qInitConvertFuncsAsm()
         qConvertFuncs[QVideoFrameFormat::Format_RGBA8888] = qt_convert_RGBA8888_to_ARGB32_avx2;
         qConvertFuncs[QVideoFrameFormat::Format_RGBX8888] = qt_convert_RGBA8888_to_ARGB32_avx2;
     }
+    extern void qt_install_YUV_converters_avx2(VideoFrameConvertFunc *converters);
+    if (qCpuHasFeature(AVX2))
+        qt_install_YUV_converters_avx2(qConvertFuncs);
+#endif
+#ifdef QT_COMPILER_SUPPORTS_AVX512F
+    extern void qt_install_YUV_converters_avx512(VideoFrameConvertFunc *converters);
+    if (qCpuHasFeature(ArchSkylakeAvx512))
+        qt_install_YUV_converters_avx512(qConvertFuncs);
+#endif
+#if (defined(__ARM_NEON__) || defined(__ARM_NEON)) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    extern void qt_install_YUV_converters_neon(VideoFrameConvertFunc *converters);
+    if (qCpuHasFeature(NEON))
+        qt_install_YUV_converters_neon(qConvertFuncs);
 #endif
 }
 
@@ -10,7 +10,7 @@ QT_BEGIN_NAMESPACE
 namespace  {
 
 template<int a, int r, int g, int b>
-void convert_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void convert_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -70,27 +70,138 @@ void convert_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
     }
 }
 
+// The matrix coefficients, broadcast to all lanes
+struct Coefficients
+{
+    explicit Coefficients(const YUVToRGBMatrix &matrix)
+        : yOffset(_mm256_set1_epi32(matrix.yOffset)),
+          y(_mm256_set1_epi32(matrix.y)),
+          rv(_mm256_set1_epi32(matrix.rv)),
+          gu(_mm256_set1_epi32(matrix.gu)),
+          gv(_mm256_set1_epi32(matrix.gv)),
+          bu(_mm256_set1_epi32(matrix.bu))
+    {
+    }
+
+    __m256i yOffset;
+    __m256i y;
+    __m256i rv;
+    __m256i gu;
+    __m256i gv;
+    __m256i bu;
+};
+
+// Converts 8 pixels with 32 bit lanes, which keeps the results identical
+// to qYUVToARGB32.
+inline __m256i yuvToARGB32(const Coefficients &c, __m256i y, __m256i u, __m256i v)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi32(255);
+    const __m256i round = _mm256_set1_epi32(128);
+
+    const __m256i yy = _mm256_mullo_epi32(_mm256_sub_epi32(y, c.yOffset), c.y);
+    const __m256i uu = _mm256_sub_epi32(u, round);
+    const __m256i vv = _mm256_sub_epi32(v, round);
+
+    __m256i r = _mm256_add_epi32(yy, _mm256_mullo_epi32(vv, c.rv));
+    __m256i g = _mm256_sub_epi32(yy, _mm256_add_epi32(_mm256_mullo_epi32(uu, c.gu),
+                                                      _mm256_mullo_epi32(vv, c.gv)));
+    __m256i b = _mm256_add_epi32(yy, _mm256_mullo_epi32(uu, c.bu));
+
+    r = _mm256_srai_epi32(_mm256_add_epi32(r, round), 8);
+    g = _mm256_srai_epi32(_mm256_add_epi32(g, round), 8);
+    b = _mm256_srai_epi32(_mm256_add_epi32(b, round), 8);
+
+    r = _mm256_min_epi32(_mm256_max_epi32(r, zero), max);
+    g = _mm256_min_epi32(_mm256_max_epi32(g, zero), max);
+    b = _mm256_min_epi32(_mm256_max_epi32(b, zero), max);
+
+    return _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(int(0xff000000)),
+                                           _mm256_slli_epi32(r, 16)),
+                           _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
 }
 
+struct KernelAvx2
+{
+    // 32 pixels per iteration
+    template<ChromaLayout Layout>
+    static int convertRow(const YUVToRGBMatrix &matrix, const uchar *y, const uchar *u,
+                          const uchar *v, quint32 *rgb, int width)
+    {
+        const Coefficients coefficients(matrix);
+        const __m128i evenBytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i oddBytes = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,
+                                               -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m128i u16;
+            __m128i v16;
+            if constexpr (Layout == ChromaLayout::Planar) {
+                u16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x / 2));
+                v16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x / 2));
+            } else {
+                const uchar *uv = Layout == ChromaLayout::UV ? u : v;
+                const __m128i chroma0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + x));
+                const __m128i chroma1 =
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + x + 16));
+                const __m128i first = Layout == ChromaLayout::UV ? evenBytes : oddBytes;
+                const __m128i second = Layout == ChromaLayout::UV ? oddBytes : evenBytes;
+                u16 = _mm_unpacklo_epi64(_mm_shuffle_epi8(chroma0, first),
+                                         _mm_shuffle_epi8(chroma1, first));
+                v16 = _mm_unpacklo_epi64(_mm_shuffle_epi8(chroma0, second),
+                                         _mm_shuffle_epi8(chroma1, second));
+            }
+
+            for (int half = 0; half < 2; ++half) {
+                const __m128i y16 =
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x + 16 * half));
+                // each chroma sample covers two pixels
+                const __m128i uDup = half ? _mm_unpackhi_epi8(u16, u16) : _mm_unpacklo_epi8(u16, u16);
+                const __m128i vDup = half ? _mm_unpackhi_epi8(v16, v16) : _mm_unpacklo_epi8(v16, v16);
+
+                auto *out = reinterpret_cast<__m256i *>(rgb + x + 16 * half);
+                _mm256_storeu_si256(out, yuvToARGB32(coefficients, _mm256_cvtepu8_epi32(y16),
+                                                     _mm256_cvtepu8_epi32(uDup),
+                                                     _mm256_cvtepu8_epi32(vDup)));
+                _mm256_storeu_si256(out + 1,
+                                    yuvToARGB32(coefficients,
+                                                _mm256_cvtepu8_epi32(_mm_srli_si128(y16, 8)),
+                                                _mm256_cvtepu8_epi32(_mm_srli_si128(uDup, 8)),
+                                                _mm256_cvtepu8_epi32(_mm_srli_si128(vDup, 8))));
+            }
+        }
+        return x;
+    }
+};
+
+}
+
+
+void QT_FASTCALL qt_convert_ARGB8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
+{
+    convert_to_ARGB32_avx2<0, 1, 2, 3>(frame, output, startLine, endLine);
+}
 
-void QT_FASTCALL qt_convert_ARGB8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_ABGR8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_avx2<0, 1, 2, 3>(frame, output);
+    convert_to_ARGB32_avx2<0, 3, 2, 1>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_ABGR8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_RGBA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_avx2<0, 3, 2, 1>(frame, output);
+    convert_to_ARGB32_avx2<3, 0, 1, 2>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_RGBA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGRA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_avx2<3, 0, 1, 2>(frame, output);
+    convert_to_ARGB32_avx2<3, 2, 1, 0>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_BGRA8888_to_ARGB32_avx2(const QVideoFrame &frame, uchar *output)
+void qt_install_YUV_converters_avx2(VideoFrameConvertFunc *converters)
 {
-    convert_to_ARGB32_avx2<3, 2, 1, 0>(frame, output);
+    YUVConverters<KernelAvx2>::install(converters);
 }
 
 QT_END_NAMESPACE
@@ -0,0 +1,123 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvideoframeconversionhelper_p.h"
+
+#ifdef QT_COMPILER_SUPPORTS_AVX512F
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// The matrix coefficients, broadcast to all lanes
+struct Coefficients
+{
+    explicit Coefficients(const YUVToRGBMatrix &matrix)
+        : yOffset(_mm512_set1_epi32(matrix.yOffset)),
+          y(_mm512_set1_epi32(matrix.y)),
+          rv(_mm512_set1_epi32(matrix.rv)),
+          gu(_mm512_set1_epi32(matrix.gu)),
+          gv(_mm512_set1_epi32(matrix.gv)),
+          bu(_mm512_set1_epi32(matrix.bu))
+    {
+    }
+
+    __m512i yOffset;
+    __m512i y;
+    __m512i rv;
+    __m512i gu;
+    __m512i gv;
+    __m512i bu;
+};
+
+// Converts 16 pixels with 32 bit lanes, which keeps the results identical
+// to qYUVToARGB32.
+inline __m512i yuvToARGB32(const Coefficients &c, __m512i y, __m512i u, __m512i v)
+{
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i max = _mm512_set1_epi32(255);
+    const __m512i round = _mm512_set1_epi32(128);
+
+    const __m512i yy = _mm512_mullo_epi32(_mm512_sub_epi32(y, c.yOffset), c.y);
+    const __m512i uu = _mm512_sub_epi32(u, round);
+    const __m512i vv = _mm512_sub_epi32(v, round);
+
+    __m512i r = _mm512_add_epi32(yy, _mm512_mullo_epi32(vv, c.rv));
+    __m512i g = _mm512_sub_epi32(yy, _mm512_add_epi32(_mm512_mullo_epi32(uu, c.gu),
+                                                      _mm512_mullo_epi32(vv, c.gv)));
+    __m512i b = _mm512_add_epi32(yy, _mm512_mullo_epi32(uu, c.bu));
+
+    r = _mm512_srai_epi32(_mm512_add_epi32(r, round), 8);
+    g = _mm512_srai_epi32(_mm512_add_epi32(g, round), 8);
+    b = _mm512_srai_epi32(_mm512_add_epi32(b, round), 8);
+
+    r = _mm512_min_epi32(_mm512_max_epi32(r, zero), max);
+    g = _mm512_min_epi32(_mm512_max_epi32(g, zero), max);
+    b = _mm512_min_epi32(_mm512_max_epi32(b, zero), max);
+
+    return _mm512_or_si512(_mm512_or_si512(_mm512_set1_epi32(int(0xff000000)),
+                                           _mm512_slli_epi32(r, 16)),
+                           _mm512_or_si512(_mm512_slli_epi32(g, 8), b));
+}
+
+struct KernelAvx512
+{
+    // 32 pixels per iteration
+    template<ChromaLayout Layout>
+    static int convertRow(const YUVToRGBMatrix &matrix, const uchar *y, const uchar *u,
+                          const uchar *v, quint32 *rgb, int width)
+    {
+        const Coefficients coefficients(matrix);
+        const __m128i evenBytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i oddBytes = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,
+                                               -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            __m128i u16;
+            __m128i v16;
+            if constexpr (Layout == ChromaLayout::Planar) {
+                u16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(u + x / 2));
+                v16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + x / 2));
+            } else {
+                const uchar *uv = Layout == ChromaLayout::UV ? u : v;
+                const __m128i chroma0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + x));
+                const __m128i chroma1 =
+                        _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + x + 16));
+                const __m128i first = Layout == ChromaLayout::UV ? evenBytes : oddBytes;
+                const __m128i second = Layout == ChromaLayout::UV ? oddBytes : evenBytes;
+                u16 = _mm_unpacklo_epi64(_mm_shuffle_epi8(chroma0, first),
+                                         _mm_shuffle_epi8(chroma1, first));
+                v16 = _mm_unpacklo_epi64(_mm_shuffle_epi8(chroma0, second),
+                                         _mm_shuffle_epi8(chroma1, second));
+            }
+
+            const __m128i y0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+            const __m128i y1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x + 16));
+
+            // each chroma sample covers two pixels
+            auto *out = reinterpret_cast<__m512i *>(rgb + x);
+            _mm512_storeu_si512(out,
+                                yuvToARGB32(coefficients, _mm512_cvtepu8_epi32(y0),
+                                            _mm512_cvtepu8_epi32(_mm_unpacklo_epi8(u16, u16)),
+                                            _mm512_cvtepu8_epi32(_mm_unpacklo_epi8(v16, v16))));
+            _mm512_storeu_si512(out + 1,
+                                yuvToARGB32(coefficients, _mm512_cvtepu8_epi32(y1),
+                                            _mm512_cvtepu8_epi32(_mm_unpackhi_epi8(u16, u16)),
+                                            _mm512_cvtepu8_epi32(_mm_unpackhi_epi8(v16, v16))));
+        }
+        return x;
+    }
+};
+
+}
+
+void qt_install_YUV_converters_avx512(VideoFrameConvertFunc *converters)
+{
+    YUVConverters<KernelAvx512>::install(converters);
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -0,0 +1,115 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvideoframeconversionhelper_p.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// Converts 4 pixels to the clamped R, G and B components with 32 bit lanes,
+// which keeps the results identical to qYUVToARGB32.
+inline void yuvToRGB(const YUVToRGBMatrix &matrix, int32x4_t y, int32x4_t u, int32x4_t v,
+                     int16x4_t &r, int16x4_t &g, int16x4_t &b)
+{
+    const int32x4_t round = vdupq_n_s32(128);
+
+    const int32x4_t yy = vmulq_n_s32(vsubq_s32(y, vdupq_n_s32(matrix.yOffset)), matrix.y);
+    const int32x4_t uu = vsubq_s32(u, round);
+    const int32x4_t vv = vsubq_s32(v, round);
+
+    const int32x4_t rr = vaddq_s32(vmlaq_n_s32(yy, vv, matrix.rv), round);
+    const int32x4_t gg =
+            vaddq_s32(vmlsq_n_s32(vmlsq_n_s32(yy, uu, matrix.gu), vv, matrix.gv), round);
+    const int32x4_t bb = vaddq_s32(vmlaq_n_s32(yy, uu, matrix.bu), round);
+
+    // saturating narrowing; the final narrowing to 8 bits clamps to [0, 255]
+    r = vqmovn_s32(vshrq_n_s32(rr, 8));
+    g = vqmovn_s32(vshrq_n_s32(gg, 8));
+    b = vqmovn_s32(vshrq_n_s32(bb, 8));
+}
+
+inline int32x4_t widenLow(uint16x8_t v)
+{
+    return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(v)));
+}
+
+inline int32x4_t widenHigh(uint16x8_t v)
+{
+    return vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(v)));
+}
+
+// Converts 8 pixels to 8 bit R, G and B components
+inline void yuvToRGB(const YUVToRGBMatrix &matrix, uint8x8_t y, uint8x8_t u, uint8x8_t v,
+                     uint8x8_t &r, uint8x8_t &g, uint8x8_t &b)
+{
+    const uint16x8_t y16 = vmovl_u8(y);
+    const uint16x8_t u16 = vmovl_u8(u);
+    const uint16x8_t v16 = vmovl_u8(v);
+
+    int16x4_t r0, g0, b0, r1, g1, b1;
+    yuvToRGB(matrix, widenLow(y16), widenLow(u16), widenLow(v16), r0, g0, b0);
+    yuvToRGB(matrix, widenHigh(y16), widenHigh(u16), widenHigh(v16), r1, g1, b1);
+
+    r = vqmovun_s16(vcombine_s16(r0, r1));
+    g = vqmovun_s16(vcombine_s16(g0, g1));
+    b = vqmovun_s16(vcombine_s16(b0, b1));
+}
+
+struct KernelNeon
+{
+    // 16 pixels per iteration
+    template<ChromaLayout Layout>
+    static int convertRow(const YUVToRGBMatrix &matrix, const uchar *y, const uchar *u,
+                          const uchar *v, quint32 *rgb, int width)
+    {
+        const uint8x8_t alpha = vdup_n_u8(0xff);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            uint8x8_t u8;
+            uint8x8_t v8;
+            if constexpr (Layout == ChromaLayout::Planar) {
+                u8 = vld1_u8(u + x / 2);
+                v8 = vld1_u8(v + x / 2);
+            } else {
+                const uchar *uv = Layout == ChromaLayout::UV ? u : v;
+                const uint8x8x2_t chroma = vld2_u8(uv + x);
+                u8 = Layout == ChromaLayout::UV ? chroma.val[0] : chroma.val[1];
+                v8 = Layout == ChromaLayout::UV ? chroma.val[1] : chroma.val[0];
+            }
+
+            // each chroma sample covers two pixels
+            const uint8x8x2_t uDup = vzip_u8(u8, u8);
+            const uint8x8x2_t vDup = vzip_u8(v8, v8);
+            const uint8x16_t y16 = vld1q_u8(y + x);
+
+            uint8x8x4_t bgra0;
+            uint8x8x4_t bgra1;
+            yuvToRGB(matrix, vget_low_u8(y16), uDup.val[0], vDup.val[0],
+                     bgra0.val[2], bgra0.val[1], bgra0.val[0]);
+            yuvToRGB(matrix, vget_high_u8(y16), uDup.val[1], vDup.val[1],
+                     bgra1.val[2], bgra1.val[1], bgra1.val[0]);
+            bgra0.val[3] = alpha;
+            bgra1.val[3] = alpha;
+
+            // ARGB32 is stored as B, G, R, A on little endian
+            vst4_u8(reinterpret_cast<uint8_t *>(rgb + x), bgra0);
+            vst4_u8(reinterpret_cast<uint8_t *>(rgb + x + 8), bgra1);
+        }
+        return x;
+    }
+};
+
+}
+
+void qt_install_YUV_converters_neon(VideoFrameConvertFunc *converters)
+{
+    YUVConverters<KernelNeon>::install(converters);
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -20,10 +20,30 @@
 
 QT_BEGIN_NAMESPACE
 
-// Converts to RGB32 or ARGB32_Premultiplied
-typedef void (QT_FASTCALL *VideoFrameConvertFunc)(const QVideoFrame &frame, uchar *output);
+// Converts the lines [startLine, endLine) of the frame to RGB32 or ARGB32_Premultiplied.
+// output points to the first converted line, with lines packed width * 4 bytes apart.
+// For formats with vertically subsampled chroma, startLine must be even.
+typedef void (QT_FASTCALL *VideoFrameConvertFunc)(const QVideoFrame &frame, uchar *output,
+                                                  int startLine, int endLine);
 
-VideoFrameConvertFunc qConverterForFormat(QVideoFrameFormat::PixelFormat format);
+Q_MULTIMEDIA_EXPORT VideoFrameConvertFunc qConverterForFormat(QVideoFrameFormat::PixelFormat format);
+
+// Fixed-point YUV to RGB matrix, with the coefficients scaled by 256:
+//   R = ((Y - yOffset) * y + (V - 128) * rv + 128) >> 8
+//   G = ((Y - yOffset) * y - (U - 128) * gu - (V - 128) * gv + 128) >> 8
+//   B = ((Y - yOffset) * y + (U - 128) * bu + 128) >> 8
+struct YUVToRGBMatrix
+{
+    int yOffset;
+    int y;
+    int rv;
+    int gu;
+    int gv;
+    int bu;
+};
+
+// The matrix for the color space and range of the format, matching the GPU conversion
+const YUVToRGBMatrix &qYUVToRGBMatrix(const QVideoFrameFormat &format);
 
 template<int a, int r, int g, int b>
 struct ArgbPixel
@@ -91,29 +111,33 @@ using XBGR8888 = RgbPixel<3, 2, 1>;
 using RGBX8888 = RgbPixel<0, 1, 2>;
 using BGRX8888 = RgbPixel<2, 1, 0>;
 
+// The FETCH_INFO macros expect startLine and endLine in scope and fetch the
+// planes starting at startLine
+
 #define FETCH_INFO_PACKED(frame) \
-    const uchar *src = frame.bits(0); \
     int stride = frame.bytesPerLine(0); \
+    const uchar *src = frame.bits(0) + startLine * stride; \
     int width = frame.width(); \
-    int height = frame.height();
+    int height = endLine - startLine;
 
+// All bi-planar formats have vertically subsampled chroma
 #define FETCH_INFO_BIPLANAR(frame) \
-    const uchar *plane1 = frame.bits(0); \
-    const uchar *plane2 = frame.bits(1); \
     int plane1Stride = frame.bytesPerLine(0); \
     int plane2Stride = frame.bytesPerLine(1); \
+    const uchar *plane1 = frame.bits(0) + startLine * plane1Stride; \
+    const uchar *plane2 = frame.bits(1) + (startLine >> 1) * plane2Stride; \
     int width = frame.width(); \
-    int height = frame.height();
+    int height = endLine - startLine;
 
-#define FETCH_INFO_TRIPLANAR(frame) \
-    const uchar *plane1 = frame.bits(0); \
-    const uchar *plane2 = frame.bits(1); \
-    const uchar *plane3 = frame.bits(2); \
+#define FETCH_INFO_TRIPLANAR(frame, chromaRowShift) \
     int plane1Stride = frame.bytesPerLine(0); \
     int plane2Stride = frame.bytesPerLine(1); \
     int plane3Stride = frame.bytesPerLine(2); \
+    const uchar *plane1 = frame.bits(0) + startLine * plane1Stride; \
+    const uchar *plane2 = frame.bits(1) + (startLine >> chromaRowShift) * plane2Stride; \
+    const uchar *plane3 = frame.bits(2) + (startLine >> chromaRowShift) * plane3Stride; \
     int width = frame.width(); \
-    int height = frame.height(); \
+    int height = endLine - startLine;
 
 #define MERGE_LOOPS(width, height, stride, bpp) \
     if (stride == width * bpp) { \
@@ -125,6 +149,175 @@ using BGRX8888 = RgbPixel<2, 1, 0>;
 #define ALIGN(boundary, ptr, x, length) \
     for (; ((reinterpret_cast<qintptr>(ptr) & (boundary - 1)) != 0) && x < length; ++x)
 
+#define CLAMP(n) (n > 255 ? 255 : (n < 0 ? 0 : n))
+
+#define EXPAND_UV(matrix, u, v) \
+    int uu = u - 128; \
+    int vv = v - 128; \
+    int rv = matrix.rv * vv + 128; \
+    int guv = matrix.gu * uu + matrix.gv * vv - 128; \
+    int bu = matrix.bu * uu + 128; \
+
+static inline quint32 qYUVToARGB32(const YUVToRGBMatrix &matrix, int y, int rv, int guv, int bu,
+                                   int a = 0xff)
+{
+    int yy = (y - matrix.yOffset) * matrix.y;
+    return (a << 24)
+            | CLAMP((yy + rv) >> 8) << 16
+            | CLAMP((yy - guv) >> 8) << 8
+            | CLAMP((yy + bu) >> 8);
+}
+
+// How the chroma samples of a planar or semi-planar YUV row are stored
+enum class ChromaLayout {
+    Planar, // separate U and V planes
+    UV,     // interleaved, U first (NV12)
+    VU      // interleaved, V first (NV21)
+};
+
+// Converts the pixels [x, width) of a YUV row with horizontally subsampled chroma.
+// Used for the leftovers of the SIMD converters.
+static inline void qt_convert_YUV_row_to_ARGB32(const YUVToRGBMatrix &matrix, const uchar *y,
+                                                const uchar *u, const uchar *v, int uvPixelStride,
+                                                quint32 *rgb, int x, int width)
+{
+    for (; x < width; x += 2) {
+        const int c = (x >> 1) * uvPixelStride;
+        EXPAND_UV(matrix, u[c], v[c]);
+        rgb[x] = qYUVToARGB32(matrix, y[x], rv, guv, bu);
+        if (x + 1 < width)
+            rgb[x + 1] = qYUVToARGB32(matrix, y[x + 1], rv, guv, bu);
+    }
+}
+
+// The planar and semi-planar YUV converters, built on a SIMD row kernel.
+// Kernel::convertRow<Layout>(matrix, y, u, v, rgb, width) converts as many pixels
+// from the start of the row as it handles in full vectors and returns their
+// count; the rest is converted by qt_convert_YUV_row_to_ARGB32.
+//
+// Instantiate it only with kernels from an anonymous namespace, so that the
+// code compiled for one instruction set doesn't leak into other translation units.
+template<typename Kernel>
+struct YUVConverters
+{
+    template<ChromaLayout Layout>
+    static void convert(const QVideoFrame &frame, const uchar *y, int yStride, const uchar *u,
+                        int uStride, const uchar *v, int vStride, int chromaRowShift,
+                        quint32 *rgb, int width, int height)
+    {
+        constexpr int uvPixelStride = Layout == ChromaLayout::Planar ? 1 : 2;
+        const YUVToRGBMatrix &matrix = qYUVToRGBMatrix(frame.surfaceFormat());
+
+        for (int j = 0; j < height; ++j) {
+            const uchar *lineY = y + j * yStride;
+            const uchar *lineU = u + (j >> chromaRowShift) * uStride;
+            const uchar *lineV = v + (j >> chromaRowShift) * vStride;
+            quint32 *lineRgb = rgb + j * width;
+
+            const int x = Kernel::template convertRow<Layout>(matrix, lineY, lineU, lineV, lineRgb,
+                                                              width);
+            qt_convert_YUV_row_to_ARGB32(matrix, lineY, lineU, lineV, uvPixelStride, lineRgb, x,
+                                         width);
+        }
+    }
+
+    static void QT_FASTCALL YUV420P(const QVideoFrame &frame, uchar *output,
+                                    int startLine, int endLine)
+    {
+        FETCH_INFO_TRIPLANAR(frame, 1)
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane2, plane2Stride, plane3,
+                                      plane3Stride, 1, reinterpret_cast<quint32 *>(output),
+                                      width, height);
+    }
+
+    static void QT_FASTCALL YUV422P(const QVideoFrame &frame, uchar *output,
+                                    int startLine, int endLine)
+    {
+        FETCH_INFO_TRIPLANAR(frame, 0)
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane2, plane2Stride, plane3,
+                                      plane3Stride, 0, reinterpret_cast<quint32 *>(output),
+                                      width, height);
+    }
+
+    static void QT_FASTCALL YV12(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_TRIPLANAR(frame, 1)
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane3, plane3Stride, plane2,
+                                      plane2Stride, 1, reinterpret_cast<quint32 *>(output),
+                                      width, height);
+    }
+
+    static void QT_FASTCALL NV12(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_BIPLANAR(frame)
+        convert<ChromaLayout::UV>(frame, plane1, plane1Stride, plane2, plane2Stride, plane2 + 1,
+                                  plane2Stride, 1, reinterpret_cast<quint32 *>(output),
+                                  width, height);
+    }
+
+    static void QT_FASTCALL NV21(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_BIPLANAR(frame)
+        convert<ChromaLayout::VU>(frame, plane1, plane1Stride, plane2 + 1, plane2Stride, plane2,
+                                  plane2Stride, 1, reinterpret_cast<quint32 *>(output),
+                                  width, height);
+    }
+
+    static void QT_FASTCALL IMC1(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_TRIPLANAR(frame, 1)
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane3, plane3Stride, plane2,
+                                      plane2Stride, 1, reinterpret_cast<quint32 *>(output),
+                                      width, height);
+    }
+
+    static void QT_FASTCALL IMC2(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_BIPLANAR(frame)
+        Q_UNUSED(plane2Stride);
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane2 + (plane1Stride >> 1),
+                                      plane1Stride, plane2, plane1Stride, 1,
+                                      reinterpret_cast<quint32 *>(output), width, height);
+    }
+
+    static void QT_FASTCALL IMC3(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_TRIPLANAR(frame, 1)
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane2, plane2Stride, plane3,
+                                      plane3Stride, 1, reinterpret_cast<quint32 *>(output),
+                                      width, height);
+    }
+
+    static void QT_FASTCALL IMC4(const QVideoFrame &frame, uchar *output,
+                                 int startLine, int endLine)
+    {
+        FETCH_INFO_BIPLANAR(frame)
+        Q_UNUSED(plane2Stride);
+        convert<ChromaLayout::Planar>(frame, plane1, plane1Stride, plane2, plane1Stride,
+                                      plane2 + (plane1Stride >> 1), plane1Stride, 1,
+                                      reinterpret_cast<quint32 *>(output), width, height);
+    }
+
+    static void install(VideoFrameConvertFunc *converters)
+    {
+        converters[QVideoFrameFormat::Format_YUV420P] = YUV420P;
+        converters[QVideoFrameFormat::Format_YUV422P] = YUV422P;
+        converters[QVideoFrameFormat::Format_YV12] = YV12;
+        converters[QVideoFrameFormat::Format_NV12] = NV12;
+        converters[QVideoFrameFormat::Format_NV21] = NV21;
+        converters[QVideoFrameFormat::Format_IMC1] = IMC1;
+        converters[QVideoFrameFormat::Format_IMC2] = IMC2;
+        converters[QVideoFrameFormat::Format_IMC3] = IMC3;
+        converters[QVideoFrameFormat::Format_IMC4] = IMC4;
+    }
+};
+
 QT_END_NAMESPACE
 
 #endif // QVIDEOFRAMECONVERSIONHELPER_P_H
@@ -0,0 +1,120 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvideoframeconversionhelper_p.h"
+
+#ifdef QT_COMPILER_SUPPORTS_SSE4_1
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+// The matrix coefficients, broadcast to all lanes
+struct Coefficients
+{
+    explicit Coefficients(const YUVToRGBMatrix &matrix)
+        : yOffset(_mm_set1_epi32(matrix.yOffset)),
+          y(_mm_set1_epi32(matrix.y)),
+          rv(_mm_set1_epi32(matrix.rv)),
+          gu(_mm_set1_epi32(matrix.gu)),
+          gv(_mm_set1_epi32(matrix.gv)),
+          bu(_mm_set1_epi32(matrix.bu))
+    {
+    }
+
+    __m128i yOffset;
+    __m128i y;
+    __m128i rv;
+    __m128i gu;
+    __m128i gv;
+    __m128i bu;
+};
+
+// Converts 4 pixels with 32 bit lanes, which keeps the results identical
+// to qYUVToARGB32.
+inline __m128i yuvToARGB32(const Coefficients &c, __m128i y, __m128i u, __m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi32(255);
+    const __m128i round = _mm_set1_epi32(128);
+
+    const __m128i yy = _mm_mullo_epi32(_mm_sub_epi32(y, c.yOffset), c.y);
+    const __m128i uu = _mm_sub_epi32(u, round);
+    const __m128i vv = _mm_sub_epi32(v, round);
+
+    __m128i r = _mm_add_epi32(yy, _mm_mullo_epi32(vv, c.rv));
+    __m128i g = _mm_sub_epi32(yy, _mm_add_epi32(_mm_mullo_epi32(uu, c.gu),
+                                                _mm_mullo_epi32(vv, c.gv)));
+    __m128i b = _mm_add_epi32(yy, _mm_mullo_epi32(uu, c.bu));
+
+    r = _mm_srai_epi32(_mm_add_epi32(r, round), 8);
+    g = _mm_srai_epi32(_mm_add_epi32(g, round), 8);
+    b = _mm_srai_epi32(_mm_add_epi32(b, round), 8);
+
+    r = _mm_min_epi32(_mm_max_epi32(r, zero), max);
+    g = _mm_min_epi32(_mm_max_epi32(g, zero), max);
+    b = _mm_min_epi32(_mm_max_epi32(b, zero), max);
+
+    return _mm_or_si128(_mm_or_si128(_mm_set1_epi32(int(0xff000000)), _mm_slli_epi32(r, 16)),
+                        _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+struct KernelSse41
+{
+    // 16 pixels per iteration
+    template<ChromaLayout Layout>
+    static int convertRow(const YUVToRGBMatrix &matrix, const uchar *y, const uchar *u,
+                          const uchar *v, quint32 *rgb, int width)
+    {
+        const Coefficients coefficients(matrix);
+        const __m128i evenBytes = _mm_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14,
+                                                -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i oddBytes = _mm_setr_epi8(1, 3, 5, 7, 9, 11, 13, 15,
+                                               -1, -1, -1, -1, -1, -1, -1, -1);
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            __m128i y16 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + x));
+
+            __m128i u8;
+            __m128i v8;
+            if constexpr (Layout == ChromaLayout::Planar) {
+                u8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(u + x / 2));
+                v8 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(v + x / 2));
+            } else {
+                const uchar *uv = Layout == ChromaLayout::UV ? u : v;
+                const __m128i chroma = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uv + x));
+                u8 = _mm_shuffle_epi8(chroma, Layout == ChromaLayout::UV ? evenBytes : oddBytes);
+                v8 = _mm_shuffle_epi8(chroma, Layout == ChromaLayout::UV ? oddBytes : evenBytes);
+            }
+
+            // each chroma sample covers two pixels
+            __m128i u16 = _mm_unpacklo_epi8(u8, u8);
+            __m128i v16 = _mm_unpacklo_epi8(v8, v8);
+
+            auto *out = reinterpret_cast<__m128i *>(rgb + x);
+            for (int i = 0; i < 4; ++i) {
+                const __m128i y4 = _mm_cvtepu8_epi32(y16);
+                const __m128i u4 = _mm_cvtepu8_epi32(u16);
+                const __m128i v4 = _mm_cvtepu8_epi32(v16);
+                _mm_storeu_si128(out + i, yuvToARGB32(coefficients, y4, u4, v4));
+
+                y16 = _mm_srli_si128(y16, 4);
+                u16 = _mm_srli_si128(u16, 4);
+                v16 = _mm_srli_si128(v16, 4);
+            }
+        }
+        return x;
+    }
+};
+
+}
+
+void qt_install_YUV_converters_sse4_1(VideoFrameConvertFunc *converters)
+{
+    YUVConverters<KernelSse41>::install(converters);
+}
+
+QT_END_NAMESPACE
+
+#endif
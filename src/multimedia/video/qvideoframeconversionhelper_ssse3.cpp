@@ -10,7 +10,7 @@ QT_BEGIN_NAMESPACE
 namespace  {
 
 template<int a, int r, int g, int b>
-void convert_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+void convert_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
     FETCH_INFO_PACKED(frame)
     MERGE_LOOPS(width, height, stride, 4)
@@ -64,24 +64,24 @@ void convert_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
 
 }
 
-void QT_FASTCALL qt_convert_ARGB8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_ARGB8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_ssse3<0, 1, 2, 3>(frame, output);
+    convert_to_ARGB32_ssse3<0, 1, 2, 3>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_ABGR8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_ABGR8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_ssse3<0, 3, 2, 1>(frame, output);
+    convert_to_ARGB32_ssse3<0, 3, 2, 1>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_RGBA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_RGBA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_ssse3<3, 0, 1, 2>(frame, output);
+    convert_to_ARGB32_ssse3<3, 0, 1, 2>(frame, output, startLine, endLine);
 }
 
-void QT_FASTCALL qt_convert_BGRA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output)
+void QT_FASTCALL qt_convert_BGRA8888_to_ARGB32_ssse3(const QVideoFrame &frame, uchar *output, int startLine, int endLine)
 {
-    convert_to_ARGB32_ssse3<3, 2, 1, 0>(frame, output);
+    convert_to_ARGB32_ssse3<3, 2, 1, 0>(frame, output, startLine, endLine);
 }
 
 QT_END_NAMESPACE
@@ -24,7 +24,13 @@
 #include <QtCore/qsize.h>
 #include <QtCore/qhash.h>
 #include <QtCore/qfile.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
 #include <QtCore/qthreadstorage.h>
+#include <QtCore/qthreadpool.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qpromise.h>
 #include <QtGui/qimage.h>
 #include <qpa/qplatformintegration.h>
 #include <private/qvideotexturehelper_p.h>
@@ -36,31 +42,77 @@
 #include <QtCore/private/qcore_mac_p.h>
 #endif
 
+#include <map>
+#include <utility>
+
 QT_BEGIN_NAMESPACE
 
 static Q_LOGGING_CATEGORY(qLcVideoFrameConverter, "qt.multimedia.video.frameconverter")
 
 namespace {
 
+// The GPU resources of the conversion, kept for the following conversions on the
+// same thread, so that repeated conversions only cost a draw and a readback
+struct RenderResources
+{
+    struct Pipeline
+    {
+        std::unique_ptr<QRhiShaderResourceBindings> bindings;
+        std::unique_ptr<QRhiGraphicsPipeline> pipeline;
+    };
+
+    std::unique_ptr<QRhiBuffer> vertexBuffer;
+    bool vertexBufferUploaded = false;
+    std::unique_ptr<QRhiBuffer> uniformBuffer;
+    std::unique_ptr<QRhiSampler> sampler;
+
+    // shared by all render targets, as they all have a single RGBA8 color attachment
+    std::unique_ptr<QRhiRenderPassDescriptor> renderPass;
+    std::unique_ptr<QRhiTexture> targetTexture;
+    std::unique_ptr<QRhiTextureRenderTarget> renderTarget;
+
+    // the textures of the last frame in memory, to upload the next one into
+    std::unique_ptr<QVideoFrameTextures> frameTextures;
+
+    // by vertex and fragment shader, which also determine the layout of the bindings
+    std::map<std::pair<QString, QString>, Pipeline> pipelines;
+};
+
 struct State
 {
     QRhi *rhi = nullptr;
+    RenderResources *resources = nullptr;
 #if QT_CONFIG(opengl)
+    // Only the GUI thread can create a QOffscreenSurface. The state of the GUI thread
+    // owns its surface, other threads borrow theirs from the GUI thread.
     QOffscreenSurface *fallbackSurface = nullptr;
+    bool ownsFallbackSurface = false;
 #endif
     bool cpuOnly = false;
-    ~State() {
-        delete rhi;
+
+    void reset()
+    {
+        // the resources have to go before the QRhi
+        delete std::exchange(resources, nullptr);
+        delete std::exchange(rhi, nullptr);
 #if QT_CONFIG(opengl)
-        delete fallbackSurface;
+        if (ownsFallbackSurface)
+            delete fallbackSurface;
+        fallbackSurface = nullptr;
+        ownsFallbackSurface = false;
 #endif
+        cpuOnly = false;
     }
+
+    ~State() { reset(); }
 };
 
 }
 
 static QThreadStorage<State> g_state;
+// shared by the GUI thread and the threads converting frames
 static QHash<QString, QShader> g_shaderCache;
+static QBasicMutex g_shaderCacheMutex;
 
 static const float g_quad[] = {
     // Rotation 0 CW
@@ -104,22 +156,28 @@ static bool pixelFormatHasAlpha(QVideoFrameFormat::PixelFormat format)
 
 static QShader vfcGetShader(const QString &name)
 {
-    QShader shader = g_shaderCache.value(name);
-    if (shader.isValid())
-        return shader;
+    {
+        QMutexLocker locker(&g_shaderCacheMutex);
+        QShader shader = g_shaderCache.value(name);
+        if (shader.isValid())
+            return shader;
+    }
 
+    QShader shader;
     QFile f(name);
     if (f.open(QIODevice::ReadOnly))
         shader = QShader::fromSerialized(f.readAll());
 
-    if (shader.isValid())
+    if (shader.isValid()) {
+        QMutexLocker locker(&g_shaderCacheMutex);
         g_shaderCache[name] = shader;
+    }
 
     return shader;
 }
 
-static void rasterTransform(QImage &image, QVideoFrame::RotationAngle rotation,
-                            bool mirrorX, bool mirrorY)
+static QTransform rasterTransformMatrix(QVideoFrame::RotationAngle rotation,
+                                        bool mirrorX, bool mirrorY)
 {
     QTransform t;
     if (mirrorX)
@@ -128,16 +186,77 @@ static void rasterTransform(QImage &image, QVideoFrame::RotationAngle rotation,
         t.rotate(float(rotation));
     if (mirrorY)
         t.scale(1.f, -1.f);
+    return t;
+}
+
+static void rasterTransform(QImage &image, QVideoFrame::RotationAngle rotation,
+                            bool mirrorX, bool mirrorY)
+{
+    const QTransform t = rasterTransformMatrix(rotation, mirrorX, mirrorY);
     if (!t.isIdentity())
         image = image.transformed(t);
 }
 
+namespace {
+
+// Maps the pixels of a frame to their position after rasterTransform(), so that
+// converted lines can be written to their final place without a second pass.
+struct PixelTransform
+{
+    PixelTransform(QSize size, QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY)
+    {
+        const QTransform t = rasterTransformMatrix(rotation, mirrorX, mirrorY);
+        isIdentity = t.isIdentity();
+
+        const QRectF bounds = t.mapRect(QRectF(QPointF(), QSizeF(size)));
+        targetSize = bounds.size().toSize();
+
+        const QPointF origin = t.map(QPointF(0.5, 0.5)) - bounds.topLeft();
+        const QPointF xStep = t.map(QPointF(1, 0)) - t.map(QPointF(0, 0));
+        const QPointF yStep = t.map(QPointF(0, 1)) - t.map(QPointF(0, 0));
+        originX = qFloor(origin.x());
+        originY = qFloor(origin.y());
+        xStepX = qRound(xStep.x());
+        xStepY = qRound(xStep.y());
+        yStepX = qRound(yStep.x());
+        yStepY = qRound(yStep.y());
+    }
+
+    bool isIdentity = true;
+    QSize targetSize;
+    int originX = 0;
+    int originY = 0;
+    // the destination offsets of one pixel to the right and one line down in the source
+    int xStepX = 1;
+    int xStepY = 0;
+    int yStepX = 0;
+    int yStepY = 1;
+};
+
+}
+
 static void imageCleanupHandler(void *info)
 {
     QByteArray *imageData = reinterpret_cast<QByteArray *>(info);
     delete imageData;
 }
 
+static bool isGuiThread()
+{
+    const QCoreApplication *app = QCoreApplication::instance();
+    return app && app->thread() == QThread::currentThread();
+}
+
+#if QT_CONFIG(opengl)
+static bool canUseOpenGL()
+{
+    QPlatformIntegration *integration = QGuiApplicationPrivate::platformIntegration();
+    return integration && integration->hasCapability(QPlatformIntegration::OpenGL)
+            && integration->hasCapability(QPlatformIntegration::RasterGLSurface)
+            && !QCoreApplication::testAttribute(Qt::AA_ForceRasterWidgets);
+}
+#endif
+
 static QRhi *initializeRHI(QRhi *videoFrameRhi)
 {
     if (g_state.localData().rhi || g_state.localData().cpuOnly)
@@ -163,16 +282,22 @@ static QRhi *initializeRHI(QRhi *videoFrameRhi)
 
 #if QT_CONFIG(opengl)
         if (!g_state.localData().rhi && (backend == QRhi::OpenGLES2 || backend == QRhi::Null)) {
-            if (QGuiApplicationPrivate::platformIntegration()->hasCapability(QPlatformIntegration::OpenGL)
-                    && QGuiApplicationPrivate::platformIntegration()->hasCapability(QPlatformIntegration::RasterGLSurface)
-                    && !QCoreApplication::testAttribute(Qt::AA_ForceRasterWidgets)) {
-
-                g_state.localData().fallbackSurface = QRhiGles2InitParams::newFallbackSurface();
-                QRhiGles2InitParams params;
-                params.fallbackSurface = g_state.localData().fallbackSurface;
-                if (backend == QRhi::OpenGLES2)
-                    params.shareContext = static_cast<const QRhiGles2NativeHandles*>(videoFrameRhi->nativeHandles())->context;
-                g_state.localData().rhi = QRhi::create(QRhi::OpenGLES2, &params);
+            if (canUseOpenGL()) {
+                State &state = g_state.localData();
+                if (!state.fallbackSurface && isGuiThread()) {
+                    state.fallbackSurface = QRhiGles2InitParams::newFallbackSurface();
+                    state.ownsFallbackSurface = true;
+                }
+
+                if (state.fallbackSurface) {
+                    QRhiGles2InitParams params;
+                    params.fallbackSurface = state.fallbackSurface;
+                    if (backend == QRhi::OpenGLES2)
+                        params.shareContext = static_cast<const QRhiGles2NativeHandles*>(videoFrameRhi->nativeHandles())->context;
+                    state.rhi = QRhi::create(QRhi::OpenGLES2, &params);
+                } else {
+                    qCDebug(qLcVideoFrameConverter) << "No fallback surface from the GUI thread";
+                }
             }
         }
 #endif
@@ -186,42 +311,90 @@ static QRhi *initializeRHI(QRhi *videoFrameRhi)
     return g_state.localData().rhi;
 }
 
-static bool updateTextures(QRhi *rhi,
-                           std::unique_ptr<QRhiBuffer> &uniformBuffer,
-                           std::unique_ptr<QRhiSampler> &textureSampler,
-                           std::unique_ptr<QRhiShaderResourceBindings> &shaderResourceBindings,
-                           std::unique_ptr<QRhiGraphicsPipeline> &graphicsPipeline,
-                           std::unique_ptr<QRhiRenderPassDescriptor> &renderPass,
-                           QVideoFrame &frame,
-                           const std::unique_ptr<QVideoFrameTextures> &videoFrameTextures)
+static bool createBuffers(QRhi *rhi, RenderResources &resources)
 {
-    auto format = frame.surfaceFormat();
-    auto pixelFormat = format.pixelFormat();
+    if (resources.vertexBuffer)
+        return true;
+
+    std::unique_ptr<QRhiBuffer> vertexBuffer(rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(g_quad)));
+    std::unique_ptr<QRhiBuffer> uniformBuffer(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64 + 64 + 4 + 4 + 4 + 4));
+    std::unique_ptr<QRhiSampler> sampler(rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
+                                                         QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge));
+    if (!vertexBuffer->create() || !uniformBuffer->create() || !sampler->create())
+        return false;
 
-    auto textureDesc = QVideoTextureHelper::textureDescription(pixelFormat);
+    resources.vertexBuffer = std::move(vertexBuffer);
+    resources.vertexBufferUploaded = false;
+    resources.uniformBuffer = std::move(uniformBuffer);
+    resources.sampler = std::move(sampler);
+    return true;
+}
+
+static QRhiTextureRenderTarget *renderTarget(QRhi *rhi, RenderResources &resources, const QSize &size)
+{
+    if (resources.targetTexture && resources.targetTexture->pixelSize() == size)
+        return resources.renderTarget.get();
+
+    resources.renderTarget.reset();
+    resources.targetTexture.reset(rhi->newTexture(QRhiTexture::RGBA8, size, 1, QRhiTexture::RenderTarget));
+    if (!resources.targetTexture->create()) {
+        resources.targetTexture.reset();
+        return nullptr;
+    }
+
+    resources.renderTarget.reset(rhi->newTextureRenderTarget({ { resources.targetTexture.get() } }));
+    if (!resources.renderPass)
+        resources.renderPass.reset(resources.renderTarget->newCompatibleRenderPassDescriptor());
+    resources.renderTarget->setRenderPassDescriptor(resources.renderPass.get());
+    if (!resources.renderTarget->create()) {
+        resources.renderTarget.reset();
+        resources.targetTexture.reset();
+        return nullptr;
+    }
+
+    return resources.renderTarget.get();
+}
+
+static RenderResources::Pipeline *graphicsPipeline(QRhi *rhi, RenderResources &resources,
+                                                   const QVideoFrameFormat &format,
+                                                   QVideoFrameTextures *videoFrameTextures)
+{
+    const std::pair key(QVideoTextureHelper::vertexShaderFileName(format),
+                        QVideoTextureHelper::fragmentShaderFileName(format));
+    RenderResources::Pipeline &pipeline = resources.pipelines[key];
+
+    // bind the textures of the current frame
+    auto textureDesc = QVideoTextureHelper::textureDescription(format.pixelFormat());
 
     QRhiShaderResourceBinding bindings[4];
     auto *b = bindings;
     *b++ = QRhiShaderResourceBinding::uniformBuffer(0, QRhiShaderResourceBinding::VertexStage | QRhiShaderResourceBinding::FragmentStage,
-                                                    uniformBuffer.get());
+                                                    resources.uniformBuffer.get());
     for (int i = 0; i < textureDesc->nplanes; ++i)
         *b++ = QRhiShaderResourceBinding::sampledTexture(i + 1, QRhiShaderResourceBinding::FragmentStage,
-                                                         videoFrameTextures->texture(i), textureSampler.get());
-    shaderResourceBindings->setBindings(bindings, b);
-    shaderResourceBindings->create();
-
-    graphicsPipeline.reset(rhi->newGraphicsPipeline());
-    graphicsPipeline->setTopology(QRhiGraphicsPipeline::TriangleStrip);
+                                                         videoFrameTextures->texture(i), resources.sampler.get());
+
+    if (!pipeline.bindings)
+        pipeline.bindings.reset(rhi->newShaderResourceBindings());
+    pipeline.bindings->setBindings(bindings, b);
+    if (!pipeline.bindings->create()) {
+        resources.pipelines.erase(key);
+        return nullptr;
+    }
 
-    QShader vs = vfcGetShader(QVideoTextureHelper::vertexShaderFileName(format));
-    if (!vs.isValid())
-        return false;
+    if (pipeline.pipeline)
+        return &pipeline;
 
-    QShader fs = vfcGetShader(QVideoTextureHelper::fragmentShaderFileName(format));
-    if (!fs.isValid())
-        return false;
+    QShader vs = vfcGetShader(key.first);
+    QShader fs = vfcGetShader(key.second);
+    if (!vs.isValid() || !fs.isValid()) {
+        resources.pipelines.erase(key);
+        return nullptr;
+    }
 
-    graphicsPipeline->setShaderStages({
+    pipeline.pipeline.reset(rhi->newGraphicsPipeline());
+    pipeline.pipeline->setTopology(QRhiGraphicsPipeline::TriangleStrip);
+    pipeline.pipeline->setShaderStages({
         { QRhiShaderStage::Vertex, vs },
         { QRhiShaderStage::Fragment, fs }
     });
@@ -235,12 +408,15 @@ static bool updateTextures(QRhi *rhi,
         { 0, 1, QRhiVertexInputAttribute::Float2, 2 * sizeof(float) }
     });
 
-    graphicsPipeline->setVertexInputLayout(inputLayout);
-    graphicsPipeline->setShaderResourceBindings(shaderResourceBindings.get());
-    graphicsPipeline->setRenderPassDescriptor(renderPass.get());
-    graphicsPipeline->create();
+    pipeline.pipeline->setVertexInputLayout(inputLayout);
+    pipeline.pipeline->setShaderResourceBindings(pipeline.bindings.get());
+    pipeline.pipeline->setRenderPassDescriptor(resources.renderPass.get());
+    if (!pipeline.pipeline->create()) {
+        resources.pipelines.erase(key);
+        return nullptr;
+    }
 
-    return true;
+    return &pipeline;
 }
 
 static QImage convertJPEG(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY)
@@ -257,7 +433,129 @@ static QImage convertJPEG(const QVideoFrame &frame, QVideoFrame::RotationAngle r
     return image;
 }
 
-static QImage convertCPU(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY)
+// Averages factor x factor blocks of the converted lines into single pixels. Blocks
+// at the right and bottom edges may be smaller.
+static void downscaleLines(const quint32 *lines, int width, int startLine, int endLine,
+                           int factor, const PixelTransform &transform, quint32 *target,
+                           qsizetype stride)
+{
+    const qsizetype step = transform.xStepY * stride + transform.xStepX;
+    const int targetWidth = (width + factor - 1) / factor;
+
+    for (int by = startLine / factor; by * factor < endLine; ++by) {
+        const quint32 *blockLines = lines + qsizetype(by * factor - startLine) * width;
+        const int rows = std::min(factor, endLine - by * factor);
+        quint32 *dst = target + (transform.originY + by * transform.yStepY) * stride
+                + transform.originX + by * transform.yStepX;
+
+        for (int bx = 0; bx < targetWidth; ++bx, dst += step) {
+            const int columns = std::min(factor, width - bx * factor);
+            int a = 0, r = 0, g = 0, b = 0;
+            for (int j = 0; j < rows; ++j) {
+                const quint32 *src = blockLines + qsizetype(j) * width + bx * factor;
+                for (int i = 0; i < columns; ++i) {
+                    a += qAlpha(src[i]);
+                    r += qRed(src[i]);
+                    g += qGreen(src[i]);
+                    b += qBlue(src[i]);
+                }
+            }
+            const int n = rows * columns;
+            *dst = qRgba((r + n / 2) / n, (g + n / 2) / n, (b + n / 2) / n, (a + n / 2) / n);
+        }
+    }
+}
+
+static void convertSegment(VideoFrameConvertFunc convert, const QVideoFrame &frame,
+                           const PixelTransform &transform, int downscaleFactor, uchar *bits,
+                           qsizetype bytesPerLine, int startLine, int endLine)
+{
+    if (transform.isIdentity && downscaleFactor == 1) {
+        convert(frame, bits + startLine * bytesPerLine, startLine, endLine);
+        return;
+    }
+
+    const int width = frame.width();
+    std::unique_ptr<quint32[]> lines(new quint32[qsizetype(width) * (endLine - startLine)]);
+    convert(frame, reinterpret_cast<uchar *>(lines.get()), startLine, endLine);
+
+    auto *target = reinterpret_cast<quint32 *>(bits);
+    const qsizetype stride = bytesPerLine / sizeof(quint32);
+
+    if (downscaleFactor > 1) {
+        downscaleLines(lines.get(), width, startLine, endLine, downscaleFactor, transform, target,
+                       stride);
+        return;
+    }
+
+    const qsizetype step = transform.xStepY * stride + transform.xStepX;
+
+    const quint32 *src = lines.get();
+    for (int y = startLine; y < endLine; ++y) {
+        quint32 *dst = target + (transform.originY + y * transform.yStepY) * stride
+                + transform.originX + y * transform.yStepX;
+        for (int x = 0; x < width; ++x, dst += step)
+            *dst = *src++;
+    }
+}
+
+static void convertSegments(VideoFrameConvertFunc convert, const QVideoFrame &frame,
+                            const PixelTransform &transform, int downscaleFactor, QImage &image)
+{
+    // don't detach in the worker threads
+    uchar *bits = image.bits();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+    const int height = frame.height();
+
+#if QT_CONFIG(thread)
+    // Same heuristic as the QImage conversions, with segments of 64K pixels. Segments
+    // start at multiples of the alignment, so that neither subsampled chroma lines nor
+    // downscaled blocks are split.
+    const int alignment = std::max(2, downscaleFactor);
+    int segments = int((qsizetype(frame.width()) * height) >> 16);
+    segments = std::min(segments, height / alignment);
+
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    if (segments > 1 && threadPool && !threadPool->contains(QThread::currentThread())) {
+        QSemaphore semaphore;
+        int y = 0;
+        for (int i = 0; i < segments; ++i) {
+            const int yn = i == segments - 1
+                    ? height - y
+                    : (height - y) / (segments - i) / alignment * alignment;
+            threadPool->start([&, y, yn]() {
+                convertSegment(convert, frame, transform, downscaleFactor, bits, bytesPerLine, y,
+                               y + yn);
+                semaphore.release(1);
+            });
+            y += yn;
+        }
+        semaphore.acquire(segments);
+        return;
+    }
+#endif
+
+    convertSegment(convert, frame, transform, downscaleFactor, bits, bytesPerLine, 0, height);
+}
+
+// The largest power of two the frame can be shrunk by while staying at least as
+// large as the target size
+static int downscaleFactor(QSize frameSize, QSize targetSize, QVideoFrame::RotationAngle rotation)
+{
+    if (targetSize.isEmpty())
+        return 1;
+    if ((rotation / 90) % 2)
+        targetSize.transpose();
+
+    int factor = 1;
+    while (frameSize.width() / (factor * 2) >= targetSize.width()
+           && frameSize.height() / (factor * 2) >= targetSize.height())
+        factor *= 2;
+    return factor;
+}
+
+static QImage convertCPU(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY,
+                         const QSize &targetSize)
 {
     VideoFrameConvertFunc convert = qConverterForFormat(frame.pixelFormat());
     if (!convert) {
@@ -270,15 +568,22 @@ static QImage convertCPU(const QVideoFrame &frame, QVideoFrame::RotationAngle ro
             return {};
         }
         auto format = pixelFormatHasAlpha(varFrame.pixelFormat()) ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
-        QImage image = QImage(varFrame.width(), varFrame.height(), format);
-        convert(varFrame, image.bits());
+        // shrink while converting; the rest of the scaling is left to the caller
+        const int factor = downscaleFactor(varFrame.size(), targetSize, rotation);
+        const QSize size((varFrame.width() + factor - 1) / factor,
+                         (varFrame.height() + factor - 1) / factor);
+        const PixelTransform transform(size, rotation, mirrorX, mirrorY);
+        QImage image = QImage(transform.targetSize, format);
+        convertSegments(convert, varFrame, transform, factor, image);
         varFrame.unmap();
-        rasterTransform(image, rotation, mirrorX, mirrorY);
         return image;
     }
 }
 
-QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY)
+// Converts the frame to an image of targetSize, or of a size between targetSize
+// and the size of the frame, if the conversion cannot scale exactly
+static QImage convertFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation,
+                           bool mirrorX, bool mirrorY, const QSize &targetSize)
 {
 #ifdef Q_OS_DARWIN
     QMacAutoReleasePool releasePool;
@@ -287,15 +592,6 @@ QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle
     if (!g_state.hasLocalData())
         g_state.setLocalData({});
 
-    std::unique_ptr<QRhiRenderPassDescriptor> renderPass;
-    std::unique_ptr<QRhiBuffer> vertexBuffer;
-    std::unique_ptr<QRhiBuffer> uniformBuffer;
-    std::unique_ptr<QRhiTexture> targetTexture;
-    std::unique_ptr<QRhiTextureRenderTarget> renderTarget;
-    std::unique_ptr<QRhiSampler> textureSampler;
-    std::unique_ptr<QRhiShaderResourceBindings> shaderResourceBindings;
-    std::unique_ptr<QRhiGraphicsPipeline> graphicsPipeline;
-
     if (frame.size().isEmpty() || frame.pixelFormat() == QVideoFrameFormat::Format_Invalid)
         return {};
 
@@ -311,61 +607,74 @@ QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle
         rhi = initializeRHI(rhi);
 
     if (!rhi || rhi->isRecordingFrame())
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
 
     // Do conversion using shaders
 
     const int rotationIndex = (rotation / 90) % 4;
 
+    // render at the target size right away
     QSize frameSize = frame.size();
     if (rotationIndex % 2)
         frameSize.transpose();
+    if (!targetSize.isEmpty())
+        frameSize = targetSize;
+
+    // Resources of the thread's own QRhi are cached in its state. A QRhi of the
+    // frame can go away at any time, so its resources only live for this call.
+    std::unique_ptr<RenderResources> localResources;
+    RenderResources *resources = nullptr;
+    if (rhi == g_state.localData().rhi) {
+        if (!g_state.localData().resources)
+            g_state.localData().resources = new RenderResources;
+        resources = g_state.localData().resources;
+    } else {
+        localResources = std::make_unique<RenderResources>();
+        resources = localResources.get();
+    }
 
-    vertexBuffer.reset(rhi->newBuffer(QRhiBuffer::Immutable, QRhiBuffer::VertexBuffer, sizeof(g_quad)));
-    vertexBuffer->create();
-
-    uniformBuffer.reset(rhi->newBuffer(QRhiBuffer::Dynamic, QRhiBuffer::UniformBuffer, 64 + 64 + 4 + 4 + 4 + 4));
-    uniformBuffer->create();
-
-    textureSampler.reset(rhi->newSampler(QRhiSampler::Linear, QRhiSampler::Linear, QRhiSampler::None,
-                                         QRhiSampler::ClampToEdge, QRhiSampler::ClampToEdge));
-    textureSampler->create();
-
-    shaderResourceBindings.reset(rhi->newShaderResourceBindings());
+    if (!createBuffers(rhi, *resources)) {
+        qCDebug(qLcVideoFrameConverter) << "Failed to create buffers. Using CPU conversion.";
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
+    }
 
-    targetTexture.reset(rhi->newTexture(QRhiTexture::RGBA8, frameSize, 1, QRhiTexture::RenderTarget));
-    if (!targetTexture->create()) {
+    QRhiTextureRenderTarget *target = renderTarget(rhi, *resources, frameSize);
+    if (!target) {
         qCDebug(qLcVideoFrameConverter) << "Failed to create target texture. Using CPU conversion.";
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
     }
 
-    renderTarget.reset(rhi->newTextureRenderTarget({ { targetTexture.get() } }));
-    renderPass.reset(renderTarget->newCompatibleRenderPassDescriptor());
-    renderTarget->setRenderPassDescriptor(renderPass.get());
-    renderTarget->create();
-
     QRhiCommandBuffer *cb = nullptr;
     QRhi::FrameOpResult r = rhi->beginOffscreenFrame(&cb);
     if (r != QRhi::FrameOpSuccess) {
         qCDebug(qLcVideoFrameConverter) << "Failed to set up offscreen frame. Using CPU conversion.";
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
     }
 
     QRhiResourceUpdateBatch *rub = rhi->nextResourceUpdateBatch();
 
-    rub->uploadStaticBuffer(vertexBuffer.get(), g_quad);
-
     QVideoFrame frameTmp = frame;
-    auto videoFrameTextures = QVideoTextureHelper::createTextures(frameTmp, rhi, rub, {});
+    auto videoFrameTextures = QVideoTextureHelper::createTextures(frameTmp, rhi, rub,
+                                                                  std::move(resources->frameTextures));
     if (!videoFrameTextures) {
         qCDebug(qLcVideoFrameConverter) << "Failed obtain textures. Using CPU conversion.";
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        rub->release();
+        rhi->endOffscreenFrame();
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
     }
 
-    if (!updateTextures(rhi, uniformBuffer, textureSampler, shaderResourceBindings,
-                        graphicsPipeline, renderPass, frameTmp, videoFrameTextures)) {
+    RenderResources::Pipeline *pipeline =
+            graphicsPipeline(rhi, *resources, frameTmp.surfaceFormat(), videoFrameTextures.get());
+    if (!pipeline) {
         qCDebug(qLcVideoFrameConverter) << "Failed to update textures. Using CPU conversion.";
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        rub->release();
+        rhi->endOffscreenFrame();
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
+    }
+
+    if (!resources->vertexBufferUploaded) {
+        rub->uploadStaticBuffer(resources->vertexBuffer.get(), g_quad);
+        resources->vertexBufferUploaded = true;
     }
 
     float xScale = mirrorX ? -1.0 : 1.0;
@@ -379,20 +688,20 @@ QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle
 
     QByteArray uniformData(64 + 64 + 4 + 4, Qt::Uninitialized);
     QVideoTextureHelper::updateUniformData(&uniformData, frame.surfaceFormat(), frame, transform, 1.f);
-    rub->updateDynamicBuffer(uniformBuffer.get(), 0, uniformData.size(), uniformData.constData());
+    rub->updateDynamicBuffer(resources->uniformBuffer.get(), 0, uniformData.size(), uniformData.constData());
 
-    cb->beginPass(renderTarget.get(), Qt::black, { 1.0f, 0 }, rub);
-    cb->setGraphicsPipeline(graphicsPipeline.get());
+    cb->beginPass(target, Qt::black, { 1.0f, 0 }, rub);
+    cb->setGraphicsPipeline(pipeline->pipeline.get());
 
     cb->setViewport({ 0, 0, float(frameSize.width()), float(frameSize.height()) });
-    cb->setShaderResources(shaderResourceBindings.get());
+    cb->setShaderResources(pipeline->bindings.get());
 
     quint32 vertexOffset = quint32(sizeof(float)) * 16 * rotationIndex;
-    const QRhiCommandBuffer::VertexInput vbufBinding(vertexBuffer.get(), vertexOffset);
+    const QRhiCommandBuffer::VertexInput vbufBinding(resources->vertexBuffer.get(), vertexOffset);
     cb->setVertexInput(0, 1, &vbufBinding);
     cb->draw(4);
 
-    QRhiReadbackDescription readDesc(targetTexture.get());
+    QRhiReadbackDescription readDesc(resources->targetTexture.get());
     QRhiReadbackResult readResult;
     bool readCompleted = false;
 
@@ -405,9 +714,13 @@ QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle
 
     rhi->endOffscreenFrame();
 
+    // keep the textures of frames in memory to upload the next frame into
+    if (frame.handleType() == QVideoFrame::NoHandle)
+        resources->frameTextures = std::move(videoFrameTextures);
+
     if (!readCompleted) {
         qCDebug(qLcVideoFrameConverter) << "Failed to read back texture. Using CPU conversion.";
-        return convertCPU(frame, rotation, mirrorX, mirrorY);
+        return convertCPU(frame, rotation, mirrorX, mirrorY, targetSize);
     }
 
     QByteArray *imageData = new QByteArray(readResult.data);
@@ -417,5 +730,143 @@ QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle
                   QImage::Format_RGBA8888_Premultiplied, imageCleanupHandler, imageData);
 }
 
-QT_END_NAMESPACE
+QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation,
+                            bool mirrorX, bool mirrorY, const QSize &targetSize,
+                            QImage::Format format)
+{
+    QImage image = convertFrame(frame, rotation, mirrorX, mirrorY, targetSize);
+    if (image.isNull())
+        return image;
+
+    if (!targetSize.isEmpty() && image.size() != targetSize)
+        image = image.scaled(targetSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (format != QImage::Format_Invalid && image.format() != format)
+        image.convertTo(format);
+    return image;
+}
+
+namespace {
 
+// Converts frames on a thread of its own, which keeps its QRhi and GPU resources
+// between the conversions
+class AsyncConverter : public QThreadPool
+{
+public:
+    AsyncConverter();
+
+    // Releases the QRhi of the thread on that thread, before the application goes away
+    void shutDown()
+    {
+        start([] { g_state.localData().reset(); });
+        waitForDone();
+#if QT_CONFIG(opengl)
+        delete fallbackSurface.fetchAndStoreOrdered(nullptr);
+#endif
+    }
+
+    // Conversions requested while this many are pending are canceled, so that
+    // frames don't pile up when the conversion cannot keep up
+    static constexpr int MaxPendingConversions = 3;
+    QAtomicInt pendingConversions;
+
+#if QT_CONFIG(opengl)
+    // created on the GUI thread, for the QRhi of the conversion thread
+    QAtomicPointer<QOffscreenSurface> fallbackSurface;
+#endif
+};
+
+Q_GLOBAL_STATIC(AsyncConverter, g_asyncConverter)
+
+static void shutDownAsyncConverter()
+{
+    if (AsyncConverter *converter = g_asyncConverter())
+        converter->shutDown();
+}
+
+AsyncConverter::AsyncConverter()
+{
+    setObjectName(QStringLiteral("QVideoFrameConverter"));
+    setMaxThreadCount(1);
+    setExpiryTimeout(-1);
+    // the thread never expires, so its state would outlive the application otherwise
+    qAddPostRoutine(shutDownAsyncConverter);
+}
+
+class ConversionTask : public QRunnable
+{
+public:
+    ConversionTask(QPromise<QImage> &&promise, const QVideoFrame &frame,
+                   QVideoFrame::RotationAngle rotation, bool mirrorX, bool mirrorY,
+                   const QSize &targetSize, QImage::Format format)
+        : m_promise(std::move(promise)),
+          m_frame(frame),
+          m_rotation(rotation),
+          m_mirrorX(mirrorX),
+          m_mirrorY(mirrorY),
+          m_targetSize(targetSize),
+          m_format(format)
+    {
+    }
+
+    void run() override
+    {
+#if QT_CONFIG(opengl)
+        // conversions requested before the GUI thread provided a surface ran on the CPU
+        State &state = g_state.localData();
+        if (!state.rhi && !state.fallbackSurface) {
+            state.fallbackSurface = g_asyncConverter->fallbackSurface.loadAcquire();
+            if (state.fallbackSurface)
+                state.cpuOnly = false;
+        }
+#endif
+        if (!m_promise.isCanceled())
+            m_promise.addResult(qImageFromVideoFrame(m_frame, m_rotation, m_mirrorX, m_mirrorY,
+                                                     m_targetSize, m_format));
+        m_promise.finish();
+        g_asyncConverter->pendingConversions.deref();
+    }
+
+private:
+    QPromise<QImage> m_promise;
+    QVideoFrame m_frame;
+    QVideoFrame::RotationAngle m_rotation;
+    bool m_mirrorX;
+    bool m_mirrorY;
+    QSize m_targetSize;
+    QImage::Format m_format;
+};
+
+}
+
+QFuture<QImage> qImageFromVideoFrameAsync(const QVideoFrame &frame,
+                                          QVideoFrame::RotationAngle rotation, bool mirrorX,
+                                          bool mirrorY, const QSize &targetSize,
+                                          QImage::Format format)
+{
+    QPromise<QImage> promise;
+    QFuture<QImage> future = promise.future();
+    promise.start();
+
+    AsyncConverter *converter = g_asyncConverter();
+    if (!converter
+        || converter->pendingConversions.fetchAndAddOrdered(1)
+                >= AsyncConverter::MaxPendingConversions) {
+        if (converter)
+            converter->pendingConversions.deref();
+        qCDebug(qLcVideoFrameConverter) << "Too many pending conversions, dropping the frame";
+        future.cancel();
+        promise.finish();
+        return future;
+    }
+
+#if QT_CONFIG(opengl)
+    if (!converter->fallbackSurface.loadAcquire() && isGuiThread() && canUseOpenGL())
+        converter->fallbackSurface.storeRelease(QRhiGles2InitParams::newFallbackSurface());
+#endif
+
+    converter->start(new ConversionTask(std::move(promise), frame, rotation, mirrorX, mirrorY,
+                                        targetSize, format));
+    return future;
+}
+
+QT_END_NAMESPACE
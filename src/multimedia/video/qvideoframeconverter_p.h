@@ -19,7 +19,16 @@
 
 QT_BEGIN_NAMESPACE
 
-Q_MULTIMEDIA_EXPORT QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation = QVideoFrame::Rotation0, bool mirrorX = false, bool mirrorY = false);
+// Converts the frame to an image of targetSize, after rotating and mirroring it.
+// An empty targetSize keeps the size of the frame, Format_Invalid keeps the format
+// the conversion produces.
+Q_MULTIMEDIA_EXPORT QImage qImageFromVideoFrame(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation = QVideoFrame::Rotation0, bool mirrorX = false, bool mirrorY = false,
+                                                const QSize &targetSize = {}, QImage::Format format = QImage::Format_Invalid);
+
+// Converts the frame on a dedicated thread. Conversions finish in the order they were
+// requested; if too many are pending, the returned future is canceled right away.
+Q_MULTIMEDIA_EXPORT QFuture<QImage> qImageFromVideoFrameAsync(const QVideoFrame &frame, QVideoFrame::RotationAngle rotation = QVideoFrame::Rotation0, bool mirrorX = false, bool mirrorY = false,
+                                                              const QSize &targetSize = {}, QImage::Format format = QImage::Format_Invalid);
 
 QT_END_NAMESPACE
 
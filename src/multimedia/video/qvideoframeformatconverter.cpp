@@ -0,0 +1,602 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvideoframeformatconverter_p.h"
+#include "qvideoframeconversionhelper_p.h"
+#include "qvideoframeconverter_p.h"
+#include "qvideoframepool_p.h"
+
+#include <QtCore/qloggingcategory.h>
+#include <QtCore/qsemaphore.h>
+#include <QtCore/qthreadpool.h>
+#include <QtGui/qimage.h>
+#include <QtGui/qrgb.h>
+
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+static Q_LOGGING_CATEGORY(qLcVideoFrameFormatConverter, "qt.multimedia.video.frameformatconverter")
+
+namespace {
+
+// Where the samples of 8 bit YUV formats are, so that they can be converted
+// to each other without going through RGB
+struct YUVLayout
+{
+    int yPlane = 0;
+    int uPlane = -1; // -1 if there's no chroma
+    int vPlane = -1;
+    int yStep = 1; // bytes between two samples of a line
+    int uvStep = 1;
+    int yOffset = 0; // byte of the first sample of a line
+    int uOffset = 0;
+    int vOffset = 0;
+    int chromaRowShift = 0; // 1 if the chroma is subsampled vertically
+};
+
+std::optional<YUVLayout> yuvLayout(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_YUV420P:
+        return YUVLayout{ 0, 1, 2, 1, 1, 0, 0, 0, 1 };
+    case QVideoFrameFormat::Format_YV12:
+        return YUVLayout{ 0, 2, 1, 1, 1, 0, 0, 0, 1 };
+    case QVideoFrameFormat::Format_NV12:
+        return YUVLayout{ 0, 1, 1, 1, 2, 0, 0, 1, 1 };
+    case QVideoFrameFormat::Format_NV21:
+        return YUVLayout{ 0, 1, 1, 1, 2, 0, 1, 0, 1 };
+    case QVideoFrameFormat::Format_YUV422P:
+        return YUVLayout{ 0, 1, 2, 1, 1, 0, 0, 0, 0 };
+    case QVideoFrameFormat::Format_UYVY:
+        return YUVLayout{ 0, 0, 0, 2, 4, 1, 0, 2, 0 };
+    case QVideoFrameFormat::Format_YUYV:
+        return YUVLayout{ 0, 0, 0, 2, 4, 0, 1, 3, 0 };
+    case QVideoFrameFormat::Format_Y8:
+        return YUVLayout{};
+    default:
+        return {};
+    }
+}
+
+// The bytes of the components of 32 bit RGB formats. Formats without alpha
+// have their padding byte in alpha.
+struct RGBLayout
+{
+    int a;
+    int r;
+    int g;
+    int b;
+    bool hasAlpha;
+    bool premultiplied;
+};
+
+std::optional<RGBLayout> rgbLayout(QVideoFrameFormat::PixelFormat format)
+{
+    switch (format) {
+    case QVideoFrameFormat::Format_ARGB8888:
+        return RGBLayout{ 0, 1, 2, 3, true, false };
+    case QVideoFrameFormat::Format_ARGB8888_Premultiplied:
+        return RGBLayout{ 0, 1, 2, 3, true, true };
+    case QVideoFrameFormat::Format_XRGB8888:
+        return RGBLayout{ 0, 1, 2, 3, false, true };
+    case QVideoFrameFormat::Format_BGRA8888:
+        return RGBLayout{ 3, 2, 1, 0, true, false };
+    case QVideoFrameFormat::Format_BGRA8888_Premultiplied:
+        return RGBLayout{ 3, 2, 1, 0, true, true };
+    case QVideoFrameFormat::Format_BGRX8888:
+        return RGBLayout{ 3, 2, 1, 0, false, true };
+    case QVideoFrameFormat::Format_ABGR8888:
+        return RGBLayout{ 0, 3, 2, 1, true, false };
+    case QVideoFrameFormat::Format_XBGR8888:
+        return RGBLayout{ 0, 3, 2, 1, false, true };
+    case QVideoFrameFormat::Format_RGBA8888:
+        return RGBLayout{ 3, 0, 1, 2, true, false };
+    case QVideoFrameFormat::Format_RGBX8888:
+        return RGBLayout{ 3, 0, 1, 2, false, true };
+    default:
+        return {};
+    }
+}
+
+// Fixed-point RGB to YUV matrix, with the coefficients scaled by 1 << 14
+struct RGBToYUVMatrix
+{
+    int yOffset;
+    int ry, gy, by;
+    int ru, gu, bu;
+    int rv, gv, bv;
+};
+
+constexpr int MatrixShift = 14;
+
+// The inverse of qYUVToRGBMatrix(), with the same choice of standard
+RGBToYUVMatrix rgbToYUVMatrix(const QVideoFrameFormat &format)
+{
+    bool fullRange = format.colorRange() == QVideoFrameFormat::ColorRange_Full;
+    float kr = 0.2126f;
+    float kb = 0.0722f;
+
+    switch (format.colorSpace()) {
+    case QVideoFrameFormat::ColorSpace_Undefined:
+        if (format.frameHeight() <= 576) {
+            kr = 0.299f;
+            kb = 0.114f;
+        }
+        break;
+    case QVideoFrameFormat::ColorSpace_AdobeRgb:
+        fullRange = true;
+        Q_FALLTHROUGH();
+    case QVideoFrameFormat::ColorSpace_BT601:
+        kr = 0.299f;
+        kb = 0.114f;
+        break;
+    case QVideoFrameFormat::ColorSpace_BT2020:
+        kr = 0.2627f;
+        kb = 0.0593f;
+        break;
+    case QVideoFrameFormat::ColorSpace_BT709:
+    default:
+        break;
+    }
+
+    const float kg = 1.f - kr - kb;
+    const float yScale = fullRange ? 1.f : 219.f / 255.f;
+    const float uvScale = fullRange ? 1.f : 224.f / 255.f;
+    const float uScale = uvScale / (2.f * (1.f - kb));
+    const float vScale = uvScale / (2.f * (1.f - kr));
+
+    const auto fixed = [](float coefficient) {
+        return qRound(coefficient * (1 << MatrixShift));
+    };
+
+    return { fullRange ? 0 : 16,
+             fixed(kr * yScale), fixed(kg * yScale), fixed(kb * yScale),
+             fixed(-kr * uScale), fixed(-kg * uScale), fixed((1.f - kb) * uScale),
+             fixed((1.f - kr) * vScale), fixed(-kg * vScale), fixed(-kb * vScale) };
+}
+
+// The mapped planes of a frame, fetched on the calling thread
+struct Planes
+{
+    explicit Planes(const QVideoFrame &frame)
+    {
+        for (int plane = 0; plane < frame.planeCount(); ++plane) {
+            bits[plane] = const_cast<uchar *>(frame.bits(plane));
+            bytesPerLine[plane] = frame.bytesPerLine(plane);
+            rows[plane] = bytesPerLine[plane] ? frame.mappedBytes(plane) / bytesPerLine[plane] : 0;
+        }
+    }
+
+    // nullptr for rows outside of the mapped memory
+    uchar *line(int plane, int row, int offset) const
+    {
+        return plane >= 0 && row < rows[plane]
+                ? bits[plane] + qsizetype(row) * bytesPerLine[plane] + offset
+                : nullptr;
+    }
+
+    uchar *bits[4] = {};
+    int bytesPerLine[4] = {};
+    int rows[4] = {};
+};
+
+void copySamples(const uchar *src, int srcStep, uchar *dst, int dstStep, int count)
+{
+    if (srcStep == 1 && dstStep == 1) {
+        memcpy(dst, src, count);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+        dst[i * dstStep] = src[i * srcStep];
+}
+
+// Splits interleaved chroma samples into two planes
+void deinterleave(const uchar *src, uchar *first, uchar *second, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 2 * i + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(first + i),
+                         _mm_packus_epi16(_mm_and_si128(a, lowBytes), _mm_and_si128(b, lowBytes)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(second + i),
+                         _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16) {
+        const uint8x16x2_t samples = vld2q_u8(src + 2 * i);
+        vst1q_u8(first + i, samples.val[0]);
+        vst1q_u8(second + i, samples.val[1]);
+    }
+#endif
+    for (; i < count; ++i) {
+        first[i] = src[2 * i];
+        second[i] = src[2 * i + 1];
+    }
+}
+
+// Interleaves the samples of two chroma planes
+void interleave(const uchar *first, const uchar *second, uchar *dst, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(second + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i), _mm_unpacklo_epi8(a, b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+    }
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t samples;
+        samples.val[0] = vld1q_u8(first + i);
+        samples.val[1] = vld1q_u8(second + i);
+        vst2q_u8(dst + 2 * i, samples);
+    }
+#endif
+    for (; i < count; ++i) {
+        dst[2 * i] = first[i];
+        dst[2 * i + 1] = second[i];
+    }
+}
+
+bool isSemiPlanar(const YUVLayout &layout)
+{
+    return layout.uPlane == layout.vPlane && layout.uvStep == 2;
+}
+
+// Reads the chroma of a line of the frame into u and v
+void fetchChroma(const Planes &planes, const YUVLayout &layout, int line, uchar *u, uchar *v,
+                 int count)
+{
+    const int row = line >> layout.chromaRowShift;
+    const uchar *uSrc = planes.line(layout.uPlane, row, layout.uOffset);
+    const uchar *vSrc = planes.line(layout.vPlane, row, layout.vOffset);
+    if (!uSrc || !vSrc) {
+        // grey for formats without chroma
+        memset(u, 128, count);
+        memset(v, 128, count);
+    } else if (isSemiPlanar(layout)) {
+        if (uSrc < vSrc)
+            deinterleave(uSrc, u, v, count);
+        else
+            deinterleave(vSrc, v, u, count);
+    } else {
+        copySamples(uSrc, layout.uvStep, u, 1, count);
+        copySamples(vSrc, layout.uvStep, v, 1, count);
+    }
+}
+
+void storeChroma(const Planes &planes, const YUVLayout &layout, int line, const uchar *u,
+                 const uchar *v, int count)
+{
+    const int row = line >> layout.chromaRowShift;
+    uchar *uDst = planes.line(layout.uPlane, row, layout.uOffset);
+    uchar *vDst = planes.line(layout.vPlane, row, layout.vOffset);
+    if (!uDst || !vDst)
+        return;
+
+    if (isSemiPlanar(layout)) {
+        if (uDst < vDst)
+            interleave(u, v, uDst, count);
+        else
+            interleave(v, u, vDst, count);
+    } else {
+        copySamples(u, 1, uDst, layout.uvStep, count);
+        copySamples(v, 1, vDst, layout.uvStep, count);
+    }
+}
+
+void averageRows(uchar *a, const uchar *b, int count)
+{
+    for (int i = 0; i < count; ++i)
+        a[i] = uchar((a[i] + b[i] + 1) >> 1);
+}
+
+// Converts the lines [startLine, endLine) between two 8 bit YUV formats of the same size
+void convertYUVLines(const Planes &src, const YUVLayout &srcLayout, const Planes &dst,
+                     const YUVLayout &dstLayout, int width, int startLine, int endLine)
+{
+    for (int line = startLine; line < endLine; ++line) {
+        const uchar *srcY = src.line(srcLayout.yPlane, line, srcLayout.yOffset);
+        uchar *dstY = dst.line(dstLayout.yPlane, line, dstLayout.yOffset);
+        if (srcY && dstY)
+            copySamples(srcY, srcLayout.yStep, dstY, dstLayout.yStep, width);
+    }
+
+    if (dstLayout.uPlane < 0)
+        return;
+
+    const int chromaWidth = (width + 1) / 2;
+    std::unique_ptr<uchar[]> scratch(new uchar[4 * chromaWidth]);
+    uchar *u = scratch.get();
+    uchar *v = u + chromaWidth;
+    uchar *nextU = v + chromaWidth;
+    uchar *nextV = nextU + chromaWidth;
+
+    const bool subsample = dstLayout.chromaRowShift > srcLayout.chromaRowShift;
+    for (int line = startLine; line < endLine; line += 1 << dstLayout.chromaRowShift) {
+        fetchChroma(src, srcLayout, line, u, v, chromaWidth);
+        if (subsample && line + 1 < endLine) {
+            fetchChroma(src, srcLayout, line + 1, nextU, nextV, chromaWidth);
+            averageRows(u, nextU, chromaWidth);
+            averageRows(v, nextV, chromaWidth);
+        }
+        storeChroma(dst, dstLayout, line, u, v, chromaWidth);
+    }
+}
+
+void storeRGBLine(const quint32 *argb, uchar *dst, const RGBLayout &layout, int width)
+{
+    // ARGB32 is stored as B, G, R, A on little endian
+    if (Q_BYTE_ORDER == Q_LITTLE_ENDIAN && layout.a == 3 && layout.r == 2 && layout.b == 0
+        && layout.hasAlpha && layout.premultiplied) {
+        memcpy(dst, argb, width * 4);
+        return;
+    }
+
+    for (int x = 0; x < width; ++x, dst += 4) {
+        QRgb pixel = argb[x];
+        if (!layout.hasAlpha)
+            pixel |= 0xff000000;
+        else if (!layout.premultiplied)
+            pixel = qUnpremultiply(pixel);
+
+        dst[layout.a] = uchar(qAlpha(pixel));
+        dst[layout.r] = uchar(qRed(pixel));
+        dst[layout.g] = uchar(qGreen(pixel));
+        dst[layout.b] = uchar(qBlue(pixel));
+    }
+}
+
+inline uchar clampToByte(int value)
+{
+    return uchar(qBound(0, value, 255));
+}
+
+void rgbToLuma(const RGBToYUVMatrix &m, const quint32 *argb, uchar *y, int width)
+{
+    constexpr int round = 1 << (MatrixShift - 1);
+    for (int x = 0; x < width; ++x) {
+        const QRgb p = argb[x];
+        y[x] = clampToByte(((m.ry * qRed(p) + m.gy * qGreen(p) + m.by * qBlue(p) + round)
+                            >> MatrixShift) + m.yOffset);
+    }
+}
+
+// The chroma of pairs of pixels of one or two lines
+void rgbToChroma(const RGBToYUVMatrix &m, const quint32 *line0, const quint32 *line1, uchar *u,
+                 uchar *v, int width)
+{
+    const int shift = MatrixShift + (line1 ? 2 : 1);
+    const int round = 1 << (shift - 1);
+    const int chromaWidth = (width + 1) / 2;
+
+    for (int i = 0; i < chromaWidth; ++i) {
+        const int x0 = 2 * i;
+        const int x1 = std::min(x0 + 1, width - 1);
+
+        int r = qRed(line0[x0]) + qRed(line0[x1]);
+        int g = qGreen(line0[x0]) + qGreen(line0[x1]);
+        int b = qBlue(line0[x0]) + qBlue(line0[x1]);
+        if (line1) {
+            r += qRed(line1[x0]) + qRed(line1[x1]);
+            g += qGreen(line1[x0]) + qGreen(line1[x1]);
+            b += qBlue(line1[x0]) + qBlue(line1[x1]);
+        }
+
+        u[i] = clampToByte(((m.ru * r + m.gu * g + m.bu * b + round) >> shift) + 128);
+        v[i] = clampToByte(((m.rv * r + m.gv * g + m.bv * b + round) >> shift) + 128);
+    }
+}
+
+// Stores the ARGB32 lines [startLine, endLine), packed width * 4 bytes apart,
+// in a YUV frame
+void storeYUVLines(const RGBToYUVMatrix &matrix, const quint32 *argb, const Planes &dst,
+                   const YUVLayout &layout, int width, int startLine, int endLine)
+{
+    std::unique_ptr<uchar[]> scratch(new uchar[width + 2 * ((width + 1) / 2)]);
+    uchar *y = scratch.get();
+    uchar *u = y + width;
+    uchar *v = u + (width + 1) / 2;
+
+    for (int line = startLine; line < endLine; ++line) {
+        if (uchar *dstY = dst.line(layout.yPlane, line, layout.yOffset)) {
+            const quint32 *src = argb + qsizetype(line - startLine) * width;
+            if (layout.yStep == 1) {
+                rgbToLuma(matrix, src, dstY, width);
+            } else {
+                rgbToLuma(matrix, src, y, width);
+                copySamples(y, 1, dstY, layout.yStep, width);
+            }
+        }
+    }
+
+    if (layout.uPlane < 0)
+        return;
+
+    for (int line = startLine; line < endLine; line += 1 << layout.chromaRowShift) {
+        const quint32 *line0 = argb + qsizetype(line - startLine) * width;
+        const quint32 *line1 = layout.chromaRowShift && line + 1 < endLine ? line0 + width : nullptr;
+        rgbToChroma(matrix, line0, line1, u, v, width);
+        storeChroma(dst, layout, line, u, v, (width + 1) / 2);
+    }
+}
+
+// Converts the frame in segments of lines on the thread pool, like qImageFromVideoFrame().
+// Segments start at even lines, so that subsampled chroma lines aren't split.
+template<typename Function>
+void convertSegments(int width, int height, Function convertLines)
+{
+#if QT_CONFIG(thread)
+    int segments = int((qsizetype(width) * height) >> 16);
+    segments = std::min(segments, height / 2);
+
+    QThreadPool *threadPool = QThreadPool::globalInstance();
+    if (segments > 1 && threadPool && !threadPool->contains(QThread::currentThread())) {
+        QSemaphore semaphore;
+        int y = 0;
+        for (int i = 0; i < segments; ++i) {
+            const int yn = i == segments - 1 ? height - y : (height - y) / (segments - i) / 2 * 2;
+            threadPool->start([&, y, yn]() {
+                convertLines(y, y + yn);
+                semaphore.release(1);
+            });
+            y += yn;
+        }
+        semaphore.acquire(segments);
+        return;
+    }
+#endif
+
+    convertLines(0, height);
+}
+
+} // namespace
+
+/*!
+    \class QVideoFrameFormatConverter
+    \internal
+
+    Converts video frames to other pixel formats and sizes on the CPU.
+
+    Conversions between 8 bit YUV formats of the same size copy the samples,
+    subsampling or duplicating the chroma as needed. All other conversions go
+    through ARGB32, using the converters of QVideoFrame::toImage(), and are scaled
+    there. The results are frames from a QVideoFramePool, which keeps the memory
+    of the frames that are gone for the next conversions.
+*/
+
+QVideoFrameFormatConverter::QVideoFrameFormatConverter() = default;
+
+QVideoFrameFormatConverter::~QVideoFrameFormatConverter() = default;
+
+/*!
+    Returns whether frames of the pixel format \a from can be converted to \a to.
+*/
+bool QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::PixelFormat from,
+                                            QVideoFrameFormat::PixelFormat to)
+{
+    if (from == QVideoFrameFormat::Format_Invalid)
+        return false;
+
+    const bool canRead = yuvLayout(from) || qConverterForFormat(from)
+            || from == QVideoFrameFormat::Format_Jpeg;
+    const bool canWrite = yuvLayout(to) || rgbLayout(to);
+    return canRead && canWrite;
+}
+
+/*!
+    Converts \a frame to a frame of the given \a pixelFormat and \a size. An empty
+    size keeps the size of the frame.
+
+    The rotation, mirroring and timing of the frame are kept. A frame that already
+    has the pixel format and the size is returned as is.
+*/
+QVideoFrame QVideoFrameFormatConverter::convert(const QVideoFrame &frame,
+                                                QVideoFrameFormat::PixelFormat pixelFormat,
+                                                const QSize &size)
+{
+    if (!frame.isValid() || !canConvert(frame.pixelFormat(), pixelFormat)) {
+        qCDebug(qLcVideoFrameFormatConverter) << "cannot convert" << frame.pixelFormat() << "to"
+                                              << pixelFormat;
+        return {};
+    }
+
+    const QSize targetSize = size.isEmpty() ? frame.size() : size;
+    if (frame.pixelFormat() == pixelFormat && frame.size() == targetSize)
+        return frame;
+
+    const QVideoFrameFormat sourceFormat = frame.surfaceFormat();
+    QVideoFrameFormat format(targetSize, pixelFormat);
+    format.setScanLineDirection(sourceFormat.scanLineDirection());
+    format.setFrameRate(sourceFormat.frameRate());
+    format.setMirrored(sourceFormat.isMirrored());
+    format.setColorSpace(sourceFormat.colorSpace());
+    format.setColorTransfer(sourceFormat.colorTransfer());
+    format.setColorRange(sourceFormat.colorRange());
+
+    const auto dstYUV = yuvLayout(pixelFormat);
+    const auto dstRGB = rgbLayout(pixelFormat);
+    if (dstYUV && format.colorSpace() == QVideoFrameFormat::ColorSpace_Undefined) {
+        // keep the standard the source is decoded with
+        format.setColorSpace(sourceFormat.frameHeight() > 576 ? QVideoFrameFormat::ColorSpace_BT709
+                                                              : QVideoFrameFormat::ColorSpace_BT601);
+    }
+
+    if (!m_pool || m_pool->format() != format)
+        m_pool = std::make_unique<QVideoFramePool>(format);
+
+    QVideoFrame result = m_pool->createFrame();
+    if (!result.map(QVideoFrame::WriteOnly))
+        return {};
+
+    const Planes dst(result);
+    const int width = targetSize.width();
+    const RGBToYUVMatrix matrix = dstYUV ? rgbToYUVMatrix(format) : RGBToYUVMatrix{};
+
+    // stores the ARGB32 lines of the target size
+    const auto storeLines = [&](const quint32 *argb, int startLine, int endLine) {
+        if (dstYUV) {
+            storeYUVLines(matrix, argb, dst, *dstYUV, width, startLine, endLine);
+            return;
+        }
+        for (int line = startLine; line < endLine; ++line) {
+            if (uchar *dstLine = dst.line(0, line, 0))
+                storeRGBLine(argb + qsizetype(line - startLine) * width, dstLine, *dstRGB, width);
+        }
+    };
+
+    QVideoFrame source = frame;
+    bool mapped = source.map(QVideoFrame::ReadOnly);
+    const auto srcYUV = yuvLayout(frame.pixelFormat());
+    VideoFrameConvertFunc convertToARGB = qConverterForFormat(frame.pixelFormat());
+
+    if (mapped && srcYUV && dstYUV && frame.size() == targetSize) {
+        const Planes src(source);
+        convertSegments(width, targetSize.height(), [&](int startLine, int endLine) {
+            convertYUVLines(src, *srcYUV, dst, *dstYUV, width, startLine, endLine);
+        });
+    } else if (mapped && convertToARGB && frame.size() == targetSize) {
+        convertSegments(width, targetSize.height(), [&](int startLine, int endLine) {
+            std::unique_ptr<quint32[]> argb(new quint32[qsizetype(width) * (endLine - startLine)]);
+            convertToARGB(source, reinterpret_cast<uchar *>(argb.get()), startLine, endLine);
+            storeLines(argb.get(), startLine, endLine);
+        });
+    } else {
+        // scaled, or not mappable; the conversion to an image handles both
+        if (mapped) {
+            source.unmap();
+            mapped = false;
+        }
+        const QImage image = qImageFromVideoFrame(frame, QVideoFrame::Rotation0, false, false,
+                                                  targetSize, QImage::Format_ARGB32_Premultiplied);
+        if (image.size() != targetSize) {
+            result.unmap();
+            return {};
+        }
+
+        Q_ASSERT(image.bytesPerLine() == width * 4);
+        const auto *argb = reinterpret_cast<const quint32 *>(image.constBits());
+        convertSegments(width, targetSize.height(), [&](int startLine, int endLine) {
+            storeLines(argb + qsizetype(startLine) * width, startLine, endLine);
+        });
+    }
+
+    if (mapped)
+        source.unmap();
+    result.unmap();
+
+    result.setStartTime(frame.startTime());
+    result.setEndTime(frame.endTime());
+    result.setRotationAngle(frame.rotationAngle());
+    result.setMirrored(frame.mirrored());
+    result.setSubtitleText(frame.subtitleText());
+    return result;
+}
+
+QT_END_NAMESPACE
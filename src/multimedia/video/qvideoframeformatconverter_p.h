@@ -0,0 +1,51 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QVIDEOFRAMEFORMATCONVERTER_P_H
+#define QVIDEOFRAMEFORMATCONVERTER_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qvideoframe.h>
+#include <qvideoframeformat.h>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QVideoFramePool;
+
+// Converts video frames to other pixel formats and sizes on the CPU. The frames
+// are converted in segments on the global thread pool, into recycled memory.
+// A converter is meant to be reused for a stream of frames; it isn't thread-safe.
+class Q_MULTIMEDIA_EXPORT QVideoFrameFormatConverter
+{
+public:
+    QVideoFrameFormatConverter();
+    ~QVideoFrameFormatConverter();
+
+    static bool canConvert(QVideoFrameFormat::PixelFormat from, QVideoFrameFormat::PixelFormat to);
+
+    // An empty size keeps the size of the frame. Returns an invalid frame if the
+    // conversion is not supported or fails.
+    QVideoFrame convert(const QVideoFrame &frame, QVideoFrameFormat::PixelFormat pixelFormat,
+                        const QSize &size = {});
+
+private:
+    Q_DISABLE_COPY(QVideoFrameFormatConverter)
+
+    std::unique_ptr<QVideoFramePool> m_pool;
+};
+
+QT_END_NAMESPACE
+
+#endif
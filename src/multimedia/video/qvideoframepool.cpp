@@ -0,0 +1,182 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qvideoframepool_p.h"
+#include "qabstractvideobuffer_p.h"
+#include "qvideotexturehelper_p.h"
+
+#include <qmutex.h>
+
+#include <vector>
+
+QT_BEGIN_NAMESPACE
+
+namespace {
+
+struct AlignedDeleter
+{
+    void operator()(uchar *data) const { qFreeAligned(data); }
+};
+
+using AlignedBuffer = std::unique_ptr<uchar, AlignedDeleter>;
+
+}
+
+class QVideoFramePoolPrivate
+{
+public:
+    AlignedBuffer takeBuffer()
+    {
+        {
+            QMutexLocker locker(&mutex);
+            if (!freeBuffers.empty()) {
+                AlignedBuffer buffer = std::move(freeBuffers.back());
+                freeBuffers.pop_back();
+                return buffer;
+            }
+        }
+
+        return AlignedBuffer(static_cast<uchar *>(qMallocAligned(size, QVideoFramePool::Alignment)));
+    }
+
+    void returnBuffer(AlignedBuffer buffer)
+    {
+        QMutexLocker locker(&mutex);
+        if (int(freeBuffers.size()) < maxFreeBuffers)
+            freeBuffers.push_back(std::move(buffer));
+    }
+
+    QVideoFrameFormat format;
+    int bytesPerLine = 0;
+    qsizetype size = 0;
+
+    mutable QMutex mutex;
+    int maxFreeBuffers = 0;
+    std::vector<AlignedBuffer> freeBuffers;
+};
+
+namespace {
+
+// Returns its memory to the pool when the last QVideoFrame referencing it is gone
+class QPooledVideoBuffer : public QAbstractVideoBuffer
+{
+public:
+    QPooledVideoBuffer(std::shared_ptr<QVideoFramePoolPrivate> pool, AlignedBuffer buffer)
+        : QAbstractVideoBuffer(QVideoFrame::NoHandle),
+          m_pool(std::move(pool)),
+          m_buffer(std::move(buffer))
+    {
+    }
+
+    ~QPooledVideoBuffer() override { m_pool->returnBuffer(std::move(m_buffer)); }
+
+    QVideoFrame::MapMode mapMode() const override { return m_mapMode; }
+
+    MapData map(QVideoFrame::MapMode mode) override
+    {
+        MapData mapData;
+        if (m_mapMode == QVideoFrame::NotMapped && mode != QVideoFrame::NotMapped) {
+            m_mapMode = mode;
+
+            mapData.nPlanes = 1;
+            mapData.bytesPerLine[0] = m_pool->bytesPerLine;
+            mapData.data[0] = m_buffer.get();
+            mapData.size[0] = m_pool->size;
+        }
+
+        return mapData;
+    }
+
+    void unmap() override { m_mapMode = QVideoFrame::NotMapped; }
+
+private:
+    std::shared_ptr<QVideoFramePoolPrivate> m_pool;
+    AlignedBuffer m_buffer;
+    QVideoFrame::MapMode m_mapMode = QVideoFrame::NotMapped;
+};
+
+}
+
+/*!
+    \class QVideoFramePool
+    \brief The QVideoFramePool class provides video frames in recycled system memory.
+    \internal
+
+    All frames have the same format, and their memory is 64 byte aligned, as are
+    the lines of the first plane. When the last QVideoFrame referencing a buffer is
+    destroyed, the buffer returns to the pool, which keeps up to a maximum number of
+    free buffers for the next frames. This avoids allocating and releasing large
+    blocks of memory at the frame rate.
+
+    Frames may outlive the pool. QVideoFramePool is thread-safe.
+*/
+
+/*!
+    Constructs a pool of frames with the given \a format, which keeps up to
+    \a maxFreeBuffers unused buffers.
+*/
+QVideoFramePool::QVideoFramePool(const QVideoFrameFormat &format, int maxFreeBuffers)
+    : d(std::make_shared<QVideoFramePoolPrivate>())
+{
+    d->format = format;
+    d->maxFreeBuffers = maxFreeBuffers;
+
+    auto *textureDescription = QVideoTextureHelper::textureDescription(format.pixelFormat());
+    const int stride = textureDescription->strideForWidth(format.frameWidth());
+    d->bytesPerLine = (stride + Alignment - 1) & ~(Alignment - 1);
+    d->size = textureDescription->bytesRequired(d->bytesPerLine, format.frameHeight());
+}
+
+/*!
+    Destroys the pool and its free buffers. The buffers of frames that are still
+    alive are released with them.
+*/
+QVideoFramePool::~QVideoFramePool()
+{
+    QMutexLocker locker(&d->mutex);
+    d->maxFreeBuffers = 0;
+    d->freeBuffers.clear();
+}
+
+/*!
+    Returns the format of the frames.
+*/
+QVideoFrameFormat QVideoFramePool::format() const
+{
+    return d->format;
+}
+
+/*!
+    Returns the stride of the first plane of the frames.
+*/
+int QVideoFramePool::bytesPerLine() const
+{
+    return d->bytesPerLine;
+}
+
+/*!
+    Returns a frame in recycled memory, or an invalid frame if the format is invalid
+    or the memory cannot be allocated. The content of the frame is undefined.
+*/
+QVideoFrame QVideoFramePool::createFrame()
+{
+    if (d->size <= 0)
+        return {};
+
+    AlignedBuffer buffer = d->takeBuffer();
+    if (!buffer)
+        return {};
+
+    return QVideoFrame(new QPooledVideoBuffer(d, std::move(buffer)), d->format);
+}
+
+/*!
+    Returns the number of free buffers, kept for the next frames.
+*/
+int QVideoFramePool::freeBufferCount() const
+{
+    QMutexLocker locker(&d->mutex);
+    return int(d->freeBuffers.size());
+}
+
+QT_END_NAMESPACE
@@ -0,0 +1,53 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#ifndef QVIDEOFRAMEPOOL_P_H
+#define QVIDEOFRAMEPOOL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include <qvideoframe.h>
+#include <qvideoframeformat.h>
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+class QVideoFramePoolPrivate;
+
+class Q_MULTIMEDIA_EXPORT QVideoFramePool
+{
+public:
+    static constexpr int DefaultMaxFreeBuffers = 4;
+    // alignment of the buffers and of the lines of the first plane
+    static constexpr int Alignment = 64;
+
+    explicit QVideoFramePool(const QVideoFrameFormat &format,
+                             int maxFreeBuffers = DefaultMaxFreeBuffers);
+    ~QVideoFramePool();
+
+    QVideoFrameFormat format() const;
+    int bytesPerLine() const;
+
+    QVideoFrame createFrame();
+
+    int freeBufferCount() const;
+
+private:
+    Q_DISABLE_COPY(QVideoFramePool)
+
+    std::shared_ptr<QVideoFramePoolPrivate> d;
+};
+
+QT_END_NAMESPACE
+
+#endif
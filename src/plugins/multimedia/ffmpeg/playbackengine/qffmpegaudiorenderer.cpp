@@ -73,6 +73,12 @@ Renderer::RenderingResult AudioRenderer::renderInternal(Frame frame)
     if (m_bufferedData.isValid()) {
         auto bytesWritten = m_ioDevice->write(m_bufferedData.constData<char>() + m_bufferWritten,
                                               m_bufferedData.byteCount() - m_bufferWritten);
+        // the meter is only created once level metering is first enabled
+        if (!m_levelMeter && m_output)
+            m_levelMeter = QPlatformAudioOutput::get(*m_output)->levelMeter();
+        if (m_levelMeter && bytesWritten > 0)
+            m_levelMeter->process(m_bufferedData.format(),
+                                  m_bufferedData.constData<char>() + m_bufferWritten, bytesWritten);
         m_bufferWritten += bytesWritten;
 
         if (m_bufferWritten >= m_bufferedData.byteCount()) {
@@ -125,6 +131,8 @@ void AudioRenderer::freeOutput()
     }
 
     m_ioDevice = nullptr;
+    if (m_levelMeter)
+        m_levelMeter->reset();
 
     m_bufferedData = {};
     m_bufferWritten = 0;
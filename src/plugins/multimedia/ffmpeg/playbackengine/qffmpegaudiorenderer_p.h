@@ -22,6 +22,7 @@ QT_BEGIN_NAMESPACE
 
 class QAudioOutput;
 class QAudioSink;
+class QAudioLevelMeter;
 
 namespace QFFmpeg {
 class Resampler;
@@ -63,6 +64,7 @@ private:
     QAudioBuffer m_bufferedData;
     qsizetype m_bufferWritten = 0;
     QIODevice *m_ioDevice = nullptr;
+    std::shared_ptr<QAudioLevelMeter> m_levelMeter;
 
     bool m_deviceChanged = false;
 };
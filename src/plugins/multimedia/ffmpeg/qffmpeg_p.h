@@ -20,6 +20,8 @@ extern "C" {
   (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(58, 91, 100)) // since ffmpeg n4.3
 #define QT_FFMPEG_HAS_FRAME_TIME_BASE \
   (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(59, 18, 100)) // since ffmpeg n5.0
+#define QT_FFMPEG_HAS_AV_PROFILE \
+  (LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(60, 26, 100)) // since ffmpeg n6.1
 
 QT_BEGIN_NAMESPACE
 
@@ -32,11 +32,6 @@ public:
         m_device = device;
         QMetaObject::invokeMethod(this, "updateSource");
     }
-    void setFrameSize(int frameSize)
-    {
-        QMutexLocker locker(&m_mutex);
-        m_bufferSize = m_format.bytesForFrames(frameSize);
-    }
     void setRunning(bool r) {
         QMutexLocker locker(&m_mutex);
         if (m_running == r)
@@ -56,7 +51,7 @@ public:
         QMetaObject::invokeMethod(this, "updateVolume");
     }
 
-    int bufferSize() const { return m_bufferSize; }
+    int bufferSize() const { return DefaultAudioInputBufferSize; }
 
 protected:
     qint64 readData(char *, qint64) override
@@ -65,13 +60,16 @@ protected:
     }
     qint64 writeData(const char *data, qint64 len) override
     {
+        if (auto meter = m_input->levelMeter())
+            meter->process(m_format, data, len);
+
         int l = len;
         while (len > 0) {
-            int toAppend = qMin(len, m_bufferSize - m_pcm.size());
+            int toAppend = qMin(len, DefaultAudioInputBufferSize - m_pcm.size());
             m_pcm.append(data, toAppend);
             data += toAppend;
             len -= toAppend;
-            if (m_pcm.size() == m_bufferSize)
+            if (m_pcm.size() == DefaultAudioInputBufferSize)
                 sendBuffer();
         }
 
@@ -104,6 +102,8 @@ private Q_SLOTS:
             m_src->start(this);
         } else {
             m_src->stop();
+            if (auto meter = m_input->levelMeter())
+                meter->reset();
         }
     }
 
@@ -115,7 +115,7 @@ private:
         qint64 time = fmt.durationForBytes(m_processed);
         QAudioBuffer buffer(m_pcm, fmt, time);
         emit m_input->newAudioBuffer(buffer);
-        m_processed += m_bufferSize;
+        m_processed += DefaultAudioInputBufferSize;
         m_pcm.clear();
     }
 
@@ -128,7 +128,6 @@ private:
     QFFmpegAudioInput *m_input = nullptr;
     std::unique_ptr<QAudioSource> m_src;
     QAudioFormat m_format;
-    std::atomic<int> m_bufferSize = DefaultAudioInputBufferSize;
     qint64 m_processed = 0;
     QByteArray m_pcm;
 };
@@ -167,11 +166,6 @@ void QFFmpegAudioInput::setVolume(float volume)
     audioIO->setVolume(volume);
 }
 
-void QFFmpegAudioInput::setFrameSize(int s)
-{
-    audioIO->setFrameSize(s);
-}
-
 void QFFmpegAudioInput::setRunning(bool b)
 {
     audioIO->setRunning(b);
@@ -39,7 +39,6 @@ public:
     void setMuted(bool /*muted*/) override;
     void setVolume(float /*volume*/) override;
 
-    void setFrameSize(int frameSize);
     void setRunning(bool b);
 
     int bufferSize() const;
@@ -15,6 +15,7 @@
 #include "qffmpegvideobuffer_p.h"
 #include "qffmpegmediametadata_p.h"
 #include "qffmpegencoderoptions_p.h"
+#include "qffmpegoutputfile_p.h"
 
 #include <qloggingcategory.h>
 
@@ -42,8 +43,18 @@ Encoder::Encoder(const QMediaEncoderSettings &settings, const QUrl &url)
     formatContext->url = (char *)av_malloc(encoded.size() + 1);
     memcpy(formatContext->url, encoded.constData(), encoded.size() + 1);
     formatContext->pb = nullptr;
-    auto result = avio_open2(&formatContext->pb, formatContext->url, AVIO_FLAG_WRITE, nullptr, nullptr);
-    qCDebug(qLcFFmpegEncoder) << "opened" << result << formatContext->url;
+
+    if (url.isLocalFile()) {
+        outputFile = OutputFile::open(url.toLocalFile());
+        if (outputFile) {
+            formatContext->pb = outputFile->avioContext();
+            formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+        qCDebug(qLcFFmpegEncoder) << "opened" << !!outputFile << formatContext->url;
+    } else {
+        auto result = avio_open2(&formatContext->pb, formatContext->url, AVIO_FLAG_WRITE, nullptr, nullptr);
+        qCDebug(qLcFFmpegEncoder) << "opened" << result << formatContext->url;
+    }
 
     muxer = new Muxer(this);
 }
@@ -129,6 +140,15 @@ void EncodingFinalizer::run()
     if (res < 0)
         qWarning() << "could not write trailer" << res;
 
+    if (encoder->outputFile) {
+        if (!encoder->outputFile->close())
+            qWarning() << "could not write all data to the output file";
+        encoder->outputFile.reset();
+        encoder->formatContext->pb = nullptr;
+    } else {
+        avio_closep(&encoder->formatContext->pb);
+    }
+
     avformat_free_context(encoder->formatContext);
     qCDebug(qLcFFmpegEncoder) << "    done finalizing.";
     emit encoder->finalizationDone();
@@ -154,6 +174,12 @@ void Encoder::setPaused(bool p)
        videoEncoder->setPaused(p);
 }
 
+void Encoder::updateVideoSettings(const QMediaEncoderSettings &settings)
+{
+    for (auto &videoEncoder : videoEncoders)
+        videoEncoder->updateSettings(settings);
+}
+
 void Encoder::setMetaData(const QMediaMetaData &metaData)
 {
     this->metaData = metaData;
@@ -188,15 +214,6 @@ void Muxer::addPacket(AVPacket *packet)
     wake();
 }
 
-AVPacket *Muxer::takePacket()
-{
-    QMutexLocker locker(&queueMutex);
-    if (packetQueue.isEmpty())
-        return nullptr;
-//    qCDebug(qLcFFmpegEncoder) << "Muxer::takePacket" << packetQueue.first()->pts;
-    return packetQueue.dequeue();
-}
-
 void Muxer::init()
 {
     qCDebug(qLcFFmpegEncoder) << "Muxer::init started thread.";
@@ -204,6 +221,8 @@ void Muxer::init()
 
 void Muxer::cleanup()
 {
+    while (!shouldWait())
+        loop();
 }
 
 bool QFFmpeg::Muxer::shouldWait() const
@@ -214,10 +233,43 @@ bool QFFmpeg::Muxer::shouldWait() const
 
 void Muxer::loop()
 {
-    auto *packet = takePacket();
+    // take all pending packets at once to keep the lock contention with the encoders low
+    QQueue<AVPacket *> packets;
+    {
+        QMutexLocker locker(&queueMutex);
+        packets.swap(packetQueue);
+    }
+
+    for (AVPacket *packet : std::as_const(packets))
+        writePacket(packet);
+}
+
+void Muxer::writePacket(AVPacket *packet)
+{
+    AVPacketUPtr holder(packet);
     //   qCDebug(qLcFFmpegEncoder) << "writing packet to file" << packet->pts << packet->duration <<
     //   packet->stream_index;
-    av_interleaved_write_frame(encoder->formatContext, packet);
+    // the muxer takes the data of the packet, even if it fails
+    const int streamIndex = packet->stream_index;
+    const qint64 dts = packet->dts;
+    const int res = av_interleaved_write_frame(encoder->formatContext, packet);
+    if (res >= 0)
+        return;
+
+    qCWarning(qLcFFmpegEncoder) << "Cannot write a packet of stream" << streamIndex << "dts"
+                                << dts << err2str(res);
+
+    // the recording is broken either way; report it once
+    if (writeFailed)
+        return;
+    writeFailed = true;
+    auto *pb = encoder->formatContext->pb;
+    if (pb && pb->error < 0)
+        emit encoder->error(QMediaRecorder::ResourceError,
+                            QLatin1String("Cannot write to the output file: ") + err2str(res));
+    else
+        emit encoder->error(QMediaRecorder::FormatError,
+                            QLatin1String("Cannot write the encoded data: ") + err2str(res));
 }
 
 
@@ -298,8 +350,6 @@ AudioEncoder::AudioEncoder(Encoder *encoder, QFFmpegAudioInput *input, const QMe
 
 void AudioEncoder::open()
 {
-    AVSampleFormat requested = QFFmpegMediaFormatInfo::avSampleFormat(format.sampleFormat());
-
     codec = avcodec_alloc_context3(avCodec);
 
     if (stream->time_base.num != 1 || stream->time_base.den != format.sampleRate()) {
@@ -319,28 +369,165 @@ void AudioEncoder::open()
     qCDebug(qLcFFmpegEncoder) << "audio codec opened" << res;
     qCDebug(qLcFFmpegEncoder) << "audio codec params: fmt=" << codec->sample_fmt << "rate=" << codec->sample_rate;
 
-    if (codec->sample_fmt != requested) {
 #if QT_FFMPEG_OLD_CHANNEL_LAYOUT
-        resampler = swr_alloc_set_opts(nullptr,  // we're allocating a new context
-                                       codec->channel_layout,  // out_ch_layout
-                                       codec->sample_fmt,    // out_sample_fmt
-                                       codec->sample_rate,                // out_sample_rate
-                                       av_get_default_channel_layout(format.channelCount()), // in_ch_layout
-                                       requested,   // in_sample_fmt
-                                       format.sampleRate(),                // in_sample_rate
-                                       0,                    // log_offset
-                                       nullptr);
+    channelCount = codec->channels;
+#else
+    channelCount = codec->ch_layout.nb_channels;
+#endif
+    // codecs with variable frame sizes don't set one; use a reasonable chunk size for them
+    frameSize = codec->frame_size > 0 ? codec->frame_size : 1024;
+    fifo.reset(av_audio_fifo_alloc(codec->sample_fmt, channelCount, 2 * frameSize));
+    packet.reset(av_packet_alloc());
+
+    updateResampler(format);
+}
+
+void AudioEncoder::updateResampler(const QAudioFormat &inputFormat)
+{
+    if (inputFormat == resamplerFormat)
+        return;
+
+    // keep the samples buffered in the old resampler
+    if (resampler)
+        convertToFifo(nullptr, 0);
+
+    resamplerFormat = inputFormat;
+    resampler.reset();
+    inputAccepted = false;
+
+    const AVSampleFormat inputSampleFormat =
+            QFFmpegMediaFormatInfo::avSampleFormat(inputFormat.sampleFormat());
+    if (inputSampleFormat == codec->sample_fmt && inputFormat.sampleRate() == codec->sample_rate
+        && inputFormat.channelCount() == channelCount) {
+        inputAccepted = true;
+        return;
+    }
+
+    qCDebug(qLcFFmpegEncoder) << "audio input needs conversion from" << inputFormat;
+
+    SwrContext *context = nullptr;
+#if QT_FFMPEG_OLD_CHANNEL_LAYOUT
+    context = swr_alloc_set_opts(nullptr,  // we're allocating a new context
+                                 codec->channel_layout,  // out_ch_layout
+                                 codec->sample_fmt,    // out_sample_fmt
+                                 codec->sample_rate,                // out_sample_rate
+                                 av_get_default_channel_layout(inputFormat.channelCount()), // in_ch_layout
+                                 inputSampleFormat,   // in_sample_fmt
+                                 inputFormat.sampleRate(),                // in_sample_rate
+                                 0,                    // log_offset
+                                 nullptr);
+#else
+    AVChannelLayout in_ch_layout = {};
+    av_channel_layout_default(&in_ch_layout, inputFormat.channelCount());
+    swr_alloc_set_opts2(&context,  // we're allocating a new context
+                        &codec->ch_layout, codec->sample_fmt, codec->sample_rate,
+                        &in_ch_layout, inputSampleFormat, inputFormat.sampleRate(),
+                        0, nullptr);
+#endif
+    resampler.reset(context);
+
+    if (!resampler || swr_init(resampler.get()) < 0) {
+        qWarning() << "Cannot convert audio from" << inputFormat << "for encoding";
+        resampler.reset();
+        return;
+    }
+
+    inputAccepted = true;
+}
+
+void AudioEncoder::writeToFifo(const QAudioBuffer &buffer)
+{
+    updateResampler(buffer.format());
+    if (!inputAccepted)
+        return;
+
+    convertToFifo(buffer.constData<uint8_t>(), buffer.frameCount());
+}
+
+// Appends the samples to the fifo, converting them if needed. A null data
+// pointer drains the samples delayed in the resampler.
+void AudioEncoder::convertToFifo(const uint8_t *data, int sampleCount)
+{
+    if (!resampler) {
+        // the input already has the codec format, which is interleaved
+        if (data && sampleCount > 0)
+            av_audio_fifo_write(fifo.get(), reinterpret_cast<void **>(const_cast<uint8_t **>(&data)),
+                                sampleCount);
+        return;
+    }
+
+    const int maxSamples = swr_get_out_samples(resampler.get(), sampleCount);
+    if (maxSamples <= 0)
+        return;
+
+    if (maxSamples > convertedSamplesCapacity) {
+        if (convertedSamples)
+            av_freep(&convertedSamples[0]);
+        av_freep(&convertedSamples);
+        convertedSamplesCapacity = 0;
+
+        if (av_samples_alloc_array_and_samples(&convertedSamples, nullptr, channelCount,
+                                               maxSamples, codec->sample_fmt, 0) < 0)
+            return;
+        convertedSamplesCapacity = maxSamples;
+    }
+
+    const int converted = swr_convert(resampler.get(), convertedSamples, convertedSamplesCapacity,
+                                      data ? &data : nullptr, data ? sampleCount : 0);
+    if (converted > 0)
+        av_audio_fifo_write(fifo.get(), reinterpret_cast<void **>(convertedSamples), converted);
+}
+
+AVFrameUPtr AudioEncoder::makeFrame()
+{
+    auto frame = framePool.get(codec->sample_fmt, channelCount, frameSize);
+    if (!frame)
+        return {};
+
+#if QT_FFMPEG_OLD_CHANNEL_LAYOUT
+    frame->channel_layout = codec->channel_layout;
+    frame->channels = codec->channels;
 #else
-        AVChannelLayout in_ch_layout = {};
-        av_channel_layout_default(&in_ch_layout, format.channelCount());
-        swr_alloc_set_opts2(&resampler,  // we're allocating a new context
-                            &codec->ch_layout, codec->sample_fmt, codec->sample_rate,
-                            &in_ch_layout, requested, format.sampleRate(),
-                            0, nullptr);
+    av_channel_layout_copy(&frame->ch_layout, &codec->ch_layout);
 #endif
+    frame->sample_rate = codec->sample_rate;
+    return frame;
+}
+
+// Sends all complete frames from the fifo to the codec. On flush, the remaining
+// samples are sent as a shorter last frame, which the codec pads if needed.
+void AudioEncoder::sendFrames(bool flush)
+{
+    while (av_audio_fifo_size(fifo.get()) >= frameSize
+           || (flush && av_audio_fifo_size(fifo.get()) > 0)) {
+        auto frame = makeFrame();
+        if (!frame)
+            return;
+
+        frame->nb_samples = av_audio_fifo_read(fifo.get(),
+                                               reinterpret_cast<void **>(frame->extended_data),
+                                               frameSize);
 
-        swr_init(resampler);
+        // the time stamps are derived from the number of samples sent, so they
+        // don't drift, whatever the size of the input buffers is
+        const auto &timeBase = stream->time_base;
+        const auto pts = av_rescale_q(samplesWritten, AVRational{ 1, codec->sample_rate },
+                                      timeBase);
+        setAVFrameTime(*frame, pts, timeBase);
+        samplesWritten += frame->nb_samples;
+
+        int ret = avcodec_send_frame(codec, frame.get());
+        if (ret == AVERROR(EAGAIN)) {
+            retrievePackets();
+            ret = avcodec_send_frame(codec, frame.get());
+        }
+        if (ret < 0)
+            qCDebug(qLcFFmpegEncoder) << "error sending audio frame" << err2str(ret);
+
+        retrievePackets();
     }
+
+    encoder->newTimeStamp(samplesWritten * 1000 / codec->sample_rate);
 }
 
 void AudioEncoder::addBuffer(const QAudioBuffer &buffer)
@@ -363,9 +550,6 @@ QAudioBuffer AudioEncoder::takeBuffer()
 void AudioEncoder::init()
 {
     open();
-    if (input) {
-        input->setFrameSize(codec->frame_size);
-    }
     qCDebug(qLcFFmpegEncoder) << "AudioEncoder::init started audio device thread.";
 }
 
@@ -373,9 +557,19 @@ void AudioEncoder::cleanup()
 {
     while (!audioBufferQueue.isEmpty())
         loop();
+
+    if (resampler)
+        convertToFifo(nullptr, 0);
+    sendFrames(true);
+
     while (avcodec_send_frame(codec, nullptr) == AVERROR(EAGAIN))
         retrievePackets();
     retrievePackets();
+
+    if (convertedSamples)
+        av_freep(&convertedSamples[0]);
+    av_freep(&convertedSamples);
+    convertedSamplesCapacity = 0;
 }
 
 bool AudioEncoder::shouldWait() const
@@ -387,23 +581,20 @@ bool AudioEncoder::shouldWait() const
 void AudioEncoder::retrievePackets()
 {
     while (1) {
-        AVPacket *packet = av_packet_alloc();
-        int ret = avcodec_receive_packet(codec, packet);
+        // the packet is only handed over to the muxer if the codec filled it
+        if (!packet)
+            packet.reset(av_packet_alloc());
+
+        int ret = avcodec_receive_packet(codec, packet.get());
         if (ret < 0) {
-            av_packet_unref(packet);
-            if (ret != AVERROR(EOF))
-                break;
-            if (ret != AVERROR(EAGAIN)) {
-                char errStr[1024];
-                av_strerror(ret, errStr, 1024);
-                qCDebug(qLcFFmpegEncoder) << "receive packet" << ret << errStr;
-            }
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF)
+                qCDebug(qLcFFmpegEncoder) << "receive packet" << ret << err2str(ret);
             break;
         }
 
         // qCDebug(qLcFFmpegEncoder) << "writing audio packet" << packet->size << packet->pts << packet->dts;
         packet->stream_index = stream->id;
-        encoder->muxer->addPacket(packet);
+        encoder->muxer->addPacket(packet.release());
     }
 }
 
@@ -414,47 +605,8 @@ void AudioEncoder::loop()
         return;
 
 //    qCDebug(qLcFFmpegEncoder) << "new audio buffer" << buffer.byteCount() << buffer.format() << buffer.frameCount() << codec->frame_size;
-    retrievePackets();
-
-    auto frame = makeAVFrame();
-    frame->format = codec->sample_fmt;
-#if QT_FFMPEG_OLD_CHANNEL_LAYOUT
-    frame->channel_layout = codec->channel_layout;
-    frame->channels = codec->channels;
-#else
-    frame->ch_layout = codec->ch_layout;
-#endif
-    frame->sample_rate = codec->sample_rate;
-    frame->nb_samples = buffer.frameCount();
-    if (frame->nb_samples)
-        av_frame_get_buffer(frame.get(), 0);
-
-    if (resampler) {
-        const uint8_t *data = buffer.constData<uint8_t>();
-        swr_convert(resampler, frame->extended_data, frame->nb_samples, &data, frame->nb_samples);
-    } else {
-        memcpy(frame->buf[0]->data, buffer.constData<uint8_t>(), buffer.byteCount());
-    }
-
-    const auto &timeBase = stream->time_base;
-    const auto pts = timeBase.den && timeBase.num
-            ? timeBase.den * samplesWritten / (codec->sample_rate * timeBase.num)
-            : samplesWritten;
-    setAVFrameTime(*frame, pts, timeBase);
-    samplesWritten += buffer.frameCount();
-
-    qint64 time = format.durationForFrames(samplesWritten);
-    encoder->newTimeStamp(time/1000);
-
-    //    qCDebug(qLcFFmpegEncoder) << "sending audio frame" << buffer.byteCount() << frame->pts <<
-    //    ((double)buffer.frameCount()/frame->sample_rate);
-
-    int ret = avcodec_send_frame(codec, frame.get());
-    if (ret < 0) {
-        char errStr[1024];
-        av_strerror(ret, errStr, 1024);
-//        qCDebug(qLcFFmpegEncoder) << "error sending frame" << ret << errStr;
-    }
+    writeToFifo(buffer);
+    sendFrames(false);
 }
 
 VideoEncoder::VideoEncoder(Encoder *encoder, const QMediaEncoderSettings &settings,
@@ -478,6 +630,7 @@ VideoEncoder::VideoEncoder(Encoder *encoder, const QMediaEncoderSettings &settin
     frameEncoder = new VideoFrameEncoder(settings, format.frameSize(), frameRate, ffmpegPixelFormat,
                                          swFormat);
     frameEncoder->initWithFormatContext(encoder->formatContext);
+    sourceFrameRate = frameRate;
 }
 
 VideoEncoder::~VideoEncoder()
@@ -499,6 +652,55 @@ bool VideoEncoder::isValid() const
     return !frameEncoder->isNull();
 }
 
+void VideoEncoder::updateSettings(const QMediaEncoderSettings &settings)
+{
+    QMutexLocker locker(&queueMutex);
+    pendingSettings = settings;
+}
+
+void VideoEncoder::applyPendingSettings()
+{
+    std::optional<QMediaEncoderSettings> settings;
+    {
+        QMutexLocker locker(&queueMutex);
+        settings = std::exchange(pendingSettings, std::nullopt);
+    }
+
+    if (!settings || frameEncoder->isNull())
+        return;
+
+    setFrameRateLimit(settings->videoFrameRate());
+
+    if (frameEncoder->updateSettings(*settings))
+        return;
+
+    qCDebug(qLcFFmpegEncoder) << "VideoEncoder: reopening the codec to apply new settings";
+
+    // the recording goes on with the current codec if the new one doesn't fit
+    if (!frameEncoder->prepareReopen(*settings)) {
+        qCWarning(qLcFFmpegEncoder) << "Cannot apply the new settings to the ongoing recording";
+        return;
+    }
+
+    // drain the codec, so that the reopened one starts with a new GOP
+    while (frameEncoder->sendFrame(nullptr) == AVERROR(EAGAIN))
+        retrievePackets();
+    retrievePackets();
+
+    frameEncoder->finishReopen();
+}
+
+void VideoEncoder::setFrameRateLimit(qreal frameRate)
+{
+    // only a lower rate than the source's needs frames to be dropped
+    const bool decimate = frameRate > 0 && frameRate < sourceFrameRate;
+    const qint64 interval = decimate ? qRound64(1'000'000. / frameRate) : 0;
+    if (interval != minFrameInterval) {
+        minFrameInterval = interval;
+        nextFrameTime.reset();
+    }
+}
+
 QVideoFrame VideoEncoder::takeFrame()
 {
     QMutexLocker locker(&queueMutex);
@@ -565,8 +767,30 @@ void VideoEncoder::loop()
     if (frameEncoder->isNull())
         return;
 
+    applyPendingSettings();
+
 //    qCDebug(qLcFFmpegEncoder) << "new video buffer" << frame.startTime();
 
+    if (baseTime.loadAcquire() == std::numeric_limits<qint64>::min()) {
+        baseTime.storeRelease(frame.startTime() - lastFrameTime);
+        qCDebug(qLcFFmpegEncoder) << ">>>> adjusting base time to" << baseTime.loadAcquire()
+                                  << frame.startTime() << lastFrameTime;
+    }
+
+    qint64 time = frame.startTime() - baseTime.loadAcquire();
+    lastFrameTime = frame.endTime() - baseTime.loadAcquire();
+
+    if (minFrameInterval > 0) {
+        // A frame is due every interval. Half an interval of tolerance keeps the jitter
+        // of the timestamps from dropping frames that are on time, and advancing the
+        // deadline by whole intervals keeps the average rate.
+        if (nextFrameTime && time < *nextFrameTime - minFrameInterval / 2)
+            return;
+        const qint64 next = nextFrameTime ? *nextFrameTime + minFrameInterval : time + minFrameInterval;
+        // after a gap, start over rather than letting frames through to catch up
+        nextFrameTime = next < time ? time + minFrameInterval : next;
+    }
+
     AVFrameUPtr avFrame;
 
     auto *videoBuffer = dynamic_cast<QFFmpegVideoBuffer *>(frame.videoBuffer());
@@ -603,15 +827,6 @@ void VideoEncoder::loop()
         avFrame->opaque_ref = av_buffer_create(nullptr, 0, freeQVideoFrame, new QVideoFrameHolder{frame, img}, 0);
     }
 
-    if (baseTime.loadAcquire() == std::numeric_limits<qint64>::min()) {
-        baseTime.storeRelease(frame.startTime() - lastFrameTime);
-        qCDebug(qLcFFmpegEncoder) << ">>>> adjusting base time to" << baseTime.loadAcquire()
-                                  << frame.startTime() << lastFrameTime;
-    }
-
-    qint64 time = frame.startTime() - baseTime.loadAcquire();
-    lastFrameTime = frame.endTime() - baseTime.loadAcquire();
-
     setAVFrameTime(*avFrame, frameEncoder->getPts(time), frameEncoder->getTimeBase());
 
     encoder->newTimeStamp(time/1000);
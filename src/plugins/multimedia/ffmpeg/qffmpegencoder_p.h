@@ -17,6 +17,7 @@
 #include "qffmpegthread_p.h"
 #include "qffmpeg_p.h"
 #include "qffmpeghwaccel_p.h"
+#include "qffmpegframepool_p.h"
 
 #include <private/qplatformmediarecorder_p.h>
 #include <qaudioformat.h>
@@ -38,6 +39,7 @@ class Muxer;
 class AudioEncoder;
 class VideoEncoder;
 class VideoFrameEncoder;
+class OutputFile;
 
 class EncodingFinalizer : public QThread
 {
@@ -65,6 +67,8 @@ public:
 
     void setPaused(bool p);
 
+    void updateVideoSettings(const QMediaEncoderSettings &settings);
+
     void setMetaData(const QMediaMetaData &metaData);
 
 public Q_SLOTS:
@@ -86,6 +90,7 @@ private:
     QMediaEncoderSettings settings;
     QMediaMetaData metaData;
     AVFormatContext *formatContext = nullptr;
+    std::unique_ptr<OutputFile> outputFile;
     Muxer *muxer = nullptr;
     bool isRecording = false;
 
@@ -108,7 +113,7 @@ public:
     void addPacket(AVPacket *);
 
 private:
-    AVPacket *takePacket();
+    void writePacket(AVPacket *packet);
 
     void init() override;
     void cleanup() override;
@@ -116,6 +121,7 @@ private:
     void loop() override;
 
     Encoder *encoder;
+    bool writeFailed = false;
 };
 
 class EncoderThread : public Thread
@@ -147,6 +153,12 @@ private:
     QAudioBuffer takeBuffer();
     void retrievePackets();
 
+    void updateResampler(const QAudioFormat &inputFormat);
+    void writeToFifo(const QAudioBuffer &buffer);
+    void convertToFifo(const uint8_t *data, int sampleCount);
+    void sendFrames(bool flush);
+    AVFrameUPtr makeFrame();
+
     void init() override;
     void cleanup() override;
     bool shouldWait() const override;
@@ -157,7 +169,23 @@ private:
     QFFmpegAudioInput *input;
     QAudioFormat format;
 
-    SwrContext *resampler = nullptr;
+    // Input buffers of any size are converted to the codec format and collected
+    // in the fifo, which is drained in chunks of exactly frameSize samples.
+    QAudioFormat resamplerFormat;
+    SwrContextUPtr resampler;
+    bool inputAccepted = false;
+    AVAudioFifoUPtr fifo;
+    int frameSize = 0;
+    int channelCount = 0;
+
+    // scratch space for converted samples, grown on demand
+    uint8_t **convertedSamples = nullptr;
+    int convertedSamplesCapacity = 0;
+
+    AVAudioFramePool framePool;
+    // reused until avcodec_receive_packet fills it
+    AVPacketUPtr packet;
+
     qint64 samplesWritten = 0;
     const AVCodec *avCodec = nullptr;
     QMediaEncoderSettings settings;
@@ -177,6 +205,9 @@ public:
 
     bool isValid() const;
 
+    // thread-safe; the settings are applied before encoding the next frame
+    void updateSettings(const QMediaEncoderSettings &settings);
+
     void setPaused(bool b) override
     {
         EncoderThread::setPaused(b);
@@ -187,6 +218,8 @@ public:
 private:
     QVideoFrame takeFrame();
     void retrievePackets();
+    void applyPendingSettings();
+    void setFrameRateLimit(qreal frameRate);
 
     void init() override;
     void cleanup() override;
@@ -194,9 +227,15 @@ private:
     void loop() override;
 
     VideoFrameEncoder *frameEncoder = nullptr;
+    std::optional<QMediaEncoderSettings> pendingSettings; // guarded by queueMutex
 
     QAtomicInteger<qint64> baseTime = std::numeric_limits<qint64>::min();
     qint64 lastFrameTime = 0;
+
+    // frame rate decimation, when the settings lower the rate below the source's
+    qreal sourceFrameRate = 0.;
+    qint64 minFrameInterval = 0;
+    std::optional<qint64> nextFrameTime;
 };
 
 }
@@ -8,6 +8,17 @@
 
 QT_BEGIN_NAMESPACE
 
+// FFmpeg 6.1 renamed the FF_PROFILE_* constants to AV_PROFILE_* and deprecated the old names
+#if QT_FFMPEG_HAS_AV_PROFILE
+[[maybe_unused]] static constexpr int ProfileH264Main = AV_PROFILE_H264_MAIN;
+[[maybe_unused]] static constexpr int ProfileH264High = AV_PROFILE_H264_HIGH;
+[[maybe_unused]] static constexpr int ProfileHevcMain = AV_PROFILE_HEVC_MAIN;
+#else
+[[maybe_unused]] static constexpr int ProfileH264Main = FF_PROFILE_H264_MAIN;
+[[maybe_unused]] static constexpr int ProfileH264High = FF_PROFILE_H264_HIGH;
+[[maybe_unused]] static constexpr int ProfileHevcMain = FF_PROFILE_HEVC_MAIN;
+#endif
+
 // unfortunately there is no common way to specify options for the encoders. The code here tries to map our settings sensibly
 // to options available in different encoders
 
@@ -180,6 +191,18 @@ static void apply_vaapi(const QMediaEncoderSettings &settings, AVCodecContext *c
         if (quality)
             codec->global_quality = quality[settings.quality()];
     }
+
+    // VA quality levels trade encoding speed for quality, 1 is the best one.
+    // Drivers clamp the value to the range they support.
+    static const int qualityLevels[] = { 7, 6, 4, 2, 1 };
+    codec->compression_level = qualityLevels[settings.quality()];
+
+    // hevc_vaapi derives main/main10 from the frames context, h264_vaapi needs a hint.
+    // Main profile doesn't allow 8x8 transforms, which are cheap on the GPU.
+    if (settings.videoCodec() == QMediaFormat::VideoCodec::H264)
+        codec->profile = settings.quality() >= QMediaRecorder::NormalQuality
+                ? ProfileH264High
+                : ProfileH264Main;
 }
 #endif
 
@@ -239,13 +262,13 @@ static void apply_mediacodec(const QMediaEncoderSettings &settings, AVCodecConte
     case QMediaFormat::VideoCodec::H264: {
         const char *levels[] = { "2.2", "3.2", "4.2", "5.2", "6.2" };
         av_dict_set(opts, "level", levels[settings.quality()], 1);
-        codec->profile = FF_PROFILE_H264_HIGH;
+        codec->profile = ProfileH264High;
         break;
     }
     case QMediaFormat::VideoCodec::H265: {
         const char *levels[] = { "h2.1", "h3.1", "h4.1", "h5.1", "h6.1" };
         av_dict_set(opts, "level", levels[settings.quality()], 1);
-        codec->profile = FF_PROFILE_HEVC_MAIN;
+        codec->profile = ProfileHevcMain;
         break;
     }
     default:
@@ -302,6 +325,9 @@ void applyVideoEncoderOptions(const QMediaEncoderSettings &settings, const QByte
 {
     av_dict_set(opts, "threads", "auto", 0); // we always want automatic threading
 
+    if (settings.videoKeyFrameInterval() > 0)
+        codec->gop_size = settings.videoKeyFrameInterval();
+
     auto *table = videoCodecOptionTable;
     while (table->name) {
         if (codecName == table->name) {
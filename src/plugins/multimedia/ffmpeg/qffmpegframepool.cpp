@@ -0,0 +1,158 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qffmpegframepool_p.h"
+
+#include <qloggingcategory.h>
+
+#include <algorithm>
+
+extern "C" {
+#include <libavutil/buffer.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/samplefmt.h>
+}
+
+QT_BEGIN_NAMESPACE
+
+static Q_LOGGING_CATEGORY(qLcFramePool, "qt.multimedia.ffmpeg.framepool")
+
+namespace QFFmpeg {
+
+// matches the alignment av_frame_get_buffer uses for AVX-512
+static constexpr int LineAlignment = 64;
+
+bool updateSwsContext(SwsContextUPtr &context, const QSize &srcSize, AVPixelFormat srcFormat,
+                      const QSize &dstSize, AVPixelFormat dstFormat, int flags)
+{
+    // sws_getCachedContext frees the passed context if it cannot be reused
+    SwsContext *updated = sws_getCachedContext(context.release(), srcSize.width(),
+                                               srcSize.height(), srcFormat, dstSize.width(),
+                                               dstSize.height(), dstFormat, flags, nullptr,
+                                               nullptr, nullptr);
+    context.reset(updated);
+    return updated != nullptr;
+}
+
+AVFramePool::~AVFramePool()
+{
+    // the pool is actually freed when the last buffer is returned
+    av_buffer_pool_uninit(&m_pool);
+}
+
+bool AVFramePool::reset(AVPixelFormat format, const QSize &size)
+{
+    av_buffer_pool_uninit(&m_pool);
+    m_format = format;
+    m_size = size;
+
+    const int bufferSize =
+            av_image_get_buffer_size(format, size.width(), size.height(), LineAlignment);
+    if (bufferSize < 0) {
+        qCWarning(qLcFramePool) << "Cannot calculate the buffer size for" << format << size;
+        return false;
+    }
+
+    // add some padding, as SIMD implementations might read or write slightly past the end
+    m_pool = av_buffer_pool_init(bufferSize + AV_INPUT_BUFFER_PADDING_SIZE, nullptr);
+    qCDebug(qLcFramePool) << "Created frame pool for" << format << size
+                          << "buffer size:" << bufferSize;
+    return m_pool != nullptr;
+}
+
+AVFrameUPtr AVFramePool::get(AVPixelFormat format, const QSize &size)
+{
+    if ((!m_pool || format != m_format || size != m_size) && !reset(format, size))
+        return {};
+
+    auto frame = makeAVFrame();
+    if (!frame)
+        return {};
+
+    frame->buf[0] = av_buffer_pool_get(m_pool);
+    if (!frame->buf[0])
+        return {};
+
+    frame->format = format;
+    frame->width = size.width();
+    frame->height = size.height();
+
+    const int res = av_image_fill_arrays(frame->data, frame->linesize, frame->buf[0]->data, format,
+                                         size.width(), size.height(), LineAlignment);
+    if (res < 0)
+        return {};
+
+    frame->extended_data = frame->data;
+    return frame;
+}
+
+AVAudioFramePool::~AVAudioFramePool()
+{
+    av_buffer_pool_uninit(&m_pool);
+}
+
+bool AVAudioFramePool::reset(AVSampleFormat format, int channelCount, int sampleCount)
+{
+    av_buffer_pool_uninit(&m_pool);
+    m_format = format;
+    m_channelCount = channelCount;
+    m_sampleCount = sampleCount;
+
+    const int bufferSize =
+            av_samples_get_buffer_size(nullptr, channelCount, sampleCount, format, 0);
+    if (bufferSize < 0) {
+        qCWarning(qLcFramePool) << "Cannot calculate the buffer size for" << format
+                                << channelCount << "channels," << sampleCount << "samples";
+        return false;
+    }
+
+    m_pool = av_buffer_pool_init(bufferSize + AV_INPUT_BUFFER_PADDING_SIZE, nullptr);
+    qCDebug(qLcFramePool) << "Created audio frame pool for" << format << channelCount
+                          << "channels," << sampleCount << "samples, buffer size:" << bufferSize;
+    return m_pool != nullptr;
+}
+
+AVFrameUPtr AVAudioFramePool::get(AVSampleFormat format, int channelCount, int sampleCount)
+{
+    if ((!m_pool || format != m_format || channelCount != m_channelCount
+         || sampleCount != m_sampleCount)
+        && !reset(format, channelCount, sampleCount))
+        return {};
+
+    auto frame = makeAVFrame();
+    if (!frame)
+        return {};
+
+    frame->buf[0] = av_buffer_pool_get(m_pool);
+    if (!frame->buf[0])
+        return {};
+
+    frame->format = format;
+    frame->nb_samples = sampleCount;
+
+    const int planeCount = av_sample_fmt_is_planar(format) ? channelCount : 1;
+    if (planeCount > AV_NUM_DATA_POINTERS) {
+        // freed by av_frame_unref
+        frame->extended_data =
+                static_cast<uint8_t **>(av_calloc(planeCount, sizeof(*frame->extended_data)));
+        if (!frame->extended_data)
+            return {};
+    } else {
+        frame->extended_data = frame->data;
+    }
+
+    const int res = av_samples_fill_arrays(frame->extended_data, &frame->linesize[0],
+                                           frame->buf[0]->data, channelCount, sampleCount,
+                                           format, 0);
+    if (res < 0)
+        return {};
+
+    if (frame->extended_data != frame->data)
+        std::copy_n(frame->extended_data, AV_NUM_DATA_POINTERS, frame->data);
+
+    return frame;
+}
+
+} // namespace QFFmpeg
+
+QT_END_NAMESPACE
@@ -0,0 +1,97 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef QFFMPEGFRAMEPOOL_P_H
+#define QFFMPEGFRAMEPOOL_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qffmpeg_p.h"
+
+#include <qsize.h>
+
+extern "C" {
+#include <libavutil/audio_fifo.h>
+}
+
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+namespace QFFmpeg {
+
+struct SwsContextDeleter
+{
+    void operator()(SwsContext *context) const { sws_freeContext(context); }
+};
+
+using SwsContextUPtr = std::unique_ptr<SwsContext, SwsContextDeleter>;
+
+using SwrContextUPtr = std::unique_ptr<SwrContext, AVDeleter<decltype(&swr_free), &swr_free>>;
+
+struct AVAudioFifoDeleter
+{
+    void operator()(AVAudioFifo *fifo) const { av_audio_fifo_free(fifo); }
+};
+
+using AVAudioFifoUPtr = std::unique_ptr<AVAudioFifo, AVAudioFifoDeleter>;
+
+// Makes the context match the given conversion parameters. The context is only
+// recreated if the parameters have changed, see sws_getCachedContext.
+bool updateSwsContext(SwsContextUPtr &context, const QSize &srcSize, AVPixelFormat srcFormat,
+                      const QSize &dstSize, AVPixelFormat dstFormat, int flags);
+
+// Hands out software frames backed by recycled buffers from an AVBufferPool.
+// The pool is recreated if the requested format or size changes; buffers of
+// frames that are still alive keep the old pool alive until they're released.
+class AVFramePool
+{
+    Q_DISABLE_COPY(AVFramePool)
+public:
+    AVFramePool() = default;
+    ~AVFramePool();
+
+    AVFrameUPtr get(AVPixelFormat format, const QSize &size);
+
+private:
+    bool reset(AVPixelFormat format, const QSize &size);
+
+    AVBufferPool *m_pool = nullptr;
+    AVPixelFormat m_format = AV_PIX_FMT_NONE;
+    QSize m_size;
+};
+
+// The audio counterpart of AVFramePool: frames of a fixed number of samples,
+// with all planes in a single pooled buffer. The channel layout and the
+// sample rate are left to the caller.
+class AVAudioFramePool
+{
+    Q_DISABLE_COPY(AVAudioFramePool)
+public:
+    AVAudioFramePool() = default;
+    ~AVAudioFramePool();
+
+    AVFrameUPtr get(AVSampleFormat format, int channelCount, int sampleCount);
+
+private:
+    bool reset(AVSampleFormat format, int channelCount, int sampleCount);
+
+    AVBufferPool *m_pool = nullptr;
+    AVSampleFormat m_format = AV_SAMPLE_FMT_NONE;
+    int m_channelCount = 0;
+    int m_sampleCount = 0;
+};
+
+} // namespace QFFmpeg
+
+QT_END_NAMESPACE
+
+#endif // QFFMPEGFRAMEPOOL_P_H
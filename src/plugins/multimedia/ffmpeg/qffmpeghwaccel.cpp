@@ -279,6 +279,15 @@ AVHWDeviceType HWAccel::deviceType() const
     return m_hwDeviceContext ? hwDeviceContext()->type : AV_HWDEVICE_TYPE_NONE;
 }
 
+bool HWAccel::supportsSwFormat(AVPixelFormat swFormat) const
+{
+    const auto constraints = this->constraints();
+    if (!constraints || !constraints->valid_sw_formats)
+        return false;
+
+    return hasAVFormat(constraints->valid_sw_formats, swFormat);
+}
+
 void HWAccel::createFramesContext(AVPixelFormat swFormat, const QSize &size)
 {
     if (m_hwFramesContext) {
@@ -286,21 +295,32 @@ void HWAccel::createFramesContext(AVPixelFormat swFormat, const QSize &size)
         return;
     }
 
+    m_hwFramesContext = makeFramesContext(swFormat, size);
+}
+
+AVBufferUPtr HWAccel::makeFramesContext(AVPixelFormat swFormat, const QSize &size) const
+{
     if (!m_hwDeviceContext)
-        return;
+        return {};
+
+    AVBufferUPtr framesContext(av_hwframe_ctx_alloc(m_hwDeviceContext.get()));
+    if (!framesContext)
+        return {};
 
-    m_hwFramesContext.reset(av_hwframe_ctx_alloc(m_hwDeviceContext.get()));
-    auto *c = (AVHWFramesContext *)m_hwFramesContext->data;
+    auto *c = (AVHWFramesContext *)framesContext->data;
     c->format = hwFormat();
     c->sw_format = swFormat;
     c->width = size.width();
     c->height = size.height();
     qCDebug(qLHWAccel) << "init frames context";
-    int err = av_hwframe_ctx_init(m_hwFramesContext.get());
-    if (err < 0)
+    int err = av_hwframe_ctx_init(framesContext.get());
+    if (err < 0) {
         qWarning() << "failed to init HW frame context" << err << err2str(err);
-    else
-        qCDebug(qLHWAccel) << "Initialized frames context" << size << c->format << c->sw_format;
+        return {};
+    }
+
+    qCDebug(qLHWAccel) << "Initialized frames context" << size << c->format << c->sw_format;
+    return framesContext;
 }
 
 AVHWFramesContext *HWAccel::hwFramesContext() const
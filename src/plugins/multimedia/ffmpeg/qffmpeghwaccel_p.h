@@ -106,10 +106,15 @@ public:
     AVPixelFormat hwFormat() const;
     AVHWFramesConstraintsUPtr constraints() const;
 
+    bool supportsSwFormat(AVPixelFormat swFormat) const;
+
     void createFramesContext(AVPixelFormat swFormat, const QSize &size);
     AVBufferRef *hwFramesContextAsBuffer() const { return m_hwFramesContext.get(); }
     AVHWFramesContext *hwFramesContext() const;
 
+    // creates an additional frames context on the same device, not owned by the accel
+    AVBufferUPtr makeFramesContext(AVPixelFormat swFormat, const QSize &size) const;
+
     static AVPixelFormat format(AVFrame *frame);
     static const std::vector<AVHWDeviceType> &encodingDeviceTypes();
 
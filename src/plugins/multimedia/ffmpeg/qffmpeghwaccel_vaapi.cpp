@@ -52,6 +52,7 @@ extern "C" {
 
 #include <va/va_drm.h>
 #include <va/va_drmcommon.h>
+#include <va/va_vpp.h>
 
 #include <EGL/egl.h>
 #include <EGL/eglext.h>
@@ -345,6 +346,107 @@ VAAPITextureSet::~VAAPITextureSet()
     }
 }
 
+static VADisplay vaDisplay(const AVBufferRef *deviceContext)
+{
+    auto *ctx = (AVHWDeviceContext *)deviceContext->data;
+    return ctx->type == AV_HWDEVICE_TYPE_VAAPI ? ((AVVAAPIDeviceContext *)ctx->hwctx)->display
+                                               : nullptr;
+}
+
+std::unique_ptr<VAAPIVideoProcessor> VAAPIVideoProcessor::create(const HWAccel &accel,
+                                                                 const QSize &outputSize)
+{
+    auto *deviceContext = accel.hwDeviceContextAsBuffer();
+    if (!deviceContext)
+        return {};
+
+    auto display = vaDisplay(deviceContext);
+    if (!display)
+        return {};
+
+    VAConfigID configId = VA_INVALID_ID;
+    VAStatus status =
+            vaCreateConfig(display, VAProfileNone, VAEntrypointVideoProc, nullptr, 0, &configId);
+    if (status != VA_STATUS_SUCCESS) {
+        qCDebug(qLHWAccelVAAPI) << "VA video processing is not supported:" << vaErrorStr(status);
+        return {};
+    }
+
+    VAContextID contextId = VA_INVALID_ID;
+    status = vaCreateContext(display, configId, outputSize.width(), outputSize.height(),
+                             VA_PROGRESSIVE, nullptr, 0, &contextId);
+    if (status != VA_STATUS_SUCCESS) {
+        qCDebug(qLHWAccelVAAPI) << "Cannot create VA video processing context:"
+                                << vaErrorStr(status);
+        vaDestroyConfig(display, configId);
+        return {};
+    }
+
+    qCDebug(qLHWAccelVAAPI) << "Created VA video processor, output size" << outputSize;
+
+    return std::unique_ptr<VAAPIVideoProcessor>(new VAAPIVideoProcessor(
+            AVBufferUPtr(av_buffer_ref(deviceContext)), configId, contextId));
+}
+
+VAAPIVideoProcessor::VAAPIVideoProcessor(AVBufferUPtr deviceContext, quint32 configId,
+                                         quint32 contextId)
+    : m_deviceContext(std::move(deviceContext)), m_configId(configId), m_contextId(contextId)
+{
+}
+
+VAAPIVideoProcessor::~VAAPIVideoProcessor()
+{
+    auto display = vaDisplay(m_deviceContext.get());
+    vaDestroyContext(display, m_contextId);
+    vaDestroyConfig(display, m_configId);
+}
+
+int VAAPIVideoProcessor::process(AVFrame *output, const AVFrame *input)
+{
+    if (input->format != AV_PIX_FMT_VAAPI || output->format != AV_PIX_FMT_VAAPI)
+        return AVERROR(EINVAL);
+
+    auto display = vaDisplay(m_deviceContext.get());
+    const auto inputSurface = (VASurfaceID)(uintptr_t)input->data[3];
+    const auto outputSurface = (VASurfaceID)(uintptr_t)output->data[3];
+
+    const VARectangle inputRegion = { 0, 0, static_cast<uint16_t>(input->width),
+                                      static_cast<uint16_t>(input->height) };
+
+    VAProcPipelineParameterBuffer params = {};
+    params.surface = inputSurface;
+    params.surface_region = &inputRegion;
+    params.output_region = nullptr; // the whole output surface
+    params.output_background_color = 0xff000000;
+    params.filter_flags = VA_FRAME_PICTURE | VA_FILTER_SCALING_DEFAULT;
+
+    VABufferID paramsBuffer = VA_INVALID_ID;
+    VAStatus status = vaCreateBuffer(display, m_contextId, VAProcPipelineParameterBufferType,
+                                     sizeof(params), 1, &params, &paramsBuffer);
+    if (status != VA_STATUS_SUCCESS) {
+        qCDebug(qLHWAccelVAAPI) << "vaCreateBuffer failed:" << vaErrorStr(status);
+        return AVERROR(EIO);
+    }
+
+    status = vaBeginPicture(display, m_contextId, outputSurface);
+    if (status == VA_STATUS_SUCCESS) {
+        status = vaRenderPicture(display, m_contextId, &paramsBuffer, 1);
+        // vaEndPicture has to be called anyway to leave the context in a valid state
+        const VAStatus endStatus = vaEndPicture(display, m_contextId);
+        if (status == VA_STATUS_SUCCESS)
+            status = endStatus;
+    }
+
+    vaDestroyBuffer(display, paramsBuffer);
+
+    if (status != VA_STATUS_SUCCESS) {
+        qCDebug(qLHWAccelVAAPI) << "VA video processing failed:" << vaErrorStr(status);
+        return AVERROR(EIO);
+    }
+
+    return av_frame_copy_props(output, input);
+}
+
 }
 
 QT_END_NAMESPACE
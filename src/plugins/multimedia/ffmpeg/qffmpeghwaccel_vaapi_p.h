@@ -39,6 +39,26 @@ public:
     QOpenGLContext *glContext = nullptr;
     QFunctionPointer eglImageTargetTexture2D = nullptr;
 };
+
+// Converts and scales VAAPI surfaces on the GPU with the VA video processing
+// pipeline (the same approach as ffmpeg's scale_vaapi filter).
+class VAAPIVideoProcessor
+{
+public:
+    static std::unique_ptr<VAAPIVideoProcessor> create(const HWAccel &accel,
+                                                       const QSize &outputSize);
+    ~VAAPIVideoProcessor();
+
+    // Renders the input surface into the output surface; both frames must be AV_PIX_FMT_VAAPI
+    int process(AVFrame *output, const AVFrame *input);
+
+private:
+    VAAPIVideoProcessor(AVBufferUPtr deviceContext, quint32 configId, quint32 contextId);
+
+    AVBufferUPtr m_deviceContext;
+    quint32 m_configId = 0;
+    quint32 m_contextId = 0;
+};
 }
 
 QT_END_NAMESPACE
@@ -166,9 +166,8 @@ void QFFmpegImageCapture::newVideoFrame(const QVideoFrame &frame)
     // ### Add metadata from the AVFrame
     emit imageMetadataAvailable(pending.id, pending.metaData);
     emit imageAvailable(pending.id, frame);
-    QImage image = frame.toImage();
-    if (m_settings.resolution().isValid() && m_settings.resolution() != image.size())
-        image = image.scaled(m_settings.resolution());
+    // scale while converting, rather than converting at full size first
+    QImage image = frame.toImage(m_settings.resolution());
 
     emit imageCaptured(pending.id, image);
     if (!pending.filename.isEmpty()) {
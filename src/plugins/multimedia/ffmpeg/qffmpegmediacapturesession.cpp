@@ -153,6 +153,8 @@ void QFFmpegMediaCaptureSession::updateAudioSink()
     if (m_audioSink) {
         m_audioSink->reset();
         m_audioSink.reset();
+        if (auto meter = m_audioOutput ? m_audioOutput->levelMeter() : nullptr)
+            meter->reset();
     };
 
     if (!m_audioInput || !m_audioOutput)
@@ -186,6 +188,8 @@ void QFFmpegMediaCaptureSession::updateAudioSink()
 
                     const auto written =
                             m_audioIODevice->write(buffer.data<const char>(), buffer.byteCount());
+                    if (auto meter = m_audioOutput->levelMeter(); meter && written > 0)
+                        meter->process(buffer.format(), buffer.data<const char>(), written);
 
                     if (written < buffer.byteCount())
                         qCWarning(qLcFFmpegMediaCaptureSession)
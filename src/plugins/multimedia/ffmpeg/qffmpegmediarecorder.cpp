@@ -137,6 +137,12 @@ void QFFmpegMediaRecorder::stop()
     }
 }
 
+void QFFmpegMediaRecorder::updateEncoderSettings(const QMediaEncoderSettings &settings)
+{
+    if (encoder)
+        encoder->updateVideoSettings(settings);
+}
+
 void QFFmpegMediaRecorder::finalizationDone()
 {
     stateChanged(QMediaRecorder::StoppedState);
@@ -46,6 +46,8 @@ public:
     void resume() override;
     void stop() override;
 
+    void updateEncoderSettings(const QMediaEncoderSettings &settings) override;
+
     void setMetaData(const QMediaMetaData &) override;
     QMediaMetaData metaData() const override;
 
@@ -0,0 +1,323 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qffmpegoutputfile_p.h"
+#include "qffmpegthread_p.h"
+
+#include <qqueue.h>
+#include <qloggingcategory.h>
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+QT_BEGIN_NAMESPACE
+
+static Q_LOGGING_CATEGORY(qLcOutputFile, "qt.multimedia.ffmpeg.outputfile")
+
+namespace QFFmpeg {
+
+class FileWriter : public Thread
+{
+    // A chunk either refers to a whole AVIO buffer, which goes back to the pool
+    // once it's written, or holds a copy of data that libavformat passed otherwise.
+    struct Chunk
+    {
+        qint64 offset = 0;
+        QByteArray data;
+        uint8_t *buffer = nullptr;
+    };
+
+    // Limits the memory held by pending writes. If the disk cannot keep up for longer
+    // than this, the muxer has to wait.
+    static constexpr qint64 MaxQueuedBytes = 64 * 1024 * 1024;
+
+    mutable QMutex queueMutex;
+    QWaitCondition spaceAvailable;
+    QQueue<Chunk> chunkQueue;
+    qint64 queuedBytes = 0;
+    QList<uint8_t *> freeBuffers;
+
+public:
+    FileWriter(OutputFile *file) : file(file) { setObjectName(QLatin1String("FileWriter")); }
+
+    ~FileWriter() override
+    {
+        // kill() drained the queue, so all the buffers are back
+        for (uint8_t *buffer : std::as_const(freeBuffers))
+            av_free(buffer);
+    }
+
+    void addChunk(qint64 offset, QByteArray data) { enqueue({ offset, std::move(data) }); }
+
+    // Queues a filled AVIO buffer without copying it, and returns an empty one of
+    // the same size to continue with. If there is none, the buffer isn't queued.
+    uint8_t *addBuffer(qint64 offset, uint8_t *buffer, int size, int bufferSize)
+    {
+        uint8_t *next = nullptr;
+        {
+            QMutexLocker locker(&queueMutex);
+            if (!freeBuffers.isEmpty())
+                next = freeBuffers.takeLast();
+        }
+        if (!next)
+            next = static_cast<uint8_t *>(av_malloc(bufferSize));
+        if (!next)
+            return nullptr;
+
+        enqueue({ offset, QByteArray::fromRawData(reinterpret_cast<const char *>(buffer), size),
+                  buffer });
+        return next;
+    }
+
+private:
+    void enqueue(Chunk &&chunk)
+    {
+        QMutexLocker locker(&queueMutex);
+        while (queuedBytes >= MaxQueuedBytes)
+            spaceAvailable.wait(&queueMutex);
+
+        queuedBytes += chunk.data.size();
+        chunkQueue.enqueue(std::move(chunk));
+        wake();
+    }
+
+    bool shouldWait() const override
+    {
+        QMutexLocker locker(&queueMutex);
+        return chunkQueue.isEmpty();
+    }
+
+    void loop() override
+    {
+        QQueue<Chunk> chunks;
+        {
+            QMutexLocker locker(&queueMutex);
+            chunks.swap(chunkQueue);
+        }
+
+        qint64 written = 0;
+        for (const Chunk &chunk : std::as_const(chunks)) {
+            // after a failure, the data is dropped; the error is reported on the next write
+            if (!file->m_failed.loadAcquire()
+                && !file->writeAt(chunk.offset, chunk.data.constData(), chunk.data.size()))
+                file->m_failed.storeRelease(true);
+            written += chunk.data.size();
+        }
+
+        QMutexLocker locker(&queueMutex);
+        for (const Chunk &chunk : std::as_const(chunks)) {
+            if (chunk.buffer)
+                freeBuffers.append(chunk.buffer);
+        }
+        queuedBytes -= written;
+        spaceAvailable.wakeAll();
+    }
+
+    void cleanup() override
+    {
+        while (!shouldWait())
+            loop();
+    }
+
+    OutputFile *file = nullptr;
+};
+
+OutputFile::Options OutputFile::Options::fromEnvironment()
+{
+    Options options;
+    bool ok = false;
+
+    const int bufferSizeKb = qEnvironmentVariableIntValue("QT_FFMPEG_ENCODING_IO_BUFFER_KB", &ok);
+    if (ok && bufferSizeKb > 0)
+        options.bufferSize = bufferSizeKb * 1024;
+
+    const int useIOThread = qEnvironmentVariableIntValue("QT_FFMPEG_ENCODING_IO_THREAD", &ok);
+    if (ok)
+        options.useIOThread = useIOThread != 0;
+
+    const int syncIntervalMb =
+            qEnvironmentVariableIntValue("QT_FFMPEG_ENCODING_SYNC_INTERVAL_MB", &ok);
+    if (ok && syncIntervalMb > 0)
+        options.syncInterval = qint64(syncIntervalMb) * 1024 * 1024;
+
+    return options;
+}
+
+OutputFile::OutputFile(const Options &options) : m_options(options) { }
+
+std::unique_ptr<OutputFile> OutputFile::open(const QString &fileName, const Options &options)
+{
+    std::unique_ptr<OutputFile> file(new OutputFile(options));
+
+    file->m_file.setFileName(fileName);
+    if (!file->m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        qWarning() << "Cannot open" << fileName << "for writing:" << file->m_file.errorString();
+        return {};
+    }
+
+    // av_malloc aligns the buffer suitably for SIMD and direct I/O
+    auto *buffer = static_cast<unsigned char *>(av_malloc(options.bufferSize));
+    if (!buffer)
+        return {};
+
+    file->m_avioContext = avio_alloc_context(buffer, options.bufferSize, 1, file.get(), nullptr,
+                                             &OutputFile::writePacket, &OutputFile::seek);
+    if (!file->m_avioContext) {
+        av_free(buffer);
+        return {};
+    }
+
+    if (options.useIOThread) {
+        file->m_writer = new FileWriter(file.get());
+        file->m_writer->start();
+    }
+
+    qCDebug(qLcOutputFile) << "opened" << fileName << "buffer size:" << options.bufferSize
+                           << "I/O thread:" << options.useIOThread
+                           << "sync interval:" << options.syncInterval;
+
+    return file;
+}
+
+OutputFile::~OutputFile()
+{
+    close();
+
+    if (m_avioContext) {
+        // the buffer might have been reallocated by libavformat, so free the current one
+        av_freep(&m_avioContext->buffer);
+        avio_context_free(&m_avioContext);
+    }
+}
+
+bool OutputFile::close()
+{
+    if (!m_file.isOpen())
+        return !m_failed.loadAcquire();
+
+    if (m_avioContext)
+        avio_flush(m_avioContext);
+
+    if (m_writer) {
+        // kill() drains the queue before the thread exits
+        m_writer->kill();
+        m_writer = nullptr;
+    }
+
+    if (m_options.syncInterval > 0 && m_bytesSinceSync > 0 && !sync())
+        m_failed.storeRelease(true);
+
+    m_file.close();
+
+    qCDebug(qLcOutputFile) << "closed" << m_file.fileName() << "size:" << m_size
+                           << "failed:" << m_failed.loadAcquire();
+
+    return !m_failed.loadAcquire();
+}
+
+int OutputFile::writePacket(void *opaque, AVIOBuffer buf, int size)
+{
+    return static_cast<OutputFile *>(opaque)->write(buf, size);
+}
+
+int64_t OutputFile::seek(void *opaque, int64_t offset, int whence)
+{
+    auto *file = static_cast<OutputFile *>(opaque);
+
+    // The actual file position is only changed when writing, so seeks
+    // don't have to be synchronized with the I/O thread.
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return file->m_size;
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += file->m_position;
+        break;
+    case SEEK_END:
+        offset += file->m_size;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+
+    if (offset < 0)
+        return AVERROR(EINVAL);
+
+    file->m_position = offset;
+    return offset;
+}
+
+int OutputFile::write(const uint8_t *buf, int size)
+{
+    if (m_failed.loadAcquire())
+        return AVERROR(EIO);
+
+    if (m_writer && buf == m_avioContext->buffer
+        && m_avioContext->buffer_size == m_options.bufferSize) {
+        // libavformat flushes its buffer, and refills it from the start once we return.
+        // Hand the buffer to the writer as it is, and let libavformat continue in another one.
+        uint8_t *buffer = m_writer->addBuffer(m_position, m_avioContext->buffer, size,
+                                              m_options.bufferSize);
+        if (!buffer)
+            return AVERROR(ENOMEM);
+        m_avioContext->buffer = buffer;
+        m_avioContext->buf_ptr = buffer;
+        m_avioContext->buf_end = buffer + m_options.bufferSize;
+    } else if (m_writer) {
+        // direct writes of large packets, or a buffer that libavformat has resized
+        m_writer->addChunk(m_position, QByteArray(reinterpret_cast<const char *>(buf), size));
+    } else if (!writeAt(m_position, reinterpret_cast<const char *>(buf), size)) {
+        return AVERROR(EIO);
+    }
+
+    m_position += size;
+    m_size = std::max(m_size, m_position);
+    return size;
+}
+
+bool OutputFile::writeAt(qint64 offset, const char *data, qint64 size)
+{
+    if (m_file.pos() != offset && !m_file.seek(offset)) {
+        qWarning() << "Cannot seek in" << m_file.fileName() << ":" << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.write(data, size) != size) {
+        qWarning() << "Cannot write to" << m_file.fileName() << ":" << m_file.errorString();
+        return false;
+    }
+
+    m_bytesSinceSync += size;
+    if (m_options.syncInterval > 0 && m_bytesSinceSync >= m_options.syncInterval)
+        return sync();
+
+    return true;
+}
+
+bool OutputFile::sync()
+{
+    m_bytesSinceSync = 0;
+
+#if defined(Q_OS_LINUX) || defined(Q_OS_ANDROID)
+    const int res = ::fdatasync(m_file.handle());
+#elif defined(Q_OS_UNIX)
+    const int res = ::fsync(m_file.handle());
+#elif defined(Q_OS_WIN)
+    const int res = ::_commit(m_file.handle());
+#else
+    const int res = m_file.flush() ? 0 : -1;
+#endif
+
+    if (res != 0)
+        qWarning() << "Cannot sync" << m_file.fileName() << "to the disk";
+
+    return res == 0;
+}
+
+} // namespace QFFmpeg
+
+QT_END_NAMESPACE
@@ -0,0 +1,92 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+#ifndef QFFMPEGOUTPUTFILE_P_H
+#define QFFMPEGOUTPUTFILE_P_H
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the Qt API. It exists purely as an
+// implementation detail. This header file may change from version to
+// version without notice, or even be removed.
+//
+// We mean it.
+//
+
+#include "qffmpeg_p.h"
+
+#include <qfile.h>
+#include <qatomic.h>
+#include <memory>
+
+QT_BEGIN_NAMESPACE
+
+namespace QFFmpeg {
+
+class FileWriter;
+
+// The muxer output: a large AVIO buffer in front of the file. Filled buffers
+// are written either directly or by a dedicated I/O thread, so that a slow disk
+// doesn't stall the muxer and the encoders behind it.
+//
+// Tuning via environment variables:
+//   QT_FFMPEG_ENCODING_IO_BUFFER_KB     - size of the AVIO buffer, 1024 by default
+//   QT_FFMPEG_ENCODING_IO_THREAD        - set to 0 to write from the muxer thread
+//   QT_FFMPEG_ENCODING_SYNC_INTERVAL_MB - fdatasync after every N megabytes and on close,
+//                                         0 (the default) leaves flushing to the OS
+class OutputFile
+{
+public:
+    struct Options
+    {
+        int bufferSize = 1024 * 1024;
+        bool useIOThread = true;
+        qint64 syncInterval = 0;
+
+        static Options fromEnvironment();
+    };
+
+    static std::unique_ptr<OutputFile> open(const QString &fileName,
+                                            const Options &options = Options::fromEnvironment());
+    ~OutputFile();
+
+    AVIOContext *avioContext() const { return m_avioContext; }
+
+    // flushes the AVIO buffer, waits for pending writes and closes the file
+    bool close();
+
+private:
+    OutputFile(const Options &options);
+
+#if LIBAVFORMAT_VERSION_MAJOR < 61
+    using AVIOBuffer = uint8_t *;
+#else
+    using AVIOBuffer = const uint8_t *;
+#endif
+
+    static int writePacket(void *opaque, AVIOBuffer buf, int size);
+    static int64_t seek(void *opaque, int64_t offset, int whence);
+
+    int write(const uint8_t *buf, int size);
+    bool writeAt(qint64 offset, const char *data, qint64 size);
+    bool sync();
+
+    friend class FileWriter;
+
+    Options m_options;
+    QFile m_file;
+    AVIOContext *m_avioContext = nullptr;
+    FileWriter *m_writer = nullptr;
+
+    qint64 m_position = 0;
+    qint64 m_size = 0;
+    qint64 m_bytesSinceSync = 0;
+    QAtomicInteger<bool> m_failed = false;
+};
+
+} // namespace QFFmpeg
+
+QT_END_NAMESPACE
+
+#endif // QFFMPEGOUTPUTFILE_P_H
@@ -46,6 +46,7 @@ Resampler::Resampler(const Codec *codec, const QAudioFormat &outputFormat)
                                    codecpar->sample_rate,                // in_sample_rate
                                    0,                    // log_offset
                                    nullptr);
+    const bool sameLayout = inConfig == QFFmpegMediaFormatInfo::avChannelLayout(config);
 #else
     AVChannelLayout in_ch_layout = codecpar->ch_layout;
     AVChannelLayout out_ch_layout = {};
@@ -59,8 +60,14 @@ Resampler::Resampler(const Codec *codec, const QAudioFormat &outputFormat)
                         codecpar->sample_rate,
                         0,
                         nullptr);
+    const bool sameLayout = av_channel_layout_compare(&in_ch_layout, &out_ch_layout) == 0;
 #endif
 
+    m_passThrough = sameLayout
+            && AVSampleFormat(codecpar->format)
+                    == QFFmpegMediaFormatInfo::avSampleFormat(m_outputFormat.sampleFormat())
+            && codecpar->sample_rate == m_outputFormat.sampleRate();
+
     swr_init(resampler);
 }
 
@@ -69,8 +76,38 @@ Resampler::~Resampler()
     swr_free(&resampler);
 }
 
+// Frames that are in the output format already don't need converting, as long
+// as nothing is left in the resampler and it isn't compensating
+bool Resampler::canPassThrough(const AVFrame *frame) const
+{
+#if QT_FFMPEG_OLD_CHANNEL_LAYOUT
+    const int channels = frame->channels;
+#else
+    const int channels = frame->ch_layout.nb_channels;
+#endif
+    return m_passThrough
+            && frame->format == QFFmpegMediaFormatInfo::avSampleFormat(m_outputFormat.sampleFormat())
+            && frame->sample_rate == m_outputFormat.sampleRate()
+            && channels == m_outputFormat.channelCount()
+            && !isSampleCompensationActive()
+            && swr_get_delay(resampler, m_outputFormat.sampleRate()) == 0;
+}
+
 QAudioBuffer Resampler::resample(const AVFrame *frame)
 {
+    if (canPassThrough(frame)) {
+        // the buffer references the samples of the frame instead of copying them
+        if (AVFrame *reference = av_frame_clone(frame)) {
+            const qint64 startTime = m_outputFormat.durationForFrames(m_samplesProcessed);
+            m_samplesProcessed += frame->nb_samples;
+            return QAudioBuffer(reference->data[0], m_outputFormat.bytesForFrames(frame->nb_samples),
+                                m_outputFormat, startTime, [](void *info) {
+                                    auto *frame = static_cast<AVFrame *>(info);
+                                    av_frame_free(&frame);
+                                }, reference);
+        }
+    }
+
     const int outSamples = swr_get_out_samples(resampler, frame->nb_samples);
     QByteArray samples(m_outputFormat.bytesForFrames(outSamples), Qt::Uninitialized);
     auto **in = const_cast<const uint8_t **>(frame->extended_data);
@@ -36,8 +36,11 @@ public:
     bool isSampleCompensationActive() const;
 
 private:
+    bool canPassThrough(const AVFrame *frame) const;
+
     QAudioFormat m_outputFormat;
     SwrContext *resampler = nullptr;
+    bool m_passThrough = false;
     qint64 m_samplesProcessed = 0;
     qint64 m_endCompensationSample = std::numeric_limits<qint64>::min();
 };
@@ -4,13 +4,19 @@
 #include "qffmpegvideobuffer_p.h"
 #include "private/qvideotexturehelper_p.h"
 #include "qffmpeghwaccel_p.h"
+#include "qffmpegframepool_p.h"
 
 extern "C" {
 #include <libavutil/pixdesc.h>
+#include <libavutil/hwcontext.h>
 #include <libavutil/hdr_dynamic_metadata.h>
 #include <libavutil/mastering_display_metadata.h>
 }
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 static bool isFrameFlipped(const AVFrame& frame) {
     for (int i = 0; i < AV_NUM_DATA_POINTERS && frame.data[i]; ++i) {
         if (frame.linesize[i] < 0)
@@ -39,29 +45,79 @@ QFFmpegVideoBuffer::QFFmpegVideoBuffer(AVFrameUPtr frame)
 
 QFFmpegVideoBuffer::~QFFmpegVideoBuffer() = default;
 
+namespace {
+struct SWConversion
+{
+    AVPixelFormat srcFormat = AV_PIX_FMT_NONE;
+    AVPixelFormat dstFormat = AV_PIX_FMT_NONE;
+    QSize size;
+    QFFmpeg::SwsContextUPtr context;
+    QFFmpeg::AVFramePool framePool;
+};
+
+constexpr size_t MaxCachedConversions = 4;
+} // namespace
+
+// Conversions run on the decoding threads, and on whatever thread maps a hw frame,
+// e.g. the render thread, which can see the frames of several streams in turn.
+// Keeping the conversions of a few formats and sizes per thread keeps the context
+// and the buffers of every stream alive between its frames, without any locking.
+static SWConversion &swConversion(AVPixelFormat srcFormat, AVPixelFormat dstFormat, const QSize &size)
+{
+    // the most recently used first
+    thread_local std::vector<std::unique_ptr<SWConversion>> conversions;
+
+    auto it = std::find_if(conversions.begin(), conversions.end(), [&](const auto &conversion) {
+        return conversion->srcFormat == srcFormat && conversion->dstFormat == dstFormat
+                && conversion->size == size;
+    });
+    if (it == conversions.end()) {
+        if (conversions.size() == MaxCachedConversions)
+            conversions.pop_back();
+        auto conversion = std::make_unique<SWConversion>();
+        conversion->srcFormat = srcFormat;
+        conversion->dstFormat = dstFormat;
+        conversion->size = size;
+        it = conversions.insert(conversions.begin(), std::move(conversion));
+    }
+
+    std::rotate(conversions.begin(), it, it + 1);
+    return *conversions.front();
+}
+
 void QFFmpegVideoBuffer::convertSWFrame()
 {
     Q_ASSERT(swFrame);
+    m_conversionFailed = false;
     bool needsConversion = false;
     auto pixelFormat = toQtPixelFormat(AVPixelFormat(swFrame->format), &needsConversion);
     if (pixelFormat != m_pixelFormat || isFrameFlipped(*swFrame)) {
-        AVPixelFormat newFormat = toAVPixelFormat(m_pixelFormat);
-        // convert the format into something we can handle
-        SwsContext *c = sws_getContext(swFrame->width, swFrame->height, AVPixelFormat(swFrame->format),
-                                       swFrame->width, swFrame->height, newFormat,
-                                       SWS_BICUBIC, nullptr, nullptr, nullptr);
-
-        auto newFrame = QFFmpeg::makeAVFrame();
-        newFrame->width = swFrame->width;
-        newFrame->height = swFrame->height;
-        newFrame->format = newFormat;
-        av_frame_get_buffer(newFrame.get(), 0);
-
-        sws_scale(c, swFrame->data, swFrame->linesize, 0, swFrame->height, newFrame->data, newFrame->linesize);
+        const AVPixelFormat srcFormat = AVPixelFormat(swFrame->format);
+        const AVPixelFormat newFormat = toAVPixelFormat(m_pixelFormat);
+        const QSize frameSize(swFrame->width, swFrame->height);
+        auto &conversion = swConversion(srcFormat, newFormat, frameSize);
+
+        // convert the format into something we can handle. If that fails, swFrame
+        // doesn't have the format of the buffer, and must not be mapped.
+        if (!QFFmpeg::updateSwsContext(conversion.context, frameSize, srcFormat, frameSize,
+                                       newFormat, SWS_BICUBIC)) {
+            qWarning() << "Cannot create a converter from" << srcFormat << "to" << newFormat;
+            m_conversionFailed = true;
+            return;
+        }
+
+        auto newFrame = conversion.framePool.get(newFormat, frameSize);
+        if (!newFrame) {
+            m_conversionFailed = true;
+            return;
+        }
+
+        sws_scale(conversion.context.get(), swFrame->data, swFrame->linesize, 0, swFrame->height,
+                  newFrame->data, newFrame->linesize);
+        av_frame_copy_props(newFrame.get(), swFrame.get());
         if (frame == swFrame.get())
             frame = newFrame.get();
         swFrame = std::move(newFrame);
-        sws_freeContext(c);
     }
 }
 
@@ -177,26 +233,62 @@ QAbstractVideoBuffer::MapData QFFmpegVideoBuffer::map(QVideoFrame::MapMode mode)
         convertSWFrame();
     }
 
+    if (m_conversionFailed)
+        return {};
+
     m_mode = mode;
+    return mapData(*swFrame);
+}
 
+QAbstractVideoBuffer::MapData QFFmpegVideoBuffer::mapRegion(QVideoFrame::MapMode mode,
+                                                           const QRect &region, int planeMask)
+{
+    // FFmpeg cannot transfer parts of hardware frames. Mapping the surface instead
+    // leaves the copying to the caller, who reads only the region it needs.
+    if (!swFrame && mode == QVideoFrame::ReadOnly) {
+        Q_ASSERT(hwFrame && hwFrame->hw_frames_ctx);
+        auto *framesContext = reinterpret_cast<AVHWFramesContext *>(hwFrame->hw_frames_ctx->data);
+
+        mappedFrame = QFFmpeg::makeAVFrame();
+        mappedFrame->format = framesContext->sw_format;
+        if (av_hwframe_map(mappedFrame.get(), hwFrame.get(), AV_HWFRAME_MAP_READ) >= 0) {
+            bool needsConversion = false;
+            const auto format = toQtPixelFormat(AVPixelFormat(mappedFrame->format), &needsConversion);
+            if (format == m_pixelFormat && !needsConversion && !isFrameFlipped(*mappedFrame)) {
+                m_mode = mode;
+                return mapData(*mappedFrame);
+            }
+        }
+
+        // not supported by the device; transfer the whole frame
+        mappedFrame.reset();
+    }
+
+    return QAbstractVideoBuffer::mapRegion(mode, region, planeMask);
+}
+
+void QFFmpegVideoBuffer::unmap()
+{
+    // nothing to do here for SW buffers; mapped HW surfaces are released
+    mappedFrame.reset();
+    m_mode = QVideoFrame::NotMapped;
+}
+
+QAbstractVideoBuffer::MapData QFFmpegVideoBuffer::mapData(const AVFrame &frame) const
+{
     MapData mapData;
     auto *desc = QVideoTextureHelper::textureDescription(pixelFormat());
     mapData.nPlanes = desc->nplanes;
     for (int i = 0; i < mapData.nPlanes; ++i) {
-        Q_ASSERT(swFrame->linesize[i] >= 0);
+        Q_ASSERT(frame.linesize[i] >= 0);
 
-        mapData.data[i] = swFrame->data[i];
-        mapData.bytesPerLine[i] = swFrame->linesize[i];
-        mapData.size[i] = mapData.bytesPerLine[i]*desc->heightForPlane(swFrame->height, i);
+        mapData.data[i] = frame.data[i];
+        mapData.bytesPerLine[i] = frame.linesize[i];
+        mapData.size[i] = mapData.bytesPerLine[i]*desc->heightForPlane(frame.height, i);
     }
     return mapData;
 }
 
-void QFFmpegVideoBuffer::unmap()
-{
-    // nothing to do here for SW buffers
-}
-
 std::unique_ptr<QVideoFrameTextures> QFFmpegVideoBuffer::mapTextures(QRhi *)
 {
     if (textures)
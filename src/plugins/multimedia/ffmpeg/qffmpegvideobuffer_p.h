@@ -35,6 +35,7 @@ public:
 
     QVideoFrame::MapMode mapMode() const override;
     MapData map(QVideoFrame::MapMode mode) override;
+    MapData mapRegion(QVideoFrame::MapMode mode, const QRect &region, int planeMask) override;
     void unmap() override;
 
     virtual std::unique_ptr<QVideoFrameTextures> mapTextures(QRhi *) override;
@@ -59,12 +60,16 @@ public:
     float maxNits();
 
 private:
+    MapData mapData(const AVFrame &frame) const;
+
     QVideoFrameFormat::PixelFormat m_pixelFormat;
     AVFrame *frame = nullptr;
     AVFrameUPtr hwFrame;
     AVFrameUPtr swFrame;
+    AVFrameUPtr mappedFrame;
     QFFmpeg::TextureConverter textureConverter;
     QVideoFrame::MapMode m_mode = QVideoFrame::NotMapped;
+    bool m_conversionFailed = false;
     std::unique_ptr<QFFmpeg::TextureSet> textures;
 };
 
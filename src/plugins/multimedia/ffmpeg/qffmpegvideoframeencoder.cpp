@@ -10,18 +10,18 @@
 #include "private/qmultimediautils_p.h"
 #include <qloggingcategory.h>
 
+#include <cstring>
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
 QT_BEGIN_NAMESPACE
 
 static Q_LOGGING_CATEGORY(qLcVideoFrameEncoder, "qt.multimedia.ffmpeg.videoencoder")
 
 namespace QFFmpeg {
 
-VideoFrameEncoder::Data::~Data()
-{
-    if (converter)
-        sws_freeContext(converter);
-}
-
 VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSettings,
                                      const QSize &sourceSize, float frameRate,
                                      AVPixelFormat sourceFormat, AVPixelFormat sourceSWFormat)
@@ -44,8 +44,16 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
 
     std::tie(d->codec, d->accel) = findHwEncoder(codecID, sourceSize);
 
-    if (!d->codec)
-        d->codec = findSwEncoder(codecID, sourceFormat, sourceSWFormat);
+    if (d->codec && !initConversions()) {
+        qCDebug(qLcVideoFrameEncoder) << "Cannot set up conversions for hw encoder"
+                                      << d->codec->name << "; trying software encoding";
+        resetCodecAndConversions();
+    }
+
+    if (d->codec)
+        return;
+
+    d->codec = findSwEncoder(codecID, sourceFormat, sourceSWFormat);
 
     if (!d->codec) {
         qWarning() << "Could not find encoder for codecId" << codecID;
@@ -53,14 +61,26 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
         return;
     }
 
+    if (!initConversions())
+        d = {};
+}
+
+VideoFrameEncoder::~VideoFrameEncoder()
+{
+}
+
+bool VideoFrameEncoder::initConversions()
+{
+    Q_ASSERT(d->codec);
+
     qCDebug(qLcVideoFrameEncoder) << "found encoder" << d->codec->name << "for id" << d->codec->id;
 
-    d->targetFormat = findTargetFormat(sourceFormat, sourceSWFormat, d->codec, d->accel.get());
+    d->targetFormat =
+            findTargetFormat(d->sourceFormat, d->sourceSWFormat, d->codec, d->accel.get());
 
     if (d->targetFormat == AV_PIX_FMT_NONE) {
-        qWarning() << "Could not find target format for codecId" << codecID;
-        d = {};
-        return;
+        qWarning() << "Could not find target format for codecId" << d->codec->id;
+        return false;
     }
 
     const bool needToScale = d->sourceSize != d->settings.videoResolution();
@@ -69,7 +89,7 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
     if (zeroCopy) {
         qCDebug(qLcVideoFrameEncoder) << "zero copy encoding, format" << d->targetFormat;
         // no need to initialize any converters
-        return;
+        return true;
     }
 
     if (isHwPixelFormat(d->sourceFormat))
@@ -86,8 +106,7 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
         if (d->targetSWFormat == AV_PIX_FMT_NONE) {
             qWarning() << "Cannot find software target format. sourceSWFormat:" << d->sourceSWFormat
                        << "targetFormat:" << d->targetFormat;
-            d = {};
-            return;
+            return false;
         }
 
         qCDebug(qLcVideoFrameEncoder)
@@ -95,6 +114,17 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
 
         // need to create a frames context to convert the input data
         d->accel->createFramesContext(d->targetSWFormat, d->settings.videoResolution());
+        if (!d->accel->hwFramesContextAsBuffer())
+            return false;
+
+        if ((d->sourceSWFormat != d->targetSWFormat || needToScale) && initHWConversion()) {
+            qCDebug(qLcVideoFrameEncoder)
+                    << "VideoFrameEncoder converts on the device:"
+                    << "sourceFormat:" << d->sourceFormat << "sourceSWFormat:" << d->sourceSWFormat
+                    << "targetSWFormat:" << d->targetSWFormat << "sizes:" << d->sourceSize
+                    << d->settings.videoResolution();
+            return true;
+        }
     } else {
         d->targetSWFormat = d->targetFormat;
     }
@@ -105,10 +135,12 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
                 << "camera and encoder use different formats:" << d->sourceSWFormat
                 << d->targetSWFormat << "or sizes:" << d->sourceSize << targetSize;
 
-        d->converter =
-                sws_getContext(d->sourceSize.width(), d->sourceSize.height(), d->sourceSWFormat,
-                               targetSize.width(), targetSize.height(), d->targetSWFormat,
-                               SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        if (!updateSwsContext(d->converter, d->sourceSize, d->sourceSWFormat, targetSize,
+                              d->targetSWFormat, SWS_FAST_BILINEAR)) {
+            qWarning() << "Cannot create a converter from" << d->sourceSWFormat << "to"
+                       << d->targetSWFormat;
+            return false;
+        }
     }
 
     qCDebug(qLcVideoFrameEncoder) << "VideoFrameEncoder conversions initialized:"
@@ -118,10 +150,56 @@ VideoFrameEncoder::VideoFrameEncoder(const QMediaEncoderSettings &encoderSetting
                                   << (isHwPixelFormat(d->targetFormat) ? "(hw)" : "(sw)")
                                   << "sourceSWFormat:" << d->sourceSWFormat
                                   << "targetSWFormat:" << d->targetSWFormat;
+    return true;
 }
 
-VideoFrameEncoder::~VideoFrameEncoder()
+bool VideoFrameEncoder::initHWConversion()
+{
+#if QT_CONFIG(vaapi)
+    Q_ASSERT(d->accel);
+
+    static const bool disableHWConversion =
+            qEnvironmentVariableIsSet("QT_FFMPEG_ENCODING_DISABLE_HW_CONVERSION");
+
+    if (disableHWConversion || d->accel->deviceType() != AV_HWDEVICE_TYPE_VAAPI)
+        return false;
+
+    // HW source frames might come from another VA display, so they still take the download path
+    if (isHwPixelFormat(d->sourceFormat) || !d->accel->supportsSwFormat(d->sourceSWFormat))
+        return false;
+
+    // the source data is uploaded as is, the device does the rest
+    d->uploadFramesContext = d->accel->makeFramesContext(d->sourceSWFormat, d->sourceSize);
+    if (!d->uploadFramesContext)
+        return false;
+
+    d->hwProcessor = VAAPIVideoProcessor::create(*d->accel, d->settings.videoResolution());
+    if (!d->hwProcessor) {
+        d->uploadFramesContext.reset();
+        return false;
+    }
+
+    d->uploadToHW = false;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void VideoFrameEncoder::resetCodecAndConversions()
 {
+#if QT_CONFIG(vaapi)
+    d->hwProcessor.reset();
+#endif
+    d->uploadFramesContext.reset();
+    d->converter.reset();
+    d->codecContext.reset();
+    d->accel.reset();
+    d->codec = nullptr;
+    d->targetFormat = AV_PIX_FMT_NONE;
+    d->targetSWFormat = AV_PIX_FMT_NONE;
+    d->downloadFromHW = false;
+    d->uploadToHW = false;
 }
 
 void QFFmpeg::VideoFrameEncoder::initWithFormatContext(AVFormatContext *formatContext)
@@ -139,6 +217,12 @@ void QFFmpeg::VideoFrameEncoder::initWithFormatContext(AVFormatContext *formatCo
     if (d->codec->id == AV_CODEC_ID_HEVC)
         d->stream->codecpar->codec_tag = MKTAG('h','v','c','1');
 
+    if (!initCodecContext())
+        d = {};
+}
+
+bool VideoFrameEncoder::initCodecContext()
+{
     // ### Fix hardcoded values
     d->stream->codecpar->format = d->targetFormat;
     d->stream->codecpar->width = d->settings.videoResolution().width();
@@ -173,8 +257,7 @@ void QFFmpeg::VideoFrameEncoder::initWithFormatContext(AVFormatContext *formatCo
     d->codecContext.reset(avcodec_alloc_context3(d->codec));
     if (!d->codecContext) {
         qWarning() << "Could not allocate codec context";
-        d = {};
-        return;
+        return false;
     }
 
     avcodec_parameters_to_context(d->codecContext.get(), d->stream->codecpar);
@@ -190,6 +273,8 @@ void QFFmpeg::VideoFrameEncoder::initWithFormatContext(AVFormatContext *formatCo
         if (framesContext)
             d->codecContext->hw_frames_ctx = av_buffer_ref(framesContext);
     }
+
+    return true;
 }
 
 bool VideoFrameEncoder::open()
@@ -198,19 +283,163 @@ bool VideoFrameEncoder::open()
         qWarning() << "Cannot open null VideoFrameEncoder";
         return false;
     }
+
+    if (openCodec())
+        return true;
+
+    // HW encoders may be listed and have a device, but still fail on opening,
+    // e.g. if the driver doesn't support the profile or the rate control mode.
+    return d->accel && fallbackToSwEncoder() && openCodec();
+}
+
+bool VideoFrameEncoder::openCodec()
+{
+    if (!d->codecContext)
+        return false;
+
+    if (!openCodecContext(d->codecContext.get())) {
+        d->codecContext.reset();
+        return false;
+    }
+    return true;
+}
+
+bool VideoFrameEncoder::openCodecContext(AVCodecContext *context)
+{
+    AVDictionaryHolder opts;
+    applyVideoEncoderOptions(d->settings, d->codec->name, context, opts);
+    int res = avcodec_open2(context, d->codec, opts);
+    if (res < 0) {
+        qWarning() << "Couldn't open codec" << d->codec->name << "for writing" << err2str(res);
+        return false;
+    }
+    qCDebug(qLcVideoFrameEncoder) << "video codec opened" << res << "time base" << context->time_base.num << context->time_base.den;
+    return true;
+}
+
+void VideoFrameEncoder::setRuntimeSettings(const QMediaEncoderSettings &settings)
+{
+    d->settings.setQuality(settings.quality());
+    d->settings.setVideoBitRate(settings.videoBitRate());
+    d->settings.setVideoKeyFrameInterval(settings.videoKeyFrameInterval());
+}
+
+bool VideoFrameEncoder::updateSettings(const QMediaEncoderSettings &settings)
+{
+    if (!d || !d->codecContext)
+        return true;
+
+    if (d->settings.quality() == settings.quality()
+        && d->settings.videoBitRate() == settings.videoBitRate()
+        && d->settings.videoKeyFrameInterval() == settings.videoKeyFrameInterval())
+        return true;
+
+    // libx264 picks up rate control changes of the opened context before the
+    // next frame (see reconfig_encoder), other wrappers and the GOP size need a reopen.
+    if (qstrcmp(d->codec->name, "libx264") != 0
+        || d->settings.videoKeyFrameInterval() != settings.videoKeyFrameInterval())
+        return false;
+
+    setRuntimeSettings(settings);
+
     AVDictionaryHolder opts;
     applyVideoEncoderOptions(d->settings, d->codec->name, d->codecContext.get(), opts);
-    int res = avcodec_open2(d->codecContext.get(), d->codec, opts);
+    // the threading setup cannot change after opening
+    av_dict_set(opts, "threads", nullptr, 0);
+
+    const int res = av_opt_set_dict2(d->codecContext.get(), opts, AV_OPT_SEARCH_CHILDREN);
     if (res < 0) {
-        d->codecContext.reset();
-        qWarning() << "Couldn't open codec for writing" << err2str(res);
+        qCDebug(qLcVideoFrameEncoder) << "Cannot update encoder options" << err2str(res);
         return false;
     }
-    qCDebug(qLcVideoFrameEncoder) << "video codec opened" << res << "time base" << d->codecContext->time_base.num << d->codecContext->time_base.den;
-    d->stream->time_base = d->stream->time_base;
+
+    qCDebug(qLcVideoFrameEncoder) << "updated encoder settings, quality:" << d->settings.quality()
+                                  << "bit rate:" << d->settings.videoBitRate();
     return true;
 }
 
+// The stream header has been written already, so a reopened codec has to produce
+// data that fits it
+static bool canContinueStream(const AVCodecContext &current, const AVCodecContext &reopened)
+{
+    return current.codec_id == reopened.codec_id && current.pix_fmt == reopened.pix_fmt
+            && current.width == reopened.width && current.height == reopened.height
+            && current.extradata_size == reopened.extradata_size
+            && (current.extradata_size == 0
+                || memcmp(current.extradata, reopened.extradata, current.extradata_size) == 0);
+}
+
+bool VideoFrameEncoder::prepareReopen(const QMediaEncoderSettings &settings)
+{
+    if (!d || !d->codecContext)
+        return false;
+
+    const QMediaEncoderSettings previousSettings = d->settings;
+    setRuntimeSettings(settings);
+
+    // keep the stream parameters and the time base of the current context
+    AVCodecContextUPtr context(avcodec_alloc_context3(d->codec));
+    const auto *current = d->codecContext.get();
+    if (context) {
+        context->pix_fmt = current->pix_fmt;
+        context->width = current->width;
+        context->height = current->height;
+        context->sample_aspect_ratio = current->sample_aspect_ratio;
+        context->time_base = current->time_base;
+        context->framerate = current->framerate;
+        context->flags = current->flags;
+        if (current->hw_device_ctx)
+            context->hw_device_ctx = av_buffer_ref(current->hw_device_ctx);
+        if (current->hw_frames_ctx)
+            context->hw_frames_ctx = av_buffer_ref(current->hw_frames_ctx);
+    }
+
+    if (!context || !openCodecContext(context.get())) {
+        d->settings = previousSettings;
+        return false;
+    }
+
+    if (!canContinueStream(*current, *context)) {
+        qCDebug(qLcVideoFrameEncoder) << "The reopened codec doesn't fit the stream";
+        d->settings = previousSettings;
+        return false;
+    }
+
+    d->reopenedContext = std::move(context);
+    return true;
+}
+
+void VideoFrameEncoder::finishReopen()
+{
+    if (!d || !d->reopenedContext)
+        return;
+
+    d->codecContext = std::move(d->reopenedContext);
+
+    // the rest of the stream parameters is the same, see canContinueStream()
+    AVCodecParameters *parameters = d->stream->codecpar;
+    parameters->bit_rate = d->codecContext->bit_rate;
+    parameters->profile = d->codecContext->profile;
+    parameters->level = d->codecContext->level;
+}
+
+bool VideoFrameEncoder::fallbackToSwEncoder()
+{
+    const auto codecID = d->codec->id;
+    qCDebug(qLcVideoFrameEncoder) << "Falling back to software encoding, hw encoder"
+                                  << d->codec->name << "failed";
+
+    resetCodecAndConversions();
+
+    d->codec = findSwEncoder(codecID, d->sourceFormat, d->sourceSWFormat);
+    if (!d->codec) {
+        qWarning() << "Could not find software encoder for codecId" << codecID;
+        return false;
+    }
+
+    return initConversions() && initCodecContext();
+}
+
 qint64 VideoFrameEncoder::getPts(qint64 us) const
 {
     Q_ASSERT(d);
@@ -223,6 +452,33 @@ const AVRational &VideoFrameEncoder::getTimeBase() const
     return d->stream->time_base;
 }
 
+static int transferToHWFrame(AVBufferRef *hwFramesContext, AVFrameUPtr &frame)
+{
+    Q_ASSERT(hwFramesContext);
+    auto f = makeAVFrame();
+
+    if (!f)
+        return AVERROR(ENOMEM);
+    int err = av_hwframe_get_buffer(hwFramesContext, f.get(), 0);
+    if (err < 0) {
+        qCDebug(qLcVideoFrameEncoder) << "Error getting HW buffer" << err2str(err);
+        return err;
+    } else {
+        qCDebug(qLcVideoFrameEncoder) << "got HW buffer";
+    }
+    if (!f->hw_frames_ctx) {
+        qCDebug(qLcVideoFrameEncoder) << "no hw frames context";
+        return AVERROR(ENOMEM);
+    }
+    err = av_hwframe_transfer_data(f.get(), frame.get(), 0);
+    if (err < 0) {
+        qCDebug(qLcVideoFrameEncoder) << "Error transferring frame data to surface." << err2str(err);
+        return err;
+    }
+    frame = std::move(f);
+    return 0;
+}
+
 int VideoFrameEncoder::sendFrame(AVFrameUPtr frame)
 {
     if (!d->codecContext) {
@@ -237,8 +493,36 @@ int VideoFrameEncoder::sendFrame(AVFrameUPtr frame)
     AVRational timeBase = {};
     getAVFrameTime(*frame, pts, timeBase);
 
-    if (d->downloadFromHW) {
+#if QT_CONFIG(vaapi)
+    if (d->hwProcessor) {
+        int err = transferToHWFrame(d->uploadFramesContext.get(), frame);
+        if (err < 0)
+            return err;
+
         auto f = makeAVFrame();
+        err = av_hwframe_get_buffer(d->accel->hwFramesContextAsBuffer(), f.get(), 0);
+        if (err < 0) {
+            qCDebug(qLcVideoFrameEncoder) << "Error getting HW buffer" << err2str(err);
+            return err;
+        }
+
+        err = d->hwProcessor->process(f.get(), frame.get());
+        if (err < 0) {
+            qCDebug(qLcVideoFrameEncoder) << "Error converting frame on the device" << err2str(err);
+            return err;
+        }
+
+        frame = std::move(f);
+    }
+#endif
+
+    if (d->downloadFromHW) {
+        // av_hwframe_transfer_data allocates the buffers itself if the frame has none,
+        // but pooled buffers avoid a huge allocation per frame
+        auto f = d->downloadFramePool.get(HWAccel::format(frame.get()),
+                                          { frame->width, frame->height });
+        if (!f)
+            f = makeAVFrame();
 
         int err = av_hwframe_transfer_data(f.get(), frame.get(), 0);
         if (err < 0) {
@@ -250,14 +534,11 @@ int VideoFrameEncoder::sendFrame(AVFrameUPtr frame)
     }
 
     if (d->converter) {
-        auto f = makeAVFrame();
-
-        f->format = d->targetSWFormat;
-        f->width = d->settings.videoResolution().width();
-        f->height = d->settings.videoResolution().height();
+        auto f = d->convertedFramePool.get(d->targetSWFormat, d->settings.videoResolution());
+        if (!f)
+            return AVERROR(ENOMEM);
 
-        av_frame_get_buffer(f.get(), 0);
-        const auto scaledHeight = sws_scale(d->converter, frame->data, frame->linesize, 0,
+        const auto scaledHeight = sws_scale(d->converter.get(), frame->data, frame->linesize, 0,
                                             frame->height, f->data, f->linesize);
 
         if (scaledHeight != f->height)
@@ -267,29 +548,9 @@ int VideoFrameEncoder::sendFrame(AVFrameUPtr frame)
     }
 
     if (d->uploadToHW) {
-        auto *hwFramesContext = d->accel->hwFramesContextAsBuffer();
-        Q_ASSERT(hwFramesContext);
-        auto f = makeAVFrame();
-
-        if (!f)
-            return AVERROR(ENOMEM);
-        int err = av_hwframe_get_buffer(hwFramesContext, f.get(), 0);
-        if (err < 0) {
-            qCDebug(qLcVideoFrameEncoder) << "Error getting HW buffer" << err2str(err);
+        int err = transferToHWFrame(d->accel->hwFramesContextAsBuffer(), frame);
+        if (err < 0)
             return err;
-        } else {
-            qCDebug(qLcVideoFrameEncoder) << "got HW buffer";
-        }
-        if (!f->hw_frames_ctx) {
-            qCDebug(qLcVideoFrameEncoder) << "no hw frames context";
-            return AVERROR(ENOMEM);
-        }
-        err = av_hwframe_transfer_data(f.get(), frame.get(), 0);
-        if (err < 0) {
-            qCDebug(qLcVideoFrameEncoder) << "Error transferring frame data to surface." << err2str(err);
-            return err;
-        }
-        frame = std::move(f);
     }
 
     qCDebug(qLcVideoFrameEncoder) << "sending frame" << pts << "*" << timeBase.num << "/"
@@ -320,6 +581,18 @@ AVPacket *VideoFrameEncoder::retrievePacket()
         packet->dts = AV_NOPTS_VALUE;
     }
 
+    // A reopened codec starts decoding before the presentation time of its first
+    // frame when it reorders frames, which would overlap with the packets written
+    // already. Shifting it by that delay keeps the timestamps increasing.
+    if (packet->dts != AV_NOPTS_VALUE) {
+        if (d->lastDts != AV_NOPTS_VALUE && packet->dts + d->timestampOffset <= d->lastDts)
+            d->timestampOffset = d->lastDts + 1 - packet->dts;
+        packet->dts += d->timestampOffset;
+        d->lastDts = packet->dts;
+    }
+    if (packet->pts != AV_NOPTS_VALUE)
+        packet->pts += d->timestampOffset;
+
     packet->stream_index = d->stream->id;
     return packet;
 }
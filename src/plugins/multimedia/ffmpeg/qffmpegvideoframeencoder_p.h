@@ -15,6 +15,10 @@
 //
 
 #include "qffmpeghwaccel_p.h"
+#include "qffmpegframepool_p.h"
+#if QT_CONFIG(vaapi)
+#include "qffmpeghwaccel_vaapi_p.h"
+#endif
 #include "qvideoframeformat.h"
 #include "private/qplatformmediarecorder_p.h"
 
@@ -27,8 +31,6 @@ class VideoFrameEncoder
     class Data final
     {
     public:
-        ~Data();
-
         QAtomicInt ref = 0;
         QMediaEncoderSettings settings;
         float frameRate = 0.;
@@ -38,16 +40,40 @@ class VideoFrameEncoder
         const AVCodec *codec = nullptr;
         AVStream *stream = nullptr;
         AVCodecContextUPtr codecContext;
-        SwsContext *converter = nullptr;
+        // opened with new settings, replaces codecContext once that is drained
+        AVCodecContextUPtr reopenedContext;
+        SwsContextUPtr converter;
+        AVFramePool downloadFramePool;
+        AVFramePool convertedFramePool;
         AVPixelFormat sourceFormat = AV_PIX_FMT_NONE;
         AVPixelFormat sourceSWFormat = AV_PIX_FMT_NONE;
         AVPixelFormat targetFormat = AV_PIX_FMT_NONE;
         AVPixelFormat targetSWFormat = AV_PIX_FMT_NONE;
         bool downloadFromHW = false;
         bool uploadToHW = false;
+
+        // the last decoding timestamp written, and how far the packets of a reopened
+        // codec are shifted to come after it
+        qint64 lastDts = AV_NOPTS_VALUE;
+        qint64 timestampOffset = 0;
+
+        // GPU side conversion: the source is uploaded as is and scaled/converted on the device
+        AVBufferUPtr uploadFramesContext;
+#if QT_CONFIG(vaapi)
+        std::unique_ptr<VAAPIVideoProcessor> hwProcessor;
+#endif
     };
 
     QExplicitlySharedDataPointer<Data> d;
+
+    bool initConversions();
+    bool initHWConversion();
+    void resetCodecAndConversions();
+    bool initCodecContext();
+    bool fallbackToSwEncoder();
+    bool openCodec();
+    bool openCodecContext(AVCodecContext *context);
+    void setRuntimeSettings(const QMediaEncoderSettings &settings);
 public:
     VideoFrameEncoder() = default;
     VideoFrameEncoder(const QMediaEncoderSettings &encoderSettings, const QSize &sourceSize, float frameRate, AVPixelFormat sourceFormat, AVPixelFormat swFormat);
@@ -56,6 +82,15 @@ public:
     void initWithFormatContext(AVFormatContext *formatContext);
     bool open();
 
+    // Applies quality, bit rate and key frame interval changes to the opened codec.
+    // Returns false if the codec has to be drained and reopened to apply them.
+    bool updateSettings(const QMediaEncoderSettings &settings);
+    // Opens a codec with the new settings, which replaces the current one once that
+    // is drained. Returns false, and keeps the settings, if it can't continue the stream.
+    bool prepareReopen(const QMediaEncoderSettings &settings);
+    // Replaces the drained codec with the one opened by prepareReopen()
+    void finishReopen();
+
     bool isNull() const { return !d; }
 
     AVPixelFormat sourceFormat() const { return d ? d->sourceFormat : AV_PIX_FMT_NONE; }
@@ -124,6 +124,7 @@ private slots:
     void captureSecondaryScreen();
     void removeWindowWhileCapture();
     void recordToFile();
+    void changeSettingsWhileRecording();
 
     void removeScreenWhileCapture(); // Keep the test last defined. TODO: find a way to restore
                                      // application screens.
@@ -515,6 +516,74 @@ void tst_QScreenCaptureIntegration::recordToFile()
     QFile(fileName).remove();
 }
 
+void tst_QScreenCaptureIntegration::changeSettingsWhileRecording()
+{
+    auto widget = QTestWidget::createAndShow(Qt::Window | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint,
+                                             QRect{ 200, 100, 430, 351 });
+
+    QScreenCapture sc;
+    QMediaCaptureSession session;
+    QMediaRecorder recorder;
+    session.setScreenCapture(&sc);
+    session.setRecorder(&recorder);
+    QSignalSpy recorderErrors(&recorder, &QMediaRecorder::errorOccurred);
+
+    // H.264 encoders reorder frames by default, so the reopened codec starts
+    // with decoding timestamps before the ones written already
+    QMediaFormat format(QMediaFormat::MPEG4);
+    format.setVideoCodec(QMediaFormat::VideoCodec::H264);
+    recorder.setMediaFormat(format);
+    recorder.setVideoResolution(QSize(640, 480));
+    recorder.setQuality(QMediaRecorder::NormalQuality);
+
+    sc.setActive(true);
+    QTest::qWait(200); // wait a bit for SC threading activating
+
+    recorder.record();
+    QTRY_COMPARE(recorder.recorderState(), QMediaRecorder::RecordingState);
+
+    QTest::qWait(400);
+    // a new key frame interval reopens the codec
+    recorder.setVideoKeyFrameInterval(10);
+    widget->setColors(QColor(0, 0xFF, 0), QColor(0, 0xFF, 0));
+    QTest::qWait(400);
+    recorder.setVideoBitRate(2'000'000);
+    recorder.setQuality(QMediaRecorder::HighQuality);
+    widget->setColors(QColor(0, 0, 0xFF), QColor(0, 0, 0xFF));
+    QTest::qWait(400);
+
+    recorder.stop();
+    QTRY_COMPARE(recorder.recorderState(), QMediaRecorder::StoppedState);
+    QVERIFY2(recorderErrors.empty(), qPrintable(recorder.errorString()));
+
+    const QString fileName = recorder.actualLocation().toLocalFile();
+    QVERIFY(!fileName.isEmpty());
+    const auto removeFile = qScopeGuard([&fileName] { QFile(fileName).remove(); });
+
+    // nothing got lost around the reopened codec
+    QMediaPlayer player;
+    player.setSource(fileName);
+    QTRY_COMPARE(player.mediaStatus(), QMediaPlayer::LoadedMedia);
+    QCOMPARE_GT(player.duration(), 1050);
+    QCOMPARE_LT(player.duration(), 1500);
+
+    TestVideoSink sink;
+    player.setVideoSink(&sink);
+    sink.setStoreImagesEnabled();
+    player.setPlaybackRate(10);
+    player.play();
+    QTRY_COMPARE(player.mediaStatus(), QMediaPlayer::EndOfMedia);
+    QCOMPARE_GT(sink.images().size(), size_t(10));
+
+    // the last frames were encoded by the reopened codec
+    const QSize screenSize = QApplication::primaryScreen()->geometry().size();
+    const QPoint point(415 * 640 / screenSize.width(), 275 * 480 / screenSize.height());
+    const QRgb rgb = sink.images().back().pixel(point);
+    QVERIFY(qRed(rgb) <= 60);
+    QVERIFY(qGreen(rgb) <= 60);
+    QVERIFY(qBlue(rgb) >= 200);
+}
+
 void tst_QScreenCaptureIntegration::removeScreenWhileCapture()
 {
     QSKIP("TODO: find a reliable way to emulate it");
@@ -38,6 +38,8 @@ private slots:
     void testSupportedMimeTypes_data();
     void testSupportedMimeTypes();
     void testCorruptFile();
+    void testOverlappingEffects();
+    void testMaxVoices();
 
 private:
     QSoundEffect* sound;
@@ -393,6 +395,70 @@ void tst_QSoundEffect::testCorruptFile()
     }
 }
 
+void tst_QSoundEffect::testOverlappingEffects()
+{
+    // the effects are mixed into the same output, with different formats
+    QSoundEffect first;
+    first.setSource(url);
+    first.setVolume(0.1f);
+    QSoundEffect second;
+    second.setSource(url2);
+    second.setVolume(0.1f);
+    second.setLoopCount(2);
+    QTRY_COMPARE(first.status(), QSoundEffect::Ready);
+    QTRY_COMPARE(second.status(), QSoundEffect::Ready);
+
+    first.play();
+    second.play();
+    QVERIFY(first.isPlaying());
+    QVERIFY(second.isPlaying());
+
+    // stopping one of them doesn't affect the other
+    first.stop();
+    QVERIFY(!first.isPlaying());
+    QVERIFY(second.isPlaying());
+    QCOMPARE(second.loopsRemaining(), 2);
+
+    first.play();
+    QTRY_VERIFY(!first.isPlaying());
+    QTRY_VERIFY(!second.isPlaying());
+    QCOMPARE(first.loopsRemaining(), 0);
+    QCOMPARE(second.loopsRemaining(), 0);
+}
+
+void tst_QSoundEffect::testMaxVoices()
+{
+    QSoundEffect effect;
+    QCOMPARE(effect.maxVoices(), 1);
+
+    QSignalSpy maxVoicesSpy(&effect, &QSoundEffect::maxVoicesChanged);
+    QTest::ignoreMessage(QtWarningMsg, "SoundEffect: maxVoices should be a positive integer");
+    effect.setMaxVoices(0);
+    QCOMPARE(effect.maxVoices(), 1);
+    effect.setMaxVoices(3);
+    QCOMPARE(effect.maxVoices(), 3);
+    QCOMPARE(maxVoicesSpy.size(), 1);
+
+    effect.setSource(url);
+    effect.setVolume(0.1f);
+    QTRY_COMPARE(effect.status(), QSoundEffect::Ready);
+
+    QSignalSpy playingSpy(&effect, &QSoundEffect::playingChanged);
+    // more triggers than voices, the oldest ones get replaced
+    for (int i = 0; i < 5; ++i) {
+        effect.play();
+        QVERIFY(effect.isPlaying());
+    }
+    QCOMPARE(playingSpy.size(), 1);
+
+    effect.setMaxVoices(1);
+    QVERIFY(effect.isPlaying());
+
+    QTRY_VERIFY(!effect.isPlaying());
+    QCOMPARE(playingSpy.size(), 2);
+    QCOMPARE(effect.loopsRemaining(), 0);
+}
+
 QTEST_MAIN(tst_QSoundEffect)
 
 #include "tst_qsoundeffect.moc"
@@ -56,6 +56,12 @@ public:
         emit actualLocationChanged(actualLocation);
     }
 
+    void updateEncoderSettings(const QMediaEncoderSettings &settings) override
+    {
+        m_settings = settings;
+        ++m_settingsUpdates;
+    }
+
     void pause() override
     {
         m_state = QMediaRecorder::PausedState;
@@ -79,6 +85,7 @@ public:
     {
         m_state = QMediaRecorder::StoppedState;
         m_settings = QMediaEncoderSettings();
+        m_settingsUpdates = 0;
         m_position = 0;
         emit stateChanged(m_state);
         emit durationChanged(m_position);
@@ -89,6 +96,7 @@ public:
     QMediaMetaData m_metaData;
     QMediaRecorder::RecorderState m_state;
     QMediaEncoderSettings m_settings;
+    int m_settingsUpdates = 0;
     qint64     m_position;
 };
 
@@ -23,6 +23,9 @@ private Q_SLOTS:
     void durations();
     void durations_data();
     void stereoSample();
+    void externalData();
+    void externalDataDetach();
+    void externalDataInvalid();
 
 private:
     QAudioFormat mFormat;
@@ -308,6 +311,65 @@ void tst_QAudioBuffer::stereoSample()
     QCOMPARE(f32s[QAudioFormat::FrontRight], 0.0f);
 }
 
+static void countCleanup(void *info)
+{
+    ++*static_cast<int *>(info);
+}
+
+void tst_QAudioBuffer::externalData()
+{
+    const QList<qint16> samples(1000, 1234);
+    int cleanups = 0;
+    {
+        QAudioBuffer buffer(samples.constData(), samples.size() * sizeof(qint16), mFormat, 100,
+                            countCleanup, &cleanups);
+        QVERIFY(buffer.isValid());
+        QCOMPARE(buffer.frameCount(), 500);
+        QCOMPARE(buffer.startTime(), 100LL);
+        // the samples aren't copied
+        QCOMPARE(buffer.constData<qint16>(), samples.constData());
+
+        const QAudioBuffer copy = buffer;
+        buffer = {};
+        QCOMPARE(cleanups, 0);
+        QCOMPARE(copy.constData<qint16>(), samples.constData());
+    }
+    QCOMPARE(cleanups, 1);
+}
+
+void tst_QAudioBuffer::externalDataDetach()
+{
+    const QList<qint16> samples(1000, 1234);
+    int cleanups = 0;
+    QAudioBuffer buffer(samples.constData(), samples.size() * sizeof(qint16), mFormat, -1,
+                        countCleanup, &cleanups);
+    QAudioBuffer copy = buffer;
+
+    copy.detach();
+    QVERIFY(copy.constData<qint16>() != samples.constData());
+    QCOMPARE(copy.constData<qint16>()[999], 1234);
+
+    // writing doesn't touch the external memory
+    buffer.data<qint16>()[0] = 42;
+    QCOMPARE(samples[0], 1234);
+    QCOMPARE(buffer.constData<qint16>()[0], 42);
+
+    buffer = {};
+    QCOMPARE(cleanups, 1);
+    copy = {};
+    QCOMPARE(cleanups, 1);
+}
+
+void tst_QAudioBuffer::externalDataInvalid()
+{
+    const QList<qint16> samples(1000, 1234);
+    int cleanups = 0;
+    QAudioBuffer buffer(samples.constData(), samples.size() * sizeof(qint16), QAudioFormat(), -1,
+                        countCleanup, &cleanups);
+    QVERIFY(!buffer.isValid());
+    // the memory is released right away
+    QCOMPARE(cleanups, 1);
+}
 
 QTEST_APPLESS_MAIN(tst_QAudioBuffer);
 
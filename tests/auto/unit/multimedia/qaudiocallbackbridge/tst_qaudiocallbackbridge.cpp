@@ -0,0 +1,153 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <private/qaudiocallbackbridge_p.h>
+
+class tst_QAudioCallbackBridge : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rendersAhead();
+    void partialPeriods();
+    void readyRead();
+    void stopWhileRendering();
+    void stopWhenFull();
+
+private:
+    static QAudioFormat format(QAudioFormat::SampleFormat sampleFormat)
+    {
+        QAudioFormat format;
+        format.setSampleFormat(sampleFormat);
+        format.setChannelCount(2);
+        format.setSampleRate(48000);
+        return format;
+    }
+};
+
+void tst_QAudioCallbackBridge::rendersAhead()
+{
+    const QAudioFormat format = this->format(QAudioFormat::Int16);
+
+    QAtomicInteger<bool> calledOnOtherThread = true;
+    QThread *testThread = QThread::currentThread();
+    QAudioCallbackBridge bridge(format, 480, 4800, [&](float *data, qsizetype frames) {
+        if (QThread::currentThread() == testThread)
+            calledOnOtherThread = false;
+        std::fill(data, data + frames * 2, 0.5f);
+    });
+    QCOMPARE(bridge.frames(), qsizetype(480));
+    QVERIFY(bridge.isOpen());
+    QVERIFY(!bridge.atEnd());
+
+    // the bridge renders ahead, up to the size of its buffer
+    QTRY_COMPARE(bridge.bytesAvailable(), qint64(4800 * format.bytesPerFrame()));
+
+    QByteArray data(1000 * format.bytesPerFrame() + 1, 0);
+    QCOMPARE(bridge.read(data.data(), data.size()), qint64(1000 * format.bytesPerFrame()));
+    const qint16 *samples = reinterpret_cast<const qint16 *>(data.constData());
+    for (int i = 0; i < 2000; ++i)
+        QCOMPARE(samples[i], qint16(16384));
+
+    // and renders more as soon as there is room for it
+    QTRY_VERIFY(bridge.bytesAvailable() > (4800 - 1000 + 480) * format.bytesPerFrame());
+    QVERIFY(calledOnOtherThread);
+}
+
+void tst_QAudioCallbackBridge::partialPeriods()
+{
+    const QAudioFormat format = this->format(QAudioFormat::Float);
+
+    // every frame holds its index, so that gaps and repeats show up
+    int next = 0;
+    QAudioCallbackBridge bridge(format, 480, 1920, [&](float *data, qsizetype frames) {
+        for (qsizetype i = 0; i < frames; ++i, ++next)
+            data[2 * i] = data[2 * i + 1] = float(next);
+    });
+
+    // reads that split periods, and frames, only return whole frames
+    int expected = 0;
+    std::vector<float> samples(2 * 333);
+    while (expected < 10 * 480) {
+        QTRY_VERIFY(bridge.bytesAvailable() >= 333 * format.bytesPerFrame());
+        const qint64 read = bridge.read(reinterpret_cast<char *>(samples.data()),
+                                        333 * format.bytesPerFrame() - 1);
+        QCOMPARE(read, qint64(332 * format.bytesPerFrame()));
+        for (qsizetype i = 0; i < 2 * 332; ++i)
+            QCOMPARE(samples[i], float(expected + i / 2));
+        expected += 332;
+    }
+}
+
+void tst_QAudioCallbackBridge::readyRead()
+{
+    const QAudioFormat format = this->format(QAudioFormat::Int16);
+
+    QAudioCallbackBridge bridge(format, 480, 960, [](float *data, qsizetype frames) {
+        std::fill(data, data + frames * 2, 0.f);
+    });
+    // emitted on the rendering thread, and delivered to the thread of the sink
+    int readyReads = 0;
+    connect(&bridge, &QIODevice::readyRead, this, [&] {
+        QCOMPARE(QThread::currentThread(), thread());
+        ++readyReads;
+    });
+
+    // the first period tells the sink that there's data
+    QTRY_COMPARE(readyReads, 1);
+    QTRY_COMPARE(bridge.bytesAvailable(), qint64(960 * format.bytesPerFrame()));
+
+    // reading what is there without running out doesn't need another one
+    QByteArray data(960 * format.bytesPerFrame(), 0);
+    QCOMPARE(bridge.read(data.data(), 480 * format.bytesPerFrame()),
+             qint64(480 * format.bytesPerFrame()));
+    QTRY_COMPARE(bridge.bytesAvailable(), qint64(960 * format.bytesPerFrame()));
+    QCOMPARE(readyReads, 1);
+
+    // but a sink that ran out waits for it
+    QCOMPARE(bridge.read(data.data(), data.size()), qint64(data.size()));
+    QTRY_COMPARE(readyReads, 2);
+}
+
+void tst_QAudioCallbackBridge::stopWhileRendering()
+{
+    const QAudioFormat format = this->format(QAudioFormat::Float);
+
+    QSemaphore rendering;
+    QAtomicInteger<int> calls = 0;
+    auto bridge = std::make_unique<QAudioCallbackBridge>(
+            format, 480, 960, [&](float *data, qsizetype frames) {
+                std::fill(data, data + frames * 2, 0.f);
+                if (calls.fetchAndAddRelaxed(1) == 0) {
+                    rendering.release();
+                    QThread::msleep(100);
+                }
+            });
+
+    // destroying the bridge waits for the callback to return, and then stops calling it
+    rendering.acquire();
+    bridge.reset();
+    QCOMPARE(calls.loadRelaxed(), 1);
+}
+
+void tst_QAudioCallbackBridge::stopWhenFull()
+{
+    const QAudioFormat format = this->format(QAudioFormat::Float);
+
+    QAtomicInteger<int> calls = 0;
+    auto bridge = std::make_unique<QAudioCallbackBridge>(
+            format, 480, 960, [&](float *data, qsizetype frames) {
+                std::fill(data, data + frames * 2, 0.f);
+                calls.fetchAndAddRelaxed(1);
+            });
+
+    // the rendering thread waits for room, and is woken up to stop
+    QTRY_COMPARE(bridge->bytesAvailable(), qint64(960 * format.bytesPerFrame()));
+    bridge.reset();
+    QCOMPARE(calls.loadRelaxed(), 2);
+}
+
+QTEST_MAIN(tst_QAudioCallbackBridge)
+
+#include "tst_qaudiocallbackbridge.moc"
@@ -0,0 +1,224 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <private/qaudioconverter_p.h>
+
+#include <cmath>
+
+class tst_QAudioConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void invalidFormats();
+    void sampleFormat();
+    void channelMatrix_data();
+    void channelMatrix();
+    void mixChannels();
+    void resample_data();
+    void resample();
+    void resampleRemovesAliases();
+    void convertBuffer();
+};
+
+static QAudioFormat format(QAudioFormat::SampleFormat sampleFormat, int channels, int sampleRate = 48000)
+{
+    QAudioFormat format;
+    format.setSampleFormat(sampleFormat);
+    format.setChannelCount(channels);
+    format.setSampleRate(sampleRate);
+    return format;
+}
+
+static QAudioFormat format(QAudioFormat::ChannelConfig config)
+{
+    QAudioFormat format;
+    format.setSampleFormat(QAudioFormat::Float);
+    format.setChannelConfig(config);
+    format.setSampleRate(48000);
+    return format;
+}
+
+static QByteArray sine(const QAudioFormat &format, int frequency, int frames)
+{
+    QList<float> samples(frames * format.channelCount());
+    for (int frame = 0; frame < frames; ++frame) {
+        const float value = 0.5f * std::sin(2 * M_PI * frequency * frame / format.sampleRate());
+        for (int channel = 0; channel < format.channelCount(); ++channel)
+            samples[frame * format.channelCount() + channel] = value;
+    }
+    return QByteArray(reinterpret_cast<const char *>(samples.constData()), samples.size() * sizeof(float));
+}
+
+static const float *floatData(const QByteArray &data)
+{
+    return reinterpret_cast<const float *>(data.constData());
+}
+
+void tst_QAudioConverter::invalidFormats()
+{
+    QAudioConverter converter(QAudioFormat(), format(QAudioFormat::Float, 2));
+    QVERIFY(!converter.isValid());
+    QVERIFY(converter.convert("abcd", 4).isEmpty());
+}
+
+void tst_QAudioConverter::sampleFormat()
+{
+    const QList<qint16> samples = { 0, 32767, -32767, 16384, -16384, 1, 2, 3, 4, 5, 6 };
+    const QByteArray data(reinterpret_cast<const char *>(samples.constData()), samples.size() * sizeof(qint16));
+
+    QAudioConverter toFloat(format(QAudioFormat::Int16, 1), format(QAudioFormat::Float, 1));
+    const QByteArray floats = toFloat.convert(data.constData(), data.size());
+    QCOMPARE(floats.size(), samples.size() * qsizetype(sizeof(float)));
+    for (int i = 0; i < samples.size(); ++i)
+        QCOMPARE(floatData(floats)[i], samples[i] / 32767.f);
+
+    QAudioConverter toInt16(format(QAudioFormat::Float, 1), format(QAudioFormat::Int16, 1));
+    QCOMPARE(toInt16.convert(floats.constData(), floats.size()), data);
+
+    QAudioConverter toUInt8(format(QAudioFormat::Int16, 1), format(QAudioFormat::UInt8, 1));
+    const QByteArray bytes = toUInt8.convert(data.constData(), data.size());
+    QCOMPARE(bytes.size(), samples.size());
+    QCOMPARE(quint8(bytes[0]), 128);
+    QCOMPARE(quint8(bytes[1]), 255);
+    QCOMPARE(quint8(bytes[2]), 1);
+}
+
+void tst_QAudioConverter::channelMatrix_data()
+{
+    QTest::addColumn<QAudioFormat>("from");
+    QTest::addColumn<QAudioFormat>("to");
+    QTest::addColumn<QList<float>>("matrix");
+
+    const float half = 0.5f;
+    QTest::newRow("mono to stereo")
+            << format(QAudioFormat::ChannelConfigMono) << format(QAudioFormat::ChannelConfigStereo)
+            << QList<float>{ 1.f, 1.f };
+    QTest::newRow("stereo to mono")
+            << format(QAudioFormat::ChannelConfigStereo) << format(QAudioFormat::ChannelConfigMono)
+            << QList<float>{ half, half };
+    QTest::newRow("stereo to 5.1")
+            << format(QAudioFormat::ChannelConfigStereo) << format(QAudioFormat::ChannelConfigSurround5Dot1)
+            << QList<float>{ 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
+    // the back channels play on the sides when there are no back speakers
+    QTest::newRow("5.0 to side surround")
+            << format(QAudioFormat::ChannelConfigSurround5Dot0)
+            << format(QAudioFormat::channelConfig(QAudioFormat::FrontLeft, QAudioFormat::FrontRight,
+                                                  QAudioFormat::FrontCenter, QAudioFormat::SideLeft,
+                                                  QAudioFormat::SideRight))
+            << QList<float>{ 1.f, 0.f, 0.f, 0.f, 0.f,
+                             0.f, 1.f, 0.f, 0.f, 0.f,
+                             0.f, 0.f, 1.f, 0.f, 0.f,
+                             0.f, 0.f, 0.f, 1.f, 0.f,
+                             0.f, 0.f, 0.f, 0.f, 1.f };
+}
+
+void tst_QAudioConverter::channelMatrix()
+{
+    QFETCH(QAudioFormat, from);
+    QFETCH(QAudioFormat, to);
+    QFETCH(QList<float>, matrix);
+
+    QCOMPARE(QAudioConverter::channelMatrix(from, to), matrix);
+}
+
+void tst_QAudioConverter::mixChannels()
+{
+    // 5.1 to stereo keeps every output from clipping, and drops the LFE
+    const QList<float> matrix = QAudioConverter::channelMatrix(
+            format(QAudioFormat::ChannelConfigSurround5Dot1), format(QAudioFormat::ChannelConfigStereo));
+    QCOMPARE(matrix.size(), 12);
+    for (int output = 0; output < 2; ++output) {
+        float sum = 0.f;
+        for (int input = 0; input < 6; ++input)
+            sum += matrix[output * 6 + input];
+        QVERIFY(sum <= 1.f + 1e-6f);
+        QCOMPARE(matrix[output * 6 + 3], 0.f);
+    }
+
+    QAudioConverter converter(format(QAudioFormat::ChannelConfigStereo),
+                              format(QAudioFormat::ChannelConfigMono));
+    const QList<float> stereo = { 1.f, 0.f, 0.5f, 0.5f, -1.f, 1.f };
+    const QByteArray mono = converter.convert(reinterpret_cast<const char *>(stereo.constData()),
+                                              stereo.size() * sizeof(float));
+    QCOMPARE(mono.size(), 3 * qsizetype(sizeof(float)));
+    QCOMPARE(floatData(mono)[0], 0.5f);
+    QCOMPARE(floatData(mono)[1], 0.5f);
+    QCOMPARE(floatData(mono)[2], 0.f);
+}
+
+void tst_QAudioConverter::resample_data()
+{
+    QTest::addColumn<int>("inputRate");
+    QTest::addColumn<int>("outputRate");
+    QTest::addColumn<int>("channels");
+
+    QTest::newRow("44100 to 48000") << 44100 << 48000 << 2;
+    QTest::newRow("48000 to 44100") << 48000 << 44100 << 2;
+    QTest::newRow("8000 to 48000") << 8000 << 48000 << 1;
+    QTest::newRow("96000 to 22050") << 96000 << 22050 << 1;
+    // needs more phases than the filter table has
+    QTest::newRow("44101 to 48000") << 44101 << 48000 << 3;
+}
+
+void tst_QAudioConverter::resample()
+{
+    QFETCH(int, inputRate);
+    QFETCH(int, outputRate);
+    QFETCH(int, channels);
+
+    const QAudioFormat input = format(QAudioFormat::Float, channels, inputRate);
+    const QAudioFormat output = format(QAudioFormat::Float, channels, outputRate);
+    QAudioConverter converter(input, output);
+
+    // a second of a 1 kHz tone, in chunks that don't line up with anything
+    const QByteArray data = sine(input, 1000, inputRate);
+    const qsizetype chunk = 997 * input.bytesPerFrame();
+    QByteArray result;
+    for (qsizetype offset = 0; offset < data.size(); offset += chunk)
+        result += converter.convert(data.constData() + offset, qMin(chunk, data.size() - offset));
+    result += converter.flush();
+
+    const qsizetype frames = result.size() / output.bytesPerFrame();
+    QVERIFY2(qAbs(frames - outputRate) <= 2, qPrintable(QString::number(frames)));
+
+    // away from the edges, the output is the same tone without any delay
+    const QByteArray expected = sine(output, 1000, outputRate);
+    for (qsizetype i = 100 * channels; i < (frames - 100) * channels; ++i)
+        QVERIFY2(qAbs(floatData(result)[i] - floatData(expected)[i]) < 1e-3f, qPrintable(QString::number(i)));
+}
+
+void tst_QAudioConverter::resampleRemovesAliases()
+{
+    // 6 kHz is above the Nyquist frequency of 8 kHz
+    const QAudioFormat input = format(QAudioFormat::Float, 1, 48000);
+    QAudioConverter converter(input, format(QAudioFormat::Float, 1, 8000));
+    const QByteArray data = sine(input, 6000, 48000);
+    const QByteArray result = converter.convert(data.constData(), data.size());
+
+    QVERIFY(result.size() > 0);
+    for (qsizetype i = 100; i < result.size() / qsizetype(sizeof(float)); ++i)
+        QVERIFY(qAbs(floatData(result)[i]) < 1e-3f);
+}
+
+void tst_QAudioConverter::convertBuffer()
+{
+    const QAudioFormat input = format(QAudioFormat::Int16, 2, 44100);
+    const QAudioFormat output = format(QAudioFormat::Float, 1, 48000);
+    QAudioConverter converter(input, output);
+
+    const QAudioBuffer buffer(4410, input, 1000);
+    const QAudioBuffer converted = converter.convert(buffer);
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.format(), output);
+    QCOMPARE(converted.startTime(), qint64(1000));
+    QVERIFY(qAbs(converted.frameCount() - 4800) < 64);
+
+    // buffers in other formats aren't converted
+    QVERIFY(!converter.convert(QAudioBuffer(100, output)).isValid());
+}
+
+QTEST_MAIN(tst_QAudioConverter)
+
+#include "tst_qaudioconverter.moc"
@@ -0,0 +1,230 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <private/qaudiohelpers_p.h>
+
+#include <limits>
+
+using namespace QAudioHelperInternal;
+
+class tst_QAudioHelpers : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void multiplySamples_data();
+    void multiplySamples();
+    void multiplySamplesClipsInt16();
+    void multiplySamplesUInt8();
+    void multiplySamplesRoundsLikeQRound();
+    void multiplySamplesRamped();
+    void mixSamplesClipsInt16();
+    void mixSamplesToFloat();
+    void convertSamplesFromFloat();
+    void measureSamples_data();
+    void measureSamples();
+    void measureSamplesWithoutFrames();
+};
+
+// Spread over the whole range of qint16
+static QList<qint16> int16Samples(int count)
+{
+    QList<qint16> samples(count);
+    for (int i = 0; i < count; ++i)
+        samples[i] = qint16((i * 7919) % 65536 - 32768);
+    return samples;
+}
+
+static QAudioFormat format(QAudioFormat::SampleFormat sampleFormat, int channels = 1)
+{
+    QAudioFormat format;
+    format.setSampleFormat(sampleFormat);
+    format.setChannelCount(channels);
+    format.setSampleRate(48000);
+    return format;
+}
+
+void tst_QAudioHelpers::multiplySamples_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<qreal>("factor");
+
+    // odd sizes, so that the vectorized kernels also have a tail to process
+    for (int count : { 1, 15, 37, 1031 }) {
+        QTest::addRow("%d samples, 0", count) << count << 0.;
+        QTest::addRow("%d samples, 0.5", count) << count << 0.5;
+        QTest::addRow("%d samples, 1", count) << count << 1.;
+    }
+}
+
+void tst_QAudioHelpers::multiplySamples()
+{
+    QFETCH(int, count);
+    QFETCH(qreal, factor);
+
+    const QList<qint16> source = int16Samples(count);
+    QList<qint16> result(count);
+    qMultiplySamples(factor, format(QAudioFormat::Int16), source.constData(), result.data(),
+                     count * sizeof(qint16));
+    for (int i = 0; i < count; ++i)
+        QVERIFY2(qAbs(result[i] - source[i] * factor) <= 1., qPrintable(QString::number(i)));
+
+    QList<float> floatSource(count);
+    for (int i = 0; i < count; ++i)
+        floatSource[i] = source[i] / 32768.f;
+    QList<float> floatResult(count);
+    qMultiplySamples(factor, format(QAudioFormat::Float), floatSource.constData(), floatResult.data(),
+                     count * sizeof(float));
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(floatResult[i], float(floatSource[i] * float(factor)));
+}
+
+void tst_QAudioHelpers::multiplySamplesClipsInt16()
+{
+    const QList<qint16> source = int16Samples(37);
+    QList<qint16> result(source.size());
+    qMultiplySamples(4., format(QAudioFormat::Int16), source.constData(), result.data(),
+                     source.size() * sizeof(qint16));
+    for (int i = 0; i < source.size(); ++i) {
+        const qreal expected = qBound(-32768., source[i] * 4., 32767.);
+        QVERIFY2(qAbs(result[i] - expected) <= 1., qPrintable(QString::number(i)));
+    }
+}
+
+void tst_QAudioHelpers::multiplySamplesUInt8()
+{
+    const QList<quint8> source = { 0, 64, 128, 192, 255 };
+    QList<quint8> result(source.size());
+    qMultiplySamples(0.5, format(QAudioFormat::UInt8), source.constData(), result.data(), source.size());
+    QCOMPARE(result, QList<quint8>({ 64, 96, 128, 160, 192 }));
+
+    // clipped to the range of the format
+    qMultiplySamples(4., format(QAudioFormat::UInt8), source.constData(), result.data(), source.size());
+    QCOMPARE(result, QList<quint8>({ 0, 0, 128, 255, 255 }));
+}
+
+void tst_QAudioHelpers::multiplySamplesRoundsLikeQRound()
+{
+    // odd samples halved end in .5, the vectorized kernels and the loop for the rest
+    // must agree on rounding them away from zero
+    QList<qint16> source(37);
+    for (int i = 0; i < source.size(); ++i)
+        source[i] = qint16((i % 2 ? 1 : -1) * (2 * i + 1));
+    QList<qint16> result(source.size());
+    qMultiplySamples(0.5, format(QAudioFormat::Int16), source.constData(), result.data(),
+                     source.size() * sizeof(qint16));
+    for (int i = 0; i < source.size(); ++i)
+        QCOMPARE(result[i], qint16(qRound(source[i] * 0.5f)));
+
+    // and so do the ones for mixing, where the halves are added to whole numbers
+    const QList<qint16> halved = result;
+    qMixSamples(0.5, format(QAudioFormat::Int16), source.constData(), result.data(),
+                source.size() * sizeof(qint16));
+    for (int i = 0; i < source.size(); ++i)
+        QCOMPARE(result[i], qint16(qRound(halved[i] + source[i] * 0.5f)));
+}
+
+void tst_QAudioHelpers::multiplySamplesRamped()
+{
+    const int frames = 100;
+    const QList<qint16> source(frames * 2, 10000);
+    QList<qint16> result(source.size());
+    qMultiplySamples(0., 1., format(QAudioFormat::Int16, 2), source.constData(), result.data(),
+                     source.size() * sizeof(qint16));
+
+    QCOMPARE(result[0], qint16(0));
+    for (int frame = 0; frame < frames; ++frame) {
+        // both channels of a frame get the same factor
+        QCOMPARE(result[frame * 2], result[frame * 2 + 1]);
+        if (frame > 0)
+            QCOMPARE_GT(result[frame * 2], result[frame * 2 - 2]);
+    }
+    QCOMPARE(result[frames * 2 - 2], qint16(9900));
+}
+
+void tst_QAudioHelpers::mixSamplesClipsInt16()
+{
+    const QList<qint16> source = int16Samples(37);
+    QList<qint16> result = source;
+    qMixSamples(1., format(QAudioFormat::Int16), source.constData(), result.data(),
+                source.size() * sizeof(qint16));
+    for (int i = 0; i < source.size(); ++i)
+        QCOMPARE(result[i], qint16(qBound(-32768, source[i] * 2, 32767)));
+}
+
+void tst_QAudioHelpers::mixSamplesToFloat()
+{
+    const QList<qint16> source = int16Samples(37);
+    QList<float> result(source.size(), 0.25f);
+    qMixSamplesToFloat(0.5f, format(QAudioFormat::Int16), source.constData(), result.data(),
+                       source.size() * sizeof(qint16));
+    for (int i = 0; i < source.size(); ++i)
+        QVERIFY(qAbs(result[i] - (0.25f + source[i] * 0.5f / 32767.f)) < 1e-5f);
+}
+
+void tst_QAudioHelpers::convertSamplesFromFloat()
+{
+    const QList<float> source = { -2.f, -1.f, -0.5f, 0.f, 0.5f, 1.f, 2.f, 0.25f, -0.25f, 0.75f, 0.1f };
+    QList<qint16> result(source.size());
+    qConvertSamplesFromFloat(source.constData(), format(QAudioFormat::Int16), result.data(), source.size());
+    QCOMPARE(result, QList<qint16>({ -32767, -32767, -16384, 0, 16384, 32767, 32767, 8192, -8192,
+                                     24575, 3277 }));
+}
+
+void tst_QAudioHelpers::measureSamples_data()
+{
+    QTest::addColumn<int>("channels");
+
+    // the vector code has its own path for every channel count up to 8
+    for (int channels : { 1, 2, 3, 4, 5, 6, 7, 8, 12, 13 })
+        QTest::addRow("%d channels", channels) << channels;
+}
+
+void tst_QAudioHelpers::measureSamples()
+{
+    QFETCH(int, channels);
+
+    // not a multiple of any vector size, so that the loop for the rest is covered too
+    constexpr int frames = 203;
+    QList<float> source(frames * channels);
+    for (int i = 0; i < source.size(); ++i)
+        source[i] = ((i * 7919) % 2001 - 1000) / 1000.f;
+
+    // accumulates into what is there
+    QList<float> peak(channels, 0.5f);
+    QList<float> sumOfSquares(channels, 1.f);
+    qMeasureSamples(source.constData(), channels, frames, peak.data(), sumOfSquares.data());
+
+    for (int c = 0; c < channels; ++c) {
+        float expectedPeak = 0.5f;
+        float expectedSum = 1.f;
+        for (int frame = 0; frame < frames; ++frame) {
+            const float sample = source[frame * channels + c];
+            expectedPeak = qMax(expectedPeak, qAbs(sample));
+            expectedSum += sample * sample;
+        }
+        QCOMPARE(peak[c], expectedPeak);
+        QVERIFY(qAbs(sumOfSquares[c] - expectedSum) < 1e-4f * expectedSum);
+    }
+}
+
+void tst_QAudioHelpers::measureSamplesWithoutFrames()
+{
+    const float source[] = { 1.f, -1.f };
+    float peak[2] = { 0.5f, 0.5f };
+    float sumOfSquares[2] = { 1.f, 1.f };
+
+    // nothing to measure, and nothing to loop over
+    qMeasureSamples(source, 0, 1, peak, sumOfSquares);
+    qMeasureSamples(source, 2, 0, peak, sumOfSquares);
+    qMeasureSamples(source, -1, 1, peak, sumOfSquares);
+    QCOMPARE(peak[0], 0.5f);
+    QCOMPARE(peak[1], 0.5f);
+    QCOMPARE(sumOfSquares[0], 1.f);
+    QCOMPARE(sumOfSquares[1], 1.f);
+}
+
+QTEST_MAIN(tst_QAudioHelpers)
+
+#include "tst_qaudiohelpers.moc"
@@ -0,0 +1,254 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <private/qaudiolevelmeter_p.h>
+#include <private/qplatformaudiooutput_p.h>
+#include <qaudiooutput.h>
+
+#include "qmockintegration.h"
+
+#include <cmath>
+
+class tst_QAudioLevelMeter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void disabledByDefault();
+    void levels();
+    void blocksOfTheInterval();
+    void spectrum_data();
+    void spectrum();
+    void reset();
+    void settings();
+    void audioOutput();
+
+private:
+    QMockIntegration mockIntegration;
+};
+
+static QAudioFormat format(QAudioFormat::SampleFormat sampleFormat, int channels, int sampleRate = 48000)
+{
+    QAudioFormat format;
+    format.setSampleFormat(sampleFormat);
+    format.setChannelCount(channels);
+    format.setSampleRate(sampleRate);
+    return format;
+}
+
+// A sine wave on the first channel, the others are silent
+static QList<float> sine(int channels, int frequency, float amplitude, int frames, int sampleRate = 48000)
+{
+    QList<float> samples(frames * channels, 0.f);
+    for (int frame = 0; frame < frames; ++frame)
+        samples[frame * channels] = amplitude * std::sin(2 * M_PI * frequency * frame / sampleRate);
+    return samples;
+}
+
+static void process(QAudioLevelMeter &meter, const QAudioFormat &format, const QList<float> &samples)
+{
+    meter.process(format, samples.constData(), samples.size() * sizeof(float));
+}
+
+void tst_QAudioLevelMeter::disabledByDefault()
+{
+    QAudioLevelMeter meter;
+    QVERIFY(!meter.isEnabled());
+    QCOMPARE(meter.interval(), QAudioLevelMeter::DefaultInterval);
+    QCOMPARE(meter.bandCount(), 0);
+
+    process(meter, format(QAudioFormat::Float, 1), sine(1, 1000, 1.f, 48000));
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(!meter.takeLevels(&levels));
+}
+
+void tst_QAudioLevelMeter::levels()
+{
+    QAudioLevelMeter meter;
+    meter.setEnabled(true);
+
+    // 1 kHz at half scale on the left, silence on the right
+    const QList<float> samples = sine(2, 1000, 0.5f, 2400);
+    QList<qint16> int16Samples(samples.size());
+    for (int i = 0; i < samples.size(); ++i)
+        int16Samples[i] = qint16(qRound(samples[i] * 32767));
+    meter.process(format(QAudioFormat::Int16, 2), int16Samples.constData(),
+                  int16Samples.size() * sizeof(qint16));
+
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.peak.size(), 2);
+    QCOMPARE(levels.rms.size(), 2);
+    QVERIFY(levels.spectrum.isEmpty());
+    QVERIFY(qAbs(levels.peak[0] - 0.5f) < 1e-3f);
+    QVERIFY(qAbs(levels.rms[0] - 0.5f / std::sqrt(2.f)) < 1e-3f);
+    QCOMPARE(levels.peak[1], 0.f);
+    QCOMPARE(levels.rms[1], 0.f);
+
+    // every block is only taken once
+    QVERIFY(!meter.takeLevels(&levels));
+}
+
+void tst_QAudioLevelMeter::blocksOfTheInterval()
+{
+    QAudioLevelMeter meter;
+    meter.setEnabled(true);
+    meter.setInterval(20);
+    const QAudioFormat format = ::format(QAudioFormat::Float, 1);
+
+    // a block takes 20 ms, 960 frames
+    QList<float> samples(959, 0.25f);
+    process(meter, format, samples);
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(!meter.takeLevels(&levels));
+
+    // the loud frames are in the next block, which isn't complete
+    samples = { 0.25f, 1.f, 1.f };
+    process(meter, format, samples);
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.peak[0], 0.25f);
+    QVERIFY(qAbs(levels.rms[0] - 0.25f) < 1e-6f);
+}
+
+void tst_QAudioLevelMeter::spectrum_data()
+{
+    QTest::addColumn<int>("sampleRate");
+    QTest::addColumn<int>("frequency");
+
+    // below a few hundred Hz, bands are narrower than a bin and get pushed up
+    QTest::newRow("500 Hz") << 48000 << 500;
+    QTest::newRow("1 kHz") << 48000 << 1000;
+    QTest::newRow("5 kHz at 44.1 kHz") << 44100 << 5000;
+    QTest::newRow("15 kHz") << 48000 << 15000;
+}
+
+void tst_QAudioLevelMeter::spectrum()
+{
+    QFETCH(int, sampleRate);
+    QFETCH(int, frequency);
+
+    constexpr int bands = 32;
+    QAudioLevelMeter meter;
+    meter.setEnabled(true);
+    meter.setBandCount(bands);
+    process(meter, format(QAudioFormat::Float, 1, sampleRate),
+            sine(1, frequency, 1.f, sampleRate / 10, sampleRate));
+
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.spectrum.size(), bands);
+
+    // the tone shows up in its band, the bands are spaced logarithmically
+    const float octaves = std::log2(sampleRate / 2.f / QAudioLevelMeter::LowestFrequency);
+    const int expectedBand = int(std::log2(frequency / QAudioLevelMeter::LowestFrequency) / octaves * bands);
+    const auto loudest = std::max_element(levels.spectrum.cbegin(), levels.spectrum.cend());
+    QVERIFY(qAbs(int(loudest - levels.spectrum.cbegin()) - expectedBand) <= 1);
+
+    // full scale reads about 1, depending on how far the tone is from the center of a bin
+    QVERIFY2(*loudest > 0.8f && *loudest < 1.05f, qPrintable(QString::number(*loudest)));
+    for (int band = 0; band < bands; ++band) {
+        if (qAbs(band - expectedBand) > 2)
+            QVERIFY(levels.spectrum[band] < 0.01f);
+    }
+}
+
+void tst_QAudioLevelMeter::reset()
+{
+    QAudioLevelMeter meter;
+    meter.setEnabled(true);
+    meter.setBandCount(16);
+    const QAudioFormat format = ::format(QAudioFormat::Float, 2);
+    process(meter, format, sine(2, 1000, 1.f, 4800));
+
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(meter.takeLevels(&levels));
+    QVERIFY(levels.peak[0] > 0.9f);
+
+    // stopping the stream drops the levels to silence
+    meter.reset();
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.peak, QList<float>({ 0.f, 0.f }));
+    QCOMPARE(levels.rms, QList<float>({ 0.f, 0.f }));
+    QCOMPARE(levels.spectrum, QList<float>(16, 0.f));
+
+    // and the next block doesn't include anything from before
+    process(meter, format, QList<float>(2 * 2400, 0.f));
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.spectrum, QList<float>(16, 0.f));
+}
+
+void tst_QAudioLevelMeter::settings()
+{
+    QAudioLevelMeter meter;
+    meter.setInterval(1);
+    QCOMPARE(meter.interval(), QAudioLevelMeter::MinimumInterval);
+    meter.setBandCount(100000);
+    QCOMPARE(meter.bandCount(), QAudioLevelMeter::MaxBandCount);
+    meter.setBandCount(-1);
+    QCOMPARE(meter.bandCount(), 0);
+
+    // the audio thread picks up changed settings with the next samples
+    meter.setEnabled(true);
+    const QAudioFormat format = ::format(QAudioFormat::Float, 1);
+    process(meter, format, sine(1, 1000, 1.f, 2400));
+    QAudioLevelMeter::Levels levels;
+    QVERIFY(meter.takeLevels(&levels));
+    QVERIFY(levels.spectrum.isEmpty());
+
+    meter.setBandCount(8);
+    process(meter, format, sine(1, 1000, 1.f, 2400));
+    QVERIFY(meter.takeLevels(&levels));
+    QCOMPARE(levels.spectrum.size(), 8);
+}
+
+void tst_QAudioLevelMeter::audioOutput()
+{
+    QAudioOutput output;
+    QVERIFY(!output.isLevelMeteringEnabled());
+    QCOMPARE(output.levelUpdateInterval(), QAudioLevelMeter::DefaultInterval);
+    QCOMPARE(output.spectrumBandCount(), 0);
+
+    // the meter is only created once metering is enabled
+    QVERIFY(!QPlatformAudioOutput::get(output)->levelMeter());
+
+    QSignalSpy enabledSpy(&output, &QAudioOutput::levelMeteringEnabledChanged);
+    QSignalSpy intervalSpy(&output, &QAudioOutput::levelUpdateIntervalChanged);
+    QSignalSpy bandsSpy(&output, &QAudioOutput::spectrumBandCountChanged);
+    QSignalSpy levelsSpy(&output, &QAudioOutput::levelsChanged);
+
+    output.setLevelUpdateInterval(20);
+    output.setLevelUpdateInterval(20);
+    QCOMPARE(intervalSpy.size(), 1);
+    output.setLevelUpdateInterval(0);
+    QCOMPARE(output.levelUpdateInterval(), QAudioLevelMeter::MinimumInterval);
+    QCOMPARE(intervalSpy.size(), 2);
+    output.setSpectrumBandCount(4);
+    QCOMPARE(bandsSpy.size(), 1);
+    QCOMPARE(bandsSpy.last().at(0).toInt(), 4);
+
+    output.setLevelMeteringEnabled(true);
+    output.setLevelMeteringEnabled(true);
+    QCOMPARE(enabledSpy.size(), 1);
+
+    // what the backend feeds its meter shows up on the output
+    auto meter = QPlatformAudioOutput::get(output)->levelMeter();
+    QVERIFY(meter);
+    QCOMPARE(meter->interval(), QAudioLevelMeter::MinimumInterval);
+    QCOMPARE(meter->bandCount(), 4);
+    process(*meter, format(QAudioFormat::Float, 1), QList<float>(4800, 0.75f));
+    QTRY_COMPARE(levelsSpy.size(), 1);
+    QCOMPARE(output.peakLevels(), QList<float>({ 0.75f }));
+    QCOMPARE(output.rmsLevels().size(), 1);
+    QCOMPARE(output.spectrum().size(), 4);
+
+    output.setLevelMeteringEnabled(false);
+    QCOMPARE(enabledSpy.size(), 2);
+    QCOMPARE(levelsSpy.size(), 2);
+    QVERIFY(output.peakLevels().isEmpty());
+    QVERIFY(output.spectrum().isEmpty());
+}
+
+QTEST_MAIN(tst_QAudioLevelMeter)
+
+#include "tst_qaudiolevelmeter.moc"
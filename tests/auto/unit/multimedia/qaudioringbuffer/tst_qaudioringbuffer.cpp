@@ -0,0 +1,109 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+#include <private/qaudioringbuffer_p.h>
+
+#include <numeric>
+
+class tst_QAudioRingBuffer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readWrite();
+    void regions();
+    void producerAndConsumerThreads();
+};
+
+void tst_QAudioRingBuffer::readWrite()
+{
+    QAudioRingBuffer<int> ring(8);
+    QCOMPARE(ring.size(), qsizetype(8));
+    QCOMPARE(ring.free(), qsizetype(8));
+
+    const int data[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+    QCOMPARE(ring.write(data, 5), qsizetype(5));
+    QCOMPARE(ring.used(), qsizetype(5));
+
+    int out[10] = {};
+    QCOMPARE(ring.read(out, 3), qsizetype(3));
+    QCOMPARE(out[0], 1);
+    QCOMPARE(out[2], 3);
+
+    // wraps around, and only writes what fits
+    QCOMPARE(ring.write(data + 5, 5), qsizetype(5));
+    QCOMPARE(ring.write(data, 5), qsizetype(1));
+    QCOMPARE(ring.free(), qsizetype(0));
+
+    QCOMPARE(ring.read(out, 10), qsizetype(8));
+    const int expected[] = { 4, 5, 6, 7, 8, 9, 10, 1 };
+    for (int i = 0; i < 8; ++i)
+        QCOMPARE(out[i], expected[i]);
+    QCOMPARE(ring.read(out, 1), qsizetype(0));
+
+    ring.write(data, 3);
+    ring.reset();
+    QCOMPARE(ring.used(), qsizetype(0));
+}
+
+void tst_QAudioRingBuffer::regions()
+{
+    QAudioRingBuffer<int> ring(8);
+    const int data[] = { 1, 2, 3, 4, 5, 6 };
+    ring.write(data, 6);
+    int out[4];
+    ring.read(out, 4);
+
+    // the free space wraps around, so a region only reaches the end of the buffer
+    auto region = ring.acquireWriteRegion(6);
+    QCOMPARE(region.size, qsizetype(2));
+    region.data[0] = 7;
+    region.data[1] = 8;
+    ring.releaseWriteRegion(region);
+    QCOMPARE(ring.acquireWriteRegion(6).size, qsizetype(4));
+
+    auto readRegion = ring.acquireReadRegion(10);
+    QCOMPARE(readRegion.size, qsizetype(4));
+    QCOMPARE(readRegion.data[0], 5);
+    QCOMPARE(readRegion.data[3], 8);
+    ring.releaseReadRegion(readRegion);
+    QCOMPARE(ring.used(), qsizetype(0));
+}
+
+void tst_QAudioRingBuffer::producerAndConsumerThreads()
+{
+    // the consumer sees every value, in order, without any locks
+    constexpr int count = 1000000;
+    QAudioRingBuffer<int> ring(1000);
+
+    std::unique_ptr<QThread> producer(QThread::create([&ring] {
+        int next = 0;
+        int chunk[37];
+        while (next < count) {
+            const int size = qMin(count - next, 37);
+            std::iota(chunk, chunk + size, next);
+            int written = 0;
+            while (written < size)
+                written += ring.write(chunk + written, size - written);
+            next += size;
+        }
+    }));
+    producer->start();
+
+    int expected = 0;
+    int chunk[53];
+    bool inOrder = true;
+    while (expected < count) {
+        const qsizetype read = ring.read(chunk, 53);
+        for (qsizetype i = 0; i < read; ++i)
+            inOrder &= chunk[i] == expected++;
+    }
+    QVERIFY(producer->wait());
+    QVERIFY(inOrder);
+    QCOMPARE(ring.used(), qsizetype(0));
+}
+
+QTEST_MAIN(tst_QAudioRingBuffer)
+
+#include "tst_qaudioringbuffer.moc"
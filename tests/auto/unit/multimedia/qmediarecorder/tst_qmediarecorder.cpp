@@ -38,6 +38,7 @@ private slots:
     void testAudioSettings();
     void testVideoSettings();
     void testSettingsApplied();
+    void testSettingsUpdatedWhileRecording();
 
     void metaData();
 
@@ -352,6 +353,54 @@ void tst_QMediaRecorder::testSettingsApplied()
     encoder.stop();
 }
 
+void tst_QMediaRecorder::testSettingsUpdatedWhileRecording()
+{
+    QMediaCaptureSession session;
+    QMediaRecorder recorder;
+    session.setRecorder(&recorder);
+    auto *mock = mockIntegration->lastCaptureService()->mockControl;
+
+    QCOMPARE(recorder.videoKeyFrameInterval(), -1);
+
+    // nothing is forwarded while stopped, the settings are applied on record()
+    recorder.setVideoBitRate(1000000);
+    QCOMPARE(mock->m_settingsUpdates, 0);
+
+    recorder.record();
+    QCOMPARE(recorder.recorderState(), QMediaRecorder::RecordingState);
+    QCOMPARE(mock->m_settings.videoBitRate(), 1000000);
+
+    recorder.setVideoBitRate(500000);
+    QCOMPARE(mock->m_settingsUpdates, 1);
+    QCOMPARE(mock->m_settings.videoBitRate(), 500000);
+
+    recorder.setQuality(QMediaRecorder::LowQuality);
+    QCOMPARE(mock->m_settings.quality(), QMediaRecorder::LowQuality);
+
+    recorder.setVideoFrameRate(15);
+    QCOMPARE(mock->m_settings.videoFrameRate(), qreal(15));
+
+    QSignalSpy keyFrameIntervalSpy(&recorder, &QMediaRecorder::videoKeyFrameIntervalChanged);
+    recorder.setVideoKeyFrameInterval(30);
+    QCOMPARE(recorder.videoKeyFrameInterval(), 30);
+    QCOMPARE(keyFrameIntervalSpy.size(), 1);
+    QCOMPARE(mock->m_settings.videoKeyFrameInterval(), 30);
+
+    // unchanged values are not forwarded
+    recorder.setVideoKeyFrameInterval(30);
+    QCOMPARE(keyFrameIntervalSpy.size(), 1);
+    QCOMPARE(mock->m_settingsUpdates, 4);
+
+    recorder.pause();
+    recorder.setVideoBitRate(250000);
+    QCOMPARE(mock->m_settingsUpdates, 5);
+    QCOMPARE(mock->m_settings.videoBitRate(), 250000);
+
+    recorder.stop();
+    recorder.setVideoBitRate(100000);
+    QCOMPARE(mock->m_settingsUpdates, 5);
+}
+
 void tst_QMediaRecorder::metaData()
 {
     QMediaCaptureSession session;
@@ -5,6 +5,7 @@
 
 #include <QtTest/QtTest>
 #include <private/qsamplecache_p.h>
+#include <qwavedecoder.h>
 
 class tst_QSampleCache : public QObject
 {
@@ -19,6 +20,9 @@ private slots:
     void testEnoughCapacity();
     void testNotEnoughCapacity();
     void testInvalidFile();
+    void testMappedFile();
+    void testRequestSamples();
+    void testConvertedSample();
 
 private:
 
@@ -141,6 +145,83 @@ void tst_QSampleCache::testInvalidFile()
     QVERIFY(!cache.isCached(QUrl::fromLocalFile("invalid")));
 }
 
+void tst_QSampleCache::testMappedFile()
+{
+    QSampleCache cache;
+
+    const QString fileName = QFINDTESTDATA("testdata/test.wav");
+    QSample *sample = cache.requestSample(QUrl::fromLocalFile(fileName));
+    QVERIFY(sample);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+
+    // little endian 16 bit PCM is used in place
+    QVERIFY(sample->dataOwner());
+    QVERIFY(sample->data().size() > 0);
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const QByteArray contents = file.readAll();
+    QCOMPARE(sample->data(), contents.mid(QWaveDecoder::headerLength()));
+
+    // the data stays valid for as long as it's referenced
+    const QByteArray data = sample->data();
+    const std::shared_ptr<const void> owner = sample->dataOwner();
+    sample->release();
+    QTRY_VERIFY(!cache.isCached(QUrl::fromLocalFile(fileName)));
+    QCOMPARE(data, contents.mid(QWaveDecoder::headerLength()));
+}
+
+void tst_QSampleCache::testRequestSamples()
+{
+    QSampleCache cache;
+    cache.setCapacity(1024 * 1024);
+
+    const QList<QUrl> urls = {
+        QUrl::fromLocalFile(QFINDTESTDATA("testdata/test.wav")),
+        QUrl::fromLocalFile(QFINDTESTDATA("testdata/test2.wav")),
+        QUrl::fromLocalFile("invalid"),
+    };
+    const QList<QSample *> samples = cache.requestSamples(urls);
+    QCOMPARE(samples.size(), urls.size());
+
+    QTRY_COMPARE(samples[0]->state(), QSample::Ready);
+    QTRY_COMPARE(samples[1]->state(), QSample::Ready);
+    QTRY_COMPARE(samples[2]->state(), QSample::Error);
+    QTRY_VERIFY(!cache.isLoading());
+
+    for (QSample *sample : samples)
+        sample->release();
+
+    QVERIFY(cache.isCached(urls[0]));
+    QVERIFY(cache.isCached(urls[1]));
+}
+
+void tst_QSampleCache::testConvertedSample()
+{
+    QSampleCache cache;
+
+    // 44.1 kHz mono 16 bit PCM
+    const QString fileName = QFINDTESTDATA("testdata/test.wav");
+    QSample *sample = cache.requestSample(QUrl::fromLocalFile(fileName));
+    QVERIFY(sample);
+    QTRY_COMPARE(sample->state(), QSample::Ready);
+    QCOMPARE(sample->convertedData(sample->format()), sample->data());
+
+    QAudioFormat format;
+    format.setSampleFormat(QAudioFormat::Float);
+    format.setChannelCount(2);
+    format.setSampleRate(48000);
+    sample->prepareConvertedData(format);
+
+    const QByteArray data = sample->convertedData(format);
+    const qint64 frames = data.size() / format.bytesPerFrame();
+    const qint64 sourceFrames = sample->data().size() / sample->format().bytesPerFrame();
+    QVERIFY(qAbs(frames - sourceFrames * 48000 / 44100) < 64);
+    // the conversion is kept
+    QCOMPARE(sample->convertedData(format).constData(), data.constData());
+    sample->release();
+}
+
 QTEST_MAIN(tst_QSampleCache)
 
 #include "tst_qsamplecache.moc"
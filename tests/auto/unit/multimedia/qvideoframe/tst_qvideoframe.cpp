@@ -8,6 +8,8 @@
 #include <qvideoframe.h>
 #include <qvideoframeformat.h>
 #include "private/qmemoryvideobuffer_p.h"
+#include "private/qvideoframeconversionhelper_p.h"
+#include "private/qvideoframeconverter_p.h"
 #include <QtGui/QImage>
 #include <QtCore/QPointer>
 #include <QtMultimedia/private/qtmultimedia-config_p.h>
@@ -60,6 +62,19 @@ private slots:
     void image_data();
     void image();
 
+    void yuvConversion_data();
+    void yuvConversion();
+
+    void imageTransform_data();
+    void imageTransform();
+
+    void imageWithTargetSize_data();
+    void imageWithTargetSize();
+    void imageAsync();
+    void imageCachePolicy();
+    void mapRegion_data();
+    void mapRegion();
+
     void emptyData();
 };
 
@@ -957,6 +972,403 @@ void tst_QVideoFrame::image()
     QCOMPARE(img.size(), size);
 }
 
+// Floating point conversion straight from Kr and Kb of the color space
+static quint32 referenceYUVToARGB32(int y, int u, int v, QVideoFrameFormat::ColorSpace colorSpace,
+                                    QVideoFrameFormat::ColorRange colorRange)
+{
+    double kr = 0.299;
+    double kb = 0.114;
+    if (colorSpace == QVideoFrameFormat::ColorSpace_BT709) {
+        kr = 0.2126;
+        kb = 0.0722;
+    } else if (colorSpace == QVideoFrameFormat::ColorSpace_BT2020) {
+        kr = 0.2627;
+        kb = 0.0593;
+    }
+    const double kg = 1. - kr - kb;
+
+    const bool fullRange = colorRange == QVideoFrameFormat::ColorRange_Full;
+    const double yy = fullRange ? y / 255. : (y - 16) / 219.;
+    const double uu = (u - 128) / (fullRange ? 255. : 224.);
+    const double vv = (v - 128) / (fullRange ? 255. : 224.);
+
+    const double r = yy + 2. * (1. - kr) * vv;
+    const double b = yy + 2. * (1. - kb) * uu;
+    const double g = (yy - kr * r - kb * b) / kg;
+
+    auto component = [](double value) { return qBound(0, qRound(value * 255.), 255); };
+    return 0xff000000 | component(r) << 16 | component(g) << 8 | component(b);
+}
+
+static bool fuzzyCompareARGB32(quint32 a, quint32 b, int tolerance)
+{
+    for (int shift = 0; shift < 32; shift += 8) {
+        if (qAbs(int((a >> shift) & 0xff) - int((b >> shift) & 0xff)) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+void tst_QVideoFrame::yuvConversion_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QVideoFrameFormat::ColorSpace>("colorSpace");
+    QTest::addColumn<QVideoFrameFormat::ColorRange>("colorRange");
+
+    // the widths exercise both the vectorized part and the leftovers;
+    // small frames without a color space are treated as BT.601 video range
+    for (const QSize size : { QSize(64, 4), QSize(70, 6), QSize(6, 2) }) {
+        const QByteArray suffix = " " + QByteArray::number(size.width()) + "x"
+                + QByteArray::number(size.height());
+        for (const auto &[name, format] :
+             { std::pair{ "YUV420P", QVideoFrameFormat::Format_YUV420P },
+               std::pair{ "YUV422P", QVideoFrameFormat::Format_YUV422P },
+               std::pair{ "YV12", QVideoFrameFormat::Format_YV12 },
+               std::pair{ "NV12", QVideoFrameFormat::Format_NV12 },
+               std::pair{ "NV21", QVideoFrameFormat::Format_NV21 } }) {
+            QTest::newRow(name + suffix) << format << size
+                                         << QVideoFrameFormat::ColorSpace_Undefined
+                                         << QVideoFrameFormat::ColorRange_Unknown;
+        }
+    }
+
+    const std::pair<const char *, QVideoFrameFormat::ColorSpace> colorSpaces[] = {
+        { "BT601", QVideoFrameFormat::ColorSpace_BT601 },
+        { "BT709", QVideoFrameFormat::ColorSpace_BT709 },
+        { "BT2020", QVideoFrameFormat::ColorSpace_BT2020 },
+    };
+    const std::pair<const char *, QVideoFrameFormat::ColorRange> colorRanges[] = {
+        { "video", QVideoFrameFormat::ColorRange_Video },
+        { "full", QVideoFrameFormat::ColorRange_Full },
+    };
+    for (const auto &[spaceName, colorSpace] : colorSpaces) {
+        for (const auto &[rangeName, colorRange] : colorRanges) {
+            QTest::addRow("YUV420P 70x6 %s %s", spaceName, rangeName)
+                    << QVideoFrameFormat::Format_YUV420P << QSize(70, 6) << colorSpace
+                    << colorRange;
+            QTest::addRow("NV12 70x6 %s %s", spaceName, rangeName)
+                    << QVideoFrameFormat::Format_NV12 << QSize(70, 6) << colorSpace
+                    << colorRange;
+        }
+    }
+}
+
+void tst_QVideoFrame::yuvConversion()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+    QFETCH(QVideoFrameFormat::ColorSpace, colorSpace);
+    QFETCH(QVideoFrameFormat::ColorRange, colorRange);
+
+    QVideoFrameFormat format(size, pixelFormat);
+    format.setColorSpace(colorSpace);
+    format.setColorRange(colorRange);
+
+    QVideoFrame frame(format);
+    QVERIFY(frame.map(QVideoFrame::ReadWrite));
+
+    // fill all planes with a pattern covering the whole value range
+    quint32 seed = 1;
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        uchar *bits = frame.bits(plane);
+        for (int i = 0; i < frame.mappedBytes(plane); ++i) {
+            seed = seed * 1103515245 + 12345;
+            bits[i] = uchar(seed >> 16);
+        }
+    }
+
+    const bool semiPlanar = pixelFormat == QVideoFrameFormat::Format_NV12
+            || pixelFormat == QVideoFrameFormat::Format_NV21;
+    const bool swapUV = pixelFormat == QVideoFrameFormat::Format_YV12
+            || pixelFormat == QVideoFrameFormat::Format_NV21;
+    const int chromaRowShift = pixelFormat == QVideoFrameFormat::Format_YUV422P ? 0 : 1;
+
+    auto chromaAt = [&](int x, int y, bool v) -> int {
+        const int row = y >> chromaRowShift;
+        if (semiPlanar)
+            return frame.bits(1)[row * frame.bytesPerLine(1) + (x / 2) * 2 + (v != swapUV)];
+        const int plane = (v != swapUV) ? 2 : 1;
+        return frame.bits(plane)[row * frame.bytesPerLine(plane) + x / 2];
+    };
+
+    VideoFrameConvertFunc convert = qConverterForFormat(pixelFormat);
+    QVERIFY(convert);
+
+    QImage image(size, QImage::Format_RGB32);
+    convert(frame, image.bits(), 0, size.height());
+
+    for (int y = 0; y < size.height(); ++y) {
+        const auto *line = reinterpret_cast<const quint32 *>(image.constScanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int luma = frame.bits(0)[y * frame.bytesPerLine(0) + x];
+            const quint32 expected = referenceYUVToARGB32(luma, chromaAt(x, y, false),
+                                                          chromaAt(x, y, true), colorSpace,
+                                                          colorRange);
+            // the converters use 8 bit fixed point coefficients
+            if (!fuzzyCompareARGB32(line[x], expected, 2))
+                QFAIL(qPrintable(QStringLiteral("Pixel (%1, %2) is %3, expected %4")
+                                         .arg(x).arg(y)
+                                         .arg(line[x], 8, 16, QLatin1Char('0'))
+                                         .arg(expected, 8, 16, QLatin1Char('0'))));
+        }
+    }
+
+    // converting in segments, as done on multiple threads, gives the same result
+    const int split = (size.height() / 2) & ~1;
+    QImage segments(size, QImage::Format_RGB32);
+    convert(frame, segments.scanLine(0), 0, split);
+    convert(frame, segments.scanLine(split), split, size.height());
+    QCOMPARE(segments, image);
+
+    frame.unmap();
+}
+
+void tst_QVideoFrame::imageTransform_data()
+{
+    QTest::addColumn<QVideoFrame::RotationAngle>("rotation");
+    QTest::addColumn<bool>("mirrorX");
+    QTest::addColumn<bool>("mirrorY");
+
+    QTest::newRow("0") << QVideoFrame::Rotation0 << false << false;
+    QTest::newRow("90") << QVideoFrame::Rotation90 << false << false;
+    QTest::newRow("180") << QVideoFrame::Rotation180 << false << false;
+    QTest::newRow("270") << QVideoFrame::Rotation270 << false << false;
+    QTest::newRow("0 mirrorX") << QVideoFrame::Rotation0 << true << false;
+    QTest::newRow("0 mirrorY") << QVideoFrame::Rotation0 << false << true;
+    QTest::newRow("90 mirrorX") << QVideoFrame::Rotation90 << true << false;
+    QTest::newRow("270 mirrorX mirrorY") << QVideoFrame::Rotation270 << true << true;
+}
+
+void tst_QVideoFrame::imageTransform()
+{
+    QFETCH(QVideoFrame::RotationAngle, rotation);
+    QFETCH(bool, mirrorX);
+    QFETCH(bool, mirrorY);
+
+    // large enough to be converted in several segments
+    const QSize size(640, 482);
+    QVideoFrame frame(QVideoFrameFormat(size, QVideoFrameFormat::Format_XRGB8888));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    quint32 seed = 1;
+    for (int i = 0; i < frame.mappedBytes(0); ++i) {
+        seed = seed * 1103515245 + 12345;
+        frame.bits(0)[i] = uchar(seed >> 16);
+    }
+    frame.unmap();
+
+    QTransform transform;
+    if (mirrorX)
+        transform.scale(-1.f, 1.f);
+    transform.rotate(float(rotation));
+    if (mirrorY)
+        transform.scale(1.f, -1.f);
+
+    const QImage expected = qImageFromVideoFrame(frame).transformed(transform);
+    const QImage image = qImageFromVideoFrame(frame, rotation, mirrorX, mirrorY);
+    QCOMPARE(image.size(), expected.size());
+    QCOMPARE(image, expected);
+}
+
+void tst_QVideoFrame::imageWithTargetSize_data()
+{
+    QTest::addColumn<QVideoFrame::RotationAngle>("rotation");
+    QTest::addColumn<QSize>("targetSize");
+    QTest::addColumn<QImage::Format>("format");
+
+    QTest::newRow("half") << QVideoFrame::Rotation0 << QSize(320, 240) << QImage::Format_Invalid;
+    QTest::newRow("quarter RGB888")
+            << QVideoFrame::Rotation0 << QSize(160, 120) << QImage::Format_RGB888;
+    QTest::newRow("non power of two") << QVideoFrame::Rotation0 << QSize(100, 50)
+                                      << QImage::Format_Invalid;
+    QTest::newRow("rotated") << QVideoFrame::Rotation90 << QSize(120, 160)
+                             << QImage::Format_Invalid;
+    QTest::newRow("empty size") << QVideoFrame::Rotation0 << QSize() << QImage::Format_RGB32;
+}
+
+void tst_QVideoFrame::imageWithTargetSize()
+{
+    QFETCH(QVideoFrame::RotationAngle, rotation);
+    QFETCH(QSize, targetSize);
+    QFETCH(QImage::Format, format);
+
+    // the left half of the frame is black, the right half white
+    const QSize size(640, 480);
+    QVideoFrame frame(QVideoFrameFormat(size, QVideoFrameFormat::Format_XRGB8888));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int y = 0; y < size.height(); ++y) {
+        auto *line = reinterpret_cast<quint32 *>(frame.bits(0) + y * frame.bytesPerLine(0));
+        for (int x = 0; x < size.width(); ++x)
+            line[x] = x < size.width() / 2 ? 0xff000000 : 0xffffffff;
+    }
+    frame.unmap();
+    frame.setRotationAngle(rotation);
+
+    const QImage image = frame.toImage(targetSize, format);
+    QVERIFY(!image.isNull());
+    const QSize expectedSize = targetSize.isEmpty()
+            ? (rotation == QVideoFrame::Rotation90 ? size.transposed() : size)
+            : targetSize;
+    QCOMPARE(image.size(), expectedSize);
+    if (format != QImage::Format_Invalid)
+        QCOMPARE(image.format(), format);
+
+    // when rotated, the left half becomes the top half
+    const QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+    QCOMPARE(rgb.pixel(0, 0), 0xff000000);
+    QCOMPARE(rgb.pixel(rgb.width() - 1, rgb.height() - 1), 0xffffffff);
+}
+
+void tst_QVideoFrame::imageAsync()
+{
+    QVideoFrame frame(QVideoFrameFormat(QSize(64, 48), QVideoFrameFormat::Format_XRGB8888));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    memset(frame.bits(0), 0x80, frame.mappedBytes(0));
+    frame.unmap();
+
+    QFuture<QImage> future = frame.toImageAsync(QSize(32, 24), QImage::Format_RGB32);
+    future.waitForFinished();
+    QVERIFY(!future.isCanceled());
+    const QImage image = future.result();
+    QCOMPARE(image.size(), QSize(32, 24));
+    QCOMPARE(image.format(), QImage::Format_RGB32);
+    QCOMPARE(image, frame.toImage(QSize(32, 24), QImage::Format_RGB32));
+
+    // invalid frames are finished right away
+    QFuture<QImage> invalid = QVideoFrame().toImageAsync();
+    QVERIFY(invalid.isFinished());
+    QVERIFY(invalid.result().isNull());
+}
+
+void tst_QVideoFrame::imageCachePolicy()
+{
+    // frames keep their own images unless the shared cache is enabled
+    QCOMPARE(QVideoFrame::imageCachePolicy(), QVideoFrame::PerFrameImageCache);
+    const auto restoreDefaults = qScopeGuard([limit = QVideoFrame::imageCacheLimit()] {
+        QVideoFrame::setImageCachePolicy(QVideoFrame::PerFrameImageCache);
+        QVideoFrame::setImageCacheLimit(limit);
+    });
+
+    const auto createFrame = [] {
+        QVideoFrame frame(QVideoFrameFormat(QSize(64, 48), QVideoFrameFormat::Format_XRGB8888));
+        if (frame.map(QVideoFrame::WriteOnly)) {
+            memset(frame.bits(0), 0x80, frame.mappedBytes(0));
+            frame.unmap();
+        }
+        return frame;
+    };
+    const qsizetype imageBytes = createFrame().toImage().sizeInBytes();
+
+    QVideoFrame::setImageCachePolicy(QVideoFrame::NoImageCache);
+    QCOMPARE(QVideoFrame::imageCachePolicy(), QVideoFrame::NoImageCache);
+    {
+        const QVideoFrame frame = createFrame();
+        QVERIFY(frame.toImage().cacheKey() != frame.toImage().cacheKey());
+    }
+
+    QVideoFrame::setImageCachePolicy(QVideoFrame::PerFrameImageCache);
+    {
+        const QVideoFrame frame = createFrame();
+        QCOMPARE(frame.toImage().cacheKey(), frame.toImage().cacheKey());
+    }
+
+    // the shared cache keeps the images of the frames converted last
+    QVideoFrame::setImageCachePolicy(QVideoFrame::SharedImageCache);
+    QVideoFrame::setImageCacheLimit(2 * imageBytes);
+    QCOMPARE(QVideoFrame::imageCacheLimit(), 2 * imageBytes);
+    {
+        const QVideoFrame first = createFrame();
+        const QVideoFrame second = createFrame();
+        const QVideoFrame third = createFrame();
+
+        const qint64 firstKey = first.toImage().cacheKey();
+        const qint64 secondKey = second.toImage().cacheKey();
+        QCOMPARE(first.toImage().cacheKey(), firstKey);
+        QCOMPARE(second.toImage().cacheKey(), secondKey);
+
+        // evicts the least recently used image, of the first frame
+        const qint64 thirdKey = third.toImage().cacheKey();
+        QCOMPARE(third.toImage().cacheKey(), thirdKey);
+        QCOMPARE(second.toImage().cacheKey(), secondKey);
+        QVERIFY(first.toImage().cacheKey() != firstKey);
+    }
+
+    // images exceeding the limit are not cached
+    QVideoFrame::setImageCacheLimit(imageBytes - 1);
+    {
+        const QVideoFrame frame = createFrame();
+        QVERIFY(frame.toImage().cacheKey() != frame.toImage().cacheKey());
+    }
+}
+
+void tst_QVideoFrame::mapRegion_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QRect>("region");
+    QTest::addColumn<QList<int>>("planeOffsetX");
+    QTest::addColumn<QList<int>>("planeOffsetY");
+
+    QTest::newRow("ARGB8888") << QVideoFrameFormat::Format_ARGB8888 << QRect(10, 6, 20, 10)
+                              << QList<int>{ 40 } << QList<int>{ 6 };
+    QTest::newRow("YUV420P") << QVideoFrameFormat::Format_YUV420P << QRect(10, 6, 20, 10)
+                             << QList<int>{ 10, 5, 5 } << QList<int>{ 6, 3, 3 };
+    QTest::newRow("YUV420P odd") << QVideoFrameFormat::Format_YUV420P << QRect(11, 7, 5, 5)
+                                 << QList<int>{ 11, 5, 5 } << QList<int>{ 7, 3, 3 };
+    QTest::newRow("NV12") << QVideoFrameFormat::Format_NV12 << QRect(10, 6, 20, 10)
+                          << QList<int>{ 10, 10 } << QList<int>{ 6, 3 };
+    QTest::newRow("UYVY") << QVideoFrameFormat::Format_UYVY << QRect(11, 6, 20, 10)
+                          << QList<int>{ 20 } << QList<int>{ 6 };
+    QTest::newRow("P010") << QVideoFrameFormat::Format_P010 << QRect(10, 6, 20, 10)
+                          << QList<int>{ 20, 20 } << QList<int>{ 6, 3 };
+}
+
+void tst_QVideoFrame::mapRegion()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QRect, region);
+    QFETCH(QList<int>, planeOffsetX);
+    QFETCH(QList<int>, planeOffsetY);
+
+    QVideoFrame frame(QVideoFrameFormat(QSize(64, 48), pixelFormat));
+    QVERIFY(frame.map(QVideoFrame::ReadOnly));
+    QCOMPARE(frame.planeCount(), planeOffsetX.size());
+    QList<const uchar *> bits;
+    QList<int> strides;
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        bits.append(frame.bits(plane));
+        strides.append(frame.bytesPerLine(plane));
+    }
+    frame.unmap();
+
+    QVERIFY(frame.map(QVideoFrame::ReadOnly, region));
+    QCOMPARE(frame.planeCount(), planeOffsetX.size());
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        QCOMPARE(frame.bytesPerLine(plane), strides[plane]);
+        QCOMPARE(std::as_const(frame).bits(plane),
+                 bits[plane] + planeOffsetY[plane] * strides[plane] + planeOffsetX[plane]);
+        QVERIFY(frame.mappedBytes(plane) > 0);
+    }
+
+    // partially mapped frames cannot be mapped again
+    QVERIFY(!frame.map(QVideoFrame::ReadOnly));
+    frame.unmap();
+
+    // the luma plane only
+    QVERIFY(frame.map(QVideoFrame::ReadOnly, region, 0x1));
+    QCOMPARE(std::as_const(frame).bits(0), bits[0] + planeOffsetY[0] * strides[0] + planeOffsetX[0]);
+    for (int plane = 1; plane < frame.planeCount(); ++plane)
+        QCOMPARE(std::as_const(frame).bits(plane), nullptr);
+    frame.unmap();
+
+    // regions are clipped to the frame
+    QVERIFY(!frame.map(QVideoFrame::ReadOnly, QRect(64, 0, 10, 10)));
+    QVERIFY(frame.map(QVideoFrame::ReadOnly, QRect(-10, -10, 100, 100)));
+    QCOMPARE(std::as_const(frame).bits(0), bits[0]);
+    QVERIFY(frame.map(QVideoFrame::ReadOnly));
+    frame.unmap();
+    frame.unmap();
+}
+
 void tst_QVideoFrame::emptyData()
 {
     QByteArray data(nullptr, 0);
@@ -0,0 +1,290 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <private/qvideoframeformatconverter_p.h>
+#include <QtGui/QImage>
+
+class tst_QVideoFrameFormatConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void canConvert();
+    void yuvRoundTrip_data();
+    void yuvRoundTrip();
+    void subsampleChroma();
+    void rgbToYUV_data();
+    void rgbToYUV();
+    void rgbToRGB();
+    void scale();
+    void keepsFrameProperties();
+};
+
+// Fills each plane with a pattern depending on the position of the sample
+static QVideoFrame createYUVFrame(QVideoFrameFormat::PixelFormat pixelFormat, QSize size)
+{
+    QVideoFrame frame(QVideoFrameFormat(size, pixelFormat));
+    if (!frame.map(QVideoFrame::WriteOnly))
+        return {};
+
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        uchar *bits = frame.bits(plane);
+        for (int i = 0; i < frame.mappedBytes(plane); ++i)
+            bits[i] = uchar((i % frame.bytesPerLine(plane)) * 3 + (i / frame.bytesPerLine(plane)) * 7
+                            + plane * 50);
+    }
+    frame.unmap();
+    return frame;
+}
+
+// Compares the planes line by line, which ignores the padding at the end of the planes
+static bool comparePlanes(QVideoFrame a, QVideoFrame b)
+{
+    if (!a.map(QVideoFrame::ReadOnly))
+        return false;
+    if (!b.map(QVideoFrame::ReadOnly)) {
+        a.unmap();
+        return false;
+    }
+
+    bool equal = a.planeCount() == b.planeCount();
+    for (int plane = 0; equal && plane < a.planeCount(); ++plane) {
+        const int bytes = std::min(a.bytesPerLine(plane), b.bytesPerLine(plane));
+        const int rows = std::min(a.mappedBytes(plane) / a.bytesPerLine(plane),
+                                  b.mappedBytes(plane) / b.bytesPerLine(plane));
+        for (int row = 0; equal && row < rows; ++row) {
+            equal = memcmp(a.bits(plane) + row * a.bytesPerLine(plane),
+                           b.bits(plane) + row * b.bytesPerLine(plane), bytes)
+                    == 0;
+        }
+    }
+
+    a.unmap();
+    b.unmap();
+    return equal;
+}
+
+static bool fuzzyCompareImages(const QImage &a, const QImage &b, int tolerance)
+{
+    if (a.size() != b.size())
+        return false;
+
+    for (int y = 0; y < a.height(); ++y) {
+        for (int x = 0; x < a.width(); ++x) {
+            const QRgb pa = a.pixel(x, y);
+            const QRgb pb = b.pixel(x, y);
+            if (qAbs(qRed(pa) - qRed(pb)) > tolerance || qAbs(qGreen(pa) - qGreen(pb)) > tolerance
+                || qAbs(qBlue(pa) - qBlue(pb)) > tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+void tst_QVideoFrameFormatConverter::canConvert()
+{
+    QVERIFY(QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::Format_NV12,
+                                                   QVideoFrameFormat::Format_YUV420P));
+    QVERIFY(QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::Format_ARGB8888,
+                                                   QVideoFrameFormat::Format_NV12));
+    QVERIFY(QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::Format_P010,
+                                                   QVideoFrameFormat::Format_RGBA8888));
+    QVERIFY(!QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::Format_Invalid,
+                                                    QVideoFrameFormat::Format_NV12));
+    QVERIFY(!QVideoFrameFormatConverter::canConvert(QVideoFrameFormat::Format_NV12,
+                                                    QVideoFrameFormat::Format_P010));
+
+    QVideoFrameFormatConverter converter;
+    QVERIFY(!converter.convert(QVideoFrame(), QVideoFrameFormat::Format_NV12).isValid());
+}
+
+void tst_QVideoFrameFormatConverter::yuvRoundTrip_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("from");
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("to");
+
+    QTest::newRow("NV12 to YUV420P")
+            << QVideoFrameFormat::Format_NV12 << QVideoFrameFormat::Format_YUV420P;
+    QTest::newRow("NV12 to NV21") << QVideoFrameFormat::Format_NV12 << QVideoFrameFormat::Format_NV21;
+    QTest::newRow("YUV420P to YV12")
+            << QVideoFrameFormat::Format_YUV420P << QVideoFrameFormat::Format_YV12;
+    QTest::newRow("YUV420P to NV12")
+            << QVideoFrameFormat::Format_YUV420P << QVideoFrameFormat::Format_NV12;
+    QTest::newRow("YUV422P to UYVY")
+            << QVideoFrameFormat::Format_YUV422P << QVideoFrameFormat::Format_UYVY;
+    QTest::newRow("UYVY to YUYV") << QVideoFrameFormat::Format_UYVY << QVideoFrameFormat::Format_YUYV;
+}
+
+void tst_QVideoFrameFormatConverter::yuvRoundTrip()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, from);
+    QFETCH(QVideoFrameFormat::PixelFormat, to);
+
+    // large enough to be converted in segments
+    const QVideoFrame frame = createYUVFrame(from, QSize(640, 480));
+    QVERIFY(frame.isValid());
+
+    QVideoFrameFormatConverter converter;
+    const QVideoFrame converted = converter.convert(frame, to);
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.pixelFormat(), to);
+    QCOMPARE(converted.size(), frame.size());
+
+    QVideoFrameFormatConverter backConverter;
+    const QVideoFrame back = backConverter.convert(converted, from);
+    QVERIFY(back.isValid());
+    QVERIFY(comparePlanes(frame, back));
+
+    // the samples are copied, so the colors are the same
+    QVERIFY(fuzzyCompareImages(converted.toImage(), frame.toImage(), 1));
+}
+
+void tst_QVideoFrameFormatConverter::subsampleChroma()
+{
+    QVideoFrame frame(QVideoFrameFormat(QSize(64, 4), QVideoFrameFormat::Format_UYVY));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int line = 0; line < 4; ++line) {
+        uchar *bits = frame.bits(0) + line * frame.bytesPerLine(0);
+        for (int x = 0; x < 32; ++x) {
+            bits[4 * x] = uchar(line * 10);       // U
+            bits[4 * x + 1] = 100;                // Y0
+            bits[4 * x + 2] = uchar(line * 20);   // V
+            bits[4 * x + 3] = 101;                // Y1
+        }
+    }
+    frame.unmap();
+
+    QVideoFrameFormatConverter converter;
+    QVideoFrame converted = converter.convert(frame, QVideoFrameFormat::Format_YUV420P);
+    QVERIFY(converted.map(QVideoFrame::ReadOnly));
+    QCOMPARE(int(converted.bits(0)[0]), 100);
+    QCOMPARE(int(converted.bits(0)[1]), 101);
+
+    // the chroma of two lines is averaged
+    QCOMPARE(int(converted.bits(1)[0]), 5);
+    QCOMPARE(int(converted.bits(2)[0]), 10);
+    QCOMPARE(int(converted.bits(1)[converted.bytesPerLine(1)]), 25);
+    QCOMPARE(int(converted.bits(2)[converted.bytesPerLine(2)]), 50);
+    converted.unmap();
+}
+
+void tst_QVideoFrameFormatConverter::rgbToYUV_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QVideoFrameFormat::ColorSpace>("colorSpace");
+    QTest::addColumn<QVideoFrameFormat::ColorRange>("colorRange");
+
+    QTest::newRow("NV12 BT709 video") << QVideoFrameFormat::Format_NV12
+                                      << QVideoFrameFormat::ColorSpace_BT709
+                                      << QVideoFrameFormat::ColorRange_Video;
+    QTest::newRow("NV12 BT601 full") << QVideoFrameFormat::Format_NV12
+                                     << QVideoFrameFormat::ColorSpace_BT601
+                                     << QVideoFrameFormat::ColorRange_Full;
+    QTest::newRow("YUV420P BT2020 video") << QVideoFrameFormat::Format_YUV420P
+                                          << QVideoFrameFormat::ColorSpace_BT2020
+                                          << QVideoFrameFormat::ColorRange_Video;
+    QTest::newRow("YUYV undefined") << QVideoFrameFormat::Format_YUYV
+                                    << QVideoFrameFormat::ColorSpace_Undefined
+                                    << QVideoFrameFormat::ColorRange_Unknown;
+}
+
+void tst_QVideoFrameFormatConverter::rgbToYUV()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QVideoFrameFormat::ColorSpace, colorSpace);
+    QFETCH(QVideoFrameFormat::ColorRange, colorRange);
+
+    // blocks of 2x2 pixels of the same color, so that subsampling doesn't blur them
+    QImage image(64, 32, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x) {
+            const int block = (y / 2) * 32 + x / 2;
+            image.setPixel(x, y, qRgb(block * 13 % 256, block * 29 % 256, block * 47 % 256));
+        }
+    }
+
+    QVideoFrameFormat format(image.size(), QVideoFrameFormat::Format_BGRX8888);
+    format.setColorSpace(colorSpace);
+    format.setColorRange(colorRange);
+    QVideoFrame frame(format);
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int y = 0; y < image.height(); ++y)
+        memcpy(frame.bits(0) + y * frame.bytesPerLine(0), image.constScanLine(y), image.width() * 4);
+    frame.unmap();
+
+    QVideoFrameFormatConverter converter;
+    const QVideoFrame converted = converter.convert(frame, pixelFormat);
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.surfaceFormat().colorRange(), colorRange);
+    QVERIFY(converted.surfaceFormat().colorSpace() != QVideoFrameFormat::ColorSpace_Undefined);
+
+    // video range quantizes more coarsely
+    QVERIFY(fuzzyCompareImages(converted.toImage(), image, 4));
+}
+
+void tst_QVideoFrameFormatConverter::rgbToRGB()
+{
+    QVideoFrame frame(QVideoFrameFormat(QSize(8, 2), QVideoFrameFormat::Format_ARGB8888));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int i = 0; i < 16; ++i) {
+        const uchar pixel[4] = { 0xff, uchar(i), uchar(i * 2), uchar(i * 3) }; // A, R, G, B
+        memcpy(frame.bits(0) + (i / 8) * frame.bytesPerLine(0) + (i % 8) * 4, pixel, 4);
+    }
+    frame.unmap();
+
+    QVideoFrameFormatConverter converter;
+    QVideoFrame converted = converter.convert(frame, QVideoFrameFormat::Format_RGBA8888);
+    QVERIFY(converted.map(QVideoFrame::ReadOnly));
+    for (int i = 0; i < 16; ++i) {
+        const uchar *pixel = converted.bits(0) + (i / 8) * converted.bytesPerLine(0) + (i % 8) * 4;
+        QCOMPARE(int(pixel[0]), i);
+        QCOMPARE(int(pixel[1]), i * 2);
+        QCOMPARE(int(pixel[2]), i * 3);
+        QCOMPARE(int(pixel[3]), 0xff);
+    }
+    converted.unmap();
+
+    // nothing to do
+    QCOMPARE(converter.convert(frame, QVideoFrameFormat::Format_ARGB8888), frame);
+}
+
+void tst_QVideoFrameFormatConverter::scale()
+{
+    QVideoFrame frame(QVideoFrameFormat(QSize(640, 480), QVideoFrameFormat::Format_NV12));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    memset(frame.bits(0), 200, frame.mappedBytes(0));
+    memset(frame.bits(1), 128, frame.mappedBytes(1));
+    frame.unmap();
+
+    QVideoFrameFormatConverter converter;
+    const QVideoFrame converted =
+            converter.convert(frame, QVideoFrameFormat::Format_YUV420P, QSize(320, 240));
+    QVERIFY(converted.isValid());
+    QCOMPARE(converted.size(), QSize(320, 240));
+    QCOMPARE(converted.pixelFormat(), QVideoFrameFormat::Format_YUV420P);
+
+    const QImage expected = frame.toImage().scaled(QSize(320, 240));
+    QVERIFY(fuzzyCompareImages(converted.toImage(), expected, 2));
+}
+
+void tst_QVideoFrameFormatConverter::keepsFrameProperties()
+{
+    QVideoFrame frame = createYUVFrame(QVideoFrameFormat::Format_NV12, QSize(64, 48));
+    frame.setStartTime(1000);
+    frame.setEndTime(2000);
+    frame.setRotationAngle(QVideoFrame::Rotation90);
+    frame.setMirrored(true);
+
+    QVideoFrameFormatConverter converter;
+    const QVideoFrame converted = converter.convert(frame, QVideoFrameFormat::Format_YUV420P);
+    QCOMPARE(converted.startTime(), frame.startTime());
+    QCOMPARE(converted.endTime(), frame.endTime());
+    QCOMPARE(converted.rotationAngle(), QVideoFrame::Rotation90);
+    QVERIFY(converted.mirrored());
+}
+
+QTEST_MAIN(tst_QVideoFrameFormatConverter)
+
+#include "tst_qvideoframeformatconverter.moc"
@@ -0,0 +1,117 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <private/qvideoframepool_p.h>
+
+class tst_QVideoFramePool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void createFrame_data();
+    void createFrame();
+    void recycleBuffers();
+    void maxFreeBuffers();
+    void framesOutlivePool();
+    void invalidFormat();
+};
+
+void tst_QVideoFramePool::createFrame_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    QTest::newRow("ARGB8888") << QVideoFrameFormat::Format_ARGB8888 << QSize(640, 480);
+    QTest::newRow("YUV420P") << QVideoFrameFormat::Format_YUV420P << QSize(641, 481);
+    QTest::newRow("NV12") << QVideoFrameFormat::Format_NV12 << QSize(1920, 1080);
+    QTest::newRow("UYVY") << QVideoFrameFormat::Format_UYVY << QSize(101, 33);
+}
+
+void tst_QVideoFramePool::createFrame()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    QVideoFramePool pool(QVideoFrameFormat(size, pixelFormat));
+    QCOMPARE(pool.bytesPerLine() % QVideoFramePool::Alignment, 0);
+
+    QVideoFrame frame = pool.createFrame();
+    QVERIFY(frame.isValid());
+    QCOMPARE(frame.pixelFormat(), pixelFormat);
+    QCOMPARE(frame.size(), size);
+    QCOMPARE(frame.handleType(), QVideoFrame::NoHandle);
+
+    QVERIFY(frame.map(QVideoFrame::ReadWrite));
+    QCOMPARE(frame.bytesPerLine(0), pool.bytesPerLine());
+    QCOMPARE(quintptr(frame.bits(0)) % QVideoFramePool::Alignment, 0u);
+
+    // the whole buffer is writable
+    for (int plane = 0; plane < frame.planeCount(); ++plane) {
+        QVERIFY(frame.bits(plane));
+        memset(frame.bits(plane), 0x80, frame.mappedBytes(plane));
+    }
+    frame.unmap();
+}
+
+void tst_QVideoFramePool::recycleBuffers()
+{
+    QVideoFramePool pool(QVideoFrameFormat(QSize(320, 240), QVideoFrameFormat::Format_ARGB8888));
+    QCOMPARE(pool.freeBufferCount(), 0);
+
+    QVideoFrame frame = pool.createFrame();
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    const uchar *bits = frame.bits(0);
+    frame.unmap();
+
+    // a copy shares the buffer, which is only returned with the last reference
+    QVideoFrame copy = frame;
+    frame = {};
+    QCOMPARE(pool.freeBufferCount(), 0);
+
+    copy = {};
+    QCOMPARE(pool.freeBufferCount(), 1);
+
+    QVideoFrame recycled = pool.createFrame();
+    QCOMPARE(pool.freeBufferCount(), 0);
+    QVERIFY(recycled.map(QVideoFrame::ReadOnly));
+    QCOMPARE(recycled.bits(0), bits);
+    recycled.unmap();
+}
+
+void tst_QVideoFramePool::maxFreeBuffers()
+{
+    QVideoFramePool pool(QVideoFrameFormat(QSize(64, 64), QVideoFrameFormat::Format_YUV420P), 2);
+
+    QList<QVideoFrame> frames;
+    for (int i = 0; i < 5; ++i)
+        frames.append(pool.createFrame());
+
+    frames.clear();
+    QCOMPARE(pool.freeBufferCount(), 2);
+}
+
+void tst_QVideoFramePool::framesOutlivePool()
+{
+    QVideoFrame frame;
+    {
+        QVideoFramePool pool(QVideoFrameFormat(QSize(64, 64), QVideoFrameFormat::Format_NV12));
+        frame = pool.createFrame();
+    }
+
+    QVERIFY(frame.isValid());
+    QVERIFY(frame.map(QVideoFrame::ReadWrite));
+    memset(frame.bits(0), 0, frame.mappedBytes(0));
+    frame.unmap();
+}
+
+void tst_QVideoFramePool::invalidFormat()
+{
+    QVideoFramePool pool{ QVideoFrameFormat() };
+    QVERIFY(!pool.createFrame().isValid());
+}
+
+QTEST_MAIN(tst_QVideoFramePool)
+
+#include "tst_qvideoframepool.moc"
@@ -5,6 +5,7 @@
 
 #include <QtTest/QtTest>
 #include <qwavedecoder.h>
+#include <private/qwavedecoder_p.h>
 
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
@@ -40,6 +41,14 @@ private slots:
 
     void readAllAtOnce();
     void readPerByte();
+
+    void seekAndSkipChunks();
+    void seek24Bit();
+    void largeFileFormats_data();
+    void largeFileFormats();
+    void truncatedData();
+    void seekStereo();
+    void closeMappedFile();
 };
 
 void tst_QWaveDecoder::init()
@@ -272,6 +281,232 @@ void tst_QWaveDecoder::readPerByte()
     stream.close();
 }
 
+static QByteArray littleEndian(quint64 value, int bytes)
+{
+    QByteArray result;
+    for (int i = 0; i < bytes; ++i)
+        result += char(value >> (8 * i));
+    return result;
+}
+
+static QByteArray chunk(const char *id, const QByteArray &contents)
+{
+    QByteArray result = QByteArray(id, 4) + littleEndian(contents.size(), 4) + contents;
+    if (contents.size() % 2)
+        result += '\0';
+    return result;
+}
+
+static QByteArray formatChunk(int bitsPerSample, int channels, int sampleRate)
+{
+    const int blockAlign = channels * bitsPerSample / 8;
+    return chunk("fmt ", littleEndian(1, 2) + littleEndian(channels, 2) + littleEndian(sampleRate, 4)
+                         + littleEndian(sampleRate * blockAlign, 4) + littleEndian(blockAlign, 2)
+                         + littleEndian(bitsPerSample, 2));
+}
+
+static QByteArray riffFile(const QByteArray &chunks)
+{
+    return "RIFF" + littleEndian(chunks.size() + 4, 4) + "WAVE" + chunks;
+}
+
+// frame i of a mono 16 bit ramp
+static qint16 rampSample(int i)
+{
+    return qint16(i * 3 - 1000);
+}
+
+static QByteArray ramp(int frames)
+{
+    QByteArray result;
+    for (int i = 0; i < frames; ++i)
+        result += littleEndian(quint16(rampSample(i)), 2);
+    return result;
+}
+
+static bool writeFile(QTemporaryFile *file, const QByteArray &data)
+{
+    if (!file->open() || file->write(data) != data.size())
+        return false;
+    return file->seek(0);
+}
+
+void tst_QWaveDecoder::seekAndSkipChunks()
+{
+    // chunks of odd sizes before and between the headers, and metadata after the samples
+    const int frames = 1000;
+    const QByteArray data = riffFile(chunk("LIST", "odd size") + formatChunk(16, 1, 8000)
+                                     + chunk("junk", QByteArray(5001, 'j')) + chunk("data", ramp(frames))
+                                     + chunk("LIST", "trailing"));
+    QTemporaryFile file;
+    QVERIFY(writeFile(&file, data));
+
+    QWaveDecoder waveDecoder(&file);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QVERIFY(waveDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(validFormatSpy.count(), 1);
+    QCOMPARE(waveDecoder.size(), qint64(frames * 2));
+    QCOMPARE(waveDecoder.pos(), qint64(0));
+    QVERIFY(QWaveDecoderPrivate::get(&waveDecoder)->isRawData());
+
+    // the metadata after the samples isn't read as samples
+    QByteArray samples = waveDecoder.readAll();
+    QCOMPARE(samples, ramp(frames));
+    QVERIFY(waveDecoder.atEnd());
+
+    qint16 sample = 0;
+    QVERIFY(waveDecoder.seek(500 * 2));
+    QCOMPARE(waveDecoder.pos(), qint64(500 * 2));
+    QCOMPARE(waveDecoder.read(reinterpret_cast<char *>(&sample), 2), qint64(2));
+    QCOMPARE(sample, rampSample(500));
+    QCOMPARE(waveDecoder.bytesAvailable(), qint64((frames - 501) * 2));
+
+    // seeking back, and into the middle of a sample
+    QVERIFY(waveDecoder.seek(10 * 2 + 1));
+    QCOMPARE(waveDecoder.pos(), qint64(10 * 2));
+    QCOMPARE(waveDecoder.read(reinterpret_cast<char *>(&sample), 2), qint64(2));
+    QCOMPARE(sample, rampSample(10));
+
+    QVERIFY(waveDecoder.seek(frames * 2));
+    QVERIFY(!waveDecoder.seek(frames * 2 + 2));
+}
+
+void tst_QWaveDecoder::seek24Bit()
+{
+    const int frames = 1000;
+    QByteArray samples;
+    for (int i = 0; i < frames; ++i)
+        samples += littleEndian(quint32(rampSample(i) * 256 + 0x7f), 3);
+    QTemporaryFile file;
+    QVERIFY(writeFile(&file, riffFile(formatChunk(24, 1, 8000) + chunk("data", samples))));
+
+    QWaveDecoder waveDecoder(&file);
+    QVERIFY(waveDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(waveDecoder.audioFormat().sampleFormat(), QAudioFormat::Int16);
+    QCOMPARE(waveDecoder.size(), qint64(frames * 2));
+    QVERIFY(!QWaveDecoderPrivate::get(&waveDecoder)->isRawData());
+
+    // positions are in the converted 16 bit samples
+    QVERIFY(waveDecoder.seek(300 * 2));
+    const QByteArray converted = waveDecoder.readAll();
+    QCOMPARE(converted.size(), qsizetype((frames - 300) * 2));
+    for (int i = 300; i < frames; ++i)
+        QCOMPARE(reinterpret_cast<const qint16 *>(converted.constData())[i - 300], rampSample(i));
+}
+
+void tst_QWaveDecoder::largeFileFormats_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    const int frames = 1001;
+
+    // RF64 keeps the sizes in the ds64 chunk, the others are all ones
+    const QByteArray ds64 = littleEndian(0, 8) + littleEndian(frames * 2, 8) + littleEndian(frames, 8)
+            + littleEndian(0, 4);
+    const QByteArray rf64 = chunk("ds64", ds64) + formatChunk(16, 1, 8000) + "data"
+            + littleEndian(0xffffffff, 4) + ramp(frames) + chunk("LIST", "trailing");
+    QTest::newRow("RF64") << "RF64" + littleEndian(0xffffffff, 4) + "WAVE" + rf64;
+    QTest::newRow("BW64") << "BW64" + littleEndian(0xffffffff, 4) + "WAVE" + rf64;
+
+    // Wave64 identifies the chunks by GUIDs, and has 64 bit sizes that include
+    // the chunk headers, with chunks aligned to 8 bytes
+    const QByteArray guidTail = QByteArray::fromHex("f3acd3118cd100c04f8edb8a");
+    const auto wave64Chunk = [&](const char *id, const QByteArray &contents) {
+        QByteArray result = QByteArray(id, 4) + guidTail + littleEndian(contents.size() + 24, 8) + contents;
+        return result.leftJustified((result.size() + 7) / 8 * 8, '\0');
+    };
+    const QByteArray w64 = wave64Chunk("junk", "thirteen byte") + wave64Chunk("fmt ", formatChunk(16, 1, 8000).mid(8))
+            + wave64Chunk("data", ramp(frames)) + wave64Chunk("list", "trailing");
+    QTest::newRow("Wave64") << QByteArray::fromHex("726966662e91cf11a5d628db04c10000")
+                               + littleEndian(w64.size() + 40, 8) + "wave" + guidTail + w64;
+}
+
+void tst_QWaveDecoder::largeFileFormats()
+{
+    QFETCH(QByteArray, data);
+    const int frames = 1001;
+
+    QTemporaryFile file;
+    QVERIFY(writeFile(&file, data));
+
+    QWaveDecoder waveDecoder(&file);
+    QSignalSpy validFormatSpy(&waveDecoder, SIGNAL(formatKnown()));
+    QVERIFY(waveDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(validFormatSpy.count(), 1);
+    QCOMPARE(waveDecoder.audioFormat().sampleRate(), 8000);
+    QCOMPARE(waveDecoder.audioFormat().channelCount(), 1);
+    QCOMPARE(waveDecoder.size(), qint64(frames * 2));
+    QCOMPARE(waveDecoder.readAll(), ramp(frames));
+}
+
+void tst_QWaveDecoder::truncatedData()
+{
+    const int frames = 1000;
+
+    // the recording stopped before the data size was written
+    QTemporaryFile unfinalized;
+    QVERIFY(writeFile(&unfinalized, riffFile(formatChunk(16, 1, 8000)) + "data"
+                                      + littleEndian(0xffffffff, 4) + ramp(frames)));
+    QWaveDecoder unfinalizedDecoder(&unfinalized);
+    QVERIFY(unfinalizedDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(unfinalizedDecoder.size(), qint64(frames * 2));
+
+    // an empty data chunk is just that, even with something after it
+    QTemporaryFile empty;
+    QVERIFY(writeFile(&empty, riffFile(formatChunk(16, 1, 8000) + chunk("data", {})
+                                       + chunk("LIST", "trailing"))));
+    QWaveDecoder emptyDecoder(&empty);
+    QVERIFY(emptyDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(emptyDecoder.size(), qint64(0));
+    QVERIFY(emptyDecoder.readAll().isEmpty());
+
+    // the file was cut off after the header was written
+    QTemporaryFile cutOff;
+    QVERIFY(writeFile(&cutOff, riffFile(formatChunk(16, 1, 8000)) + "data"
+                                 + littleEndian(frames * 4, 4) + ramp(frames)));
+    QWaveDecoder cutOffDecoder(&cutOff);
+    QVERIFY(cutOffDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(cutOffDecoder.size(), qint64(frames * 2));
+    QCOMPARE(cutOffDecoder.readAll(), ramp(frames));
+}
+
+void tst_QWaveDecoder::seekStereo()
+{
+    // frame i holds rampSample(2 * i) and rampSample(2 * i + 1)
+    const int frames = 500;
+    QTemporaryFile file;
+    QVERIFY(writeFile(&file, riffFile(formatChunk(16, 2, 8000) + chunk("data", ramp(frames * 2)))));
+
+    QWaveDecoder waveDecoder(&file);
+    QVERIFY(waveDecoder.open(QIODevice::ReadOnly));
+    QCOMPARE(waveDecoder.audioFormat().bytesPerFrame(), 4);
+
+    // seeking into the second channel continues at the start of the frame
+    qint16 samples[2] = {};
+    QVERIFY(waveDecoder.seek(100 * 4 + 2));
+    QCOMPARE(waveDecoder.pos(), qint64(100 * 4));
+    QCOMPARE(waveDecoder.read(reinterpret_cast<char *>(samples), 4), qint64(4));
+    QCOMPARE(samples[0], rampSample(200));
+    QCOMPARE(samples[1], rampSample(201));
+}
+
+void tst_QWaveDecoder::closeMappedFile()
+{
+    const int frames = 1000;
+    QTemporaryFile file;
+    QVERIFY(writeFile(&file, riffFile(formatChunk(16, 1, 8000) + chunk("data", ramp(frames)))));
+
+    QWaveDecoder waveDecoder(&file);
+    QVERIFY(waveDecoder.open(QIODevice::ReadOnly));
+    QByteArray samples(200, 0);
+    QCOMPARE(waveDecoder.read(samples.data(), samples.size()), qint64(samples.size()));
+    QCOMPARE(samples, ramp(100));
+
+    // the samples are no longer read from the mapping once the file is closed
+    file.close();
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression("device not open"));
+    QVERIFY(waveDecoder.read(samples.data(), samples.size()) <= 0);
+}
+
 QTEST_MAIN(tst_QWaveDecoder)
 
 #include "tst_qwavedecoder.moc"
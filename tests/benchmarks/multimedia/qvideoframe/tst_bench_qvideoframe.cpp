@@ -0,0 +1,147 @@
+// Copyright (C) 2023 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR GPL-3.0-only WITH Qt-GPL-exception-1.0
+
+#include <QtTest/QtTest>
+
+#include <qvideoframe.h>
+#include <qvideoframeformat.h>
+#include <private/qvideoframeconversionhelper_p.h>
+#include <private/qvideoframeconverter_p.h>
+#include <private/qvideoframeformatconverter_p.h>
+#include <QtGui/QImage>
+
+class tst_QVideoFrameBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void convertToARGB32_data();
+    void convertToARGB32();
+    void imageFromVideoFrame_data();
+    void imageFromVideoFrame();
+    void convertFormat_data();
+    void convertFormat();
+};
+
+void tst_QVideoFrameBench::convertToARGB32_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QSize>("size");
+
+    const std::pair<const char *, QVideoFrameFormat::PixelFormat> formats[] = {
+        { "YUV420P", QVideoFrameFormat::Format_YUV420P },
+        { "YUV422P", QVideoFrameFormat::Format_YUV422P },
+        { "YV12", QVideoFrameFormat::Format_YV12 },
+        { "NV12", QVideoFrameFormat::Format_NV12 },
+        { "NV21", QVideoFrameFormat::Format_NV21 },
+        { "IMC3", QVideoFrameFormat::Format_IMC3 },
+        { "UYVY", QVideoFrameFormat::Format_UYVY },
+        { "YUYV", QVideoFrameFormat::Format_YUYV },
+        { "P010", QVideoFrameFormat::Format_P010 },
+        { "ARGB8888", QVideoFrameFormat::Format_ARGB8888 },
+    };
+
+    const std::pair<const char *, QSize> sizes[] = {
+        { "1080p", QSize(1920, 1080) },
+        { "4K", QSize(3840, 2160) },
+    };
+
+    for (const auto &[sizeName, size] : sizes)
+        for (const auto &[formatName, format] : formats)
+            QTest::addRow("%s %s", formatName, sizeName) << format << size;
+}
+
+void tst_QVideoFrameBench::convertToARGB32()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QSize, size);
+
+    VideoFrameConvertFunc convert = qConverterForFormat(pixelFormat);
+    QVERIFY(convert);
+
+    QVideoFrame frame(QVideoFrameFormat(size, pixelFormat));
+    QVERIFY(frame.map(QVideoFrame::ReadWrite));
+    for (int plane = 0; plane < frame.planeCount(); ++plane)
+        memset(frame.bits(plane), 0x80, frame.mappedBytes(plane));
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+
+    // the converters are what QVideoFrame::toImage() uses when no RHI is available
+    QBENCHMARK {
+        convert(frame, image.bits(), 0, size.height());
+    }
+
+    frame.unmap();
+}
+
+void tst_QVideoFrameBench::imageFromVideoFrame_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("pixelFormat");
+    QTest::addColumn<QVideoFrame::RotationAngle>("rotation");
+
+    QTest::newRow("NV12 4K") << QVideoFrameFormat::Format_NV12 << QVideoFrame::Rotation0;
+    QTest::newRow("NV12 4K rotated") << QVideoFrameFormat::Format_NV12 << QVideoFrame::Rotation90;
+    QTest::newRow("YUV420P 4K") << QVideoFrameFormat::Format_YUV420P << QVideoFrame::Rotation0;
+    QTest::newRow("ARGB8888 4K") << QVideoFrameFormat::Format_ARGB8888 << QVideoFrame::Rotation0;
+}
+
+void tst_QVideoFrameBench::imageFromVideoFrame()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, pixelFormat);
+    QFETCH(QVideoFrame::RotationAngle, rotation);
+
+    QVideoFrame frame(QVideoFrameFormat(QSize(3840, 2160), pixelFormat));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int plane = 0; plane < frame.planeCount(); ++plane)
+        memset(frame.bits(plane), 0x80, frame.mappedBytes(plane));
+    frame.unmap();
+
+    // the whole conversion, including the segmentation over the thread pool
+    QBENCHMARK {
+        QImage image = qImageFromVideoFrame(frame, rotation);
+        Q_UNUSED(image);
+    }
+}
+
+void tst_QVideoFrameBench::convertFormat_data()
+{
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("from");
+    QTest::addColumn<QVideoFrameFormat::PixelFormat>("to");
+    QTest::addColumn<QSize>("size");
+
+    const QSize size(3840, 2160);
+    QTest::newRow("NV12 to YUV420P 4K")
+            << QVideoFrameFormat::Format_NV12 << QVideoFrameFormat::Format_YUV420P << size;
+    QTest::newRow("UYVY to NV12 4K")
+            << QVideoFrameFormat::Format_UYVY << QVideoFrameFormat::Format_NV12 << size;
+    QTest::newRow("BGRX8888 to NV12 4K")
+            << QVideoFrameFormat::Format_BGRX8888 << QVideoFrameFormat::Format_NV12 << size;
+    QTest::newRow("NV12 to RGBA8888 4K")
+            << QVideoFrameFormat::Format_NV12 << QVideoFrameFormat::Format_RGBA8888 << size;
+    QTest::newRow("NV12 4K to YUV420P 1080p")
+            << QVideoFrameFormat::Format_NV12 << QVideoFrameFormat::Format_YUV420P << QSize(1920, 1080);
+}
+
+void tst_QVideoFrameBench::convertFormat()
+{
+    QFETCH(QVideoFrameFormat::PixelFormat, from);
+    QFETCH(QVideoFrameFormat::PixelFormat, to);
+    QFETCH(QSize, size);
+
+    QVideoFrame frame(QVideoFrameFormat(QSize(3840, 2160), from));
+    QVERIFY(frame.map(QVideoFrame::WriteOnly));
+    for (int plane = 0; plane < frame.planeCount(); ++plane)
+        memset(frame.bits(plane), 0x80, frame.mappedBytes(plane));
+    frame.unmap();
+
+    // the converter recycles the memory of the frames it returned before
+    QVideoFrameFormatConverter converter;
+    QBENCHMARK {
+        QVideoFrame converted = converter.convert(frame, to, size);
+        Q_UNUSED(converted);
+    }
+}
+
+QTEST_MAIN(tst_QVideoFrameBench)
+
+#include "tst_bench_qvideoframe.moc"